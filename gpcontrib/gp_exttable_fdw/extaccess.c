@@ -109,7 +109,7 @@ elog(DEBUG2, "external_getnext returning tuple")
  */
 FileScanDesc
 external_beginscan(Relation relation, uint32 scancounter,
-				   List *uriList, char fmtType, bool isMasterOnly,
+				   List *uriList, List *splitList, char fmtType, bool isMasterOnly,
 				   int rejLimit, bool rejLimitInRows, char logErrors, int encoding,
 				   List *extOptions)
 {
@@ -182,6 +182,18 @@ external_beginscan(Relation relation, uint32 scancounter,
 				uri = NULL;
 			else
 				uri = (char *) strVal(v);
+
+			/* do we share the URI with other segments? */
+			if (splitList != NIL)
+			{
+				List	   *split = (List *) list_nth(splitList, idx);
+
+				if (split != NIL)
+				{
+					scan->fs_split_index = linitial_int(split);
+					scan->fs_split_count = lsecond_int(split);
+				}
+			}
 		}
 	}
 	else if (Gp_role == GP_ROLE_DISPATCH && isMasterOnly)
@@ -1300,6 +1312,13 @@ open_external_readable_source(FileScanDesc scan, ExternalSelectDesc desc)
 							  scan->fs_scancounter,
 							  scan->fs_custom_formatter_params);
 
+	/* read only our share of the data, if we share the URI */
+	if (desc)
+	{
+		desc->split_index = scan->fs_split_index;
+		desc->split_count = scan->fs_split_count;
+	}
+
 	/* actually open the external source */
 	scan->fs_file = url_fopen(scan->fs_uri,
 							  false /* for read */ ,
@@ -45,17 +45,6 @@ typedef struct ExternalInsertDescData
 
 typedef ExternalInsertDescData *ExternalInsertDesc;
 
-/*
- * ExternalSelectDescData is used for storing state related
- * to selecting data from an external table.
- */
-typedef struct ExternalSelectDescData
-{
-	ProjectionInfo *projInfo;   /* Information for column projection */
-	List *filter_quals;         /* Information for filter pushdown */
-
-} ExternalSelectDescData;
-
 /*
  * used for scan of external relations with the file protocol
  */
@@ -66,6 +55,8 @@ typedef struct FileScanDescData
 	struct URL_FILE *fs_file;	/* the file pointer to our URI */
 	char	   *fs_uri;			/* the URI string */
 	bool		fs_noop;		/* no op. this segdb has no file to scan */
+	int			fs_split_index;	/* read only this share of the URI ... */
+	int			fs_split_count;	/* ... out of this many, if > 1 */
 	uint32      fs_scancounter;	/* copied from struct ExternalScan in plan */
 
 	/* current file parse state */
@@ -105,7 +96,7 @@ typedef enum DataLineStatus
 } DataLineStatus;
 
 extern FileScanDesc external_beginscan(Relation relation,
-				   uint32 scancounter, List *uriList,
+				   uint32 scancounter, List *uriList, List *splitList,
 				   char fmtType, bool isMasterOnly,
 				   int rejLimit, bool rejLimitInRows,
 				   char logErrors, int encoding, List *extOptions);
@@ -644,6 +644,7 @@ exttable_BeginForeignScan(ForeignScanState *node,
 	currentScanDesc = external_beginscan(currentRelation,
 										 externalscan_info->scancounter,
 										 externalscan_info->uriList,
+										 externalscan_info->splitList,
 										 externalscan_info->fmtType,
 										 externalscan_info->isMasterOnly,
 										 externalscan_info->rejLimit,
@@ -11,18 +11,22 @@
 #include "funcapi.h"
 #include "cdb/cdbvars.h"
 #include "utils/builtins.h"
+#include "utils/timestamp.h"
 #include "executor/instrument.h"
+#include "nodes/print.h"
 
 PG_MODULE_MAGIC;
 
 Datum		gp_instrument_shmem_summary(PG_FUNCTION_ARGS);
 Datum		gp_instrument_shmem_detail(PG_FUNCTION_ARGS);
+Datum		gp_instrument_shmem_live_stats(PG_FUNCTION_ARGS);
 
 /* Helper functions */
 static InstrumentationSlot *next_used_slot(int32 *);
 
 PG_FUNCTION_INFO_V1(gp_instrument_shmem_summary);
 PG_FUNCTION_INFO_V1(gp_instrument_shmem_detail);
+PG_FUNCTION_INFO_V1(gp_instrument_shmem_live_stats);
 
 #define GET_SLOT_BY_INDEX(index) ((InstrumentationSlot*)(InstrumentGlobal + 1) + (index))
 
@@ -179,3 +183,129 @@ gp_instrument_shmem_detail(PG_FUNCTION_ARGS)
 		SRF_RETURN_NEXT(funcctx, result);
 	}
 }
+
+/*
+ * Get live execution statistics of the plan nodes running on this segment
+ *
+ * ---------------------------------------------------------------------
+ * Interface to gp_instrument_shmem_live_stats function.
+ *
+ * Unlike gp_instrument_shmem_detail, the rows carry the slice and type of
+ * each node and are meant to be combined across segments while the query
+ * runs, see gp_toolkit.gp_live_exec_stats.
+ *
+ * CREATE FUNCTION gp_instrument_shmem_live_stats()
+ *   RETURNS TABLE ( segid int4
+ *   				,sess_id int4
+ *   				,command_cnt int4
+ *   				,slice int4
+ *   				,node_id int4
+ *   				,node_type text
+ *   				,pid int4
+ *   				,start_time timestamptz
+ *   				,rows int8
+ *   				,nloops int8
+ *   				,time_ms float8
+ *   				,sending bool
+ *                 )
+ *   AS '$libdir/gp_instrument_shmem', 'gp_instrument_shmem_live_stats' LANGUAGE C VOLATILE;
+ *
+ * time_ms is NULL unless gp_enable_query_metrics_timing was on when the
+ * query started.  A Motion has a row for each side: for the sending side,
+ * sending is true and rows counts the tuples sent to the receivers.
+ */
+Datum
+gp_instrument_shmem_live_stats(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	int32	   *crtIndexPtr;
+
+#define GP_INSTRUMENT_SHMEM_LIVE_STATS_NATTR 12
+	if (SRF_IS_FIRSTCALL())
+	{
+		/* create a function context for cross-call persistence */
+		funcctx = SRF_FIRSTCALL_INIT();
+
+		/* Switch to memory context appropriate for multiple function calls */
+		MemoryContext oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		TupleDesc	tupdesc = CreateTemplateTupleDesc(GP_INSTRUMENT_SHMEM_LIVE_STATS_NATTR);
+
+		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "segid", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 2, "sess_id", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 3, "command_cnt", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 4, "slice", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 5, "node_id", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 6, "node_type", TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 7, "pid", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 8, "start_time", TIMESTAMPTZOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 9, "rows", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 10, "nloops", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 11, "time_ms", FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 12, "sending", BOOLOID, -1, 0);
+
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		crtIndexPtr = (int32 *) palloc(sizeof(*crtIndexPtr));
+		*crtIndexPtr = 0;
+		funcctx->user_fctx = crtIndexPtr;
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	crtIndexPtr = (int32 *) funcctx->user_fctx;
+	while (true)
+	{
+		InstrumentationSlot *slot = next_used_slot(crtIndexPtr);
+		InstrumentationSlot copy;
+		Plan		plan;
+
+		if (slot == NULL)
+		{
+			/* Reached the end of the entry array, we're done */
+			SRF_RETURN_DONE(funcctx);
+		}
+
+		/*
+		 * The owner keeps updating the slot without a lock, so work on a copy
+		 * to at least report values that belong together.  Skip the slot if
+		 * it was recycled meanwhile.
+		 */
+		memcpy(&copy, slot, sizeof(InstrumentationSlot));
+		if (SlotIsEmpty(&copy))
+			continue;
+
+		Datum		values[GP_INSTRUMENT_SHMEM_LIVE_STATS_NATTR];
+		bool		nulls[GP_INSTRUMENT_SHMEM_LIVE_STATS_NATTR];
+
+		memset(nulls, 0, sizeof(nulls));
+
+		/* plannode_type() only looks at the node tag */
+		plan.type = (NodeTag) copy.ntag;
+
+		values[0] = Int32GetDatum(copy.segid);
+		values[1] = Int32GetDatum(copy.ssid);
+		values[2] = Int32GetDatum(copy.ccnt);
+		values[3] = Int32GetDatum(copy.sliceid);
+		values[4] = Int32GetDatum(copy.nid);
+		values[5] = CStringGetTextDatum(plannode_type(&plan));
+		values[6] = Int32GetDatum(copy.pid);
+		values[7] = TimestampTzGetDatum(copy.starttime);
+		if (copy.tuplessent >= 0)
+			values[8] = Int64GetDatum(copy.tuplessent);
+		else
+			values[8] = Int64GetDatum((int64) (copy.data.ntuples + copy.data.tuplecount));
+		values[9] = Int64GetDatum((int64) copy.data.nloops);
+		if (copy.data.need_timer)
+			values[10] = Float8GetDatum(1000.0 * (copy.data.total +
+												  INSTR_TIME_GET_DOUBLE(copy.data.counter)));
+		else
+			nulls[10] = true;
+		values[11] = BoolGetDatum(copy.tuplessent >= 0);
+
+		HeapTuple	tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+		Datum		result = HeapTupleGetDatum(tuple);
+
+		SRF_RETURN_NEXT(funcctx, result);
+	}
+}
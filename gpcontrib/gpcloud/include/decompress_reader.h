@@ -1,6 +1,10 @@
 #ifndef INCLUDE_DECOMPRESS_READER_H_
 #define INCLUDE_DECOMPRESS_READER_H_
 
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
 #include "reader.h"
 #include "s3common_headers.h"
 #include "s3exception.h"
@@ -10,6 +14,20 @@
 // 2MB by default
 extern uint64_t S3_ZIP_DECOMPRESS_CHUNKSIZE;
 
+// Upper bound of decompressed bytes produced by one batch of parallel frames.
+#define S3_FRAME_BATCH_MAX_OUTPUT (S3_ZIP_DECOMPRESS_CHUNKSIZE * 8)
+
+enum DecompressCodec { CODEC_UNKNOWN, CODEC_ZLIB, CODEC_ZSTD };
+
+// One independently decompressible unit inside the 'in' buffer: a BGZF gzip member or a zstd
+// frame whose compressed and decompressed sizes are both known up front.
+struct DecompressFrame {
+    uint64_t inOffset;
+    uint64_t inLen;
+    uint64_t outOffset;
+    uint64_t outLen;
+};
+
 class DecompressReader : public Reader {
    public:
     DecompressReader();
@@ -29,19 +47,47 @@ class DecompressReader : public Reader {
     void resizeDecompressReaderBuffer(uint64_t size);
 
    private:
-    void decompress();
+    // Produce the next piece of decompressed data into outData/outLen. Return false on EOF.
+    bool decompress();
+
+    void inflateChunk();
+#ifdef USE_ZSTD
+    void decompressZstdChunk();
+#endif
 
-    uint64_t getDecompressedBytesNum() {
-        return S3_ZIP_DECOMPRESS_CHUNKSIZE - this->zstream.avail_out;
-    }
+    // Try to decompress a batch of complete frames at the head of 'in' concurrently.
+    bool decompressFrames();
+    bool findFrame(uint64_t offset, DecompressFrame &frame);
+
+    uint64_t fillInBuffer();
 
     Reader *reader;
 
+    DecompressCodec codec;
+
     // zlib related variables.
     z_stream zstream;
+#ifdef USE_ZSTD
+    ZSTD_DCtx *zstdDCtx;
+#endif
+
     char *in;            // Input buffer for decompression.
-    char *out;           // Output buffer for decompression.
-    uint64_t outOffset;  // Next position to read in out buffer.
+    uint64_t inLen;      // Valid bytes in 'in' buffer.
+    uint64_t inOffset;   // Next byte to decompress in 'in' buffer.
+    bool readerEOF;      // Underlying reader reached EOF.
+
+    char *out;           // Output buffer for streaming decompression.
+    const char *outData; // Either 'out' or 'frameOut'.
+    uint64_t outLen;     // Valid bytes in outData.
+    uint64_t outOffset;  // Next position to read in outData.
+
+    bool frameDone;      // Stream is at a gzip member or zstd frame boundary.
+    bool outputFull;     // Last streaming step filled 'out', decoder may hold more output.
+    bool memberEnded;    // A gzip member was completed, zero padding may follow.
+
+    uint64_t numThreads;
+    vector<char> frameOut;
+    vector<DecompressFrame> frames;
 
     bool isClosed;
 };
@@ -1,6 +1,7 @@
 #ifndef __GP_READER_H__
 #define __GP_READER_H__
 
+#include "parquet_reader.h"
 #include "reader.h"
 #include "s3bucket_reader.h"
 #include "s3common_headers.h"
@@ -38,6 +39,7 @@ class GPReader : public Reader {
     S3Params params;
     S3BucketReader bucketReader;
     S3CommonReader commonReader;
+    ParquetReader parquetReader;
     S3RESTfulService restfulService;
 
     S3InterfaceService s3InterfaceService;
@@ -48,7 +50,8 @@ class GPReader : public Reader {
 };
 
 // Following 3 functions are invoked by s3_import(), need to be exception safe
-GPReader *reader_init(const char *url_with_options);
+// scanSpec describes the external table for Parquet objects, NULL to read all their columns.
+GPReader *reader_init(const char *url_with_options, const ParquetScanSpec *scanSpec = NULL);
 bool reader_transfer_data(GPReader *reader, char *data_buf, int &data_len);
 bool reader_cleanup(GPReader **reader);
 
@@ -0,0 +1,236 @@
+#ifndef INCLUDE_PARQUET_READER_H_
+#define INCLUDE_PARQUET_READER_H_
+
+#include "reader.h"
+#include "s3common_headers.h"
+#include "s3exception.h"
+#include "s3interface.h"
+#include "s3macros.h"
+#include "s3params.h"
+
+// Bytes read from the end of an object at first, which normally covers the whole footer.
+#define PARQUET_FOOTER_READ_SIZE (64 * 1024)
+
+// Column chunks closer than this are fetched by one ranged GET.
+#define PARQUET_RANGE_MERGE_GAP (1024 * 1024)
+
+// Rows are converted to CSV in batches of about this size.
+#define PARQUET_OUTPUT_BATCH_SIZE (64 * 1024)
+
+// How a Parquet value is converted to text, derived from its physical and logical types.
+enum ParquetValueKind {
+    PARQUET_VALUE_PLAIN,
+    PARQUET_VALUE_STRING,
+    PARQUET_VALUE_UNSIGNED,
+    PARQUET_VALUE_DECIMAL,
+    PARQUET_VALUE_DATE,
+    PARQUET_VALUE_TIMESTAMP,
+};
+
+struct ParquetSchemaColumn {
+    ParquetSchemaColumn()
+        : type(-1),
+          typeLength(0),
+          repetition(0),
+          convertedType(-1),
+          numChildren(0),
+          scale(0),
+          precision(0),
+          kind(PARQUET_VALUE_PLAIN),
+          timeUnitsPerSecond(0),
+          adjustedToUTC(false) {
+    }
+
+    string name;
+    int32_t type;  // physical type
+    int32_t typeLength;
+    int32_t repetition;
+    int32_t convertedType;
+    int32_t numChildren;
+    int32_t scale;
+    int32_t precision;
+
+    ParquetValueKind kind;
+    int64_t timeUnitsPerSecond;  // for timestamps
+    bool adjustedToUTC;
+};
+
+struct ParquetStatistics {
+    ParquetStatistics() : hasMin(false), hasMax(false), hasNullCount(false), nullCount(0) {
+    }
+
+    bool hasMin;
+    bool hasMax;
+    string min;
+    string max;
+    bool hasNullCount;
+    int64_t nullCount;
+};
+
+struct ParquetColumnChunk {
+    ParquetColumnChunk()
+        : codec(0), numValues(0), totalCompressedSize(0), dataPageOffset(0), dictPageOffset(0) {
+    }
+
+    // The chunk starts with its dictionary page, if there is one.
+    uint64_t getOffset() const {
+        return (dictPageOffset > 0 && dictPageOffset < dataPageOffset) ? dictPageOffset
+                                                                         : dataPageOffset;
+    }
+
+    int32_t codec;
+    int64_t numValues;
+    int64_t totalCompressedSize;
+    int64_t dataPageOffset;
+    int64_t dictPageOffset;
+    ParquetStatistics stats;
+};
+
+struct ParquetRowGroup {
+    ParquetRowGroup() : numRows(0) {
+    }
+
+    int64_t numRows;
+    vector<ParquetColumnChunk> columns;
+};
+
+// Text form of the values of one column chunk.
+class ParquetColumnValues {
+   public:
+    void clear() {
+        text.clear();
+        ends.clear();
+        nulls.clear();
+    }
+
+    void reserve(uint64_t num) {
+        ends.reserve(num);
+        nulls.reserve(num);
+    }
+
+    uint64_t size() const {
+        return ends.size();
+    }
+
+    void appendNull() {
+        ends.push_back(text.size());
+        nulls.push_back(true);
+    }
+
+    void append(const char *value, uint64_t len) {
+        text.append(value, len);
+        ends.push_back(text.size());
+        nulls.push_back(false);
+    }
+
+    // Copy value idx of another column, used to expand dictionary indices.
+    void appendFrom(const ParquetColumnValues &other, uint64_t idx) {
+        if (other.nulls[idx]) {
+            this->appendNull();
+        } else {
+            uint64_t start = other.getStart(idx);
+            this->append(other.text.data() + start, other.ends[idx] - start);
+        }
+    }
+
+    bool isNull(uint64_t idx) const {
+        return nulls[idx];
+    }
+
+    const char *getValue(uint64_t idx) const {
+        return text.data() + this->getStart(idx);
+    }
+
+    uint64_t getLength(uint64_t idx) const {
+        return ends[idx] - this->getStart(idx);
+    }
+
+   private:
+    uint64_t getStart(uint64_t idx) const {
+        return idx == 0 ? 0 : ends[idx - 1];
+    }
+
+    string text;
+    vector<uint64_t> ends;
+    vector<bool> nulls;
+};
+
+// ParquetReader reads a Parquet object and converts its rows to CSV text for the external table
+// formatter. It fetches the footer and only the column chunks of the table columns the query
+// references with ranged GETs, and skips row groups whose min/max statistics contradict the
+// pushed-down quals. Only flat schemas are supported.
+class ParquetReader : public Reader {
+   public:
+    ParquetReader();
+    virtual ~ParquetReader();
+
+    virtual void open(const S3Params &params);
+
+    // read() attempts to read up to count bytes into the buffer.
+    // Return 0 if EOF. Throw exception if encounters errors.
+    virtual uint64_t read(char *buf, uint64_t count);
+
+    // This should be reentrant, has no side effects when called multiple times.
+    virtual void close();
+
+    void setS3InterfaceService(S3Interface *s3) {
+        this->s3Interface = s3;
+    }
+
+    const vector<ParquetSchemaColumn> &getSchema() const {
+        return schema;
+    }
+
+    uint64_t getNumRowGroups() const {
+        return rowGroups.size();
+    }
+
+    uint64_t getNumSkippedRowGroups() const {
+        return numSkippedRowGroups;
+    }
+
+    uint64_t getFetchedBytes() const {
+        return fetchedBytes;
+    }
+
+   private:
+    void fetchRange(uint64_t offset, uint64_t len, string &out);
+    void readFooter();
+    void mapColumns();
+
+    bool rowGroupMayMatch(const ParquetRowGroup &rowGroup);
+    bool loadNextRowGroup();
+    void decodeColumnChunk(const ParquetSchemaColumn &column, const ParquetColumnChunk &chunk,
+                           const char *data, uint64_t len, ParquetColumnValues &values);
+
+    void formatRows();
+    void appendValue(const ParquetColumnValues &values, uint64_t row, bool isString);
+
+    S3Interface *s3Interface;
+    S3Params params;
+    ParquetScanSpec spec;
+
+    vector<ParquetSchemaColumn> schema;  // leaf columns
+    vector<ParquetRowGroup> rowGroups;
+
+    // The end of the object, read together with the footer.
+    string tailData;
+    uint64_t tailOffset;
+
+    // Parquet column of each output column, -1 if it's not needed or not in the file.
+    vector<int> outputColumns;
+
+    uint64_t curRowGroup;
+    uint64_t numSkippedRowGroups;
+    uint64_t fetchedBytes;
+
+    // Decoded values of the current row group, indexed by Parquet column.
+    vector<ParquetColumnValues> columnValues;
+    uint64_t curRow;
+    uint64_t numRows;
+
+    string outBuffer;
+    uint64_t outOffset;
+};
+
+#endif /* INCLUDE_PARQUET_READER_H_ */
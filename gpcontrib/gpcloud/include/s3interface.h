@@ -19,6 +19,7 @@ enum S3CompressionType {
     S3_COMPRESSION_GZIP,
     S3_COMPRESSION_PLAIN,
     S3_COMPRESSION_DEFLATE,
+    S3_COMPRESSION_ZSTD,
 };
 
 struct BucketContent {
@@ -6,6 +6,10 @@
 #include "s3exception.h"
 #include "s3interface.h"
 
+// Ranges are not split below this size to spread a key over the downloading threads, and the head
+// of the next key prefetched is at most this large.
+#define S3_MIN_RANGE_SIZE (8 * 1024 * 1024)
+
 struct Range {
     uint64_t offset;
     uint64_t length;
@@ -13,7 +17,7 @@ struct Range {
 
 class OffsetMgr {
    public:
-    OffsetMgr() : keySize(0), chunkSize(0), curPos(0) {
+    OffsetMgr() : keySize(0), chunkSize(0), numOfThreads(1), curPos(0) {
         pthread_mutex_init(&this->offsetLock, NULL);
     }
     ~OffsetMgr() {
@@ -38,6 +42,14 @@ class OffsetMgr {
         this->keySize = keySize;
     }
 
+    uint64_t getNumOfThreads() const {
+        return numOfThreads;
+    }
+
+    void setNumOfThreads(uint64_t numOfThreads) {
+        this->numOfThreads = numOfThreads;
+    }
+
     void setCurPos(uint64_t curPos) {
         this->curPos = curPos;
     }
@@ -46,6 +58,7 @@ class OffsetMgr {
         this->setCurPos(0);
         this->setChunkSize(0);
         this->setKeySize(0);
+        this->setNumOfThreads(1);
     }
 
     uint64_t getCurPos() const {
@@ -53,9 +66,12 @@ class OffsetMgr {
     }
 
    private:
+    uint64_t getRangeLength() const;
+
     pthread_mutex_t offsetLock;
     uint64_t keySize;  // size of S3 key(file)
     uint64_t chunkSize;
+    uint64_t numOfThreads;  // threads downloading the key
     uint64_t curPos;
 };
 
@@ -74,13 +90,20 @@ class S3KeyReader : public Reader {
           curReadingChunk(0),
           transferredKeyLen(0),
           s3Interface(NULL),
+          headData(NULL),
+          headOffset(0),
+          prefetchStarted(false),
+          nextHeadData(NULL),
           hasEol(false),
           eolAppended(false) {
         pthread_mutex_init(&this->mutexErrorMessage, NULL);
+        pthread_mutex_init(&this->prefetchLock, NULL);
     }
     virtual ~S3KeyReader() {
         this->close();
+        this->releaseNextHead();
         pthread_mutex_destroy(&this->mutexErrorMessage);
+        pthread_mutex_destroy(&this->prefetchLock);
     }
 
     void open(const S3Params& params);
@@ -140,6 +163,9 @@ class S3KeyReader : public Reader {
         return region;
     }
 
+    // Called by a downloading thread once it has nothing more to download of the current key.
+    void prefetchNextKey();
+
    private:
     pthread_mutex_t mutexErrorMessage;
 
@@ -160,7 +186,24 @@ class S3KeyReader : public Reader {
 
     S3Interface* s3Interface;
 
+    S3Params params;
+
+    // The first bytes of the current key, prefetched while the previous key was read. They are
+    // returned before the data of the chunk buffers.
+    S3VectorUInt8* headData;
+    uint64_t headOffset;
+
+    // The first bytes of the next key of the bucket reader, prefetched by one of the downloading
+    // threads once they are done with the current key. It holds the one chunk of memory the
+    // reader has besides the chunk buffers.
+    pthread_mutex_t prefetchLock;
+    bool prefetchStarted;
+    S3VectorUInt8* nextHeadData;
+    string nextHeadUrl;
+
     void reset();
+    void releaseHead();
+    void releaseNextHead();
 
     bool hasEol;
     bool eolAppended;
@@ -218,6 +261,10 @@ class ChunkBuffer {
         this->sharedKeyReader.setSharedError(sharedError, e);
     }
 
+    S3KeyReader& getKeyReader() {
+        return this->sharedKeyReader;
+    }
+
    protected:
     S3Url s3Url;
 
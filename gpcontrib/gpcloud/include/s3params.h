@@ -7,6 +7,41 @@
 
 enum S3SSEType { SSE_NONE, SSE_S3 };
 
+enum ParquetFilterOp { PARQUET_OP_LT, PARQUET_OP_LE, PARQUET_OP_EQ, PARQUET_OP_GE, PARQUET_OP_GT };
+
+// How the table column of a filter compares its values.
+enum ParquetFilterType { PARQUET_FILTER_INT, PARQUET_FILTER_STRING };
+
+// A "column op constant" qual of the query, used to skip Parquet row groups by their min/max
+// statistics. The constant is in its text form.
+struct ParquetFilter {
+    ParquetFilter(const string& column, ParquetFilterType type, ParquetFilterOp op,
+                  const string& value)
+        : column(column), type(type), op(op), value(value) {
+    }
+
+    string column;
+    ParquetFilterType type;
+    ParquetFilterOp op;
+    string value;
+};
+
+// Describes the external table a Parquet object is read into: its columns, the columns the query
+// references, and the CSV options of the table.
+struct ParquetScanSpec {
+    ParquetScanSpec() : delimiter(','), quote('"'), escape('"') {
+    }
+
+    vector<string> columns;  // names of the table columns, in order
+    vector<bool> needed;     // whether each column is referenced by the query
+    vector<ParquetFilter> filters;
+
+    char delimiter;
+    char quote;
+    char escape;
+    string nullString;
+};
+
 class S3Params {
    public:
     S3Params(const string& sourceUrl = "", bool useHttps = true, const string& version = "",
@@ -22,7 +57,10 @@ class S3Params {
           autoCompress(false),
           verifyCert(false),
           sseType(SSE_NONE),
-          gpcheckcloud_newline("") {
+          gpcheckcloud_newline(""),
+          parquet(false),
+          nextKeyUrl(""),
+          nextKeySize(0) {
     }
 
     virtual ~S3Params() {
@@ -147,6 +185,35 @@ class S3Params {
         this->gpcheckcloud_newline = gpcheckcloud_newline;
     }
 
+    bool isParquet() const {
+        return parquet;
+    }
+
+    void setParquet(bool parquet) {
+        this->parquet = parquet;
+    }
+
+    const ParquetScanSpec& getParquetScanSpec() const {
+        return parquetScanSpec;
+    }
+
+    void setParquetScanSpec(const ParquetScanSpec& parquetScanSpec) {
+        this->parquetScanSpec = parquetScanSpec;
+    }
+
+    const S3Url& getNextKeyUrl() const {
+        return nextKeyUrl;
+    }
+
+    uint64_t getNextKeySize() const {
+        return nextKeySize;
+    }
+
+    void setNextKey(const S3Url& nextKeyUrl, uint64_t nextKeySize) {
+        this->nextKeyUrl = nextKeyUrl;
+        this->nextKeySize = nextKeySize;
+    }
+
    private:
     S3Url s3Url;  // original url to read/write.
 
@@ -172,12 +239,19 @@ class S3Params {
     S3MemoryContext memoryContext;
 
     string gpcheckcloud_newline;  // newline LF, CRLF, CR
+
+    bool parquet;                     // objects are Parquet files, converted to CSV rows
+    ParquetScanSpec parquetScanSpec;  // table columns and quals for Parquet objects
+
+    S3Url nextKeyUrl;      // key to read after this one, to be prefetched
+    uint64_t nextKeySize;  // 0 if there is no next key
 };
 
 inline void PrepareS3MemContext(const S3Params& params) {
     S3MemoryContext& memoryContext = const_cast<S3MemoryContext&>(params.getMemoryContext());
 
-    // We need one more chunk of memory for writer to prepare data to upload.
+    // We need one more chunk of memory for writer to prepare data to upload, or for reader to
+    // prefetch the next key.
     memoryContext.prepare(params.getChunkSize(), params.getNumOfChunks() + 1);
 }
 
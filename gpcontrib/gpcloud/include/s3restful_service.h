@@ -39,7 +39,16 @@ class S3RESTfulService : public RESTfulService {
     uint64_t chunkBufferSize;
     S3MemoryContext s3MemContext;
 
+    // DNS entries and TLS sessions shared by all requests of this service, so the download
+    // threads of all keys skip the lookups and resume TLS sessions.
+    CURLSH* share;
+    pthread_mutex_t shareLocks[CURL_LOCK_DATA_LAST];
+
+    void initShare();
     void performCurl(CURL* curl, Response& response);
+
+    S3RESTfulService(const S3RESTfulService&);
+    S3RESTfulService& operator=(const S3RESTfulService&);
 };
 
 class S3MessageParser {
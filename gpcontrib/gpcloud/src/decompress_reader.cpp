@@ -2,28 +2,119 @@
 
 uint64_t S3_ZIP_DECOMPRESS_CHUNKSIZE = S3_ZIP_DEFAULT_CHUNKSIZE;
 
+// Decompresses a contiguous range of frames, run by each thread of a parallel batch.
+struct FrameWorker {
+    DecompressCodec codec;
+    const char *in;
+    char *out;
+    const DecompressFrame *frames;
+    uint64_t count;
+    string error;
+};
+
+static void DecompressFrames(FrameWorker *worker) {
+    // Frames that decompress to nothing (e.g. the BGZF EOF marker) still need a valid buffer.
+    char dummy;
+
+    if (worker->codec == CODEC_ZLIB) {
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        if (inflateInit2(&zs, MAX_WBITS + 16) != Z_OK) {
+            worker->error = "failed to initialize zlib library";
+            return;
+        }
+
+        for (uint64_t i = 0; i < worker->count; i++) {
+            const DecompressFrame &frame = worker->frames[i];
+
+            inflateReset(&zs);
+            zs.next_in = (Byte *)worker->in + frame.inOffset;
+            zs.avail_in = frame.inLen;
+            zs.next_out = frame.outLen ? (Byte *)worker->out + frame.outOffset : (Byte *)&dummy;
+            zs.avail_out = frame.outLen ? frame.outLen : 1;
+
+            // inflate() verifies the member's CRC32 and ISIZE for us.
+            int status = inflate(&zs, Z_FINISH);
+            if (status != Z_STREAM_END || zs.total_out != frame.outLen) {
+                worker->error = "Failed to decompress gzip block: " + std::to_string(status);
+                break;
+            }
+        }
+
+        inflateEnd(&zs);
+    }
+#ifdef USE_ZSTD
+    else if (worker->codec == CODEC_ZSTD) {
+        ZSTD_DCtx *dctx = ZSTD_createDCtx();
+        if (dctx == NULL) {
+            worker->error = "failed to initialize zstd library";
+            return;
+        }
+
+        for (uint64_t i = 0; i < worker->count; i++) {
+            const DecompressFrame &frame = worker->frames[i];
+            char *dst = frame.outLen ? worker->out + frame.outOffset : &dummy;
+
+            size_t ret = ZSTD_decompressDCtx(dctx, dst, frame.outLen, worker->in + frame.inOffset,
+                                             frame.inLen);
+            if (ZSTD_isError(ret) || ret != frame.outLen) {
+                worker->error = string("Failed to decompress zstd frame: ") +
+                                (ZSTD_isError(ret) ? ZSTD_getErrorName(ret) : "size mismatch");
+                break;
+            }
+        }
+
+        ZSTD_freeDCtx(dctx);
+    }
+#endif
+}
+
+static void *DecompressFramesThreadFunc(void *data) {
+    MaskThreadSignals();
+
+    DecompressFrames(static_cast<FrameWorker *>(data));
+
+    return NULL;
+}
+
 DecompressReader::DecompressReader() : isClosed(true) {
     this->reader = NULL;
+    this->codec = CODEC_UNKNOWN;
+#ifdef USE_ZSTD
+    this->zstdDCtx = NULL;
+#endif
     this->in = new char[S3_ZIP_DECOMPRESS_CHUNKSIZE];
     this->out = new char[S3_ZIP_DECOMPRESS_CHUNKSIZE];
+    this->inLen = 0;
+    this->inOffset = 0;
+    this->readerEOF = false;
+    this->outData = this->out;
+    this->outLen = 0;
     this->outOffset = 0;
+    this->frameDone = true;
+    this->outputFull = false;
+    this->memberEnded = false;
+    this->numThreads = 1;
 }
 
 DecompressReader::~DecompressReader() {
     this->close();
 
-    delete this->in;
-    delete this->out;
+    delete[] this->in;
+    delete[] this->out;
 }
 
 // Used for unit test to adjust buffer size
 void DecompressReader::resizeDecompressReaderBuffer(uint64_t size) {
-    delete this->in;
-    delete this->out;
+    delete[] this->in;
+    delete[] this->out;
     this->in = new char[size];
     this->out = new char[size];
+    this->inLen = 0;
+    this->inOffset = 0;
+    this->outData = this->out;
+    this->outLen = 0;
     this->outOffset = 0;
-    this->zstream.avail_out = size;
 }
 
 void DecompressReader::setReader(Reader *reader) {
@@ -36,96 +127,351 @@ void DecompressReader::open(const S3Params &params) {
     zstream.zfree = Z_NULL;
     zstream.opaque = Z_NULL;
     zstream.next_in = Z_NULL;
-    zstream.next_out = (Byte *)this->out;
-
     zstream.avail_in = 0;
-    zstream.avail_out = S3_ZIP_DECOMPRESS_CHUNKSIZE;
 
+    this->codec = CODEC_UNKNOWN;
+    this->inLen = 0;
+    this->inOffset = 0;
+    this->readerEOF = false;
+    this->outData = this->out;
+    this->outLen = 0;
     this->outOffset = 0;
+    this->frameDone = true;
+    this->outputFull = false;
+    this->memberEnded = false;
+
+    // Frames are decompressed by as many threads as there are download threads.
+    this->numThreads = std::max(params.getNumOfChunks(), (uint64_t)1);
 
     // with S3_INFLATE_WINDOWSBITS, it could recognize and decode both zlib and gzip stream.
     int ret = inflateInit2(&zstream, S3_INFLATE_WINDOWSBITS);
     S3_CHECK_OR_DIE(ret == Z_OK, S3RuntimeError, "failed to initialize zlib library");
 
+#ifdef USE_ZSTD
+    this->zstdDCtx = ZSTD_createDCtx();
+    S3_CHECK_OR_DIE(this->zstdDCtx != NULL, S3RuntimeError, "failed to initialize zstd library");
+#endif
+
     this->isClosed = false;
 
     this->reader->open(params);
 }
 
 uint64_t DecompressReader::read(char *buf, uint64_t bufSize) {
-    uint64_t remainingOutLen = this->getDecompressedBytesNum() - this->outOffset;
-
-    if (remainingOutLen == 0) {
-        this->decompress();
-        this->outOffset = 0;  // reset cursor for out buffer to read from beginning.
-        remainingOutLen = this->getDecompressedBytesNum();
+    while (this->outOffset == this->outLen) {
+        if (!this->decompress()) {
+            return 0;
+        }
     }
 
-    uint64_t count = std::min(remainingOutLen, bufSize);
-    memcpy(buf, this->out + outOffset, count);
+    uint64_t count = std::min(this->outLen - this->outOffset, bufSize);
+    memcpy(buf, this->outData + this->outOffset, count);
 
     this->outOffset += count;
 
     return count;
 }
 
-// Read compressed data from underlying reader and decompress to this->out buffer.
-// If no more data to consume, this->zstream.avail_out == S3_ZIP_DECOMPRESS_CHUNKSIZE;
-void DecompressReader::decompress() {
-    if (this->zstream.avail_in == 0) {
-        this->zstream.avail_out = S3_ZIP_DECOMPRESS_CHUNKSIZE;
-        this->zstream.next_out = (Byte *)this->out;
-
-        // read S3_ZIP_DECOMPRESS_CHUNKSIZE data from underlying reader and put into this->in
-        // buffer. read() might happen more than once when reaching EOF, make sure every time read()
-        // will return 0.
-        uint64_t hasRead = this->reader->read(this->in, S3_ZIP_DECOMPRESS_CHUNKSIZE);
-
-        // EOF, no more data to decompress.
-        if (hasRead == 0) {
-            S3DEBUG(
-                "No more data to decompress: avail_in = %u, avail_out = %u, total_in = %u, "
-                "total_out = %u",
-                zstream.avail_in, zstream.avail_out,
-		(unsigned int) zstream.total_in, (unsigned int) zstream.total_out);
-            return;
+// Move unconsumed input to the front of this->in and fill the rest from the underlying reader.
+// Return the number of bytes read.
+uint64_t DecompressReader::fillInBuffer() {
+    if (this->inOffset > 0) {
+        memmove(this->in, this->in + this->inOffset, this->inLen - this->inOffset);
+        this->inLen -= this->inOffset;
+        this->inOffset = 0;
+    }
+
+    // Fill this->in as possible as it could, otherwise data in this->in might not be able to be
+    // inflated.
+    uint64_t hasRead = 0;
+    while (!this->readerEOF && this->inLen < S3_ZIP_DECOMPRESS_CHUNKSIZE) {
+        uint64_t count =
+            this->reader->read(this->in + this->inLen, S3_ZIP_DECOMPRESS_CHUNKSIZE - this->inLen);
+
+        if (count == 0) {
+            this->readerEOF = true;
+            break;
         }
 
-        // Fill this->in as possible as it could, otherwise data in this->in might not be able to be
-        // inflated.
-        while (hasRead < S3_ZIP_DECOMPRESS_CHUNKSIZE) {
-            uint64_t count =
-                this->reader->read(this->in + hasRead, S3_ZIP_DECOMPRESS_CHUNKSIZE - hasRead);
+        this->inLen += count;
+        hasRead += count;
+    }
 
-            if (count == 0) {
-                break;
-            }
+    return hasRead;
+}
+
+// Decompress the next piece of data into this->outData. Return false if there is no more data to
+// decompress. The result may be empty, e.g. when only a header was consumed.
+bool DecompressReader::decompress() {
+    this->outData = this->out;
+    this->outLen = 0;
+    this->outOffset = 0;
 
-            hasRead += count;
+    // Read more input once the 'in' buffer is consumed. At EOF, a decoder that filled the output
+    // buffer last time may still hold output, so give it one more round to drain.
+    if (this->inOffset == this->inLen) {
+        if (this->fillInBuffer() == 0 && !this->outputFull) {
+            S3DEBUG("No more data to decompress: total_in = %u, total_out = %u",
+                    (unsigned int)zstream.total_in, (unsigned int)zstream.total_out);
+            S3_CHECK_OR_DIE(this->codec != CODEC_ZSTD || this->frameDone, S3RuntimeError,
+                            "Failed to decompress data: truncated zstd frame");
+            return false;
         }
+    }
+
+    if (this->codec == CODEC_UNKNOWN) {
+        const unsigned char *p = (const unsigned char *)this->in + this->inOffset;
 
-        this->zstream.next_in = (Byte *)this->in;
-        this->zstream.avail_in = hasRead;
-    } else {
-        // Still have more data in 'in' buffer to decode.
-        this->zstream.avail_out = S3_ZIP_DECOMPRESS_CHUNKSIZE;
-        this->zstream.next_out = (Byte *)this->out;
+        if (this->inLen - this->inOffset >= 4 && p[0] == 0x28 && p[1] == 0xb5 && p[2] == 0x2f &&
+            p[3] == 0xfd) {
+#ifdef USE_ZSTD
+            this->codec = CODEC_ZSTD;
+#else
+            S3_DIE(S3RuntimeError, "zstd compressed data is not supported by this build");
+#endif
+        } else {
+            this->codec = CODEC_ZLIB;
+        }
     }
 
+    if (this->frameDone && this->numThreads > 1 && this->decompressFrames()) {
+        return true;
+    }
+
+#ifdef USE_ZSTD
+    if (this->codec == CODEC_ZSTD) {
+        this->decompressZstdChunk();
+        return true;
+    }
+#endif
+
+    this->inflateChunk();
+    return true;
+}
+
+// Streaming decompression of this->in into this->out with zlib.
+void DecompressReader::inflateChunk() {
+    // Like gzip, ignore zero bytes padding the end of a file (e.g. to a tape block) instead of
+    // taking them for the header of another member.
+    if (this->frameDone && this->memberEnded) {
+        while (this->inOffset < this->inLen && this->in[this->inOffset] == '\0') {
+            this->inOffset++;
+        }
+
+        if (this->inOffset == this->inLen) {
+            this->outputFull = false;
+            return;
+        }
+    }
+
+    this->zstream.next_in = (Byte *)this->in + this->inOffset;
+    this->zstream.avail_in = this->inLen - this->inOffset;
+    this->zstream.next_out = (Byte *)this->out;
+    this->zstream.avail_out = S3_ZIP_DECOMPRESS_CHUNKSIZE;
+
     int status = inflate(&this->zstream, Z_NO_FLUSH);
+
+    this->inOffset = this->inLen - this->zstream.avail_in;
+    this->outLen = S3_ZIP_DECOMPRESS_CHUNKSIZE - this->zstream.avail_out;
+    this->outputFull = (this->zstream.avail_out == 0);
+    this->frameDone = false;
+
     if (status == Z_STREAM_END) {
+        // A gzip file may consist of several members (pigz, bgzip, or simply concatenated .gz
+        // files), start over for the next one instead of stopping at the first.
         S3DEBUG("Decompression finished: Z_STREAM_END.");
+        inflateReset(&this->zstream);
+        this->frameDone = true;
+        this->memberEnded = true;
+    } else if (status == Z_BUF_ERROR) {
+        // No progress possible, more input is needed.
     } else if (status < 0 || status == Z_NEED_DICT) {
-        inflateEnd(&this->zstream);
         S3_CHECK_OR_DIE(
             false, S3RuntimeError,
             string("Failed to decompress data: ") + std::to_string((unsigned long long)status));
     }
 }
 
+#ifdef USE_ZSTD
+// Streaming decompression of this->in into this->out with zstd. Multiple frames are decoded one
+// after another by the same context.
+void DecompressReader::decompressZstdChunk() {
+    ZSTD_inBuffer input = {this->in, this->inLen, this->inOffset};
+    ZSTD_outBuffer output = {this->out, S3_ZIP_DECOMPRESS_CHUNKSIZE, 0};
+
+    size_t ret = ZSTD_decompressStream(this->zstdDCtx, &output, &input);
+    S3_CHECK_OR_DIE(!ZSTD_isError(ret), S3RuntimeError,
+                    string("Failed to decompress data: ") + ZSTD_getErrorName(ret));
+
+    this->inOffset = input.pos;
+    this->outLen = output.pos;
+    this->outputFull = (output.pos == output.size);
+    this->frameDone = (ret == 0);
+}
+#endif
+
+// Check whether a complete frame with known compressed and decompressed size starts at 'offset'
+// of this->in, and describe it in 'frame'.
+bool DecompressReader::findFrame(uint64_t offset, DecompressFrame &frame) {
+    const unsigned char *p = (const unsigned char *)this->in + offset;
+    uint64_t avail = this->inLen - offset;
+
+    if (this->codec == CODEC_ZLIB) {
+        // BGZF: a gzip member whose 'BC' extra subfield holds the member size minus one, and
+        // whose trailer ends with the decompressed size.
+        if (avail < 18 || p[0] != 0x1f || p[1] != 0x8b || p[2] != 8 || !(p[3] & 4)) {
+            return false;
+        }
+
+        uint64_t xlen = p[10] | (p[11] << 8);
+        if (avail < 12 + xlen) {
+            return false;
+        }
+
+        uint64_t blockSize = 0;
+        for (uint64_t i = 12; i + 4 <= 12 + xlen;) {
+            uint64_t slen = p[i + 2] | (p[i + 3] << 8);
+            if (p[i] == 'B' && p[i + 1] == 'C' && slen == 2 && i + 6 <= 12 + xlen) {
+                blockSize = (p[i + 4] | (p[i + 5] << 8)) + 1;
+                break;
+            }
+            i += 4 + slen;
+        }
+
+        if (blockSize < 12 + xlen + 8 || blockSize > avail) {
+            return false;
+        }
+
+        const unsigned char *trailer = p + blockSize - 4;
+        frame.inLen = blockSize;
+        frame.outLen = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) |
+                       ((uint64_t)trailer[3] << 24);
+    }
+#ifdef USE_ZSTD
+    else if (this->codec == CODEC_ZSTD) {
+        // Frames written by pzstd or the seekable format record their content size.
+        size_t inLen = ZSTD_findFrameCompressedSize(p, avail);
+        if (ZSTD_isError(inLen)) {
+            return false;
+        }
+
+        unsigned long long outLen = ZSTD_getFrameContentSize(p, avail);
+        if (outLen == ZSTD_CONTENTSIZE_UNKNOWN || outLen == ZSTD_CONTENTSIZE_ERROR) {
+            return false;
+        }
+
+        frame.inLen = inLen;
+        frame.outLen = outLen;
+    }
+#endif
+    else {
+        return false;
+    }
+
+    frame.inOffset = offset;
+    return true;
+}
+
+// Decompress as many complete frames at the head of this->in as fit into one batch, spreading
+// them over up to numThreads threads, and leave the output in order in this->frameOut.
+// Return false if the input does not consist of such frames; the caller then falls back to
+// streaming decompression, which handles any frame on its own.
+bool DecompressReader::decompressFrames() {
+    DecompressFrame frame;
+
+    if (!this->findFrame(this->inOffset, frame)) {
+        // Top up the input only if it may be a frame that just isn't fully buffered yet.
+        const unsigned char *p = (const unsigned char *)this->in + this->inOffset;
+        uint64_t avail = this->inLen - this->inOffset;
+        bool maybeFrame = avail >= 4 && ((this->codec == CODEC_ZLIB && p[0] == 0x1f &&
+                                          p[1] == 0x8b && (p[3] & 4)) ||
+                                         this->codec == CODEC_ZSTD);
+
+        if (!maybeFrame || this->readerEOF || this->fillInBuffer() == 0 ||
+            !this->findFrame(this->inOffset, frame)) {
+            return false;
+        }
+    }
+
+    this->frames.clear();
+
+    uint64_t offset = this->inOffset;
+    uint64_t outTotal = 0;
+    while (offset < this->inLen && this->findFrame(offset, frame)) {
+        if (outTotal + frame.outLen > S3_FRAME_BATCH_MAX_OUTPUT) {
+            break;
+        }
+
+        frame.outOffset = outTotal;
+        this->frames.push_back(frame);
+
+        offset += frame.inLen;
+        outTotal += frame.outLen;
+    }
+
+    // A lone frame gains nothing from a thread, stream it instead.
+    if (this->frames.size() < 2) {
+        return false;
+    }
+
+    if (this->frameOut.size() < outTotal) {
+        this->frameOut.resize(outTotal);
+    }
+
+    uint64_t numWorkers = std::min(this->numThreads, (uint64_t)this->frames.size());
+    vector<FrameWorker> workers(numWorkers);
+    vector<pthread_t> threads(numWorkers, 0);
+
+    for (uint64_t i = 0; i < numWorkers; i++) {
+        uint64_t begin = this->frames.size() * i / numWorkers;
+        uint64_t end = this->frames.size() * (i + 1) / numWorkers;
+
+        workers[i].codec = this->codec;
+        workers[i].in = this->in;
+        workers[i].out = this->frameOut.data();
+        workers[i].frames = &this->frames[begin];
+        workers[i].count = end - begin;
+    }
+
+    // The current thread takes the first range itself.
+    for (uint64_t i = 1; i < numWorkers; i++) {
+        if (pthread_create(&threads[i], NULL, DecompressFramesThreadFunc, &workers[i]) != 0) {
+            threads[i] = 0;
+            DecompressFrames(&workers[i]);
+        }
+    }
+
+    DecompressFrames(&workers[0]);
+
+    for (uint64_t i = 1; i < numWorkers; i++) {
+        if (threads[i] != 0) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    for (uint64_t i = 0; i < numWorkers; i++) {
+        S3_CHECK_OR_DIE(workers[i].error.empty(), S3RuntimeError, workers[i].error);
+    }
+
+    S3DEBUG("Decompressed %zu frames (%" PRIu64 " bytes) with %" PRIu64 " threads",
+            this->frames.size(), outTotal, numWorkers);
+
+    this->inOffset = offset;
+    this->outData = this->frameOut.data();
+    this->outLen = outTotal;
+    this->outputFull = false;
+    this->memberEnded = (this->codec == CODEC_ZLIB);
+
+    return true;
+}
+
 void DecompressReader::close() {
     if (!this->isClosed) {
         inflateEnd(&zstream);
+#ifdef USE_ZSTD
+        ZSTD_freeDCtx(this->zstdDCtx);
+        this->zstdDCtx = NULL;
+#endif
         this->reader->close();
         this->isClosed = true;
     }
@@ -15,12 +15,18 @@ extern "C" {
 #include "access/extprotocol.h"
 #include "access/xact.h"
 #include "catalog/pg_proc.h"
+#include "catalog/pg_type.h"
 #include "commands/defrem.h"
 #include "fmgr.h"
 #include "funcapi.h"
+#include "nodes/execnodes.h"
+#include "nodes/nodeFuncs.h"
 #include "utils/array.h"
 #include "utils/builtins.h"
+#include "utils/guc.h"
+#include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/pg_locale.h"
 #include "utils/resowner.h"
 
 #ifdef __clang__
@@ -169,6 +175,171 @@ static void parseFormatOpts(FunctionCallInfo fcinfo) {
     }
 }
 
+/*
+ * Collect the attribute numbers of the Vars in an expression, a whole-row Var
+ * stands for all of them.
+ */
+static bool collectVarAttnos(Node *node, Bitmapset **attnos) {
+    if (node == NULL) return false;
+
+    if (IsA(node, Var)) {
+        Var *var = (Var *)node;
+
+        if (var->varlevelsup == 0) {
+            if (var->varattno == InvalidAttrNumber)
+                *attnos = bms_add_member(*attnos, 0);
+            else if (var->varattno > 0)
+                *attnos = bms_add_member(*attnos, var->varattno);
+        }
+        return false;
+    }
+
+    return expression_tree_walker(node, (bool (*)())collectVarAttnos, (void *)attnos);
+}
+
+/*
+ * Turn a "column op constant" qual into a filter the Parquet reader can check
+ * against row group statistics. Only integer columns, and text columns compared
+ * with C collation, match how Parquet orders the statistics.
+ */
+static bool qualToParquetFilter(Node *qual, TupleDesc tupdesc, ParquetFilterType &type,
+                                ParquetFilterOp &op, string &column, string &value) {
+    if (!IsA(qual, OpExpr) || list_length(((OpExpr *)qual)->args) != 2) return false;
+
+    OpExpr *opexpr = (OpExpr *)qual;
+    Node *left = (Node *)linitial(opexpr->args);
+    Node *right = (Node *)lsecond(opexpr->args);
+    bool commuted = false;
+
+    if (IsA(left, RelabelType)) left = (Node *)((RelabelType *)left)->arg;
+    if (IsA(right, RelabelType)) right = (Node *)((RelabelType *)right)->arg;
+
+    if (IsA(left, Const) && IsA(right, Var)) {
+        Node *tmp = left;
+        left = right;
+        right = tmp;
+        commuted = true;
+    }
+    if (!IsA(left, Var) || !IsA(right, Const)) return false;
+
+    Var *var = (Var *)left;
+    Const *cnst = (Const *)right;
+    if (var->varlevelsup != 0 || var->varattno <= 0 || var->varattno > tupdesc->natts ||
+        cnst->constisnull)
+        return false;
+
+    Form_pg_attribute attr = TupleDescAttr(tupdesc, var->varattno - 1);
+    switch (attr->atttypid) {
+        case INT2OID:
+        case INT4OID:
+        case INT8OID:
+            if (cnst->consttype != INT2OID && cnst->consttype != INT4OID &&
+                cnst->consttype != INT8OID)
+                return false;
+            type = PARQUET_FILTER_INT;
+            break;
+        case TEXTOID:
+        case VARCHAROID:
+            if ((cnst->consttype != TEXTOID && cnst->consttype != VARCHAROID) ||
+                !lc_collate_is_c(opexpr->inputcollid))
+                return false;
+            type = PARQUET_FILTER_STRING;
+            break;
+        default:
+            return false;
+    }
+
+    char *opname = get_opname(opexpr->opno);
+    if (opname == NULL) return false;
+
+    if (strcmp(opname, "=") == 0)
+        op = PARQUET_OP_EQ;
+    else if (strcmp(opname, "<") == 0)
+        op = commuted ? PARQUET_OP_GT : PARQUET_OP_LT;
+    else if (strcmp(opname, "<=") == 0)
+        op = commuted ? PARQUET_OP_GE : PARQUET_OP_LE;
+    else if (strcmp(opname, ">=") == 0)
+        op = commuted ? PARQUET_OP_LE : PARQUET_OP_GE;
+    else if (strcmp(opname, ">") == 0)
+        op = commuted ? PARQUET_OP_LT : PARQUET_OP_GT;
+    else
+        return false;
+
+    Oid typoutput;
+    bool typisvarlena;
+    getTypeOutputInfo(cnst->consttype, &typoutput, &typisvarlena);
+
+    column = NameStr(attr->attname);
+    value = OidOutputFunctionCall(typoutput, cnst->constvalue);
+    return true;
+}
+
+/*
+ * Describe the external table to the Parquet reader: the columns, which of
+ * them the query references, the pushed-down quals, and the CSV options the
+ * rows must be formatted with.
+ */
+static void buildParquetScanSpec(FunctionCallInfo fcinfo, ParquetScanSpec &spec) {
+    Relation rel = EXTPROTOCOL_GET_RELATION(fcinfo);
+    ExtTableEntry *exttbl = GetExtTableEntry(rel->rd_id);
+    ExternalSelectDesc desc = EXTPROTOCOL_GET_EXTERNAL_SELECT_DESC(fcinfo);
+    TupleDesc tupdesc = RelationGetDescr(rel);
+    Bitmapset *attnos = NULL;
+    bool allNeeded = true;
+    ListCell *lc;
+
+    if (!fmttype_is_csv(exttbl->fmtcode))
+        ereport(ERROR, errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                errmsg("gpcloud reads Parquet files only into tables of FORMAT 'CSV'"));
+
+    foreach (lc, exttbl->options) {
+        DefElem *defel = (DefElem *)lfirst(lc);
+
+        if (strcmp(defel->defname, "delimiter") == 0)
+            spec.delimiter = defGetString(defel)[0];
+        else if (strcmp(defel->defname, "quote") == 0)
+            spec.quote = defGetString(defel)[0];
+        else if (strcmp(defel->defname, "escape") == 0)
+            spec.escape = defGetString(defel)[0];
+        else if (strcmp(defel->defname, "null") == 0)
+            spec.nullString = defGetString(defel);
+        else if (strcmp(defel->defname, "header") == 0 && defGetBoolean(defel))
+            // The rows converted from Parquet have no header line, the first one would be lost.
+            ereport(ERROR, errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                    errmsg("gpcloud doesn't support HEADER for Parquet files"));
+    }
+
+    /*
+     * Without the quals, which are only passed when filter pushdown is enabled,
+     * we can't tell which columns they reference.
+     */
+    if (desc != NULL && desc->projInfo != NULL && gp_external_enable_filter_pushdown) {
+        collectVarAttnos((Node *)desc->projInfo->pi_state.expr, &attnos);
+        collectVarAttnos((Node *)desc->filter_quals, &attnos);
+        allNeeded = bms_is_member(0, attnos);
+    }
+
+    for (int i = 0; i < tupdesc->natts; i++) {
+        Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+
+        if (attr->attisdropped) continue;
+
+        spec.columns.push_back(NameStr(attr->attname));
+        spec.needed.push_back(allNeeded || bms_is_member(attr->attnum, attnos));
+    }
+
+    if (desc != NULL) {
+        foreach (lc, desc->filter_quals) {
+            ParquetFilterType type;
+            ParquetFilterOp op;
+            string column, value;
+
+            if (qualToParquetFilter((Node *)lfirst(lc), tupdesc, type, op, column, value))
+                spec.filters.push_back(ParquetFilter(column, type, op, value));
+        }
+    }
+}
+
 typedef struct gpcloudResHandle {
     GPReader *gpreader;
     GPWriter *gpwriter;
@@ -292,9 +463,15 @@ Datum s3_import(PG_FUNCTION_ARGS) {
         // has HEADER? and newline EOL?
         parseFormatOpts(fcinfo);
 
+        ParquetScanSpec scanSpec;
+        bool parquet = (GetOptS3(url_with_options, "format") == "parquet");
+        if (parquet) {
+            buildParquetScanSpec(fcinfo, scanSpec);
+        }
+
         thread_setup();
 
-        resHandle->gpreader = reader_init(url_with_options);
+        resHandle->gpreader = reader_init(url_with_options, parquet ? &scanSpec : NULL);
         if (!resHandle->gpreader) {
             ereport(ERROR, errmsg("Failed to init gpcloud extension (segid = %d, "
 				  "segnum = %d), please check your "
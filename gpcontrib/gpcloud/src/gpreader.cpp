@@ -66,8 +66,13 @@ GPReader::GPReader(const S3Params& params)
 void GPReader::open(const S3Params& params) {
     this->s3InterfaceService.setRESTfulService(this->restfulServicePtr);
     this->bucketReader.setS3InterfaceService(&this->s3InterfaceService);
-    this->bucketReader.setUpstreamReader(&this->commonReader);
-    this->commonReader.setS3InterfaceService(&this->s3InterfaceService);
+    if (this->params.isParquet()) {
+        this->bucketReader.setUpstreamReader(&this->parquetReader);
+        this->parquetReader.setS3InterfaceService(&this->s3InterfaceService);
+    } else {
+        this->bucketReader.setUpstreamReader(&this->commonReader);
+        this->commonReader.setS3InterfaceService(&this->s3InterfaceService);
+    }
     this->bucketReader.open(this->params);
 }
 
@@ -83,7 +88,7 @@ void GPReader::close() {
 }
 
 // invoked by s3_import(), need to be exception safe
-GPReader* reader_init(const char* url_with_options) {
+GPReader* reader_init(const char* url_with_options, const ParquetScanSpec* scanSpec) {
     GPReader* reader = NULL;
     s3extErrorMessage.clear();
 
@@ -95,6 +100,9 @@ GPReader* reader_init(const char* url_with_options) {
         string urlWithOptions(url_with_options);
 
         S3Params params = InitConfig(urlWithOptions);
+        if (scanSpec != NULL) {
+            params.setParquetScanSpec(*scanSpec);
+        }
 
         InitRemoteLog();
 
@@ -77,6 +77,9 @@ GPWriter* writer_init(const char* url_with_options, const char* format) {
 
         InitRemoteLog();
 
+        S3_CHECK_OR_DIE(!params.isParquet(), S3ConfigError,
+                        "\"FATAL: format 'parquet' is only supported for reading\"", "format");
+
         // Prepare memory to be used for thread chunk buffer.
         PrepareS3MemContext(params);
 
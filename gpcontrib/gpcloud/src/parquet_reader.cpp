@@ -0,0 +1,1752 @@
+#include "parquet_reader.h"
+#include "gpcommon.h"
+#include "s3log.h"
+
+#include <errno.h>
+#include <strings.h>
+
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+// Parquet physical types
+enum {
+    PARQUET_BOOLEAN = 0,
+    PARQUET_INT32 = 1,
+    PARQUET_INT64 = 2,
+    PARQUET_INT96 = 3,
+    PARQUET_FLOAT = 4,
+    PARQUET_DOUBLE = 5,
+    PARQUET_BYTE_ARRAY = 6,
+    PARQUET_FIXED_LEN_BYTE_ARRAY = 7,
+};
+
+// Parquet converted (legacy logical) types we care about
+enum {
+    PARQUET_CONVERTED_UTF8 = 0,
+    PARQUET_CONVERTED_ENUM = 4,
+    PARQUET_CONVERTED_DECIMAL = 5,
+    PARQUET_CONVERTED_DATE = 6,
+    PARQUET_CONVERTED_TIMESTAMP_MILLIS = 9,
+    PARQUET_CONVERTED_TIMESTAMP_MICROS = 10,
+    PARQUET_CONVERTED_UINT_8 = 11,
+    PARQUET_CONVERTED_UINT_64 = 14,
+    PARQUET_CONVERTED_INT_8 = 15,
+    PARQUET_CONVERTED_INT_64 = 18,
+    PARQUET_CONVERTED_JSON = 19,
+};
+
+enum { PARQUET_REQUIRED = 0, PARQUET_OPTIONAL = 1, PARQUET_REPEATED = 2 };
+
+enum {
+    PARQUET_CODEC_UNCOMPRESSED = 0,
+    PARQUET_CODEC_SNAPPY = 1,
+    PARQUET_CODEC_GZIP = 2,
+    PARQUET_CODEC_ZSTD = 6,
+};
+
+enum {
+    PARQUET_ENCODING_PLAIN = 0,
+    PARQUET_ENCODING_PLAIN_DICTIONARY = 2,
+    PARQUET_ENCODING_RLE = 3,
+    PARQUET_ENCODING_RLE_DICTIONARY = 8,
+};
+
+enum {
+    PARQUET_PAGE_DATA = 0,
+    PARQUET_PAGE_INDEX = 1,
+    PARQUET_PAGE_DICTIONARY = 2,
+    PARQUET_PAGE_DATA_V2 = 3,
+};
+
+// Thrift compact protocol types
+enum {
+    THRIFT_STOP = 0,
+    THRIFT_TRUE = 1,
+    THRIFT_FALSE = 2,
+    THRIFT_BYTE = 3,
+    THRIFT_I16 = 4,
+    THRIFT_I32 = 5,
+    THRIFT_I64 = 6,
+    THRIFT_DOUBLE = 7,
+    THRIFT_BINARY = 8,
+    THRIFT_LIST = 9,
+    THRIFT_SET = 10,
+    THRIFT_MAP = 11,
+    THRIFT_STRUCT = 12,
+};
+
+#define THRIFT_MAX_DEPTH 64
+
+// Decimals are read into an __int128, which holds any 38 digit number.
+#define PARQUET_MAX_DECIMAL_PRECISION 38
+
+#define PARQUET_DIE(_msg) S3_DIE(S3RuntimeError, string("invalid Parquet file: ") + (_msg))
+
+static inline uint32_t readLE32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t readLE64(const uint8_t *p) {
+    return (uint64_t)readLE32(p) | ((uint64_t)readLE32(p + 4) << 32);
+}
+
+// Decoder of the Thrift compact protocol, just enough for Parquet metadata.
+class ThriftCompactReader {
+   public:
+    ThriftCompactReader(const uint8_t *data, uint64_t len)
+        : data(data), len(len), pos(0), lastFieldId(0) {
+    }
+
+    uint64_t position() const {
+        return pos;
+    }
+
+    void structBegin() {
+        S3_CHECK_OR_DIE(fieldIdStack.size() < THRIFT_MAX_DEPTH, S3RuntimeError,
+                        "invalid Parquet file: metadata nested too deep");
+        fieldIdStack.push_back(lastFieldId);
+        lastFieldId = 0;
+    }
+
+    void structEnd() {
+        lastFieldId = fieldIdStack.back();
+        fieldIdStack.pop_back();
+    }
+
+    // Read the header of the next field in current struct, return false at the end of struct.
+    bool readFieldBegin(uint8_t &type, int16_t &id) {
+        uint8_t byte = readByte();
+
+        type = byte & 0x0f;
+        if (type == THRIFT_STOP) {
+            return false;
+        }
+
+        uint8_t delta = byte >> 4;
+        id = (delta == 0) ? (int16_t)readZigzag() : (int16_t)(lastFieldId + delta);
+        lastFieldId = id;
+        return true;
+    }
+
+    void readListBegin(uint8_t &elemType, uint32_t &size) {
+        uint8_t byte = readByte();
+
+        elemType = byte & 0x0f;
+        size = byte >> 4;
+        if (size == 15) {
+            size = (uint32_t)readVarint();
+        }
+    }
+
+    // Booleans of struct fields are encoded in the field type.
+    bool getBool(uint8_t type) const {
+        return type == THRIFT_TRUE;
+    }
+
+    int32_t readI32() {
+        return (int32_t)readZigzag();
+    }
+
+    int64_t readI64() {
+        return readZigzag();
+    }
+
+    void readBinary(string &out) {
+        uint64_t size = readVarint();
+        S3_CHECK_OR_DIE(size <= len - pos, S3RuntimeError,
+                        "invalid Parquet file: truncated metadata");
+        out.assign((const char *)data + pos, size);
+        pos += size;
+    }
+
+    void skip(uint8_t type, int depth = 0) {
+        S3_CHECK_OR_DIE(depth < THRIFT_MAX_DEPTH, S3RuntimeError,
+                        "invalid Parquet file: metadata nested too deep");
+
+        switch (type) {
+            case THRIFT_TRUE:
+            case THRIFT_FALSE:
+                break;
+            case THRIFT_BYTE:
+                readByte();
+                break;
+            case THRIFT_I16:
+            case THRIFT_I32:
+            case THRIFT_I64:
+                readVarint();
+                break;
+            case THRIFT_DOUBLE:
+                advance(8);
+                break;
+            case THRIFT_BINARY:
+                advance(readVarint());
+                break;
+            case THRIFT_LIST:
+            case THRIFT_SET: {
+                uint8_t elemType;
+                uint32_t size;
+                readListBegin(elemType, size);
+                for (uint32_t i = 0; i < size; i++) {
+                    skipElement(elemType, depth + 1);
+                }
+                break;
+            }
+            case THRIFT_MAP: {
+                uint64_t size = readVarint();
+                if (size > 0) {
+                    uint8_t types = readByte();
+                    for (uint64_t i = 0; i < size; i++) {
+                        skipElement(types >> 4, depth + 1);
+                        skipElement(types & 0x0f, depth + 1);
+                    }
+                }
+                break;
+            }
+            case THRIFT_STRUCT: {
+                uint8_t fieldType;
+                int16_t fieldId;
+
+                structBegin();
+                while (readFieldBegin(fieldType, fieldId)) {
+                    skip(fieldType, depth + 1);
+                }
+                structEnd();
+                break;
+            }
+            default:
+                PARQUET_DIE("unknown thrift type in metadata");
+        }
+    }
+
+   private:
+    // Booleans in containers take one byte.
+    void skipElement(uint8_t type, int depth) {
+        if (type == THRIFT_TRUE || type == THRIFT_FALSE) {
+            readByte();
+        } else {
+            skip(type, depth);
+        }
+    }
+
+    uint8_t readByte() {
+        S3_CHECK_OR_DIE(pos < len, S3RuntimeError, "invalid Parquet file: truncated metadata");
+        return data[pos++];
+    }
+
+    void advance(uint64_t n) {
+        S3_CHECK_OR_DIE(n <= len - pos, S3RuntimeError, "invalid Parquet file: truncated metadata");
+        pos += n;
+    }
+
+    uint64_t readVarint() {
+        uint64_t result = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = readByte();
+            result |= (uint64_t)(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return result;
+            }
+        }
+        PARQUET_DIE("bad varint in metadata");
+    }
+
+    int64_t readZigzag() {
+        uint64_t n = readVarint();
+        return (int64_t)(n >> 1) ^ -(int64_t)(n & 1);
+    }
+
+    const uint8_t *data;
+    uint64_t len;
+    uint64_t pos;
+
+    int16_t lastFieldId;
+    vector<int16_t> fieldIdStack;
+};
+
+static void checkFieldType(uint8_t type, uint8_t expected) {
+    S3_CHECK_OR_DIE(type == expected, S3RuntimeError,
+                    "invalid Parquet file: unexpected field type in metadata");
+}
+
+static int64_t timeUnitsPerSecond(ThriftCompactReader &tr) {
+    uint8_t type;
+    int16_t id;
+    int64_t units = 0;
+
+    // TimeUnit is a union of empty structs: MILLIS, MICROS, NANOS.
+    tr.structBegin();
+    while (tr.readFieldBegin(type, id)) {
+        if (id == 1) {
+            units = 1000;
+        } else if (id == 2) {
+            units = 1000000;
+        } else if (id == 3) {
+            units = 1000000000;
+        }
+        tr.skip(type);
+    }
+    tr.structEnd();
+
+    return units;
+}
+
+static void parseLogicalType(ThriftCompactReader &tr, ParquetSchemaColumn &column) {
+    uint8_t type;
+    int16_t id;
+
+    tr.structBegin();
+    while (tr.readFieldBegin(type, id)) {
+        if (type != THRIFT_STRUCT) {
+            tr.skip(type);
+            continue;
+        }
+
+        switch (id) {
+            case 1:  // STRING
+            case 4:  // ENUM
+            case 12: // JSON
+                column.kind = PARQUET_VALUE_STRING;
+                tr.skip(type);
+                break;
+            case 5:  // DECIMAL, scale and precision are also in the SchemaElement
+                column.kind = PARQUET_VALUE_DECIMAL;
+                tr.skip(type);
+                break;
+            case 6:  // DATE
+                column.kind = PARQUET_VALUE_DATE;
+                tr.skip(type);
+                break;
+            case 8: {  // TIMESTAMP
+                uint8_t fieldType;
+                int16_t fieldId;
+
+                column.kind = PARQUET_VALUE_TIMESTAMP;
+                tr.structBegin();
+                while (tr.readFieldBegin(fieldType, fieldId)) {
+                    if (fieldId == 1 && (fieldType == THRIFT_TRUE || fieldType == THRIFT_FALSE)) {
+                        column.adjustedToUTC = tr.getBool(fieldType);
+                    } else if (fieldId == 2 && fieldType == THRIFT_STRUCT) {
+                        column.timeUnitsPerSecond = timeUnitsPerSecond(tr);
+                    } else {
+                        tr.skip(fieldType);
+                    }
+                }
+                tr.structEnd();
+                break;
+            }
+            case 10: {  // INTEGER
+                uint8_t fieldType;
+                int16_t fieldId;
+
+                tr.structBegin();
+                while (tr.readFieldBegin(fieldType, fieldId)) {
+                    if (fieldId == 2 && fieldType == THRIFT_FALSE) {
+                        column.kind = PARQUET_VALUE_UNSIGNED;
+                    }
+                    tr.skip(fieldType);
+                }
+                tr.structEnd();
+                break;
+            }
+            default:
+                tr.skip(type);
+                break;
+        }
+    }
+    tr.structEnd();
+}
+
+static void parseSchemaElement(ThriftCompactReader &tr, ParquetSchemaColumn &column) {
+    uint8_t type;
+    int16_t id;
+    bool hasLogicalType = false;
+
+    tr.structBegin();
+    while (tr.readFieldBegin(type, id)) {
+        switch (id) {
+            case 1:
+                checkFieldType(type, THRIFT_I32);
+                column.type = tr.readI32();
+                break;
+            case 2:
+                checkFieldType(type, THRIFT_I32);
+                column.typeLength = tr.readI32();
+                break;
+            case 3:
+                checkFieldType(type, THRIFT_I32);
+                column.repetition = tr.readI32();
+                break;
+            case 4:
+                checkFieldType(type, THRIFT_BINARY);
+                tr.readBinary(column.name);
+                break;
+            case 5:
+                checkFieldType(type, THRIFT_I32);
+                column.numChildren = tr.readI32();
+                break;
+            case 6:
+                checkFieldType(type, THRIFT_I32);
+                column.convertedType = tr.readI32();
+                break;
+            case 7:
+                checkFieldType(type, THRIFT_I32);
+                column.scale = tr.readI32();
+                break;
+            case 8:
+                checkFieldType(type, THRIFT_I32);
+                column.precision = tr.readI32();
+                break;
+            case 10:
+                checkFieldType(type, THRIFT_STRUCT);
+                parseLogicalType(tr, column);
+                hasLogicalType = true;
+                break;
+            default:
+                tr.skip(type);
+                break;
+        }
+    }
+    tr.structEnd();
+
+    // Files written before logical types existed only have converted types.
+    if (hasLogicalType && column.kind != PARQUET_VALUE_PLAIN) {
+        return;
+    }
+
+    switch (column.convertedType) {
+        case PARQUET_CONVERTED_UTF8:
+        case PARQUET_CONVERTED_ENUM:
+        case PARQUET_CONVERTED_JSON:
+            column.kind = PARQUET_VALUE_STRING;
+            break;
+        case PARQUET_CONVERTED_DECIMAL:
+            column.kind = PARQUET_VALUE_DECIMAL;
+            break;
+        case PARQUET_CONVERTED_DATE:
+            column.kind = PARQUET_VALUE_DATE;
+            break;
+        case PARQUET_CONVERTED_TIMESTAMP_MILLIS:
+            column.kind = PARQUET_VALUE_TIMESTAMP;
+            column.timeUnitsPerSecond = 1000;
+            column.adjustedToUTC = true;
+            break;
+        case PARQUET_CONVERTED_TIMESTAMP_MICROS:
+            column.kind = PARQUET_VALUE_TIMESTAMP;
+            column.timeUnitsPerSecond = 1000000;
+            column.adjustedToUTC = true;
+            break;
+        default:
+            if (column.convertedType >= PARQUET_CONVERTED_UINT_8 &&
+                column.convertedType <= PARQUET_CONVERTED_UINT_64) {
+                column.kind = PARQUET_VALUE_UNSIGNED;
+            }
+            break;
+    }
+
+    // INT96 is the legacy timestamp type, nanoseconds of day and a Julian day.
+    if (column.type == PARQUET_INT96) {
+        column.kind = PARQUET_VALUE_TIMESTAMP;
+        column.timeUnitsPerSecond = 1000000000;
+    }
+}
+
+// Values are formatted into fixed size buffers, so don't trust the footer for the number of digits.
+static void checkSchemaColumn(const ParquetSchemaColumn &column) {
+    if (column.kind == PARQUET_VALUE_DECIMAL) {
+        S3_CHECK_OR_DIE(column.precision >= 1 && column.precision <= PARQUET_MAX_DECIMAL_PRECISION &&
+                            column.scale >= 0 && column.scale <= column.precision,
+                        S3RuntimeError,
+                        "invalid Parquet file: bad decimal precision " +
+                            std::to_string(column.precision) + " and scale " +
+                            std::to_string(column.scale) + " of column " + column.name);
+    }
+}
+
+static void parseStatistics(ThriftCompactReader &tr, ParquetStatistics &stats) {
+    uint8_t type;
+    int16_t id;
+    string value;
+
+    tr.structBegin();
+    while (tr.readFieldBegin(type, id)) {
+        switch (id) {
+            case 3:
+                checkFieldType(type, THRIFT_I64);
+                stats.nullCount = tr.readI64();
+                stats.hasNullCount = true;
+                break;
+            case 5:  // max_value
+                checkFieldType(type, THRIFT_BINARY);
+                tr.readBinary(stats.max);
+                stats.hasMax = true;
+                break;
+            case 6:  // min_value
+                checkFieldType(type, THRIFT_BINARY);
+                tr.readBinary(stats.min);
+                stats.hasMin = true;
+                break;
+            default:
+                // The deprecated min and max (1 and 2) may use a wrong sort order, ignore them.
+                tr.skip(type);
+                break;
+        }
+    }
+    tr.structEnd();
+}
+
+static void parseColumnMetaData(ThriftCompactReader &tr, ParquetColumnChunk &chunk) {
+    uint8_t type;
+    int16_t id;
+
+    tr.structBegin();
+    while (tr.readFieldBegin(type, id)) {
+        switch (id) {
+            case 4:
+                checkFieldType(type, THRIFT_I32);
+                chunk.codec = tr.readI32();
+                break;
+            case 5:
+                checkFieldType(type, THRIFT_I64);
+                chunk.numValues = tr.readI64();
+                break;
+            case 7:
+                checkFieldType(type, THRIFT_I64);
+                chunk.totalCompressedSize = tr.readI64();
+                break;
+            case 9:
+                checkFieldType(type, THRIFT_I64);
+                chunk.dataPageOffset = tr.readI64();
+                break;
+            case 11:
+                checkFieldType(type, THRIFT_I64);
+                chunk.dictPageOffset = tr.readI64();
+                break;
+            case 12:
+                checkFieldType(type, THRIFT_STRUCT);
+                parseStatistics(tr, chunk.stats);
+                break;
+            default:
+                tr.skip(type);
+                break;
+        }
+    }
+    tr.structEnd();
+}
+
+static void parseColumnChunk(ThriftCompactReader &tr, ParquetColumnChunk &chunk) {
+    uint8_t type;
+    int16_t id;
+    bool hasMetaData = false;
+
+    tr.structBegin();
+    while (tr.readFieldBegin(type, id)) {
+        if (id == 1) {
+            S3_DIE(S3RuntimeError, "Parquet column chunks in external files are not supported");
+        } else if (id == 3) {
+            checkFieldType(type, THRIFT_STRUCT);
+            parseColumnMetaData(tr, chunk);
+            hasMetaData = true;
+        } else {
+            tr.skip(type);
+        }
+    }
+    tr.structEnd();
+
+    S3_CHECK_OR_DIE(hasMetaData, S3RuntimeError, "invalid Parquet file: column chunk without metadata");
+}
+
+static void parseRowGroup(ThriftCompactReader &tr, ParquetRowGroup &rowGroup) {
+    uint8_t type;
+    int16_t id;
+
+    tr.structBegin();
+    while (tr.readFieldBegin(type, id)) {
+        if (id == 1) {
+            uint8_t elemType;
+            uint32_t size;
+
+            checkFieldType(type, THRIFT_LIST);
+            tr.readListBegin(elemType, size);
+            checkFieldType(elemType, THRIFT_STRUCT);
+            rowGroup.columns.resize(size);
+            for (uint32_t i = 0; i < size; i++) {
+                parseColumnChunk(tr, rowGroup.columns[i]);
+            }
+        } else if (id == 3) {
+            checkFieldType(type, THRIFT_I64);
+            rowGroup.numRows = tr.readI64();
+        } else {
+            tr.skip(type);
+        }
+    }
+    tr.structEnd();
+}
+
+static void parseFileMetaData(ThriftCompactReader &tr, vector<ParquetSchemaColumn> &schema,
+                              vector<ParquetRowGroup> &rowGroups) {
+    uint8_t type;
+    int16_t id;
+
+    tr.structBegin();
+    while (tr.readFieldBegin(type, id)) {
+        if (id == 2) {
+            uint8_t elemType;
+            uint32_t size;
+
+            checkFieldType(type, THRIFT_LIST);
+            tr.readListBegin(elemType, size);
+            checkFieldType(elemType, THRIFT_STRUCT);
+            schema.resize(size);
+            for (uint32_t i = 0; i < size; i++) {
+                parseSchemaElement(tr, schema[i]);
+                checkSchemaColumn(schema[i]);
+            }
+        } else if (id == 4) {
+            uint8_t elemType;
+            uint32_t size;
+
+            checkFieldType(type, THRIFT_LIST);
+            tr.readListBegin(elemType, size);
+            checkFieldType(elemType, THRIFT_STRUCT);
+            rowGroups.resize(size);
+            for (uint32_t i = 0; i < size; i++) {
+                parseRowGroup(tr, rowGroups[i]);
+            }
+        } else {
+            tr.skip(type);
+        }
+    }
+    tr.structEnd();
+}
+
+struct ParquetPageHeader {
+    ParquetPageHeader()
+        : type(-1),
+          uncompressedSize(0),
+          compressedSize(0),
+          numValues(0),
+          encoding(0),
+          defLevelsLength(0),
+          repLevelsLength(0),
+          isCompressed(true) {
+    }
+
+    int32_t type;
+    int32_t uncompressedSize;
+    int32_t compressedSize;
+
+    int32_t numValues;
+    int32_t encoding;
+
+    // data page v2 only
+    int32_t defLevelsLength;
+    int32_t repLevelsLength;
+    bool isCompressed;
+};
+
+// DataPageHeader, DictionaryPageHeader and DataPageHeaderV2 share the ids of the fields we need.
+static void parsePageTypeHeader(ThriftCompactReader &tr, ParquetPageHeader &header) {
+    uint8_t type;
+    int16_t id;
+    bool v2 = (header.type == PARQUET_PAGE_DATA_V2);
+
+    tr.structBegin();
+    while (tr.readFieldBegin(type, id)) {
+        if (id == 1) {
+            checkFieldType(type, THRIFT_I32);
+            header.numValues = tr.readI32();
+        } else if (id == 2 && !v2) {
+            checkFieldType(type, THRIFT_I32);
+            header.encoding = tr.readI32();
+        } else if (id == 4 && v2) {
+            checkFieldType(type, THRIFT_I32);
+            header.encoding = tr.readI32();
+        } else if (id == 5 && v2) {
+            checkFieldType(type, THRIFT_I32);
+            header.defLevelsLength = tr.readI32();
+        } else if (id == 6 && v2) {
+            checkFieldType(type, THRIFT_I32);
+            header.repLevelsLength = tr.readI32();
+        } else if (id == 7 && v2 && (type == THRIFT_TRUE || type == THRIFT_FALSE)) {
+            header.isCompressed = tr.getBool(type);
+        } else {
+            tr.skip(type);
+        }
+    }
+    tr.structEnd();
+}
+
+static void parsePageHeader(ThriftCompactReader &tr, ParquetPageHeader &header) {
+    uint8_t type;
+    int16_t id;
+
+    tr.structBegin();
+    while (tr.readFieldBegin(type, id)) {
+        switch (id) {
+            case 1:
+                checkFieldType(type, THRIFT_I32);
+                header.type = tr.readI32();
+                break;
+            case 2:
+                checkFieldType(type, THRIFT_I32);
+                header.uncompressedSize = tr.readI32();
+                break;
+            case 3:
+                checkFieldType(type, THRIFT_I32);
+                header.compressedSize = tr.readI32();
+                break;
+            case 5:
+            case 7:
+            case 8:
+                checkFieldType(type, THRIFT_STRUCT);
+                parsePageTypeHeader(tr, header);
+                break;
+            default:
+                tr.skip(type);
+                break;
+        }
+    }
+    tr.structEnd();
+
+    S3_CHECK_OR_DIE(header.compressedSize >= 0 && header.uncompressedSize >= 0 &&
+                        header.numValues >= 0 && header.defLevelsLength >= 0 &&
+                        header.repLevelsLength >= 0,
+                    S3RuntimeError, "invalid Parquet file: bad page header");
+}
+
+static void snappyUncompress(const uint8_t *in, uint64_t inLen, char *out, uint64_t outLen) {
+    uint64_t ip = 0;
+    uint64_t op = 0;
+    uint64_t expected = 0;
+
+    // preamble: uncompressed length as varint
+    for (int shift = 0;; shift += 7) {
+        S3_CHECK_OR_DIE(ip < inLen && shift < 35, S3RuntimeError,
+                        "invalid Parquet file: bad snappy data");
+        uint8_t byte = in[ip++];
+        expected |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) break;
+    }
+    S3_CHECK_OR_DIE(expected == outLen, S3RuntimeError, "invalid Parquet file: bad snappy data");
+
+    while (ip < inLen) {
+        uint8_t tag = in[ip++];
+        uint64_t length;
+        uint64_t offset;
+
+        if ((tag & 3) == 0) {
+            // literal
+            length = (tag >> 2) + 1;
+            if (length > 60) {
+                uint64_t bytes = length - 60;
+                S3_CHECK_OR_DIE(inLen - ip >= bytes, S3RuntimeError,
+                                "invalid Parquet file: bad snappy data");
+                length = 0;
+                for (uint64_t i = 0; i < bytes; i++) {
+                    length |= (uint64_t)in[ip + i] << (8 * i);
+                }
+                length += 1;
+                ip += bytes;
+            }
+            S3_CHECK_OR_DIE(inLen - ip >= length && outLen - op >= length, S3RuntimeError,
+                            "invalid Parquet file: bad snappy data");
+            memcpy(out + op, in + ip, length);
+            ip += length;
+            op += length;
+            continue;
+        }
+
+        if ((tag & 3) == 1) {
+            S3_CHECK_OR_DIE(ip < inLen, S3RuntimeError, "invalid Parquet file: bad snappy data");
+            length = ((tag >> 2) & 7) + 4;
+            offset = ((uint64_t)(tag >> 5) << 8) | in[ip++];
+        } else if ((tag & 3) == 2) {
+            S3_CHECK_OR_DIE(inLen - ip >= 2, S3RuntimeError,
+                            "invalid Parquet file: bad snappy data");
+            length = (tag >> 2) + 1;
+            offset = (uint64_t)in[ip] | ((uint64_t)in[ip + 1] << 8);
+            ip += 2;
+        } else {
+            S3_CHECK_OR_DIE(inLen - ip >= 4, S3RuntimeError,
+                            "invalid Parquet file: bad snappy data");
+            length = (tag >> 2) + 1;
+            offset = readLE32(in + ip);
+            ip += 4;
+        }
+
+        // copies may overlap their own output
+        S3_CHECK_OR_DIE(offset > 0 && offset <= op && outLen - op >= length, S3RuntimeError,
+                        "invalid Parquet file: bad snappy data");
+        for (uint64_t i = 0; i < length; i++, op++) {
+            out[op] = out[op - offset];
+        }
+    }
+
+    S3_CHECK_OR_DIE(op == outLen, S3RuntimeError, "invalid Parquet file: bad snappy data");
+}
+
+static void gzipUncompress(const uint8_t *in, uint64_t inLen, char *out, uint64_t outLen) {
+    z_stream zs;
+
+    memset(&zs, 0, sizeof(zs));
+    // 32 + MAX_WBITS: accept both zlib and gzip headers
+    S3_CHECK_OR_DIE(inflateInit2(&zs, MAX_WBITS + 32) == Z_OK, S3RuntimeError,
+                    "failed to initialize zlib");
+
+    zs.next_in = (Bytef *)in;
+    zs.avail_in = inLen;
+    zs.next_out = (Bytef *)out;
+    zs.avail_out = outLen;
+
+    int ret = inflate(&zs, Z_FINISH);
+    uint64_t produced = zs.total_out;
+    inflateEnd(&zs);
+
+    S3_CHECK_OR_DIE(ret == Z_STREAM_END && produced == outLen, S3RuntimeError,
+                    "invalid Parquet file: bad gzip data");
+}
+
+// Decompress a page, or return the input if it isn't compressed.
+static const uint8_t *uncompressPage(int32_t codec, const uint8_t *in, uint64_t inLen,
+                                     uint64_t outLen, string &buffer) {
+    if (codec == PARQUET_CODEC_UNCOMPRESSED) {
+        S3_CHECK_OR_DIE(inLen == outLen, S3RuntimeError, "invalid Parquet file: bad page size");
+        return in;
+    }
+
+    buffer.resize(outLen);
+    char *out = &buffer[0];
+
+    switch (codec) {
+        case PARQUET_CODEC_SNAPPY:
+            snappyUncompress(in, inLen, out, outLen);
+            break;
+        case PARQUET_CODEC_GZIP:
+            gzipUncompress(in, inLen, out, outLen);
+            break;
+#ifdef USE_ZSTD
+        case PARQUET_CODEC_ZSTD: {
+            size_t ret = ZSTD_decompress(out, outLen, in, inLen);
+            S3_CHECK_OR_DIE(!ZSTD_isError(ret) && ret == outLen, S3RuntimeError,
+                            "invalid Parquet file: bad zstd data");
+            break;
+        }
+#endif
+        default:
+            S3_DIE(S3RuntimeError,
+                   "unsupported Parquet compression codec " + std::to_string(codec));
+    }
+
+    return (const uint8_t *)buffer.data();
+}
+
+// Decoder of the RLE/bit-packing hybrid encoding used by levels and dictionary indices.
+class RleBitPackedDecoder {
+   public:
+    RleBitPackedDecoder(const uint8_t *data, uint64_t len, int bitWidth)
+        : data(data), len(len), pos(0), bitWidth(bitWidth), runLeft(0), packed(false),
+          runValue(0), packedBitPos(0), packedBytes(0) {
+        S3_CHECK_OR_DIE(bitWidth >= 0 && bitWidth <= 32, S3RuntimeError,
+                        "invalid Parquet file: bad bit width");
+    }
+
+    uint32_t next() {
+        while (runLeft == 0) {
+            nextRun();
+        }
+        runLeft--;
+
+        if (!packed) {
+            return runValue;
+        }
+
+        uint64_t value = 0;
+        for (int i = 0; i < bitWidth; i++, packedBitPos++) {
+            uint64_t byte = pos + packedBitPos / 8;
+            if ((data[byte] >> (packedBitPos % 8)) & 1) {
+                value |= (uint64_t)1 << i;
+            }
+        }
+        return (uint32_t)value;
+    }
+
+   private:
+    void nextRun() {
+        if (packed) {
+            // skip the bytes of the finished bit-packed run
+            pos += packedBytes;
+        }
+
+        uint64_t header = 0;
+        for (int shift = 0;; shift += 7) {
+            S3_CHECK_OR_DIE(pos < len && shift < 35, S3RuntimeError,
+                            "invalid Parquet file: truncated RLE data");
+            uint8_t byte = data[pos++];
+            header |= (uint64_t)(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) break;
+        }
+
+        if (header & 1) {
+            // bit-packed run of groups of 8 values
+            packed = true;
+            runLeft = (header >> 1) * 8;
+            packedBytes = (header >> 1) * bitWidth;
+            packedBitPos = 0;
+            S3_CHECK_OR_DIE(packedBytes <= len - pos, S3RuntimeError,
+                            "invalid Parquet file: truncated RLE data");
+        } else {
+            uint64_t valueBytes = (bitWidth + 7) / 8;
+
+            packed = false;
+            runLeft = header >> 1;
+            S3_CHECK_OR_DIE(valueBytes <= len - pos, S3RuntimeError,
+                            "invalid Parquet file: truncated RLE data");
+            runValue = 0;
+            for (uint64_t i = 0; i < valueBytes; i++) {
+                runValue |= (uint32_t)data[pos + i] << (8 * i);
+            }
+            pos += valueBytes;
+        }
+    }
+
+    const uint8_t *data;
+    uint64_t len;
+    uint64_t pos;
+    int bitWidth;
+
+    uint64_t runLeft;
+    bool packed;
+    uint32_t runValue;
+    uint64_t packedBitPos;
+    uint64_t packedBytes;
+};
+
+// Convert days since 1970-01-01 to a civil date.
+static void civilFromDays(int64_t days, int64_t &year, unsigned &month, unsigned &day) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned doe = (unsigned)(days - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = (int64_t)yoe + era * 400 + (month <= 2);
+}
+
+static int formatDate(char *buf, uint64_t size, int64_t days) {
+    int64_t year;
+    unsigned month, day;
+
+    civilFromDays(days, year, month, day);
+    if (year <= 0) {
+        return snprintf(buf, size, "%04" PRId64 "-%02u-%02u BC", 1 - year, month, day);
+    }
+    return snprintf(buf, size, "%04" PRId64 "-%02u-%02u", year, month, day);
+}
+
+// Format a timestamp given as days since 1970-01-01 and time units into the day.
+static int formatTimestamp(char *buf, uint64_t size, int64_t days, int64_t rest,
+                           int64_t unitsPerSecond, bool adjustedToUTC) {
+    int64_t unitsPerDay = unitsPerSecond * 86400;
+
+    days += rest / unitsPerDay;
+    rest %= unitsPerDay;
+    if (rest < 0) {
+        rest += unitsPerDay;
+        days--;
+    }
+
+    int64_t seconds = rest / unitsPerSecond;
+    int64_t fraction = rest % unitsPerSecond;
+    int64_t year;
+    unsigned month, day;
+
+    civilFromDays(days, year, month, day);
+
+    int n = snprintf(buf, size, "%04" PRId64 "-%02u-%02u %02d:%02d:%02d",
+                     year <= 0 ? 1 - year : year, month, day, (int)(seconds / 3600),
+                     (int)(seconds / 60 % 60), (int)(seconds % 60));
+    if (fraction != 0) {
+        int digits = unitsPerSecond == 1000 ? 3 : (unitsPerSecond == 1000000 ? 6 : 9);
+        n += snprintf(buf + n, size - n, ".%0*" PRId64, digits, fraction);
+    }
+    if (adjustedToUTC) {
+        n += snprintf(buf + n, size - n, "+00");
+    }
+    if (year <= 0) {
+        n += snprintf(buf + n, size - n, " BC");
+    }
+    return n;
+}
+
+static int formatDecimal(char *buf, uint64_t size, __int128 value, int32_t scale) {
+    char digits[64];
+    int n = 0;
+    bool negative = value < 0;
+    unsigned __int128 abs = negative ? -(unsigned __int128)value : (unsigned __int128)value;
+
+    // an __int128 has at most 39 digits, and the scale was checked against the precision
+    S3_CHECK_OR_DIE(scale >= 0 && scale < (int32_t)sizeof(digits), S3RuntimeError,
+                    "unsupported Parquet decimal scale " + std::to_string(scale));
+
+    do {
+        digits[n++] = '0' + (int)(abs % 10);
+        abs /= 10;
+    } while (abs != 0);
+
+    while (n <= scale) {
+        digits[n++] = '0';
+    }
+
+    // sign, digits, decimal point and the terminating NUL
+    S3_CHECK_OR_DIE((uint64_t)(negative + n + (scale > 0) + 1) <= size, S3RuntimeError,
+                    "Parquet decimal does not fit in " + std::to_string(size) + " bytes");
+
+    int len = 0;
+    if (negative) {
+        buf[len++] = '-';
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        buf[len++] = digits[i];
+        if (i == scale && scale > 0) {
+            buf[len++] = '.';
+        }
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+// Big-endian two's complement, as used by decimals in byte arrays.
+static __int128 readBigEndianInteger(const uint8_t *p, uint64_t len) {
+    S3_CHECK_OR_DIE(len > 0 && len <= 16, S3RuntimeError,
+                    "unsupported Parquet decimal of " + std::to_string(len) + " bytes");
+
+    __int128 value = (p[0] & 0x80) ? -1 : 0;
+    for (uint64_t i = 0; i < len; i++) {
+        value = (__int128)(((unsigned __int128)value << 8) | p[i]);
+    }
+    return value;
+}
+
+// Append the text form of one PLAIN encoded value at p to values, and return its encoded size.
+static uint64_t decodePlainValue(const ParquetSchemaColumn &column, const uint8_t *p,
+                                 uint64_t avail, ParquetColumnValues &values) {
+    char buf[128];
+    int n = 0;
+    uint64_t size;
+
+    switch (column.type) {
+        case PARQUET_INT32: {
+            size = 4;
+            S3_CHECK_OR_DIE(avail >= size, S3RuntimeError, "invalid Parquet file: truncated page");
+            int32_t v = (int32_t)readLE32(p);
+            if (column.kind == PARQUET_VALUE_DATE) {
+                n = formatDate(buf, sizeof(buf), v);
+            } else if (column.kind == PARQUET_VALUE_DECIMAL) {
+                n = formatDecimal(buf, sizeof(buf), v, column.scale);
+            } else if (column.kind == PARQUET_VALUE_UNSIGNED) {
+                n = snprintf(buf, sizeof(buf), "%" PRIu32, (uint32_t)v);
+            } else {
+                n = snprintf(buf, sizeof(buf), "%" PRId32, v);
+            }
+            break;
+        }
+        case PARQUET_INT64: {
+            size = 8;
+            S3_CHECK_OR_DIE(avail >= size, S3RuntimeError, "invalid Parquet file: truncated page");
+            int64_t v = (int64_t)readLE64(p);
+            if (column.kind == PARQUET_VALUE_TIMESTAMP && column.timeUnitsPerSecond > 0) {
+                n = formatTimestamp(buf, sizeof(buf), 0, v, column.timeUnitsPerSecond,
+                                    column.adjustedToUTC);
+            } else if (column.kind == PARQUET_VALUE_DECIMAL) {
+                n = formatDecimal(buf, sizeof(buf), v, column.scale);
+            } else if (column.kind == PARQUET_VALUE_UNSIGNED) {
+                n = snprintf(buf, sizeof(buf), "%" PRIu64, (uint64_t)v);
+            } else {
+                n = snprintf(buf, sizeof(buf), "%" PRId64, v);
+            }
+            break;
+        }
+        case PARQUET_INT96: {
+            size = 12;
+            S3_CHECK_OR_DIE(avail >= size, S3RuntimeError, "invalid Parquet file: truncated page");
+            int64_t nanos = (int64_t)readLE64(p);
+            int64_t days = (int64_t)readLE32(p + 8) - 2440588;  // Julian day of 1970-01-01
+            n = formatTimestamp(buf, sizeof(buf), days, nanos, 1000000000, false);
+            break;
+        }
+        case PARQUET_FLOAT: {
+            float v;
+            size = 4;
+            S3_CHECK_OR_DIE(avail >= size, S3RuntimeError, "invalid Parquet file: truncated page");
+            memcpy(&v, p, sizeof(v));
+            n = snprintf(buf, sizeof(buf), "%.9g", v);
+            break;
+        }
+        case PARQUET_DOUBLE: {
+            double v;
+            size = 8;
+            S3_CHECK_OR_DIE(avail >= size, S3RuntimeError, "invalid Parquet file: truncated page");
+            memcpy(&v, p, sizeof(v));
+            n = snprintf(buf, sizeof(buf), "%.17g", v);
+            break;
+        }
+        case PARQUET_BYTE_ARRAY:
+        case PARQUET_FIXED_LEN_BYTE_ARRAY: {
+            uint64_t len;
+            if (column.type == PARQUET_BYTE_ARRAY) {
+                S3_CHECK_OR_DIE(avail >= 4, S3RuntimeError, "invalid Parquet file: truncated page");
+                len = readLE32(p);
+                p += 4;
+                avail -= 4;
+                size = 4 + len;
+            } else {
+                len = column.typeLength;
+                size = len;
+            }
+            S3_CHECK_OR_DIE(avail >= len, S3RuntimeError, "invalid Parquet file: truncated page");
+
+            if (column.kind == PARQUET_VALUE_DECIMAL) {
+                n = formatDecimal(buf, sizeof(buf), readBigEndianInteger(p, len), column.scale);
+                break;
+            }
+            values.append((const char *)p, len);
+            return size;
+        }
+        default:
+            S3_DIE(S3RuntimeError,
+                   "unsupported Parquet physical type " + std::to_string(column.type));
+    }
+
+    values.append(buf, n);
+    return size;
+}
+
+// Append count non-null values of the page, stored with the given encoding, to values.
+static void decodeValues(const ParquetSchemaColumn &column, int32_t encoding, const uint8_t *p,
+                         uint64_t len, uint64_t count, const ParquetColumnValues *dict,
+                         vector<uint8_t> &defLevels, ParquetColumnValues &values) {
+    int16_t maxDef = (column.repetition == PARQUET_OPTIONAL) ? 1 : 0;
+    uint64_t numValues = defLevels.empty() ? count : defLevels.size();
+
+    if (encoding == PARQUET_ENCODING_PLAIN_DICTIONARY ||
+        encoding == PARQUET_ENCODING_RLE_DICTIONARY) {
+        S3_CHECK_OR_DIE(dict != NULL && len >= 1, S3RuntimeError,
+                        "invalid Parquet file: dictionary page not found");
+
+        RleBitPackedDecoder indices(p + 1, len - 1, p[0]);
+        for (uint64_t i = 0; i < numValues; i++) {
+            if (maxDef > 0 && defLevels[i] == 0) {
+                values.appendNull();
+                continue;
+            }
+            uint32_t idx = indices.next();
+            S3_CHECK_OR_DIE(idx < dict->size(), S3RuntimeError,
+                            "invalid Parquet file: bad dictionary index");
+            values.appendFrom(*dict, idx);
+        }
+        return;
+    }
+
+    if (column.type == PARQUET_BOOLEAN) {
+        uint64_t bit = 0;
+        const uint8_t *bits = p;
+        uint64_t bitsLen = len;
+
+        S3_CHECK_OR_DIE(encoding == PARQUET_ENCODING_PLAIN || encoding == PARQUET_ENCODING_RLE,
+                        S3RuntimeError,
+                        "unsupported Parquet encoding " + std::to_string(encoding));
+
+        if (encoding == PARQUET_ENCODING_RLE) {
+            S3_CHECK_OR_DIE(len >= 4 && readLE32(p) <= len - 4, S3RuntimeError,
+                            "invalid Parquet file: truncated page");
+            bitsLen = readLE32(p);
+            bits = p + 4;
+        }
+
+        RleBitPackedDecoder rle(bits, bitsLen, 1);
+        for (uint64_t i = 0; i < numValues; i++) {
+            if (maxDef > 0 && defLevels[i] == 0) {
+                values.appendNull();
+                continue;
+            }
+
+            bool value;
+            if (encoding == PARQUET_ENCODING_RLE) {
+                value = rle.next();
+            } else {
+                S3_CHECK_OR_DIE(bit / 8 < len, S3RuntimeError,
+                                "invalid Parquet file: truncated page");
+                value = (p[bit / 8] >> (bit % 8)) & 1;
+                bit++;
+            }
+            values.append(value ? "t" : "f", 1);
+        }
+        return;
+    }
+
+    S3_CHECK_OR_DIE(encoding == PARQUET_ENCODING_PLAIN, S3RuntimeError,
+                    "unsupported Parquet encoding " + std::to_string(encoding));
+
+    uint64_t pos = 0;
+    for (uint64_t i = 0; i < numValues; i++) {
+        if (maxDef > 0 && defLevels[i] == 0) {
+            values.appendNull();
+            continue;
+        }
+        pos += decodePlainValue(column, p + pos, len - pos, values);
+    }
+}
+
+static void decodeLevels(const uint8_t *p, uint64_t len, uint64_t count, vector<uint8_t> &levels) {
+    RleBitPackedDecoder rle(p, len, 1);
+
+    levels.resize(count);
+    for (uint64_t i = 0; i < count; i++) {
+        uint32_t level = rle.next();
+        S3_CHECK_OR_DIE(level <= 1, S3RuntimeError, "invalid Parquet file: bad definition level");
+        levels[i] = level;
+    }
+}
+
+// Check whether the int64 or string value v may satisfy "v op c" for some v in [min, max].
+template <typename T>
+static bool rangeMayMatch(const T &min, const T &max, ParquetFilterOp op, const T &c) {
+    switch (op) {
+        case PARQUET_OP_LT:
+            return min < c;
+        case PARQUET_OP_LE:
+            return min <= c;
+        case PARQUET_OP_EQ:
+            return min <= c && c <= max;
+        case PARQUET_OP_GE:
+            return max >= c;
+        case PARQUET_OP_GT:
+            return max > c;
+    }
+    return true;
+}
+
+static bool parseInt64(const string &s, int64_t &value) {
+    char *end = NULL;
+
+    if (s.empty()) {
+        return false;
+    }
+    errno = 0;
+    long long v = strtoll(s.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0') {
+        return false;
+    }
+    value = v;
+    return true;
+}
+
+ParquetReader::ParquetReader()
+    : s3Interface(NULL),
+      tailOffset(0),
+      curRowGroup(0),
+      numSkippedRowGroups(0),
+      fetchedBytes(0),
+      curRow(0),
+      numRows(0),
+      outOffset(0) {
+}
+
+ParquetReader::~ParquetReader() {
+    this->close();
+}
+
+// Fetch [offset, offset + len) of the object, no more than a chunk per request.
+void ParquetReader::fetchRange(uint64_t offset, uint64_t len, string &out) {
+    uint64_t chunkSize = this->params.getChunkSize();
+
+    out.clear();
+    out.reserve(len);
+
+    while (len > 0) {
+        uint64_t size = (chunkSize > 0 && len > chunkSize) ? chunkSize : len;
+        S3VectorUInt8 data(this->params.getMemoryContext());
+
+        uint64_t fetched = this->s3Interface->fetchData(offset, data, size, params.getS3Url());
+        S3_CHECK_OR_DIE(fetched == size, S3PartialResponseError, size, fetched);
+
+        out.append((const char *)data.data(), size);
+        data.release();
+
+        this->fetchedBytes += size;
+        offset += size;
+        len -= size;
+    }
+}
+
+void ParquetReader::readFooter() {
+    uint64_t keySize = this->params.getKeySize();
+    uint64_t chunkSize = this->params.getChunkSize();
+    string &tail = this->tailData;
+
+    S3_CHECK_OR_DIE(keySize >= 12, S3RuntimeError,
+                    "invalid Parquet file: " + params.getS3Url().getFullUrlForCurl());
+
+    uint64_t tailSize = std::min(keySize, (uint64_t)PARQUET_FOOTER_READ_SIZE);
+    if (chunkSize > 0) {
+        tailSize = std::min(tailSize, chunkSize);
+    }
+    tailSize = std::max(tailSize, (uint64_t)8);
+
+    this->tailOffset = keySize - tailSize;
+    this->fetchRange(this->tailOffset, tailSize, tail);
+
+    const uint8_t *end = (const uint8_t *)tail.data() + tailSize;
+    S3_CHECK_OR_DIE(memcmp(end - 4, "PAR1", 4) == 0, S3RuntimeError,
+                    "not a Parquet file: " + params.getS3Url().getFullUrlForCurl());
+
+    uint64_t footerSize = readLE32(end - 8);
+    S3_CHECK_OR_DIE(footerSize + 12 <= keySize, S3RuntimeError,
+                    "invalid Parquet file: bad footer size");
+
+    string footer;
+    if (footerSize + 8 <= tailSize) {
+        footer = tail.substr(tailSize - 8 - footerSize, footerSize);
+    } else {
+        this->fetchRange(keySize - 8 - footerSize, footerSize, footer);
+    }
+
+    vector<ParquetSchemaColumn> elements;
+    ThriftCompactReader tr((const uint8_t *)footer.data(), footer.size());
+    parseFileMetaData(tr, elements, this->rowGroups);
+
+    // The first element is the root, the others must be its primitive children.
+    S3_CHECK_OR_DIE(!elements.empty() && (uint64_t)elements[0].numChildren == elements.size() - 1,
+                    S3RuntimeError, "nested Parquet schemas are not supported");
+
+    this->schema.assign(elements.begin() + 1, elements.end());
+    for (uint64_t i = 0; i < this->schema.size(); i++) {
+        S3_CHECK_OR_DIE(this->schema[i].numChildren == 0 &&
+                            this->schema[i].repetition != PARQUET_REPEATED,
+                        S3RuntimeError, "nested Parquet schemas are not supported");
+    }
+
+    for (uint64_t i = 0; i < this->rowGroups.size(); i++) {
+        ParquetRowGroup &rowGroup = this->rowGroups[i];
+        S3_CHECK_OR_DIE(rowGroup.columns.size() == this->schema.size(), S3RuntimeError,
+                        "invalid Parquet file: row group doesn't match the schema");
+
+        for (uint64_t j = 0; j < rowGroup.columns.size(); j++) {
+            ParquetColumnChunk &chunk = rowGroup.columns[j];
+            S3_CHECK_OR_DIE(chunk.totalCompressedSize >= 0 && chunk.dataPageOffset >= 0 &&
+                                chunk.getOffset() + chunk.totalCompressedSize <= keySize,
+                            S3RuntimeError, "invalid Parquet file: bad column chunk offset");
+        }
+    }
+}
+
+// Find the Parquet column of each table column, by name, case-insensitively if no exact match.
+void ParquetReader::mapColumns() {
+    this->outputColumns.clear();
+
+    // Without a table, such as in gpcheckcloud, output all columns of the file.
+    if (this->spec.columns.empty()) {
+        for (uint64_t i = 0; i < this->schema.size(); i++) {
+            this->outputColumns.push_back(i);
+        }
+        return;
+    }
+
+    for (uint64_t i = 0; i < this->spec.columns.size(); i++) {
+        const string &name = this->spec.columns[i];
+        int found = -1;
+
+        if (i < this->spec.needed.size() && !this->spec.needed[i]) {
+            this->outputColumns.push_back(-1);
+            continue;
+        }
+
+        for (uint64_t j = 0; j < this->schema.size() && found < 0; j++) {
+            if (this->schema[j].name == name) {
+                found = j;
+            }
+        }
+        for (uint64_t j = 0; j < this->schema.size() && found < 0; j++) {
+            if (strcasecmp(this->schema[j].name.c_str(), name.c_str()) == 0) {
+                found = j;
+            }
+        }
+
+        if (found < 0) {
+            S3DEBUG("column \"%s\" is not in the Parquet file, read as NULL", name.c_str());
+        }
+        this->outputColumns.push_back(found);
+    }
+}
+
+void ParquetReader::open(const S3Params &params) {
+    S3_CHECK_OR_DIE(this->s3Interface != NULL, S3RuntimeError, "s3Interface must not be NULL");
+
+    this->close();
+
+    this->params = params;
+    this->spec = params.getParquetScanSpec();
+
+    this->readFooter();
+    this->mapColumns();
+
+    S3DEBUG("Parquet file %s: %" PRIu64 " columns, %" PRIu64 " row groups",
+            params.getS3Url().getFullUrlForCurl().c_str(), (uint64_t)this->schema.size(),
+            (uint64_t)this->rowGroups.size());
+}
+
+// Check the statistics of the row group against the filters, return false if no row can match.
+bool ParquetReader::rowGroupMayMatch(const ParquetRowGroup &rowGroup) {
+    for (uint64_t i = 0; i < this->spec.filters.size(); i++) {
+        const ParquetFilter &filter = this->spec.filters[i];
+        int col = -1;
+
+        for (uint64_t j = 0; j < this->schema.size() && col < 0; j++) {
+            if (this->schema[j].name == filter.column) {
+                col = j;
+            }
+        }
+        for (uint64_t j = 0; j < this->schema.size() && col < 0; j++) {
+            if (strcasecmp(this->schema[j].name.c_str(), filter.column.c_str()) == 0) {
+                col = j;
+            }
+        }
+        if (col < 0) {
+            // The column reads as NULL, no row satisfies the qual.
+            return false;
+        }
+
+        const ParquetSchemaColumn &column = this->schema[col];
+        const ParquetColumnChunk &chunk = rowGroup.columns[col];
+        const ParquetStatistics &stats = chunk.stats;
+
+        // All values are NULL.
+        if (stats.hasNullCount && stats.nullCount == chunk.numValues && rowGroup.numRows > 0) {
+            return false;
+        }
+
+        if (!stats.hasMin || !stats.hasMax) {
+            continue;
+        }
+
+        // The statistics are ordered like the table column only if the Parquet type matches
+        // it, e.g. an int column read from strings compares "100" < "9".
+        if (filter.type == PARQUET_FILTER_INT &&
+            (column.type == PARQUET_INT32 || column.type == PARQUET_INT64) &&
+            (column.kind == PARQUET_VALUE_PLAIN || column.kind == PARQUET_VALUE_UNSIGNED)) {
+            uint64_t size = (column.type == PARQUET_INT32) ? 4 : 8;
+            int64_t c;
+
+            if (stats.min.size() != size || stats.max.size() != size ||
+                !parseInt64(filter.value, c)) {
+                continue;
+            }
+
+            const uint8_t *min = (const uint8_t *)stats.min.data();
+            const uint8_t *max = (const uint8_t *)stats.max.data();
+            int64_t minValue, maxValue;
+
+            if (column.kind == PARQUET_VALUE_UNSIGNED) {
+                uint64_t umin = (size == 4) ? readLE32(min) : readLE64(min);
+                uint64_t umax = (size == 4) ? readLE32(max) : readLE64(max);
+
+                // Beyond the range of int8, the values can't be compared with the constant.
+                if (umin > (uint64_t)INT64_MAX || umax > (uint64_t)INT64_MAX) {
+                    continue;
+                }
+                minValue = umin;
+                maxValue = umax;
+            } else {
+                minValue = (size == 4) ? (int32_t)readLE32(min) : (int64_t)readLE64(min);
+                maxValue = (size == 4) ? (int32_t)readLE32(max) : (int64_t)readLE64(max);
+            }
+
+            if (!rangeMayMatch(minValue, maxValue, filter.op, c)) {
+                return false;
+            }
+        } else if (filter.type == PARQUET_FILTER_STRING && column.type == PARQUET_BYTE_ARRAY &&
+                   column.kind == PARQUET_VALUE_STRING) {
+            // min_value and max_value of strings are ordered by unsigned bytes, like C collation
+            if (!rangeMayMatch(stats.min, stats.max, filter.op, filter.value)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void ParquetReader::decodeColumnChunk(const ParquetSchemaColumn &column,
+                                      const ParquetColumnChunk &chunk, const char *data,
+                                      uint64_t len, ParquetColumnValues &values) {
+    const uint8_t *p = (const uint8_t *)data;
+    uint64_t pos = 0;
+    ParquetColumnValues dict;
+    bool hasDict = false;
+    string pageBuffer;
+    vector<uint8_t> defLevels;
+    bool optional = (column.repetition == PARQUET_OPTIONAL);
+
+    values.clear();
+    values.reserve(chunk.numValues);
+
+    while (values.size() < (uint64_t)chunk.numValues) {
+        ParquetPageHeader header;
+
+        S3_CHECK_OR_DIE(pos < len, S3RuntimeError, "invalid Parquet file: truncated column chunk");
+
+        ThriftCompactReader tr(p + pos, len - pos);
+        parsePageHeader(tr, header);
+        pos += tr.position();
+
+        S3_CHECK_OR_DIE((uint64_t)header.compressedSize <= len - pos, S3RuntimeError,
+                        "invalid Parquet file: truncated column chunk");
+
+        const uint8_t *page = p + pos;
+        uint64_t pageLen = header.compressedSize;
+        pos += pageLen;
+
+        if (header.type == PARQUET_PAGE_DICTIONARY) {
+            S3_CHECK_OR_DIE(header.encoding == PARQUET_ENCODING_PLAIN ||
+                                header.encoding == PARQUET_ENCODING_PLAIN_DICTIONARY,
+                            S3RuntimeError,
+                            "unsupported Parquet dictionary encoding " +
+                                std::to_string(header.encoding));
+
+            const uint8_t *buf =
+                uncompressPage(chunk.codec, page, pageLen, header.uncompressedSize, pageBuffer);
+            vector<uint8_t> noLevels;
+            ParquetSchemaColumn required = column;
+
+            required.repetition = PARQUET_REQUIRED;
+            dict.clear();
+            dict.reserve(header.numValues);
+            decodeValues(required, PARQUET_ENCODING_PLAIN, buf, header.uncompressedSize,
+                         header.numValues, NULL, noLevels, dict);
+            hasDict = true;
+        } else if (header.type == PARQUET_PAGE_DATA) {
+            const uint8_t *buf =
+                uncompressPage(chunk.codec, page, pageLen, header.uncompressedSize, pageBuffer);
+            uint64_t bufLen = header.uncompressedSize;
+
+            // Flat columns have no repetition levels, definition levels have a length prefix.
+            defLevels.clear();
+            if (optional) {
+                S3_CHECK_OR_DIE(bufLen >= 4 && readLE32(buf) <= bufLen - 4, S3RuntimeError,
+                                "invalid Parquet file: truncated page");
+                uint64_t levelsLen = readLE32(buf);
+                decodeLevels(buf + 4, levelsLen, header.numValues, defLevels);
+                buf += 4 + levelsLen;
+                bufLen -= 4 + levelsLen;
+            }
+
+            decodeValues(column, header.encoding, buf, bufLen, header.numValues,
+                         hasDict ? &dict : NULL, defLevels, values);
+        } else if (header.type == PARQUET_PAGE_DATA_V2) {
+            uint64_t levelsLen = (uint64_t)header.defLevelsLength + header.repLevelsLength;
+
+            S3_CHECK_OR_DIE(header.repLevelsLength == 0 && levelsLen <= pageLen &&
+                                levelsLen <= (uint64_t)header.uncompressedSize,
+                            S3RuntimeError, "invalid Parquet file: bad page levels");
+
+            // Levels of v2 pages are never compressed.
+            defLevels.clear();
+            if (optional) {
+                decodeLevels(page, header.defLevelsLength, header.numValues, defLevels);
+            }
+
+            const uint8_t *buf = uncompressPage(
+                header.isCompressed ? chunk.codec : (int32_t)PARQUET_CODEC_UNCOMPRESSED,
+                page + levelsLen, pageLen - levelsLen, header.uncompressedSize - levelsLen,
+                pageBuffer);
+
+            decodeValues(column, header.encoding, buf, header.uncompressedSize - levelsLen,
+                         header.numValues, hasDict ? &dict : NULL, defLevels, values);
+        }
+        // index pages are skipped
+    }
+
+    S3_CHECK_OR_DIE(values.size() == (uint64_t)chunk.numValues, S3RuntimeError,
+                    "invalid Parquet file: wrong number of values in column chunk");
+}
+
+// Fetch and decode the needed columns of the next row group that may have matching rows.
+bool ParquetReader::loadNextRowGroup() {
+    while (this->curRowGroup < this->rowGroups.size()) {
+        const ParquetRowGroup &rowGroup = this->rowGroups[this->curRowGroup++];
+
+        if (!this->rowGroupMayMatch(rowGroup)) {
+            this->numSkippedRowGroups++;
+            continue;
+        }
+
+        // Ranges of the needed column chunks, adjacent ones are fetched together.
+        vector<std::pair<uint64_t, int> > chunks;
+        for (uint64_t i = 0; i < this->outputColumns.size(); i++) {
+            int col = this->outputColumns[i];
+            if (col >= 0) {
+                chunks.push_back(std::make_pair(rowGroup.columns[col].getOffset(), col));
+            }
+        }
+        std::sort(chunks.begin(), chunks.end());
+
+        this->columnValues.resize(this->schema.size());
+
+        uint64_t i = 0;
+        while (i < chunks.size()) {
+            uint64_t start = chunks[i].first;
+            uint64_t end = start + rowGroup.columns[chunks[i].second].totalCompressedSize;
+            uint64_t j = i + 1;
+
+            while (j < chunks.size() && chunks[j].first <= end + PARQUET_RANGE_MERGE_GAP) {
+                uint64_t chunkEnd =
+                    chunks[j].first + rowGroup.columns[chunks[j].second].totalCompressedSize;
+                end = std::max(end, chunkEnd);
+                j++;
+            }
+
+            // Small files and the last columns are already read with the footer.
+            string fetched;
+            const char *data;
+            if (start >= this->tailOffset && end <= this->tailOffset + this->tailData.size()) {
+                data = this->tailData.data() + (start - this->tailOffset);
+            } else {
+                this->fetchRange(start, end - start, fetched);
+                data = fetched.data();
+            }
+
+            for (; i < j; i++) {
+                int col = chunks[i].second;
+                const ParquetColumnChunk &chunk = rowGroup.columns[col];
+
+                // the same column may be output more than once
+                if (i > 0 && chunks[i - 1].second == col) {
+                    continue;
+                }
+
+                this->decodeColumnChunk(this->schema[col], chunk,
+                                        data + (chunk.getOffset() - start),
+                                        chunk.totalCompressedSize, this->columnValues[col]);
+                S3_CHECK_OR_DIE(this->columnValues[col].size() == (uint64_t)rowGroup.numRows,
+                                S3RuntimeError,
+                                "invalid Parquet file: column chunk doesn't match the row count");
+            }
+        }
+
+        this->curRow = 0;
+        this->numRows = rowGroup.numRows;
+        if (this->numRows > 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ParquetReader::appendValue(const ParquetColumnValues &values, uint64_t row, bool isString) {
+    const char *value = values.getValue(row);
+    uint64_t len = values.getLength(row);
+    bool quoted = isString || len == 0 ||
+                  (len == this->spec.nullString.size() &&
+                   memcmp(value, this->spec.nullString.data(), len) == 0);
+
+    for (uint64_t i = 0; i < len && !quoted; i++) {
+        char c = value[i];
+        quoted = (c == this->spec.delimiter || c == this->spec.quote ||
+                  c == this->spec.escape || c == '\n' || c == '\r');
+    }
+
+    if (!quoted) {
+        this->outBuffer.append(value, len);
+        return;
+    }
+
+    this->outBuffer.push_back(this->spec.quote);
+    for (uint64_t i = 0; i < len; i++) {
+        char c = value[i];
+        if (c == this->spec.quote || c == this->spec.escape) {
+            this->outBuffer.push_back(this->spec.escape);
+        }
+        this->outBuffer.push_back(c);
+    }
+    this->outBuffer.push_back(this->spec.quote);
+}
+
+// Convert a batch of rows of the current row group to CSV lines.
+void ParquetReader::formatRows() {
+    this->outBuffer.clear();
+    this->outOffset = 0;
+
+    while (this->curRow < this->numRows && this->outBuffer.size() < PARQUET_OUTPUT_BATCH_SIZE) {
+        for (uint64_t i = 0; i < this->outputColumns.size(); i++) {
+            int col = this->outputColumns[i];
+
+            if (i > 0) {
+                this->outBuffer.push_back(this->spec.delimiter);
+            }
+
+            if (col < 0 || this->columnValues[col].isNull(this->curRow)) {
+                this->outBuffer.append(this->spec.nullString);
+            } else {
+                const ParquetSchemaColumn &column = this->schema[col];
+                bool isString = (column.type == PARQUET_BYTE_ARRAY ||
+                                 column.type == PARQUET_FIXED_LEN_BYTE_ARRAY) &&
+                                column.kind != PARQUET_VALUE_DECIMAL;
+
+                this->appendValue(this->columnValues[col], this->curRow, isString);
+            }
+        }
+        this->outBuffer.append(eolString);
+        this->curRow++;
+    }
+}
+
+uint64_t ParquetReader::read(char *buf, uint64_t count) {
+    uint64_t filled = 0;
+
+    while (filled < count) {
+        if (this->outOffset < this->outBuffer.size()) {
+            uint64_t len = std::min(count - filled, this->outBuffer.size() - this->outOffset);
+            memcpy(buf + filled, this->outBuffer.data() + this->outOffset, len);
+            this->outOffset += len;
+            filled += len;
+            continue;
+        }
+
+        if (this->curRow >= this->numRows && !this->loadNextRowGroup()) {
+            break;
+        }
+        this->formatRows();
+    }
+
+    return filled;
+}
+
+// This should be reentrant, has no side effects when called multiple times.
+void ParquetReader::close() {
+    if (this->curRowGroup > 0) {
+        S3DEBUG("Parquet file %s: skipped %" PRIu64 " of %" PRIu64 " row groups, fetched %" PRIu64
+                " bytes",
+                this->params.getS3Url().getFullUrlForCurl().c_str(), this->numSkippedRowGroups,
+                (uint64_t)this->rowGroups.size(), this->fetchedBytes);
+    }
+
+    this->schema.clear();
+    this->rowGroups.clear();
+    this->outputColumns.clear();
+    this->columnValues.clear();
+    this->outBuffer.clear();
+    this->tailData.clear();
+
+    this->tailOffset = 0;
+    this->curRowGroup = 0;
+    this->numSkippedRowGroups = 0;
+    this->fetchedBytes = 0;
+    this->curRow = 0;
+    this->numRows = 0;
+    this->outOffset = 0;
+}
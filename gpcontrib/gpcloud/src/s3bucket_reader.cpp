@@ -35,16 +35,27 @@ BucketContent& S3BucketReader::getNextKey() {
     return key;
 }
 
-S3Params S3BucketReader::constructReaderParams(BucketContent& key) {
-    // encode the key name but leave the "/"
-    // "/encoded_path/encoded_name"
-    string keyEncoded = UriEncode(key.getName());
+// encode the key name but leave the "/"
+// "/encoded_path/encoded_name"
+static string EncodeKeyName(const string& name) {
+    string keyEncoded = UriEncode(name);
     FindAndReplace(keyEncoded, "%2F", "/");
+    return keyEncoded;
+}
 
-    S3Params readerParams = this->params.setPrefix(keyEncoded);
+S3Params S3BucketReader::constructReaderParams(BucketContent& key) {
+    S3Params readerParams = this->params.setPrefix(EncodeKeyName(key.getName()));
 
     readerParams.setKeySize(key.getSize());
 
+    // Let the key reader prefetch the key this segment reads next.
+    if (this->keyIndex < this->keyList.contents.size()) {
+        BucketContent& nextKey = this->keyList.contents[this->keyIndex];
+        S3Params nextParams = this->params.setPrefix(EncodeKeyName(nextKey.getName()));
+
+        readerParams.setNextKey(nextParams.getS3Url(), nextKey.getSize());
+    }
+
     S3DEBUG("key: %s, size: %" PRIu64, readerParams.getS3Url().getFullUrlForCurl().c_str(),
             readerParams.getKeySize());
     return readerParams;
@@ -8,6 +8,7 @@ void S3CommonReader::open(const S3Params &params) {
     switch (compressionType) {
         case S3_COMPRESSION_DEFLATE:
         case S3_COMPRESSION_GZIP:
+        case S3_COMPRESSION_ZSTD:
             this->upstreamReader = &this->decompressReader;
             this->decompressReader.setReader(&this->keyReader);
             break;
@@ -61,6 +61,11 @@ S3Params InitConfig(const string& urlWithOptions) {
     // region could be empty
     string urlRegion = GetOptS3(urlWithOptions, "region");
 
+    // objects are text by default
+    string format = GetOptS3(urlWithOptions, "format");
+    S3_CHECK_OR_DIE(format.empty() || format == "parquet", S3ConfigError,
+                    "\"FATAL: format '" + format + "' is not supported\"", "format");
+
     // read configurations from file
     Config s3Cfg(configPath);
 
@@ -121,6 +126,8 @@ S3Params InitConfig(const string& urlWithOptions) {
 
     params.setGpcheckcloud_newline(s3Cfg.Get(configSection, "gpcheckcloud_newline", "\n"));
 
+    params.setParquet(format == "parquet");
+
     CheckEssentialConfig(params);
 
     return params;
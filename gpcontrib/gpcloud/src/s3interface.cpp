@@ -386,6 +386,11 @@ S3CompressionType S3InterfaceService::checkCompressionType(const S3Url &s3Url) {
         if ((responseData[0] == 0x1f) && (responseData[1] == 0x8b)) {
             return S3_COMPRESSION_GZIP;
         }
+
+        if ((responseData[0] == 0x28) && (responseData[1] == 0xb5) && (responseData[2] == 0x2f) &&
+            (responseData[3] == 0xfd)) {
+            return S3_COMPRESSION_ZSTD;
+        }
     } else if (resp.getStatus() == RESPONSE_ERROR) {
         S3MessageParser s3msg(resp);
         S3_DIE(S3LogicError, s3msg.getCode(), s3msg.getMessage());
@@ -1,5 +1,20 @@
 #include "s3key_reader.h"
 
+// Once less than a chunk is left for each thread, the rest of the key is split evenly among the
+// threads, so that they finish together instead of leaving the last chunks to a few of them.
+uint64_t OffsetMgr::getRangeLength() const {
+    uint64_t remaining = this->keySize - std::min(this->curPos, this->keySize);
+
+    if (remaining >= this->chunkSize * this->numOfThreads) {
+        return this->chunkSize;
+    }
+
+    uint64_t minLength = std::min(this->chunkSize, (uint64_t)S3_MIN_RANGE_SIZE);
+    uint64_t length = (remaining + this->numOfThreads - 1) / this->numOfThreads;
+
+    return std::min(std::max(length, minLength), this->chunkSize);
+}
+
 // Return (offset, length) of next chunk to download,
 // or (fileSize, 0) if reach end of file.
 Range OffsetMgr::getNextOffset() {
@@ -7,14 +22,8 @@ Range OffsetMgr::getNextOffset() {
 
     pthread_mutex_lock(&this->offsetLock);
     ret.offset = std::min(this->curPos, this->keySize);
-
-    if (this->curPos + this->chunkSize > this->keySize) {
-        ret.length = this->keySize - this->curPos;
-        this->curPos = this->keySize;
-    } else {
-        ret.length = this->chunkSize;
-        this->curPos += this->chunkSize;
-    }
+    ret.length = std::min(this->getRangeLength(), this->keySize - ret.offset);
+    this->curPos = ret.offset + ret.length;
     pthread_mutex_unlock(&this->offsetLock);
 
     return ret;
@@ -177,14 +186,59 @@ static void* DownloadThreadFunc(void* data) {
             }
         }
     } while (!buffer->isEOF());
+
+    if (!buffer->isError()) {
+        buffer->getKeyReader().prefetchNextKey();
+    }
+
     S3DEBUG("Downloading thread ended");
     return NULL;
 }
 
+void S3KeyReader::prefetchNextKey() {
+    // The reader has only one spare chunk of memory, and the head it uses for the current key
+    // until read() consumes it takes the place of a chunk buffer (see open()).
+    if (this->params.getNextKeySize() == 0 || this->params.getNumOfChunks() < 2) {
+        return;
+    }
+
+    pthread_mutex_lock(&this->prefetchLock);
+    bool started = this->prefetchStarted;
+    this->prefetchStarted = true;
+    pthread_mutex_unlock(&this->prefetchLock);
+
+    if (started || this->isSharedError() || S3QueryIsAbortInProgress()) {
+        return;
+    }
+
+    const S3Url& url = this->params.getNextKeyUrl();
+    uint64_t len = std::min(this->params.getNextKeySize(),
+                            std::min(this->params.getChunkSize(), (uint64_t)S3_MIN_RANGE_SIZE));
+
+    S3VectorUInt8* data = new S3VectorUInt8(this->params.getMemoryContext());
+
+    try {
+        if (this->s3Interface->fetchData(0, *data, len, url) == len && data->size() == len) {
+            S3DEBUG("Prefetched %" PRIu64 " bytes of %s", len, url.getFullUrlForCurl().c_str());
+
+            this->nextHeadData = data;
+            this->nextHeadUrl = url.getFullUrlForCurl();
+            return;
+        }
+    } catch (S3Exception& e) {
+        // The next key is read as usual.
+        S3DEBUG("Failed to prefetch %s: %s", url.getFullUrlForCurl().c_str(),
+                e.getMessage().c_str());
+    }
+
+    delete data;
+}
+
 void S3KeyReader::open(const S3Params& params) {
     S3_CHECK_OR_DIE(this->s3Interface != NULL, S3RuntimeError, "s3Interface must not be NULL");
 
     this->sharedError = false;
+    this->params = params;
 
     this->numOfChunks = params.getNumOfChunks();
     S3_CHECK_OR_DIE(this->numOfChunks > 0, S3RuntimeError, "numOfChunks must not be zero");
@@ -195,6 +249,28 @@ void S3KeyReader::open(const S3Params& params) {
     S3_CHECK_OR_DIE(params.getChunkSize() > 0, S3RuntimeError,
                     "chunk size must be greater than zero");
 
+    // Take the head of this key if it was prefetched while the previous key was read.
+    this->releaseHead();
+    if (this->nextHeadData != NULL && this->nextHeadUrl == params.getS3Url().getFullUrlForCurl() &&
+        this->nextHeadData->size() <= params.getKeySize()) {
+        this->headData = this->nextHeadData;
+        this->nextHeadData = NULL;
+
+        this->offsetMgr.setCurPos(this->headData->size());
+
+        // the head holds the memory of one chunk buffer
+        this->numOfChunks = std::max(this->numOfChunks - 1, (uint64_t)1);
+    }
+    this->releaseNextHead();
+
+    // Don't start more threads than there are ranges to download.
+    uint64_t remaining = params.getKeySize() - this->offsetMgr.getCurPos();
+    uint64_t minRangeSize = std::min(params.getChunkSize(), (uint64_t)S3_MIN_RANGE_SIZE);
+    uint64_t numOfRanges = (remaining + minRangeSize - 1) / minRangeSize;
+
+    this->numOfChunks = std::min(this->numOfChunks, std::max(numOfRanges, (uint64_t)1));
+    this->offsetMgr.setNumOfThreads(this->numOfChunks);
+
     this->chunkBuffers.reserve(this->numOfChunks);
 
     for (uint64_t i = 0; i < this->numOfChunks; i++) {
@@ -229,9 +305,23 @@ uint64_t S3KeyReader::read(char* buf, uint64_t count) {
             return 0;
         }
 
-        ChunkBuffer& buffer = chunkBuffers[this->curReadingChunk % this->numOfChunks];
+        if (this->headData != NULL) {
+            readLen = std::min(count, this->headData->size() - this->headOffset);
+            memcpy(buf, this->headData->data() + this->headOffset, readLen);
 
-        readLen = buffer.read(buf, count);
+            this->headOffset += readLen;
+            if (this->headOffset == this->headData->size()) {
+                this->releaseHead();
+            }
+        } else {
+            ChunkBuffer& buffer = chunkBuffers[this->curReadingChunk % this->numOfChunks];
+
+            readLen = buffer.read(buf, count);
+
+            if (readLen < count) {
+                this->curReadingChunk++;
+            }
+        }
 
         if (this->isSharedError()) {
             if (this->sharedException != NULL) {
@@ -248,10 +338,6 @@ uint64_t S3KeyReader::read(char* buf, uint64_t count) {
             }
         }
 
-        if (readLen < count) {
-            this->curReadingChunk++;
-        }
-
         count -= readLen;
     } while (readLen == 0);  // retry to confirm whether thread reading is finished or chunk size is
                              // divisible by get()'s buffer size
@@ -259,7 +345,19 @@ uint64_t S3KeyReader::read(char* buf, uint64_t count) {
     return readLen;
 }
 
-// reset marks before reading next key
+void S3KeyReader::releaseHead() {
+    delete this->headData;
+    this->headData = NULL;
+    this->headOffset = 0;
+}
+
+void S3KeyReader::releaseNextHead() {
+    delete this->nextHeadData;
+    this->nextHeadData = NULL;
+    this->nextHeadUrl.clear();
+}
+
+// reset marks before reading next key, the prefetched head of the next key is kept.
 void S3KeyReader::reset() {
     this->sharedError = false;
     this->curReadingChunk = 0;
@@ -270,20 +368,27 @@ void S3KeyReader::reset() {
     this->chunkBuffers.clear();
     this->threads.clear();
 
+    this->releaseHead();
+    this->prefetchStarted = false;
+
     this->hasEol = false;
     this->eolAppended = false;
 }
 
 void S3KeyReader::close() {
-    // to interupt downlading thread, we must: (check ChunkBuffer::fill())
-    // 1. set condition to ReadyToFill and signal conditional_variable.
-    // 2. set the shared error status to prevent download thread from continuing.
-    this->sharedError = true;
-
-    for (uint64_t i = 0; i < this->chunkBuffers.size(); i++) {
-        UniqueLock lock(this->chunkBuffers[i].getStatMutex());
-        this->chunkBuffers[i].setStatus(ReadyToFill);
-        pthread_cond_signal(this->chunkBuffers[i].getStatCond());
+    // If the whole key has been read, all downloading threads have reached the end of the key and
+    // exit by themselves, after one of them prefetches the next key. Otherwise interrupt them.
+    if (this->transferredKeyLen < this->offsetMgr.getKeySize() || this->isSharedError()) {
+        // to interupt downlading thread, we must: (check ChunkBuffer::fill())
+        // 1. set condition to ReadyToFill and signal conditional_variable.
+        // 2. set the shared error status to prevent download thread from continuing.
+        this->sharedError = true;
+
+        for (uint64_t i = 0; i < this->chunkBuffers.size(); i++) {
+            UniqueLock lock(this->chunkBuffers[i].getStatMutex());
+            this->chunkBuffers[i].setStatus(ReadyToFill);
+            pthread_cond_signal(this->chunkBuffers[i].getStatCond());
+        }
     }
 
     for (uint64_t i = 0; i < this->threads.size(); i++) {
@@ -7,6 +7,7 @@ S3RESTfulService::S3RESTfulService()
       debugCurl(false),
       verifyCert(true),
       chunkBufferSize(64 * 1024) {
+    this->initShare();
 }
 
 S3RESTfulService::S3RESTfulService(const string &proxy)
@@ -16,6 +17,7 @@ S3RESTfulService::S3RESTfulService(const string &proxy)
       debugCurl(false),
       verifyCert(true),
       chunkBufferSize(64 * 1024) {
+    this->initShare();
 }
 
 S3RESTfulService::S3RESTfulService(const S3Params &params)
@@ -30,14 +32,48 @@ S3RESTfulService::S3RESTfulService(const S3Params &params)
     this->chunkBufferSize = params.getChunkSize();
     this->verifyCert = params.isVerifyCert();
     this->proxy = params.getProxy();
+
+    this->initShare();
 }
 
 S3RESTfulService::~S3RESTfulService() {
+    curl_share_cleanup(this->share);
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_destroy(&this->shareLocks[i]);
+    }
+
     // This function is not thread safe, must NOT call it when any other
     // threads are running, that is, do NOT put it in threads.
     curl_global_cleanup();
 }
 
+static void RESTfulServiceShareLock(CURL *handle, curl_lock_data data, curl_lock_access access,
+                                    void *userp) {
+    pthread_mutex_lock(&((pthread_mutex_t *)userp)[data]);
+}
+
+static void RESTfulServiceShareUnlock(CURL *handle, curl_lock_data data, void *userp) {
+    pthread_mutex_unlock(&((pthread_mutex_t *)userp)[data]);
+}
+
+void S3RESTfulService::initShare() {
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&this->shareLocks[i], NULL);
+    }
+
+    this->share = curl_share_init();
+    curl_share_setopt(this->share, CURLSHOPT_LOCKFUNC, RESTfulServiceShareLock);
+    curl_share_setopt(this->share, CURLSHOPT_UNLOCKFUNC, RESTfulServiceShareUnlock);
+    curl_share_setopt(this->share, CURLSHOPT_USERDATA, this->shareLocks);
+
+    curl_share_setopt(this->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(this->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+    // Not CURL_LOCK_DATA_CONNECT: libcurl doesn't support sharing connections between concurrent
+    // threads, and the download threads run concurrently. Resumed TLS sessions still save most of
+    // the handshake of a new connection.
+}
+
 // curl's write function callback.
 static size_t RESTfulServiceWriteFuncCallback(char *ptr, size_t size, size_t nmemb, void *userp) {
     if (S3QueryIsAbortInProgress()) {
@@ -96,10 +132,10 @@ static size_t RESTfulServiceReadFuncCallback(char *ptr, size_t size, size_t nmem
 
 struct CURLWrapper {
     CURLWrapper(const string &url, curl_slist *headers, uint64_t lowSpeedLimit,
-                uint64_t lowSpeedTime, bool debugCurl, string proxy) {
+                uint64_t lowSpeedTime, bool debugCurl, string proxy, CURLSH *share) {
         curl = curl_easy_init();
         curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+        curl_easy_setopt(curl, CURLOPT_SHARE, share);
         curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
         curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
         curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, lowSpeedLimit);
@@ -149,7 +185,7 @@ Response S3RESTfulService::get(const string &url, HTTPHeaders &headers) {
 
     headers.CreateList();
     CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+                        this->debugCurl, this->proxy, this->share);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
@@ -182,7 +218,7 @@ Response S3RESTfulService::put(const string &url, HTTPHeaders &headers, const S3
 
     headers.CreateList();
     CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+                        this->debugCurl, this->proxy, this->share);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
@@ -225,7 +261,7 @@ Response S3RESTfulService::post(const string &url, HTTPHeaders &headers,
 
     headers.CreateList();
     CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+                        this->debugCurl, this->proxy, this->share);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
@@ -270,7 +306,7 @@ ResponseCode S3RESTfulService::head(const string &url, HTTPHeaders &headers) {
 
     headers.CreateList();
     CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+                        this->debugCurl, this->proxy, this->share);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "HEAD");
@@ -303,7 +339,7 @@ Response S3RESTfulService::deleteRequest(const string &url, HTTPHeaders &headers
 
     headers.CreateList();
     CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+                        this->debugCurl, this->proxy, this->share);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
@@ -311,3 +311,119 @@ TEST_F(DecompressReaderTest, AbleToDecompressWithIncorrectEncodedStream) {
 
     EXPECT_THROW(decompressReader.read(outputBuffer, sizeof(outputBuffer)), S3RuntimeError);
 }
+
+// Build a gzip member of 'input'. With 'bgzf', add the 'BC' extra subfield that records the
+// member size, like bgzip does.
+static vector<uint8_t> makeGzipMember(const string &input, bool bgzf) {
+    vector<uint8_t> deflated(input.size() + 1024);
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    zs.next_in = (Byte *)input.data();
+    zs.avail_in = input.size();
+    zs.next_out = deflated.data();
+    zs.avail_out = deflated.size();
+    deflate(&zs, Z_FINISH);
+    deflated.resize(zs.total_out);
+    deflateEnd(&zs);
+
+    vector<uint8_t> member = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff};
+    if (bgzf) {
+        member[3] = 4;  // FEXTRA
+        member.insert(member.end(), {6, 0, 'B', 'C', 2, 0, 0, 0});
+    }
+    member.insert(member.end(), deflated.begin(), deflated.end());
+
+    uint32_t crc = crc32(0, (const Bytef *)input.data(), input.size());
+    uint32_t isize = input.size();
+    for (int i = 0; i < 4; i++) member.push_back((crc >> (8 * i)) & 0xff);
+    for (int i = 0; i < 4; i++) member.push_back((isize >> (8 * i)) & 0xff);
+
+    if (bgzf) {
+        member[16] = (member.size() - 1) & 0xff;
+        member[17] = (member.size() - 1) >> 8;
+    }
+
+    return member;
+}
+
+static string readAll(DecompressReader &reader, uint64_t readSize) {
+    string result;
+    vector<char> buf(readSize);
+    uint64_t count;
+
+    while ((count = reader.read(buf.data(), readSize)) > 0) {
+        result.append(buf.data(), count);
+    }
+
+    return result;
+}
+
+TEST_F(DecompressReaderTest, AbleToDecompressMultiMemberGzip) {
+    string expected;
+    vector<uint8_t> data;
+
+    for (int i = 0; i < 100; i++) {
+        string line = "line " + std::to_string(i) + " of a concatenated gzip file\n";
+        vector<uint8_t> member = makeGzipMember(line, false);
+
+        expected += line;
+        data.insert(data.end(), member.begin(), member.end());
+    }
+
+    bufReader.setData(data.data(), data.size());
+
+    EXPECT_EQ(expected, readAll(decompressReader, 7));
+}
+
+TEST_F(DecompressReaderTest, AbleToDecompressGzipWithTrailingZeroPadding) {
+    string expected;
+    vector<uint8_t> data;
+
+    for (int i = 0; i < 3; i++) {
+        string line = "line " + std::to_string(i) + " of a padded gzip file\n";
+        vector<uint8_t> member = makeGzipMember(line, false);
+
+        expected += line;
+        data.insert(data.end(), member.begin(), member.end());
+    }
+
+    // e.g. a file written to a tape in 512 byte blocks
+    data.resize(data.size() + 512, 0);
+
+    bufReader.setData(data.data(), data.size());
+
+    EXPECT_EQ(expected, readAll(decompressReader, 7));
+}
+
+TEST_F(DecompressReaderTest, AbleToDecompressBGZFBlocksInParallel) {
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(4);
+
+    decompressReader.close();
+    decompressReader.open(params);
+
+    string expected;
+    vector<uint8_t> data;
+
+    for (int i = 0; i < 1000; i++) {
+        string block(i % 64 * 31 + 1, 'a' + i % 26);
+        vector<uint8_t> member = makeGzipMember(block, true);
+
+        expected += block;
+        data.insert(data.end(), member.begin(), member.end());
+    }
+
+    // bgzip ends files with an empty block.
+    vector<uint8_t> eof = makeGzipMember("", true);
+    data.insert(data.end(), eof.begin(), eof.end());
+
+    // small chunks so that the blocks get split across several batches
+    S3_ZIP_DECOMPRESS_CHUNKSIZE = 4096;
+    decompressReader.resizeDecompressReaderBuffer(S3_ZIP_DECOMPRESS_CHUNKSIZE);
+
+    bufReader.setData(data.data(), data.size());
+
+    EXPECT_EQ(expected, readAll(decompressReader, 1000));
+}
@@ -0,0 +1,316 @@
+#include "parquet_reader.cpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mock_classes.h"
+
+#include <fstream>
+
+using ::testing::_;
+using ::testing::AtLeast;
+using ::testing::Invoke;
+
+// Serves ranged GETs from a local Parquet file.
+class MockParquetObject {
+   public:
+    explicit MockParquetObject(const char *path) {
+        std::ifstream file(path, std::ios::binary);
+        std::stringstream ss;
+        ss << file.rdbuf();
+        this->data = ss.str();
+    }
+
+    uint64_t fetchData(uint64_t offset, S3VectorUInt8 &out, uint64_t len, const S3Url &s3Url) {
+        out.assign(this->data.begin() + offset, this->data.begin() + offset + len);
+        return len;
+    }
+
+    string data;
+};
+
+class ParquetReaderTest : public testing::Test {
+   protected:
+    virtual void SetUp() {
+        eolString[0] = '\n';
+        eolString[1] = '\0';
+
+        reader.setS3InterfaceService(&s3Interface);
+    }
+
+    virtual void TearDown() {
+        reader.close();
+    }
+
+    void open(MockParquetObject &object, const ParquetScanSpec &spec, uint64_t chunkSize = 1024) {
+        EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+            .Times(AtLeast(1))
+            .WillRepeatedly(Invoke(&object, &MockParquetObject::fetchData));
+
+        S3Params params("s3://abc/def.parquet");
+        params.setKeySize(object.data.size());
+        params.setChunkSize(chunkSize);
+        params.setParquet(true);
+        params.setParquetScanSpec(spec);
+
+        reader.open(params);
+    }
+
+    // Read everything in small pieces.
+    string readAll() {
+        string result;
+        char buf[100];
+        uint64_t count;
+
+        while ((count = reader.read(buf, sizeof(buf))) > 0) {
+            result.append(buf, count);
+        }
+        return result;
+    }
+
+    vector<string> readLines() {
+        vector<string> lines;
+        std::stringstream ss(this->readAll());
+        string line;
+
+        while (std::getline(ss, line)) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    MockS3Interface s3Interface;
+    ParquetReader reader;
+};
+
+TEST_F(ParquetReaderTest, ReadAllColumns) {
+    MockParquetObject object("data/parquet_v1.parquet");
+    ParquetScanSpec spec;
+
+    this->open(object, spec);
+
+    EXPECT_EQ((uint64_t)7, reader.getSchema().size());
+    EXPECT_EQ((uint64_t)3, reader.getNumRowGroups());
+
+    vector<string> lines = this->readLines();
+    ASSERT_EQ((uint64_t)30, lines.size());
+    EXPECT_EQ("0,\"name0\",0,t,2020-01-01,2021-06-01 12:00:00+00,-5.00", lines[0]);
+    EXPECT_EQ("1,\"name1\",1.5,f,2020-01-02,2021-06-01 12:00:00.001000+00,-3.99", lines[1]);
+    EXPECT_EQ("3,,4.5,t,2020-01-04,2021-06-01 12:00:00.003000+00,-1.97", lines[3]);
+    EXPECT_EQ("5,\"a,\"\"b\"\"\",7.5,f,2020-01-06,2021-06-01 12:00:00.005000+00,0.05", lines[5]);
+    EXPECT_EQ("29,\"name1\",43.5,f,2020-01-30,2021-06-01 12:00:00.029000+00,24.29", lines[29]);
+
+    EXPECT_EQ((uint64_t)0, reader.read(NULL, 100));
+}
+
+TEST_F(ParquetReaderTest, ReadProjectedColumns) {
+    MockParquetObject object("data/parquet_v1.parquet");
+    ParquetScanSpec spec;
+
+    spec.columns.push_back("ID");
+    spec.columns.push_back("name");
+    spec.columns.push_back("flag");
+    spec.columns.push_back("no_such_column");
+    spec.needed.push_back(true);
+    spec.needed.push_back(false);
+    spec.needed.push_back(true);
+    spec.needed.push_back(true);
+    spec.delimiter = '|';
+    spec.nullString = "\\N";
+
+    this->open(object, spec);
+
+    vector<string> lines = this->readLines();
+    ASSERT_EQ((uint64_t)30, lines.size());
+    EXPECT_EQ("0|\\N|t|\\N", lines[0]);
+    EXPECT_EQ("10|\\N|f|\\N", lines[10]);
+
+    // The chunks of the last three columns are not fetched.
+    uint64_t projectedBytes = reader.getFetchedBytes();
+    reader.close();
+
+    this->open(object, ParquetScanSpec());
+    this->readAll();
+    EXPECT_LT(projectedBytes, reader.getFetchedBytes());
+}
+
+TEST_F(ParquetReaderTest, ReuseFooterReadForSmallFile) {
+    MockParquetObject object("data/parquet_v2.parquet");
+    ParquetScanSpec spec;
+
+    this->open(object, spec, 1024 * 1024);
+
+    // The whole object is fetched by the footer read, and only once.
+    EXPECT_EQ((uint64_t)30, this->readLines().size());
+    EXPECT_EQ(object.data.size(), reader.getFetchedBytes());
+}
+
+TEST_F(ParquetReaderTest, SkipRowGroupsByStatistics) {
+    MockParquetObject object("data/parquet_v1.parquet");
+    ParquetScanSpec spec;
+
+    spec.columns.push_back("id");
+    spec.needed.push_back(true);
+    spec.filters.push_back(ParquetFilter("id", PARQUET_FILTER_INT, PARQUET_OP_GE, "12"));
+    spec.filters.push_back(ParquetFilter("id", PARQUET_FILTER_INT, PARQUET_OP_LT, "20"));
+
+    this->open(object, spec);
+
+    vector<string> lines = this->readLines();
+    ASSERT_EQ((uint64_t)10, lines.size());
+    EXPECT_EQ("10", lines[0]);
+    EXPECT_EQ((uint64_t)2, reader.getNumSkippedRowGroups());
+}
+
+TEST_F(ParquetReaderTest, SkipRowGroupsByStringStatistics) {
+    MockParquetObject object("data/parquet_v1.parquet");
+    ParquetScanSpec spec;
+
+    spec.columns.push_back("id");
+    spec.needed.push_back(true);
+    spec.filters.push_back(ParquetFilter("name", PARQUET_FILTER_STRING, PARQUET_OP_EQ, "a,\"b\""));
+
+    this->open(object, spec);
+
+    // 'a,"b"' is in the first row group only.
+    EXPECT_EQ((uint64_t)10, this->readLines().size());
+    EXPECT_EQ((uint64_t)2, reader.getNumSkippedRowGroups());
+}
+
+TEST_F(ParquetReaderTest, SkipRowGroupsByUnsignedStatistics) {
+    MockParquetObject object("data/parquet_unsigned.parquet");
+    ParquetScanSpec spec;
+
+    spec.columns.push_back("u");
+    spec.needed.push_back(true);
+    spec.filters.push_back(ParquetFilter("u", PARQUET_FILTER_INT, PARQUET_OP_GE, "3000000000"));
+
+    this->open(object, spec);
+
+    // The second row group holds 3000000000 to 3000000009, negative if read as signed.
+    vector<string> lines = this->readLines();
+    ASSERT_EQ((uint64_t)10, lines.size());
+    EXPECT_EQ("3000000000", lines[0]);
+    EXPECT_EQ((uint64_t)1, reader.getNumSkippedRowGroups());
+}
+
+TEST_F(ParquetReaderTest, KeepRowGroupsOfMismatchedType) {
+    MockParquetObject object("data/parquet_v1.parquet");
+    ParquetScanSpec spec;
+
+    spec.columns.push_back("id");
+    spec.needed.push_back(true);
+
+    // An int column over strings: "100" sorts before all the names.
+    spec.filters.push_back(ParquetFilter("name", PARQUET_FILTER_INT, PARQUET_OP_EQ, "100"));
+    // A text column over integers: '10' < '5' holds for text.
+    spec.filters.push_back(ParquetFilter("id", PARQUET_FILTER_STRING, PARQUET_OP_LT, "5"));
+
+    this->open(object, spec);
+
+    EXPECT_EQ((uint64_t)30, this->readLines().size());
+    EXPECT_EQ((uint64_t)0, reader.getNumSkippedRowGroups());
+}
+
+TEST_F(ParquetReaderTest, SkipAllRowGroupsOfMissingColumn) {
+    MockParquetObject object("data/parquet_v1.parquet");
+    ParquetScanSpec spec;
+
+    spec.columns.push_back("id");
+    spec.needed.push_back(true);
+    spec.filters.push_back(ParquetFilter("no_such_column", PARQUET_FILTER_INT, PARQUET_OP_EQ, "1"));
+
+    this->open(object, spec);
+
+    EXPECT_EQ((uint64_t)0, this->readLines().size());
+    EXPECT_EQ((uint64_t)3, reader.getNumSkippedRowGroups());
+}
+
+TEST_F(ParquetReaderTest, ReadGzipDataPageV2) {
+    MockParquetObject object("data/parquet_v2.parquet");
+    ParquetScanSpec spec;
+
+    this->open(object, spec);
+
+    vector<string> lines = this->readLines();
+    ASSERT_EQ((uint64_t)30, lines.size());
+    EXPECT_EQ(",\"name0\"", lines[0]);
+    EXPECT_EQ("1,\"name1\"", lines[1]);
+    EXPECT_EQ("3,", lines[3]);
+    EXPECT_EQ("29,\"name1\"", lines[29]);
+}
+
+TEST_F(ParquetReaderTest, RejectNonParquetObject) {
+    MockParquetObject object("data/s3test.conf");
+    ParquetScanSpec spec;
+
+    EXPECT_THROW(this->open(object, spec), S3RuntimeError);
+}
+
+TEST_F(ParquetReaderTest, RejectBadFooterSize) {
+    MockParquetObject object("data/parquet_v1.parquet");
+    ParquetScanSpec spec;
+
+    // keep the magic but break the footer length
+    object.data[object.data.size() - 5] = 0x7f;
+
+    EXPECT_THROW(this->open(object, spec), S3RuntimeError);
+}
+
+TEST(ParquetSnappy, UncompressLiteralsAndCopies) {
+    // "abcabcabcabcX": literal "abc", copy of 9 bytes at offset 3, literal "X"
+    const uint8_t input[] = {13, 2 << 2, 'a', 'b', 'c', (uint8_t)(((9 - 1) << 2) | 2), 3, 0,
+                             0 << 2, 'X'};
+    char out[13];
+
+    snappyUncompress(input, sizeof(input), out, sizeof(out));
+    EXPECT_EQ(0, memcmp(out, "abcabcabcabcX", 13));
+
+    EXPECT_THROW(snappyUncompress(input, sizeof(input) - 1, out, sizeof(out)), S3RuntimeError);
+}
+
+TEST(ParquetFormat, Timestamps) {
+    char buf[128];
+
+    formatTimestamp(buf, sizeof(buf), 0, -1, 1000000, false);
+    EXPECT_STREQ("1969-12-31 23:59:59.999999", buf);
+
+    // INT96 style: days and nanoseconds of day
+    formatTimestamp(buf, sizeof(buf), -719162, 0, 1000000000, false);
+    EXPECT_STREQ("0001-01-01 00:00:00", buf);
+
+    formatDate(buf, sizeof(buf), 18262);
+    EXPECT_STREQ("2020-01-01", buf);
+
+    formatDecimal(buf, sizeof(buf), -5, 3);
+    EXPECT_STREQ("-0.005", buf);
+}
+
+TEST(ParquetFormat, DecimalLimits) {
+    char buf[8];
+    ParquetSchemaColumn column;
+
+    // "-0.005" and its NUL fit exactly
+    EXPECT_EQ(6, formatDecimal(buf, 7, -5, 3));
+    EXPECT_STREQ("-0.005", buf);
+    EXPECT_THROW(formatDecimal(buf, 6, -5, 3), S3RuntimeError);
+    EXPECT_THROW(formatDecimal(buf, sizeof(buf), 1, 100), S3RuntimeError);
+
+    column.kind = PARQUET_VALUE_DECIMAL;
+    column.precision = 38;
+    column.scale = 38;
+    EXPECT_NO_THROW(checkSchemaColumn(column));
+
+    column.scale = 64;
+    EXPECT_THROW(checkSchemaColumn(column), S3RuntimeError);
+
+    column.scale = -1;
+    EXPECT_THROW(checkSchemaColumn(column), S3RuntimeError);
+
+    column.precision = 39;
+    column.scale = 2;
+    EXPECT_THROW(checkSchemaColumn(column), S3RuntimeError);
+
+    // the precision is required for decimals only
+    column.kind = PARQUET_VALUE_PLAIN;
+    column.precision = 0;
+    EXPECT_NO_THROW(checkSchemaColumn(column));
+}
@@ -216,6 +216,23 @@ TEST(OffsetMgr, reset) {
     EXPECT_EQ((uint64_t)0, o.getCurPos());
 }
 
+TEST(OffsetMgr, SplitTailAmongThreads) {
+    OffsetMgr o;
+    o.setKeySize(100 * 1024 * 1024);
+    o.setChunkSize(32 * 1024 * 1024);
+    o.setNumOfThreads(2);
+
+    uint64_t expected[] = {32, 32, 18, 9, 8, 1, 0};
+    uint64_t offset = 0;
+
+    for (uint64_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        Range r = o.getNextOffset();
+        EXPECT_EQ(offset, r.offset);
+        EXPECT_EQ(expected[i] * 1024 * 1024, r.length);
+        offset += r.length;
+    }
+}
+
 TEST_F(S3KeyReaderTest, OpenWithZeroChunk) {
     S3Params params("s3://abc/def");
 
@@ -833,6 +850,66 @@ TEST_F(S3KeyReaderTest, MTReadWithHundredsOfThreadsAndSignalCancel) {
     EXPECT_THROW(this->read(buffer, 31), S3QueryAbort);
 }
 
+TEST_F(S3KeyReaderTest, ReadPrefetchedNextKey) {
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(2);
+    params.setKeySize(100);
+    params.setChunkSize(64);
+    params.setNextKey(S3Url("s3://abc/ghi"), 50);
+
+    EXPECT_CALL(s3Interface, fetchData(0, _, 64, _)).WillOnce(Invoke(MockFetchData(64, 64)));
+    EXPECT_CALL(s3Interface, fetchData(64, _, 36, _)).WillOnce(Invoke(MockFetchData(36, 36)));
+    EXPECT_CALL(s3Interface, fetchData(0, _, 50, _)).WillOnce(Invoke(MockFetchData(50, 50)));
+
+    this->open(params);
+
+    EXPECT_EQ((uint64_t)64, this->read(buffer, 64));
+    EXPECT_EQ((uint64_t)36, this->read(buffer, 64));
+    EXPECT_EQ((uint64_t)1, this->read(buffer, 64));
+    EXPECT_EQ((uint64_t)0, this->read(buffer, 64));
+
+    this->close();
+
+    // The next key is served from the prefetched data, without another request.
+    S3Params nextParams("s3://abc/ghi");
+    nextParams.setNumOfChunks(2);
+    nextParams.setKeySize(50);
+    nextParams.setChunkSize(64);
+
+    this->open(nextParams);
+
+    EXPECT_EQ((uint64_t)50, this->read(buffer, 64));
+    EXPECT_EQ((uint64_t)1, this->read(buffer, 64));
+    EXPECT_EQ((uint64_t)0, this->read(buffer, 64));
+}
+
+TEST_F(S3KeyReaderTest, DropPrefetchedDataOfOtherKey) {
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(2);
+    params.setKeySize(10);
+    params.setChunkSize(64);
+    params.setNextKey(S3Url("s3://abc/ghi"), 20);
+
+    EXPECT_CALL(s3Interface, fetchData(0, _, 10, _))
+        .Times(2)
+        .WillRepeatedly(Invoke(MockFetchData(10, 10)));
+    EXPECT_CALL(s3Interface, fetchData(0, _, 20, _)).WillOnce(Invoke(MockFetchData(20, 20)));
+
+    this->open(params);
+
+    EXPECT_EQ((uint64_t)10, this->read(buffer, 64));
+    EXPECT_EQ((uint64_t)1, this->read(buffer, 64));
+
+    this->close();
+
+    params.setNextKey(S3Url("s3://abc/ghi"), 0);
+    this->open(params);
+
+    EXPECT_EQ((uint64_t)10, this->read(buffer, 64));
+    EXPECT_EQ((uint64_t)1, this->read(buffer, 64));
+    EXPECT_EQ((uint64_t)0, this->read(buffer, 64));
+}
+
 TEST(ChunkBuffer, ChunkBufferOperatorEqual) {
     S3Url s3Url("s3://whatever");
     S3KeyReader reader;
@@ -102,12 +102,13 @@ static void buf_make_space(Relation rel,
 					  BMTidBuildBuf *tidLocsBuffer, bool use_wal);
 static void verify_bitmappages(Relation rel, BMLOVItem lovitem);
 static int16 buf_add_tid_with_fill(Relation rel, BMTIDBuffer *buf,
-								   Buffer lovBuffer, OffsetNumber off,
-								   uint64 tidnum, bool use_wal);
+								   Buffer lovBuffer, BlockNumber lovBlock,
+								   OffsetNumber off, uint64 tidnum,
+								   bool use_wal);
 static uint16 buf_extend(BMTIDBuffer *buf);
 static uint16 buf_ensure_head_space(Relation rel, BMTIDBuffer *buf,
-								   Buffer lovBuffer, OffsetNumber off,
-								   bool use_wal);
+								   Buffer lovBuffer, BlockNumber lovBlock,
+								   OffsetNumber off, bool use_wal);
 static uint16 buf_free_mem_block(Relation rel, BMTIDBuffer *buf,
 			  			         Buffer lovBuffer, OffsetNumber off,
 						         bool use_wal);
@@ -1705,11 +1706,16 @@ create_lovitem(Relation rel, Buffer metabuf, uint64 tidnum,
 /*
  * When building an index we try and buffer calls to write tids to disk
  * as it will result in lots of I/Os.
+ *
+ * If 'cachedbuf' is not NULL, it caches the BMTIDBuffer of this LOV item
+ * for the caller, so that subsequent calls for the same value don't need
+ * to search the LOV block list for it.
  */
 
 static void
 buf_add_tid(Relation rel, BMTidBuildBuf *tids, uint64 tidnum, 
-			BMBuildState *state, BlockNumber lov_block, OffsetNumber off)
+			BMBuildState *state, BlockNumber lov_block, OffsetNumber off,
+			BMTIDBuffer **cachedbuf)
 {
 	BMTIDBuffer *buf;
 	BMTIDLOVBuffer *lov_buf = NULL;
@@ -1718,6 +1724,13 @@ buf_add_tid(Relation rel, BMTidBuildBuf *tids, uint64 tidnum,
 	if (tids->byte_size >= maintenance_work_mem * 1024L)
 		buf_make_space(rel, tids, state->use_wal);
 
+	if (cachedbuf && *cachedbuf)
+	{
+		buf_add_tid_with_fill(rel, *cachedbuf, InvalidBuffer, lov_block, off,
+							  tidnum, state->use_wal);
+		return;
+	}
+
 	/*
 	 * tids is lazily initialized. If we do not have a current LOV block 
 	 * buffer, initialize one.
@@ -1761,13 +1774,14 @@ buf_add_tid(Relation rel, BMTidBuildBuf *tids, uint64 tidnum,
 
 	if (lov_buf->bufs[off - 1])
 	{
-
 		buf = lov_buf->bufs[off - 1];
 
-		Buffer lovbuf = _bitmap_getbuf(rel, lov_block, BM_WRITE);
-		buf_add_tid_with_fill(rel, buf, lovbuf, off,
+		/*
+		 * The LOV page is only needed if buffered words have to be written
+		 * out, buf_add_tid_with_fill() locks it then.
+		 */
+		buf_add_tid_with_fill(rel, buf, InvalidBuffer, lov_block, off,
 							  tidnum, state->use_wal);
-		_bitmap_relbuf(lovbuf);
 	}
 	else
 	{
@@ -1794,7 +1808,7 @@ buf_add_tid(Relation rel, BMTidBuildBuf *tids, uint64 tidnum,
 
 		buf->curword = 0;
 
-		buf_add_tid_with_fill(rel, buf, lovbuf, off, tidnum,
+		buf_add_tid_with_fill(rel, buf, lovbuf, lov_block, off, tidnum,
 							  state->use_wal);
 
 		_bitmap_relbuf(lovbuf);
@@ -1802,6 +1816,9 @@ buf_add_tid(Relation rel, BMTidBuildBuf *tids, uint64 tidnum,
 		lov_buf->bufs[off - 1] = buf;
 		tids->byte_size += bytes_added;
 	}
+
+	if (cachedbuf)
+		*cachedbuf = lov_buf->bufs[off - 1];
 }
 
 /*
@@ -1810,11 +1827,15 @@ buf_add_tid(Relation rel, BMTidBuildBuf *tids, uint64 tidnum,
  * Return how many bytes are used. Since we move words to disk when
  * there is no space left for new header words, this returning number
  * can be negative.
+ *
+ * 'lovBuffer' is the LOV page 'lovBlock', if the caller holds a BM_WRITE
+ * lock on it already. Otherwise it is InvalidBuffer, and the page is locked
+ * only if words need to be written out.
  */
 static int16
 buf_add_tid_with_fill(Relation rel, BMTIDBuffer *buf,
-					  Buffer lovBuffer, OffsetNumber off,
-					  uint64 tidnum, bool use_wal)
+					  Buffer lovBuffer, BlockNumber lovBlock,
+					  OffsetNumber off, uint64 tidnum, bool use_wal)
 {
 	int64 zeros;
 	uint16 inserting_pos;
@@ -1856,7 +1877,8 @@ buf_add_tid_with_fill(Relation rel, BMTIDBuffer *buf,
 			 * last bitmap complete word.
 			 */
 			bytes_used -=
-				buf_ensure_head_space(rel, buf, lovBuffer, off, use_wal);
+				buf_ensure_head_space(rel, buf, lovBuffer, lovBlock, off,
+						      use_wal);
 
 			bytes_used += mergewords(buf, false);
 			zeros -= zerosNeeded;
@@ -1883,7 +1905,8 @@ buf_add_tid_with_fill(Relation rel, BMTIDBuffer *buf,
 			buf->last_word = BM_MAKE_FILL_WORD(0, numOfFillWords);
 
 			bytes_used -= 
-				buf_ensure_head_space(rel, buf, lovBuffer, off, use_wal);
+				buf_ensure_head_space(rel, buf, lovBuffer, lovBlock, off,
+						      use_wal);
 			bytes_used += mergewords(buf, true);
 
 			numOfTotalFillWords -= numOfFillWords;
@@ -1913,7 +1936,8 @@ buf_add_tid_with_fill(Relation rel, BMTIDBuffer *buf,
 		}
 
 		bytes_used -=
-			buf_ensure_head_space(rel, buf, lovBuffer, off, use_wal);
+			buf_ensure_head_space(rel, buf, lovBuffer, lovBlock, off,
+					      use_wal);
 		bytes_used += mergewords(buf, lastWordFill);
 	}
 
@@ -1931,13 +1955,17 @@ buf_add_tid_with_fill(Relation rel, BMTIDBuffer *buf,
  */
 static uint16
 buf_ensure_head_space(Relation rel, BMTIDBuffer *buf, 
-					  Buffer lovBuffer, OffsetNumber off, bool use_wal)
+					  Buffer lovBuffer, BlockNumber lovBlock,
+					  OffsetNumber off, bool use_wal)
 {
 	uint16 bytes_freed = 0;
 
 	if (buf->curword >= (BM_NUM_OF_HEADER_WORDS * BM_HRL_WORD_SIZE))
 	{
-		bytes_freed = buf_free_mem_block(rel, buf, lovBuffer, off, use_wal);
+		if (BufferIsValid(lovBuffer))
+			bytes_freed = buf_free_mem_block(rel, buf, lovBuffer, off, use_wal);
+		else
+			bytes_freed = buf_free_mem(rel, buf, lovBlock, off, use_wal);
 		bytes_freed -= buf_extend(buf);
 	}
 
@@ -2146,7 +2174,8 @@ insertsetbit(Relation rel, BlockNumber lovBlock, OffsetNumber lovOffset,
 	 * To insert this new set bit, we also need to add all zeros between
 	 * this set bit and last set bit. We construct all new words here.
 	 */
-	buf_add_tid_with_fill(rel, buf, lovBuffer, lovOffset, tidnum, use_wal);
+	buf_add_tid_with_fill(rel, buf, lovBuffer, lovBlock, lovOffset, tidnum,
+						  use_wal);
 	
 	/*
 	 * If there are only updates to the last bitmap complete word and
@@ -2259,6 +2288,7 @@ build_inserttuple(Relation rel, uint64 tidnum,
 	int				attno;
 	bool			allNulls = true;
 	BMBuildHashKey  *entry;
+	BMTIDBuffer	  **cachedbuf = NULL;
 
 	CHECK_FOR_INTERRUPTS();
 
@@ -2274,11 +2304,12 @@ build_inserttuple(Relation rel, uint64 tidnum,
 		}
 	}
 
-	metabuf = _bitmap_getbuf(rel, BM_METAPAGE, BM_WRITE);
-	
 	/*
 	 * if the inserting tuple has the value of NULL, then
 	 * the corresponding tid array is the first.
+	 *
+	 * The meta page is only needed, and locked, to create a new LOV item.
+	 * Nothing else can modify the index while we're building it.
 	 */
 	if (allNulls)
 	{
@@ -2318,13 +2349,16 @@ build_inserttuple(Relation rel, uint64 tidnum,
 				 * If the inserting tuple has a new value, then we create a new
 				 * LOV item.
 				 */
+				metabuf = _bitmap_getbuf(rel, BM_METAPAGE, BM_WRITE);
 				create_lovitem(rel, metabuf, tidnum, tupDesc, attdata, 
 							   nulls, state->bm_lov_heap, state->bm_lov_index,
 							   &lovBlock, &lovOffset, state->use_wal);
+				_bitmap_wrtbuf(metabuf);
 
 				lov = (BMBuildLovData *) (((char*)entry) + state->lovitem_hashKeySize );
 				lov->lov_block = lovBlock;
 				lov->lov_off = lovOffset;
+				lov->tidbuf = NULL;
 			}
 
 			else
@@ -2333,6 +2367,9 @@ build_inserttuple(Relation rel, uint64 tidnum,
 				lovBlock = lov->lov_block;
 				lovOffset = lov->lov_off;
 			}
+
+			/* remember the tid buffer of this value in the hash entry, too */
+			cachedbuf = &lov->tidbuf;
 		}
 
 		else {
@@ -2368,15 +2405,17 @@ build_inserttuple(Relation rel, uint64 tidnum,
 				 * If the inserting tuple has a new value, then we create a new
 				 * LOV item.
 				 */
+				metabuf = _bitmap_getbuf(rel, BM_METAPAGE, BM_WRITE);
 				create_lovitem(rel, metabuf, tidnum, tupDesc, attdata, 
 							   nulls, state->bm_lov_heap, state->bm_lov_index,
 							   &lovBlock, &lovOffset, state->use_wal);
+				_bitmap_wrtbuf(metabuf);
 			}
 		}
 	}
 
-	buf_add_tid(rel, tidLocsBuffer, tidnum, state, lovBlock, lovOffset);
-	_bitmap_wrtbuf(metabuf);
+	buf_add_tid(rel, tidLocsBuffer, tidnum, state, lovBlock, lovOffset,
+				cachedbuf);
 
 	CHECK_FOR_INTERRUPTS();
 }
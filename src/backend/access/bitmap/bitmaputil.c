@@ -25,9 +25,13 @@
 #include "access/reloptions.h"
 #include "access/relscan.h"
 #include "miscadmin.h"
+#include "port/pg_bitutils.h"
 #include "storage/bufmgr.h"
 
 static void _bitmap_findnextword(BMBatchWords* words, uint64 nextReadNo);
+static uint32 _bitmap_literal_run(BMBatchWords *words, uint32 maxWords);
+static uint32 _bitmap_union_literals(BMBatchWords **batches, uint32 numBatches,
+									 uint64 nextReadNo, BMBatchWords *result);
 static void _bitmap_resetWord(BMBatchWords *words, uint32 prevStartNo);
 static uint8 _bitmap_find_bitset(BM_HRL_WORD word, uint8 lastPos);
 
@@ -588,6 +592,20 @@ _bitmap_union(BMBatchWords **batches, uint32 numBatches, BMBatchWords *result)
 		BM_HRL_WORD orWord = LITERAL_ALL_ZERO;
 		BM_HRL_WORD	word;
 		bool		orWordIsLiteral = true;
+		uint32		nliterals;
+
+		/*
+		 * For medium cardinality values, most words are literal. OR whole
+		 * runs of words that are literal in all the batches at once, rather
+		 * than walking through them one word at a time below.
+		 */
+		nliterals = _bitmap_union_literals(batches, numBatches, nextReadNo,
+										   result);
+		if (nliterals > 0)
+		{
+			nextReadNo += nliterals;
+			continue;
+		}
 
 		for (batchNo = 0; batchNo < numBatches; batchNo++)
 		{
@@ -683,6 +701,97 @@ _bitmap_union(BMBatchWords **batches, uint32 numBatches, BMBatchWords *result)
 	pfree(prevstarts);
 }
 
+/*
+ * _bitmap_literal_run() -- count the consecutive literal words starting
+ *		at the current position of 'words', up to 'maxWords'.
+ *
+ * Looks at the header words a whole word at a time.
+ */
+static uint32
+_bitmap_literal_run(BMBatchWords *words, uint32 maxWords)
+{
+	uint32		n = 0;
+
+	if (maxWords > words->nwords)
+		maxWords = words->nwords;
+
+	while (n < maxWords)
+	{
+		uint32		wordno = words->startNo + n;
+		uint32		bitno = wordno % BM_HRL_WORD_SIZE;
+		BM_HRL_WORD	h;
+
+		/* header bits are stored from the leftmost bit */
+		h = words->hwords[wordno / BM_HRL_WORD_SIZE] << bitno;
+		if (h == 0)
+			n += BM_HRL_WORD_SIZE - bitno;
+		else
+		{
+			n += BM_HRL_WORD_LEFTMOST - pg_leftmost_one_pos64(h);
+			break;
+		}
+	}
+
+	return Min(n, maxWords);
+}
+
+/*
+ * _bitmap_union_literals() -- OR a run of words that are literal in all
+ *		of the given batches into 'result'.
+ *
+ * Returns the number of words consumed from each batch, which is 0 if any
+ * of the batches is not at a literal word at position 'nextReadNo'. The
+ * run is never longer than what is left in the shortest batch, so that
+ * the caller sees the end of a batch the same way as before.
+ */
+static uint32
+_bitmap_union_literals(BMBatchWords **batches, uint32 numBatches,
+					   uint64 nextReadNo, BMBatchWords *result)
+{
+	uint32		run = result->maxNumOfWords - result->nwords;
+	uint32		batchNo;
+	uint32		i;
+	BM_HRL_WORD *out;
+
+	for (batchNo = 0; batchNo < numBatches && run > 1; batchNo++)
+	{
+		BMBatchWords *bch = batches[batchNo];
+
+		_bitmap_findnextword(bch, nextReadNo);
+		if (bch->nwords == 0 || bch->nwordsread != nextReadNo - 1)
+			return 0;
+
+		run = _bitmap_literal_run(bch, run);
+	}
+
+	/* not worth it for a single word */
+	if (run <= 1)
+		return 0;
+
+	out = result->cwords + result->nwords;
+	memcpy(out, batches[0]->cwords + batches[0]->startNo,
+		   run * sizeof(BM_HRL_WORD));
+	for (batchNo = 1; batchNo < numBatches; batchNo++)
+	{
+		const BM_HRL_WORD *in = batches[batchNo]->cwords + batches[batchNo]->startNo;
+
+		for (i = 0; i < run; i++)
+			out[i] |= in[i];
+	}
+
+	for (batchNo = 0; batchNo < numBatches; batchNo++)
+	{
+		BMBatchWords *bch = batches[batchNo];
+
+		bch->startNo += run;
+		bch->nwords -= run;
+		bch->nwordsread += run;
+	}
+	result->nwords += run;
+
+	return run;
+}
+
 /*
  * _bitmap_findnextword() -- Find the next word whose position is
  *        	                'nextReadNo' in an uncompressed format.
@@ -764,24 +873,15 @@ _bitmap_resetWord(BMBatchWords *words, uint32 prevStartNo)
 static uint8
 _bitmap_find_bitset(BM_HRL_WORD word, uint8 lastPos)
 {
-	uint8 pos = lastPos + 1;
-	BM_HRL_WORD	rightmostBitWord;
-
-	if (pos > BM_HRL_WORD_SIZE)
-	  return 0;
-
-	rightmostBitWord = (((BM_HRL_WORD)1) << (pos-1));
-
-	while (pos <= BM_HRL_WORD_SIZE && (word & rightmostBitWord) == 0)
-	{
-		rightmostBitWord <<= 1;
-		pos++;
-	}
+	if (lastPos >= BM_HRL_WORD_SIZE)
+		return 0;
 
-	if (pos > BM_HRL_WORD_SIZE)
-		pos = 0;
+	/* clear the bits up to and including 'lastPos' */
+	word &= ~((BM_HRL_WORD) 0) << lastPos;
+	if (word == 0)
+		return 0;
 
-	return pos;
+	return pg_rightmost_one_pos64(word) + 1;
 }
 
 /*
@@ -18,6 +18,7 @@
 #include "access/external.h"
 #include "access/reloptions.h"
 #include "access/table.h"
+#include "access/url.h"
 #include "catalog/indexing.h"
 #include "catalog/pg_foreign_server.h"
 #include "catalog/pg_foreign_table.h"
@@ -29,10 +30,15 @@
 #include "nodes/makefuncs.h"
 #include "optimizer/optimizer.h"
 #include "utils/fmgroids.h"
+#include "utils/guc.h"
 #include "utils/lsyscache.h"
 #include "utils/uri.h"
 
-static List *create_external_scan_uri_list(ExtTableEntry *ext, bool *ismasteronly);
+static List *create_external_scan_uri_list(ExtTableEntry *ext, bool *ismasteronly,
+										   List **splitlist);
+static List *split_external_file_uris(char **segdb_file_map,
+									  CdbComponentDatabases *db_info,
+									  int total_primaries);
 
 void
 gfile_printf_then_putc_newline(const char *format,...)
@@ -311,6 +317,7 @@ MakeExternalScanInfo(ExtTableEntry *extEntry)
 {
 	ExternalScanInfo *node = makeNode(ExternalScanInfo);
 	List	   *urilist;
+	List	   *splitlist;
 	bool		ismasteronly = false;
 	bool		islimitinrows = false;
 	int			rejectlimit = -1;
@@ -330,7 +337,7 @@ MakeExternalScanInfo(ExtTableEntry *extEntry)
 	}
 
 	/* assign Uris to segments. */
-	urilist = create_external_scan_uri_list(extEntry, &ismasteronly);
+	urilist = create_external_scan_uri_list(extEntry, &ismasteronly, &splitlist);
 
 	/* single row error handling */
 	if (extEntry->rejectlimit != -1)
@@ -341,6 +348,7 @@ MakeExternalScanInfo(ExtTableEntry *extEntry)
 	}
 
 	node->uriList = urilist;
+	node->splitList = splitlist;
 	node->fmtType = extEntry->fmtcode;
 	node->isMasterOnly = ismasteronly;
 	node->rejLimit = rejectlimit;
@@ -419,8 +427,96 @@ BuildForeignScanForExternalTable(Oid relid, Index scanrelid,
 	return fscan;
 }
 
+/*
+ * Assign each primary without a file:// URI to one of the URIs of its host,
+ * spreading them evenly. All the primaries of a URI then read a share of
+ * its data. Returns a list with the share of each primary, as an integer
+ * list of its index and the number of shares, or NIL if it reads its URI
+ * whole.
+ */
+static List *
+split_external_file_uris(char **segdb_file_map, CdbComponentDatabases *db_info,
+						 int total_primaries)
+{
+	CdbComponentDatabaseInfo **primaries;
+	int		   *owner;
+	int		   *nreaders;
+	int		   *reader_index;
+	List	   *splitlist = NIL;
+	int			i;
+	int			j;
+
+	primaries = palloc0(total_primaries * sizeof(CdbComponentDatabaseInfo *));
+	owner = palloc(total_primaries * sizeof(int));
+	nreaders = palloc0(total_primaries * sizeof(int));
+	reader_index = palloc0(total_primaries * sizeof(int));
+
+	for (i = 0; i < db_info->total_segment_dbs; i++)
+	{
+		CdbComponentDatabaseInfo *p = &db_info->segment_db_info[i];
+
+		if (SEGMENT_IS_ACTIVE_PRIMARY(p))
+			primaries[p->config->segindex] = p;
+	}
+
+	for (i = 0; i < total_primaries; i++)
+	{
+		owner[i] = i;
+		if (segdb_file_map[i] != NULL)
+			nreaders[i] = 1;
+	}
+
+	/* hand out the idle primaries, in segindex order */
+	for (i = 0; i < total_primaries; i++)
+	{
+		int			best = -1;
+
+		if (segdb_file_map[i] != NULL || primaries[i] == NULL)
+			continue;
+
+		for (j = 0; j < total_primaries; j++)
+		{
+			if (segdb_file_map[j] == NULL || primaries[j] == NULL ||
+				strcmp(primaries[i]->config->hostname,
+					   primaries[j]->config->hostname) != 0)
+				continue;
+
+			if (best < 0 || nreaders[j] < nreaders[best])
+				best = j;
+		}
+
+		if (best >= 0)
+		{
+			owner[i] = best;
+			reader_index[i] = nreaders[best]++;
+		}
+	}
+
+	for (i = 0; i < total_primaries; i++)
+	{
+		int			count = nreaders[owner[i]];
+
+		if (owner[i] != i)
+			segdb_file_map[i] = pstrdup(segdb_file_map[owner[i]]);
+
+		if (segdb_file_map[i] != NULL && count > 1)
+			splitlist = lappend(splitlist,
+								list_make2_int(reader_index[i], count));
+		else
+			splitlist = lappend(splitlist, NIL);
+	}
+
+	pfree(primaries);
+	pfree(owner);
+	pfree(nreaders);
+	pfree(reader_index);
+
+	return splitlist;
+}
+
 static List *
-create_external_scan_uri_list(ExtTableEntry *ext, bool *ismasteronly)
+create_external_scan_uri_list(ExtTableEntry *ext, bool *ismasteronly,
+							  List **splitlist)
 {
 	ListCell   *c;
 	List	   *modifiedloclist = NIL;
@@ -448,6 +544,7 @@ create_external_scan_uri_list(ExtTableEntry *ext, bool *ismasteronly)
 	char	   *on_clause;
 
 	*ismasteronly = false;
+	*splitlist = NIL;
 
 	/* is this an EXECUTE table or a LOCATION (URI) table */
 	if (ext->command)
@@ -654,6 +751,15 @@ create_external_scan_uri_list(ExtTableEntry *ext, bool *ismasteronly)
 			}
 		}
 
+		/*
+		 * GPDB: let the primaries that didn't get a file help reading the
+		 * files on their host. Only TEXT format can be cut at any end of
+		 * line, CSV may have newlines in quoted values.
+		 */
+		if (uri->protocol == URI_FILE && gp_external_enable_file_split &&
+			fmttype_is_text(ext->fmtcode))
+			*splitlist = split_external_file_uris(segdb_file_map, db_info,
+												  total_primaries);
 
 	}
 	/* (2) */
@@ -198,7 +198,7 @@ url_fopen(char *url, bool forwrite, extvar_t *ev, CopyState pstate, ExternalSele
 	if (pg_strncasecmp(url, EXEC_URL_PREFIX, strlen(EXEC_URL_PREFIX)) == 0)
 		return url_execute_fopen(url, forwrite, ev, pstate);
 	else if (IS_FILE_URI(url))
-		return url_file_fopen(url, forwrite, ev, pstate);
+		return url_file_fopen(url, forwrite, ev, pstate, desc);
 	else if (IS_HTTP_URI(url) || IS_GPFDIST_URI(url) || IS_GPFDISTS_URI(url))
 		return url_curl_fopen(url, forwrite, ev, pstate);
 	else
@@ -22,6 +22,10 @@
 
 #include <curl/curl.h>
 #include <time.h>
+#include <zlib.h>
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
 
 #include "cdb/cdbsreh.h"
 #include "cdb/cdbutil.h"
@@ -84,6 +88,17 @@ typedef struct
 					top;
 	} out;
 
+	/*
+	 * Compression of the data we POST, as acknowledged by the server, and
+	 * the buffer holding the compressed data of the current request.
+	 */
+	int			compression;
+	struct
+	{
+		char	   *ptr;		/* palloc-ed buffer */
+		size_t		max;
+	} zout;
+
 	int			still_running;	/* Is background url fetch still in progress */
 	int			error,
 				eof;			/* error & eof flags */
@@ -109,6 +124,10 @@ typedef struct
 #define FDIST_TIMEOUT  408
 #define MAX_TRY_WAIT_TIME 64
 
+/* compression levels of the writable external table data, tuned for speed */
+#define WRITE_ZLIB_LEVEL 1
+#define WRITE_ZSTD_LEVEL 1
+
 /*
  * SSL support GUCs - should be added soon. Until then we will use stubs
  *
@@ -348,6 +367,33 @@ header_callback(void *ptr_, size_t size, size_t nmemb, void *userp)
 		}
 	}
 
+	/*
+	 * gpfdist acknowledges the compression of the data we write with an
+	 * X-GP-COMPRESSION header naming the same method.
+	 */
+	if (len > 16 && *ptr == 'X' && 0 == strncmp("X-GP-COMPRESSION", ptr, 16))
+	{
+		ptr += 16;
+		len -= 16;
+
+		while (len > 0 && (*ptr == ' ' || *ptr == '\t' || *ptr == ':'))
+		{
+			ptr++;
+			len--;
+		}
+
+		for (i = 0; i < sizeof(buf) - 1 && i < len && ptr[i] != '\r' && ptr[i] != '\n'; i++)
+			buf[i] = ptr[i];
+		buf[i] = 0;
+
+		if (strcmp(buf, "zlib") == 0)
+			url->compression = WRITABLE_EXTERNAL_TABLE_COMPRESSION_ZLIB;
+#ifdef USE_ZSTD
+		else if (strcmp(buf, "zstd") == 0)
+			url->compression = WRITABLE_EXTERNAL_TABLE_COMPRESSION_ZSTD;
+#endif
+	}
+
 	return size * nmemb;
 }
 
@@ -1212,6 +1258,12 @@ url_curl_fopen(char *url, bool forwrite, extvar_t *ev, CopyState pstate)
 		set_httpheader(file, "X-GP-PROTO", "0");
 		set_httpheader(file, "X-GP-SEQ", "1");
 		set_httpheader(file, "Content-Type", "text/xml");
+
+		/* ask for compression, gpfdist confirms it in the response */
+		if (writable_external_table_compression == WRITABLE_EXTERNAL_TABLE_COMPRESSION_ZLIB)
+			set_httpheader(file, "X-GP-COMPRESSION", "zlib");
+		else if (writable_external_table_compression == WRITABLE_EXTERNAL_TABLE_COMPRESSION_ZSTD)
+			set_httpheader(file, "X-GP-COMPRESSION", "zstd");
 	}
 	else
 	{
@@ -1368,6 +1420,18 @@ url_curl_fopen(char *url, bool forwrite, extvar_t *ev, CopyState pstate)
 		/* post away and check response, retry if failed (timeout or * connect error) */
 		gp_perform_backoff_and_check_response(file, easy_perform_work);
 		file->seq_number++;
+
+		/*
+		 * An older gpfdist ignores the header. One that doesn't support the
+		 * method we asked for doesn't confirm it; send plain data then.
+		 */
+		if (writable_external_table_compression != WRITABLE_EXTERNAL_TABLE_COMPRESSION_NONE &&
+			file->compression != writable_external_table_compression)
+		{
+			elog(LOG, "gpfdist did not accept compressed data, sending it uncompressed");
+			file->compression = WRITABLE_EXTERNAL_TABLE_COMPRESSION_NONE;
+			replace_httpheader(file, "X-GP-COMPRESSION", "none");
+		}
 	}
 
 	return (URL_FILE *) file;
@@ -1421,6 +1485,12 @@ url_curl_fclose(URL_FILE *fileg, bool failOnError, const char *relname)
 		file->out.ptr = NULL;
 	}
 
+	if (file->zout.ptr)
+	{
+		pfree(file->zout.ptr);
+		file->zout.ptr = NULL;
+	}
+
 	file->gp_proto = 0;
 	file->error = file->eof = 0;
 	memset(&file->in, 0, sizeof(file->in));
@@ -1669,6 +1739,70 @@ gp_proto1_read(char *buf, int bufsz, URL_CURL_FILE *file, CopyState pstate, char
 	return n;
 }
 
+/*
+ * compress_write_buffer
+ *
+ * Compress the buffered rows into file->zout, as one zlib stream or zstd
+ * frame, which gpfdist decompresses before writing them out. Returns the
+ * compressed size.
+ */
+static size_t
+compress_write_buffer(URL_CURL_FILE *file)
+{
+	size_t		bound;
+	size_t		len = 0;
+
+	if (file->compression == WRITABLE_EXTERNAL_TABLE_COMPRESSION_ZLIB)
+		bound = compressBound(file->out.top);
+#ifdef USE_ZSTD
+	else if (file->compression == WRITABLE_EXTERNAL_TABLE_COMPRESSION_ZSTD)
+		bound = ZSTD_compressBound(file->out.top);
+#endif
+	else
+		elog(ERROR, "unknown compression method %d", file->compression);
+
+	if (file->zout.max < bound)
+	{
+		if (file->zout.ptr)
+			pfree(file->zout.ptr);
+		file->zout.ptr = palloc(bound);
+		file->zout.max = bound;
+	}
+
+	if (file->compression == WRITABLE_EXTERNAL_TABLE_COMPRESSION_ZLIB)
+	{
+		uLongf		destlen = file->zout.max;
+		int			ret;
+
+		ret = compress2((Bytef *) file->zout.ptr, &destlen,
+						(Bytef *) file->out.ptr, file->out.top, WRITE_ZLIB_LEVEL);
+		if (ret != Z_OK)
+			elog(ERROR, "could not compress data for gpfdist: zlib error %d", ret);
+		len = destlen;
+	}
+#ifdef USE_ZSTD
+	else
+	{
+		static ZSTD_CCtx *cxt = NULL;
+
+		if (!cxt)
+		{
+			cxt = ZSTD_createCCtx();
+			if (!cxt)
+				elog(ERROR, "out of memory");
+		}
+
+		len = ZSTD_compressCCtx(cxt, file->zout.ptr, file->zout.max,
+								file->out.ptr, file->out.top, WRITE_ZSTD_LEVEL);
+		if (ZSTD_isError(len))
+			elog(ERROR, "could not compress data for gpfdist: %s",
+				 ZSTD_getErrorName(len));
+	}
+#endif
+
+	return len;
+}
+
 /*
  * gp_proto0_write
  *
@@ -1684,6 +1818,12 @@ gp_proto0_write(URL_CURL_FILE *file, CopyState pstate)
 	if (nbytes == 0)
 		return;
 
+	if (file->compression != WRITABLE_EXTERNAL_TABLE_COMPRESSION_NONE)
+	{
+		nbytes = compress_write_buffer(file);
+		buf = file->zout.ptr;
+	}
+
 	/* post binary data */
 	CURL_EASY_SETOPT(file->curl->handle, CURLOPT_POSTFIELDS, buf);
 
@@ -33,7 +33,8 @@ typedef struct URL_FSTREAM_FILE
 } URL_FSTREAM_FILE;
 
 URL_FILE *
-url_file_fopen(char *url, bool forwrite, extvar_t *ev, CopyState pstate)
+url_file_fopen(char *url, bool forwrite, extvar_t *ev, CopyState pstate,
+			   ExternalSelectDesc desc)
 {
 	URL_FSTREAM_FILE *file;
 	char	   *path = strchr(url + strlen(PROTOCOL_FILE), '/');
@@ -62,6 +63,15 @@ url_file_fopen(char *url, bool forwrite, extvar_t *ev, CopyState pstate)
 	fo.bufsize = 32 * 1024;
 	pstate->header_line = 0;
 
+	/* are we reading only a share of the files? */
+	if (desc)
+	{
+		fo.split_index = desc->split_index;
+		fo.split_count = desc->split_count;
+	}
+	else
+		fo.split_count = 0;
+
 	/*
 	 * Open the file stream. This includes opening the first file to be read
 	 * and finding and preparing any other files to be opened later (if a
@@ -107,7 +117,12 @@ url_file_fread(void *ptr, size_t size, URL_FILE *file, CopyState pstate)
 	{
 		pstate->cur_lineno = fo.line_number;
 
-		if (pstate->cdbsreh)
+		if (pstate->cdbsreh && fo.split_start > 0)
+			snprintf(pstate->cdbsreh->filename,
+					 sizeof(pstate->cdbsreh->filename),
+					 "%s [%s, range at byte " INT64_FORMAT "]",
+					 ffile->common.url, fo.fname, (int64) fo.split_start);
+		else if (pstate->cdbsreh)
 			snprintf(pstate->cdbsreh->filename,
 					 sizeof(pstate->cdbsreh->filename),
 					 "%s [%s]", ffile->common.url, fo.fname);
@@ -1997,7 +1997,9 @@ LANGUAGE plpgsql;
 --        int - containing slice,
 --        int - sessionid,
 --        int - command_cnt,
---        int - number of files
+--        int - number of files,
+--        bigint - bytes written,
+--        bigint - time spent on writing, in microseconds, with track_io_timing
 --
 -- @doc:
 --        UDF to retrieve workfile sets currently present on disk on one segment
@@ -2039,7 +2041,9 @@ WITH all_entries AS (
             slice int,
             sessionid int,
             commandid int,
-            numfiles int
+            numfiles int,
+            written bigint,
+            write_usecs bigint
           )
     UNION ALL
     SELECT C.*
@@ -2051,7 +2055,9 @@ WITH all_entries AS (
             slice int,
             sessionid int,
             commandid int,
-            numfiles int
+            numfiles int,
+            written bigint,
+            write_usecs bigint
           ))
 SELECT S.datname,
        S.pid,
@@ -2064,7 +2070,9 @@ SELECT S.datname,
        C.optype,
        C.size,
        C.numfiles,
-       C.prefix
+       C.prefix,
+       C.written,
+       C.write_usecs
 FROM all_entries C LEFT OUTER JOIN
 pg_stat_activity as S
 ON C.sessionid = S.sess_id;
@@ -2098,13 +2106,18 @@ GRANT SELECT ON gp_toolkit.gp_workfile_usage_per_segment TO public;
 --        gp_toolkit.gp_workfile_usage_per_query
 --
 -- @doc:
---        Amount of disk space used for workfiles by each query
+--        Amount of disk space used for workfiles by each query, and the
+--        bandwidth the query's workfiles are written with
 --
 --------------------------------------------------------------------------------
 
 CREATE VIEW gp_toolkit.gp_workfile_usage_per_query AS
 SELECT datname, pid, sess_id, command_cnt, usename, query, segid,
-    SUM(size) AS size, SUM(numfiles) AS numfiles
+    SUM(size) AS size, SUM(numfiles) AS numfiles,
+    SUM(written) AS written,
+    CASE WHEN SUM(write_usecs) > 0
+         THEN SUM(written) * 1000000 / SUM(write_usecs)
+    END AS write_bytes_per_sec
 FROM gp_toolkit.gp_workfile_entries
 GROUP BY datname, pid, sess_id, command_cnt, usename, query, segid;
 
@@ -2165,6 +2178,170 @@ GRANT SELECT ON gp_toolkit.gp_workfile_mgr_used_diskspace TO public;
 
 --------------------------------------------------------------------------------
 
+-- Live execution statistics views
+--------------------------------------------------------------------------------
+
+--------------------------------------------------------------------------------
+-- @function:
+--        gp_toolkit.__gp_live_exec_stats_f
+--
+-- @in:
+--
+-- @out:
+--        int - segment id
+--        int - sessionid,
+--        int - command_cnt,
+--        int - slice,
+--        int - plan node id,
+--        text - plan node type,
+--        int - pid of the executing backend,
+--        timestamptz - time the node was initialized,
+--        bigint - rows produced so far, or sent by the sending side of a Motion,
+--        bigint - number of completed loops,
+--        float8 - time spent in the node, in milliseconds,
+--        bool - is this the sending side of a Motion
+--
+-- @doc:
+--        UDF to retrieve the statistics that running plan nodes keep in the
+--        query metrics shared memory of one segment; requires
+--        gp_enable_query_metrics
+--
+--------------------------------------------------------------------------------
+
+CREATE FUNCTION gp_toolkit.__gp_live_exec_stats_f_on_master()
+RETURNS SETOF record
+AS '$libdir/gp_instrument_shmem', 'gp_instrument_shmem_live_stats'
+LANGUAGE C VOLATILE EXECUTE ON COORDINATOR;
+
+GRANT EXECUTE ON FUNCTION gp_toolkit.__gp_live_exec_stats_f_on_master() TO public;
+
+CREATE FUNCTION gp_toolkit.__gp_live_exec_stats_f_on_segments()
+RETURNS SETOF record
+AS '$libdir/gp_instrument_shmem', 'gp_instrument_shmem_live_stats'
+LANGUAGE C VOLATILE EXECUTE ON ALL SEGMENTS;
+
+GRANT EXECUTE ON FUNCTION gp_toolkit.__gp_live_exec_stats_f_on_segments() TO public;
+
+--------------------------------------------------------------------------------
+-- @view:
+--        gp_toolkit.gp_live_exec_stats
+--
+-- @doc:
+--        Statistics of every plan node of the running queries on every
+--        segment, together with the workfile bytes written by the node's
+--        slice on that segment
+--
+--------------------------------------------------------------------------------
+
+CREATE VIEW gp_toolkit.gp_live_exec_stats AS
+WITH all_entries AS (
+   SELECT C.*
+          FROM gp_toolkit.__gp_live_exec_stats_f_on_master() AS C (
+            segid int,
+            sess_id int,
+            command_cnt int,
+            slice int,
+            node_id int,
+            node_type text,
+            pid int,
+            start_time timestamptz,
+            rows bigint,
+            nloops bigint,
+            time_ms float8,
+            sending bool
+          )
+    UNION ALL
+    SELECT C.*
+          FROM gp_toolkit.__gp_live_exec_stats_f_on_segments() AS C (
+            segid int,
+            sess_id int,
+            command_cnt int,
+            slice int,
+            node_id int,
+            node_type text,
+            pid int,
+            start_time timestamptz,
+            rows bigint,
+            nloops bigint,
+            time_ms float8,
+            sending bool
+          )),
+slice_spill AS (
+    SELECT sess_id, command_cnt, segid, slice, SUM(written) AS written
+    FROM gp_toolkit.gp_workfile_entries
+    GROUP BY sess_id, command_cnt, segid, slice)
+SELECT S.datname,
+       S.pid AS qd_pid,
+       C.sess_id,
+       C.command_cnt,
+       S.usename,
+       S.query,
+       C.segid,
+       C.slice,
+       C.node_id,
+       C.node_type,
+       C.pid,
+       C.start_time,
+       C.rows,
+       C.nloops,
+       C.time_ms,
+       C.sending,
+       COALESCE(W.written, 0) AS slice_spill_bytes
+FROM all_entries C
+LEFT OUTER JOIN slice_spill W
+ON C.sess_id = W.sess_id AND C.command_cnt = W.command_cnt AND
+   C.segid = W.segid AND C.slice = W.slice
+LEFT OUTER JOIN pg_stat_activity AS S
+ON C.sess_id = S.sess_id;
+
+GRANT SELECT ON gp_toolkit.gp_live_exec_stats TO public;
+
+--------------------------------------------------------------------------------
+-- @view:
+--        gp_toolkit.gp_live_exec_stats_summary
+--
+-- @doc:
+--        Statistics of every plan node of the running queries, combined
+--        across segments.  A row_skew well above 1 points at a skewed
+--        segment.  The queue_depth of a receiving Motion is the number of
+--        tuples sent to it that have not been consumed yet; a growing one
+--        points at a consumer that does not keep up.
+--
+--------------------------------------------------------------------------------
+
+CREATE VIEW gp_toolkit.gp_live_exec_stats_summary AS
+WITH nodes AS (
+    SELECT datname, qd_pid, sess_id, command_cnt, usename, query,
+        slice, node_id, node_type, sending,
+        COUNT(*) AS numsegments,
+        MIN(start_time) AS start_time,
+        SUM(rows) AS rows,
+        MIN(rows) AS min_rows,
+        MAX(rows) AS max_rows,
+        CASE WHEN SUM(rows) > 0
+             THEN (MAX(rows) * COUNT(*) / SUM(rows)::float8)::numeric(10,2)
+        END AS row_skew,
+        MAX(time_ms) AS max_time_ms,
+        SUM(slice_spill_bytes) AS slice_spill_bytes
+    FROM gp_toolkit.gp_live_exec_stats
+    GROUP BY datname, qd_pid, sess_id, command_cnt, usename, query,
+        slice, node_id, node_type, sending)
+SELECT R.datname, R.qd_pid, R.sess_id, R.command_cnt, R.usename, R.query,
+    R.slice, R.node_id, R.node_type, R.sending,
+    R.numsegments, R.start_time, R.rows, R.min_rows, R.max_rows, R.row_skew,
+    R.max_time_ms,
+    GREATEST(S.rows - R.rows, 0) AS queue_depth,
+    R.slice_spill_bytes
+FROM nodes R
+LEFT OUTER JOIN nodes S
+ON NOT R.sending AND S.sending AND
+   R.sess_id = S.sess_id AND R.command_cnt = S.command_cnt AND
+   R.node_id = S.node_id;
+
+GRANT SELECT ON gp_toolkit.gp_live_exec_stats_summary TO public;
+
+--------------------------------------------------------------------------------
+
 -- Finalize install
 COMMIT;
 
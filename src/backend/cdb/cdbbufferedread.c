@@ -19,10 +19,14 @@
 #include "cdb/cdbbufferedread.h"
 #include "miscadmin.h"
 #include "pgstat.h"
+#include "storage/bufmgr.h"
 #include "utils/guc.h"
 
 static void BufferedReadIo(
 			   BufferedRead *bufferedRead);
+static void BufferedReadPrefetchNext(
+			   BufferedRead *bufferedRead,
+			   int64 inEffectFileLen);
 static uint8 *BufferedReadUseBeforeBuffer(
 							BufferedRead *bufferedRead,
 							int32 maxReadAheadLen,
@@ -153,6 +157,7 @@ BufferedReadSetFile(
 		else
 			bufferedRead->largeReadLen = (int32) fileLen;
 		BufferedReadIo(bufferedRead);
+		BufferedReadPrefetchNext(bufferedRead, fileLen);
 	}
 }
 
@@ -224,6 +229,42 @@ BufferedReadIo(
 		VacuumCostBalance += VacuumCostPageMiss;
 }
 
+/*
+ * Ask the kernel to start reading the large read that follows the current
+ * one, so that the i/o overlaps with the caller decompressing and processing
+ * the current one, instead of the scan stalling on each large read in turn.
+ *
+ * Only done on the sequential read paths; with effective_io_concurrency set
+ * to 0, no prefetch requests are issued.
+ */
+static void
+BufferedReadPrefetchNext(
+			   BufferedRead *bufferedRead,
+			   int64 inEffectFileLen)
+{
+	int64		nextPosition;
+	int64		remainingFileLen;
+	int32		prefetchLen;
+
+	if (effective_io_concurrency <= 0)
+		return;
+
+	nextPosition = bufferedRead->largeReadPosition + bufferedRead->largeReadLen;
+	remainingFileLen = inEffectFileLen - nextPosition;
+	if (remainingFileLen <= 0)
+		return;
+
+	if (remainingFileLen > bufferedRead->maxLargeReadLen)
+		prefetchLen = bufferedRead->maxLargeReadLen;
+	else
+		prefetchLen = (int32) remainingFileLen;
+
+	(void) FilePrefetch(bufferedRead->file,
+						nextPosition,
+						prefetchLen,
+						WAIT_EVENT_DATA_FILE_PREFETCH);
+}
+
 static uint8 *
 BufferedReadUseBeforeBuffer(
 							BufferedRead *bufferedRead,
@@ -304,6 +345,7 @@ BufferedReadUseBeforeBuffer(
 	}
 
 	BufferedReadIo(bufferedRead);
+	BufferedReadPrefetchNext(bufferedRead, inEffectFileLen);
 
 	extraLen = maxReadAheadLen - beforeLen;
 	Assert(extraLen > 0);
@@ -520,6 +562,7 @@ BufferedReadGetNextBuffer(
 		}
 
 		BufferedReadIo(bufferedRead);
+		BufferedReadPrefetchNext(bufferedRead, inEffectFileLen);
 
 		if (maxReadAheadLen > bufferedRead->largeReadLen)
 			bufferedRead->bufferLen = bufferedRead->largeReadLen;
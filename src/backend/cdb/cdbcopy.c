@@ -39,6 +39,13 @@
  * cdbCopyGetData() and cdbCopySendData() call libpq's PQgetCopyData() and
  * PQputCopyData(), respectively. If an error occurs, it is thrown with ereport().
  *
+ * cdbCopySendDataChunked() is like cdbCopySendData(), but collects the data
+ * into a per-segment chunk first, if gp_copy_dispatch_chunk_size is set.
+ * cdbCopySendData() sends out the segment's partial chunk before the new data,
+ * so that the data reaches the segment in the order it was passed in.
+ * cdbCopyFlushChunks() must be called to send out any partial chunks before
+ * cdbCopyEnd().
+ *
  * When you're done, call cdbCopyEnd().
  *
  * Portions Copyright (c) 2005-2008, Greenplum inc
@@ -72,6 +79,7 @@
 #include "storage/pmsignal.h"
 #include "tcop/tcopprot.h"
 #include "utils/faultinjector.h"
+#include "utils/guc.h"
 #include "utils/memutils.h"
 
 #include <poll.h>
@@ -79,6 +87,8 @@
 static void cdbCopyEndInternal(CdbCopy *c, char *abort_msg,
 				   int64 *total_rows_completed_p,
 				   int64 *total_rows_rejected_p);
+static void cdbCopyPutData(CdbCopy *c, int target_seg, const char *buffer,
+			   int nbytes);
 
 static Gang *
 getCdbCopyPrimaryGang(CdbCopy *c)
@@ -109,6 +119,8 @@ makeCdbCopy(CopyState cstate, bool is_copy_in)
 	c->copy_in = is_copy_in;
 	c->seglist = NIL;
 	c->dispatcherState = NULL;
+	c->send_chunks = NULL;
+	c->send_chunk_size = 0;
 	initStringInfo(&(c->copy_out_buf));
 
 	/*
@@ -130,6 +142,16 @@ makeCdbCopy(CopyState cstate, bool is_copy_in)
 			c->seglist = lappend_int(c->seglist, i);
 	}
 
+	if (is_copy_in && gp_copy_dispatch_chunk_size > 0)
+	{
+		int			i;
+
+		c->send_chunk_size = gp_copy_dispatch_chunk_size * 1024;
+		c->send_chunks = palloc(c->total_segs * sizeof(StringInfoData));
+		for (i = 0; i < c->total_segs; i++)
+			initStringInfo(&c->send_chunks[i]);
+	}
+
 	cstate->cdbCopy = c;
 
 	return c;
@@ -229,6 +251,30 @@ cdbCopySendDataToAll(CdbCopy *c, const char *buffer, int nbytes)
 void
 cdbCopySendData(CdbCopy *c, int target_seg, const char *buffer,
 				int nbytes)
+{
+	/* don't let the data overtake the rows still waiting in the chunk */
+	if (c->send_chunks != NULL)
+	{
+		StringInfo	chunk;
+
+		Assert(target_seg >= 0 && target_seg < c->total_segs);
+		chunk = &c->send_chunks[target_seg];
+		if (chunk->len > 0)
+		{
+			cdbCopyPutData(c, target_seg, chunk->data, chunk->len);
+			resetStringInfo(chunk);
+		}
+	}
+
+	cdbCopyPutData(c, target_seg, buffer, nbytes);
+}
+
+/*
+ * transmits data to a specific segment, bypassing the chunks.
+ */
+static void
+cdbCopyPutData(CdbCopy *c, int target_seg, const char *buffer,
+			   int nbytes)
 {
 	SegmentDatabaseDescriptor *q;
 	Gang	   *gp;
@@ -264,6 +310,63 @@ cdbCopySendData(CdbCopy *c, int target_seg, const char *buffer,
 	}
 }
 
+/*
+ * Like cdbCopySendData(), but if chunking is enabled, only append the data
+ * to the target segment's chunk, and send the chunk once it is full. The
+ * caller must pass complete QD->QE frames, so that frames sent directly with
+ * cdbCopySendData() or cdbCopySendDataToAll() can be interleaved with the
+ * chunks.
+ *
+ * Returns true if the data was sent to the segment, false if it is still
+ * waiting in the chunk.
+ */
+bool
+cdbCopySendDataChunked(CdbCopy *c, int target_seg, const char *buffer,
+					   int nbytes)
+{
+	StringInfo	chunk;
+
+	if (c->send_chunks == NULL)
+	{
+		cdbCopySendData(c, target_seg, buffer, nbytes);
+		return true;
+	}
+
+	Assert(target_seg >= 0 && target_seg < c->total_segs);
+	chunk = &c->send_chunks[target_seg];
+	appendBinaryStringInfo(chunk, buffer, nbytes);
+
+	if (chunk->len < c->send_chunk_size)
+		return false;
+
+	cdbCopyPutData(c, target_seg, chunk->data, chunk->len);
+	resetStringInfo(chunk);
+	return true;
+}
+
+/*
+ * Send out any data still waiting in the per-segment chunks.
+ */
+void
+cdbCopyFlushChunks(CdbCopy *c)
+{
+	int			i;
+
+	if (c->send_chunks == NULL)
+		return;
+
+	for (i = 0; i < c->total_segs; i++)
+	{
+		StringInfo	chunk = &c->send_chunks[i];
+
+		if (chunk->len > 0)
+		{
+			cdbCopyPutData(c, i, chunk->data, chunk->len);
+			resetStringInfo(chunk);
+		}
+	}
+}
+
 /*
  * gets a chunk of rows of data from a copy command.
  * returns boolean true if done. Caller should still
@@ -121,6 +121,11 @@ int			gp_fts_probe_retries = 5;
  */
 int			gp_fts_probe_timeout = 20;
 
+/*
+ * Keep FTS probe connections open between probe cycles.
+ */
+bool		gp_fts_persistent_probe_connections = false;
+
 /*
  * Polling interval for the fts prober. A scan of the entire system starts
  * every time this expires.
@@ -258,6 +263,7 @@ double		gp_selectivity_damping_factor = 1;
 bool		gp_selectivity_damping_sigsort = true;
 
 int			gp_hashjoin_tuples_per_bucket = 5;
+bool		gp_hashjoin_adaptive_skew = false;
 int			gp_hashagg_groups_per_bucket = 5;
 
 /* Analyzing aid */
@@ -259,6 +259,8 @@ static void SendCopyFromForwardedTuple(CopyState cstate,
 						   int line_len,
 						   Datum *values,
 						   bool *nulls);
+static bool SendCopyFromForwardedLine(CopyState cstate, CdbCopy *cdbCopy,
+									  int target_seg, Relation rel);
 static void SendCopyFromForwardedHeader(CopyState cstate, CdbCopy *cdbCopy);
 static void SendCopyFromForwardedError(CopyState cstate, CdbCopy *cdbCopy, char *errmsg);
 
@@ -3788,6 +3790,8 @@ CopyFrom(CopyState cstate)
 	CdbCopy	   *cdbCopy = NULL;
 	bool		is_check_distkey;
 	GpDistributionData *distData = NULL; /* distribution data used to compute target seg */
+	bool		dispatch_raw_lines = false;
+	int			chunk_target_seg = 0;
 
 	Assert(cstate->rel);
 
@@ -4151,6 +4155,31 @@ CopyFrom(CopyState cstate)
 	if (cstate->dispatch_mode == COPY_DISPATCH)
 		InitCopyFromDispatchSplit(cstate, distData, estate);
 
+	/*
+	 * If the table is randomly distributed and the QD has nothing to parse
+	 * or compute for a row, any segment will do. With chunked dispatch, the
+	 * QD then just splits the input at line boundaries, and sends each chunk
+	 * of lines to the next segment in turn. The segments do all the parsing.
+	 */
+	if (cstate->dispatch_mode == COPY_DISPATCH &&
+		gp_copy_dispatch_chunk_size > 0 &&
+		!cstate->binary &&
+		cstate->first_qe_processed_field == 0 &&
+		cstate->num_defaults == 0 &&
+		cstate->whereClause == NULL &&
+		proute == NULL &&
+		list_length(cstate->attnumlist) > 0 &&
+		distData->policy != NULL &&
+		distData->policy->nattrs == 0 &&
+		!GpPolicyIsReplicated(distData->policy))
+	{
+		dispatch_raw_lines = true;
+		chunk_target_seg = cdbhashrandomseg(distData->policy->numsegments);
+
+		if (Test_copy_qd_qe_split)
+			elog(INFO, "input lines will be sent to the QEs in chunks");
+	}
+
 	if (cstate->dispatch_mode == COPY_DISPATCH ||
 		cstate->dispatch_mode == COPY_EXECUTOR)
 	{
@@ -4308,6 +4337,17 @@ CopyFrom(CopyState cstate)
 			{
 				if (!NextCopyFromDispatch(cstate, econtext, myslot->tts_values, myslot->tts_isnull))
 					break;
+
+				if (dispatch_raw_lines)
+				{
+					/* Move on to the next segment once a chunk has been sent */
+					if (SendCopyFromForwardedLine(cstate, cdbCopy, chunk_target_seg,
+												  resultRelInfo->ri_RelationDesc))
+						chunk_target_seg = (chunk_target_seg + 1) % cdbCopy->total_segs;
+					processed++;
+					MemoryContextSwitchTo(oldcontext);
+					continue;
+				}
 			}
 			else
 			{
@@ -4708,6 +4748,7 @@ CopyFrom(CopyState cstate)
 		int64		total_completed_from_qes;
 		int64		total_rejected_from_qes;
 
+		cdbCopyFlushChunks(cdbCopy);
 		cdbCopyEnd(cdbCopy,
 				   &total_completed_from_qes,
 				   &total_rejected_from_qes);
@@ -6032,7 +6073,40 @@ SendCopyFromForwardedTuple(CopyState cstate,
 	if (toAll)
 		cdbCopySendDataToAll(cdbCopy, msgbuf->data, msgbuf->len);
 	else
-		cdbCopySendData(cdbCopy, target_seg, msgbuf->data, msgbuf->len);
+		(void) cdbCopySendDataChunked(cdbCopy, target_seg, msgbuf->data, msgbuf->len);
+}
+
+/*
+ * Like SendCopyFromForwardedTuple, but for a row that the QD did not parse
+ * at all. The whole input line is passed on for the QE to process.
+ *
+ * Returns true if this filled up the chunk for 'target_seg', and it was
+ * sent out.
+ */
+static bool
+SendCopyFromForwardedLine(CopyState cstate, CdbCopy *cdbCopy, int target_seg,
+						  Relation rel)
+{
+	copy_from_dispatch_row *frame;
+	StringInfo	msgbuf;
+
+	msgbuf = cstate->dispatch_msgbuf;
+	msgbuf->len = 0;
+	ENLARGE_MSGBUF(msgbuf, SizeOfCopyFromDispatchRow + cstate->line_buf.len);
+
+	frame = (copy_from_dispatch_row *) msgbuf->data;
+	memset(frame, 0, SizeOfCopyFromDispatchRow);
+	frame->lineno = cstate->cur_lineno;
+	frame->relid = RelationGetRelid(rel);
+	frame->line_len = cstate->line_buf.len;
+	frame->residual_off = cstate->line_buf.cursor;
+	frame->fld_count = 0;
+	frame->delim_seen_at_end = cstate->stopped_processing_at_delim;
+	msgbuf->len = SizeOfCopyFromDispatchRow;
+
+	APPEND_MSGBUF_NOCHECK(msgbuf, cstate->line_buf.data, cstate->line_buf.len);
+
+	return cdbCopySendDataChunked(cdbCopy, target_seg, msgbuf->data, msgbuf->len);
 }
 
 static void
@@ -74,6 +74,7 @@
 #include "commands/user.h"
 #include "executor/executor.h"
 #include "executor/instrument.h"
+#include "executor/spi.h"
 #include "foreign/foreign.h"
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
@@ -477,6 +478,8 @@ static void RangeVarCallbackForAlterRelation(const RangeVar *rv, Oid relid,
 
 static void ATExecExpandTable(List **wqueue, Relation rel, AlterTableCmd *cmd);
 static void ATExecExpandTableCTAS(AlterTableCmd *rootCmd, Relation rel, AlterTableCmd *cmd);
+static bool can_expand_table_in_place(Relation rel);
+static void ATExecExpandTableInPlace(Relation rel, GpPolicy *newPolicy);
 
 static void ATExecSetDistributedBy(Relation rel, Node *node,
 								   AlterTableCmd *cmd);
@@ -16213,12 +16216,18 @@ checkPolicyCompatibleWithIndexes(Relation rel, GpPolicy *pol)
  * Update a table's "numsegments" value to current cluster size, and move
  * data as needed to the new segments.
  *
- * There are currently only one way we can perform EXPAND TABLE:
+ * There are two ways we can perform EXPAND TABLE:
  *
  * 1. Create a whole new relation file, with the new 'numsegments', copy all
  *    the data to the new reltion file, and swap it in place of the old one.
  *    This is called the "CTAS method", because it uses a CREATE TABLE AS
  *    command internally to create the new physical relation.
+ *
+ * 2. For hash distributed tables, when gp_expand_in_place is set, move only
+ *    the rows whose segment changes with the new 'numsegments'. With jump
+ *    consistent hashing, those rows all move to the new segments, and the rest
+ *    of the table stays where it is, without being rewritten. This is the
+ *    "in-place method".
  */
 static void
 ATExecExpandTable(List **wqueue, Relation rel, AlterTableCmd *cmd)
@@ -16229,6 +16238,7 @@ ATExecExpandTable(List **wqueue, Relation rel, AlterTableCmd *cmd)
 	Oid					relid = RelationGetRelid(rel);
 	GpPolicy			*newPolicy;
 	GpPolicy			*policy = rel->rd_cdbpolicy;
+	bool				inPlace = false;
 
 	if (Gp_role == GP_ROLE_UTILITY)
 		ereport(ERROR,
@@ -16281,6 +16291,16 @@ ATExecExpandTable(List **wqueue, Relation rel, AlterTableCmd *cmd)
 			return;
 		}
 	}
+	else if (Gp_role == GP_ROLE_DISPATCH ? can_expand_table_in_place(rel) :
+			 cmd->expandInPlace)
+	{
+		/*
+		 * The QD moves the rows and updates the policy; the QEs only update
+		 * their copy of the policy. Tell them so.
+		 */
+		inPlace = true;
+		cmd->expandInPlace = true;
+	}
 	else
 	{
 		ATExecExpandTableCTAS(rootCmd, rel, cmd);
@@ -16288,7 +16308,147 @@ ATExecExpandTable(List **wqueue, Relation rel, AlterTableCmd *cmd)
 
 	/* Update numsegments to cluster size */
 	newPolicy->numsegments = getgpsegmentCount();
+
+	if (inPlace && Gp_role == GP_ROLE_DISPATCH)
+		ATExecExpandTableInPlace(rel, newPolicy);
+	else
+		GpPolicyReplace(relid, newPolicy);
+}
+
+/*
+ * Can the in-place method be used to expand this table?
+ *
+ * The rows are moved with plain INSERT and DELETE commands, so tables
+ * whose rules, triggers, row level security or generated columns would
+ * interfere with those are expanded by the CTAS method.
+ */
+static bool
+can_expand_table_in_place(Relation rel)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+
+	if (!gp_expand_in_place)
+		return false;
+
+	if (rel->rd_rel->relkind != RELKIND_RELATION ||
+		!GpPolicyIsHashPartitioned(rel->rd_cdbpolicy))
+		return false;
+
+	if (rel->rd_rules != NULL || rel->trigdesc != NULL || rel->rd_rel->relrowsecurity)
+		return false;
+
+	if (tupdesc->constr && tupdesc->constr->has_generated_stored)
+		return false;
+
+	return true;
+}
+
+/*
+ * Expand a hash distributed table by the in-place method, and store its new
+ * policy.
+ *
+ * The rows whose segment changes are first copied to a randomly distributed
+ * staging table and deleted, while the old policy is still in place. Once the
+ * new policy is stored, inserting them back redistributes them to their new
+ * segments. Rows can't be moved with a single INSERT ... SELECT from the table
+ * itself: with the old policy the rows would be sent back to their old
+ * segments, and with the new one the scan and the insert are co-located, so
+ * there would be no Motion to move them at all.
+ *
+ * For append-optimized tables the DELETE only marks the rows in the
+ * visibility map, so the segment files of the old segments are not rewritten.
+ */
+static void
+ATExecExpandTableInPlace(Relation rel, GpPolicy *newPolicy)
+{
+	Oid			relid = RelationGetRelid(rel);
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	RangeVar   *tmprv;
+	StringInfoData qual;
+	StringInfoData sql;
+	const char *relname;
+	const char *tmpname;
+	bool		saveOptimizerGucValue;
+	uint64		nmoved;
+	int			i;
+
+	relname = quote_qualified_identifier(get_namespace_name(RelationGetNamespace(rel)),
+										 RelationGetRelationName(rel));
+	tmprv = make_temp_table_name(rel, MyBackendId);
+	tmpname = quote_qualified_identifier("pg_temp", tmprv->relname);
+
+	/* gp_segment_id <> gp_expand_target_segment(rel, numsegments, key columns) */
+	initStringInfo(&qual);
+	appendStringInfo(&qual,
+					 "gp_segment_id OPERATOR(pg_catalog.<>) pg_catalog.gp_expand_target_segment(%u::pg_catalog.regclass, %d",
+					 relid, newPolicy->numsegments);
+	for (i = 0; i < newPolicy->nattrs; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, newPolicy->attrs[i] - 1);
+
+		appendStringInfo(&qual, ", %s", quote_identifier(NameStr(attr->attname)));
+	}
+	appendStringInfoChar(&qual, ')');
+
+	elog(DEBUG1, "expanding \"%s\" in place from %d to %d segments",
+		 RelationGetRelationName(rel), rel->rd_cdbpolicy->numsegments,
+		 newPolicy->numsegments);
+
+	/* same as the CTAS method, see ATExecExpandTableCTAS() */
+	saveOptimizerGucValue = optimizer;
+	optimizer = false;
+
+	PushActiveSnapshot(GetLatestSnapshot());
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "SPI_connect failed");
+
+	/* stage and delete the rows to move, with the old policy */
+	initStringInfo(&sql);
+	appendStringInfo(&sql,
+					 "CREATE TEMP TABLE %s AS SELECT * FROM ONLY %s WHERE %s DISTRIBUTED RANDOMLY",
+					 tmpname, relname, qual.data);
+	if (SPI_execute(sql.data, false, 0) != SPI_OK_UTILITY)
+		elog(ERROR, "failed to stage the rows of \"%s\" to move",
+			 RelationGetRelationName(rel));
+
+	resetStringInfo(&sql);
+	appendStringInfo(&sql, "DELETE FROM ONLY %s WHERE %s", relname, qual.data);
+	if (SPI_execute(sql.data, false, 0) != SPI_OK_DELETE)
+		elog(ERROR, "failed to delete the rows of \"%s\" to move",
+			 RelationGetRelationName(rel));
+	nmoved = SPI_processed;
+
+	/* plan the INSERT with the new policy */
 	GpPolicyReplace(relid, newPolicy);
+	CommandCounterIncrement();
+
+	resetStringInfo(&sql);
+	appendStringInfo(&sql,
+					 "INSERT INTO ONLY %s OVERRIDING SYSTEM VALUE SELECT * FROM %s",
+					 relname, tmpname);
+	if (SPI_execute(sql.data, false, 0) != SPI_OK_INSERT)
+		elog(ERROR, "failed to move rows of \"%s\" to the new segments",
+			 RelationGetRelationName(rel));
+	if (SPI_processed != nmoved)
+		elog(ERROR, "moved " UINT64_FORMAT " rows of \"%s\", expected " UINT64_FORMAT,
+			 SPI_processed, RelationGetRelationName(rel), nmoved);
+
+	resetStringInfo(&sql);
+	appendStringInfo(&sql, "DROP TABLE %s", tmpname);
+	if (SPI_execute(sql.data, false, 0) != SPI_OK_UTILITY)
+		elog(ERROR, "failed to drop the staging table of \"%s\"",
+			 RelationGetRelationName(rel));
+
+	elog(DEBUG1, "moved " UINT64_FORMAT " rows of \"%s\"",
+		 nmoved, RelationGetRelationName(rel));
+
+	SPI_finish();
+
+	PopActiveSnapshot();
+	optimizer = saveOptimizerGucValue;
+
+	CommandCounterIncrement();
 }
 
 static void
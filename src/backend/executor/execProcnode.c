@@ -531,7 +531,27 @@ ExecInitNode(Plan *node, EState *estate, int eflags)
 
 	/* Set up instrumentation for this node if requested */
 	if (estate->es_instrument && result != NULL)
-		result->instrument = GpInstrAlloc(node, estate->es_instrument);
+	{
+		int			instrSliceId = estate->currentSliceId;
+		bool		sending = false;
+
+		/*
+		 * GPDB: every process initializes the whole plan, but only executes
+		 * the nodes of its own slice, and the sending side of the Motion on
+		 * top of it.  Tell GpInstrAlloc() which ones these are.
+		 */
+		if (IsA(result, MotionState) &&
+			((MotionState *) result)->mstype == MOTIONSTATE_SEND)
+		{
+			instrSliceId = ((Motion *) node)->motionID;
+			sending = true;
+		}
+		else if (instrSliceId != LocallyExecutingSliceIndex(estate))
+			instrSliceId = -1;
+
+		result->instrument = GpInstrAlloc(node, estate->es_instrument,
+										  instrSliceId, sending);
+	}
 
 	return result;
 }
@@ -36,7 +36,8 @@ static void BufferUsageAccumDiff(BufferUsage *dst,
 
 /* GPDB specific */
 static bool shouldPickInstrInShmem(NodeTag tag);
-static Instrumentation *pickInstrFromShmem(const Plan *plan, int instrument_options);
+static Instrumentation *pickInstrFromShmem(const Plan *plan, int instrument_options,
+										   int sliceId, bool sending);
 static void instrShmemRecycleCallback(ResourceReleasePhase phase, bool isCommit,
 						  bool isTopLevel, void *arg);
 static void gp_gettmid(int32* tmid);
@@ -348,14 +349,19 @@ InstrShmemInit(void)
  *
  * Use shmem if gp_enable_query_metrics is on and there is free slot.
  * Otherwise use local memory.
+ *
+ * sliceId is the slice this process executes the node in, or -1 if it only
+ * initializes the node; such nodes always use local memory, so that the
+ * query metrics only show the nodes that run.  'sending' is set for the
+ * sending side of a Motion.
  */
 Instrumentation *
-GpInstrAlloc(const Plan *node, int instrument_options)
+GpInstrAlloc(const Plan *node, int instrument_options, int sliceId, bool sending)
 {
 	Instrumentation *instr = NULL;
 
-	if (shouldPickInstrInShmem(nodeTag(node)))
-		instr = pickInstrFromShmem(node, instrument_options);
+	if (sliceId >= 0 && shouldPickInstrInShmem(nodeTag(node)))
+		instr = pickInstrFromShmem(node, instrument_options, sliceId, sending);
 
 	if (instr == NULL)
 		instr = InstrAlloc(1, instrument_options);
@@ -363,6 +369,29 @@ GpInstrAlloc(const Plan *node, int instrument_options)
 	return instr;
 }
 
+/*
+ * Return the shmem slot holding the given Instrumentation, or NULL if it
+ * was allocated in local memory.
+ *
+ * Nodes use this to publish live statistics that do not fit in
+ * Instrumentation, e.g. the receive queue depth of a Motion.
+ */
+InstrumentationSlot *
+GpInstrGetSlot(Instrumentation *instr)
+{
+	InstrumentationSlot *first;
+
+	if (NULL == instr || NULL == InstrumentGlobal)
+		return NULL;
+
+	first = (InstrumentationSlot *) (InstrumentGlobal + 1);
+	if ((char *) instr < (char *) first ||
+		(char *) instr >= (char *) (first + InstrShmemNumSlots()))
+		return NULL;
+
+	return (InstrumentationSlot *) instr;
+}
+
 static bool
 shouldPickInstrInShmem(NodeTag tag)
 {
@@ -404,7 +433,8 @@ shouldPickInstrInShmem(NodeTag tag)
  * See instrShmemRecycleCallback for recycling behavior
  */
 static Instrumentation *
-pickInstrFromShmem(const Plan *plan, int instrument_options)
+pickInstrFromShmem(const Plan *plan, int instrument_options, int sliceId,
+				   bool sending)
 {
 	Instrumentation *instr = NULL;
 	InstrumentationSlot *slot = NULL;
@@ -435,6 +465,10 @@ pickInstrFromShmem(const Plan *plan, int instrument_options)
 		slot->ssid = gp_session_id;
 		slot->ccnt = gp_command_count;
 		slot->nid = (int16) plan->plan_node_id;
+		slot->sliceid = (int16) sliceId;
+		slot->ntag = (int16) nodeTag(plan);
+		slot->tuplessent = sending ? 0 : -1;
+		slot->starttime = GetCurrentTimestamp();
 
 		MemoryContext contextSave = MemoryContextSwitchTo(TopMemoryContext);
 
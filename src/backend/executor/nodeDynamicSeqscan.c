@@ -7,6 +7,10 @@
  *
  * DynamicSeqScan node scans each relation one after the other. For each
  * relation, it opens the table, scans the tuple, and returns relevant tuples.
+ * Consecutive relations with the same attribute layout are scanned with the
+ * same SeqScanState, and with gp_dynamic_scan_prefetch_partitions set, the
+ * next few relations are opened and their first blocks prefetched while the
+ * current one is being scanned.
  *
  * GPDB_12_MERGE_FIXME: This is currently disabled altogether. If it is
  * resurrected, some changes are needed to GPORCA. The way Partition
@@ -41,8 +45,13 @@
 #include "cdb/cdbvars.h"
 #include "access/table.h"
 #include "access/tableam.h"
+#include "storage/bufmgr.h"
+
+/* Number of leading blocks of a heap partition to prefetch ahead of its scan */
+#define DYNAMIC_SCAN_PREFETCH_BLOCKS 32
 
 static void CleanupOnePartition(DynamicSeqScanState *node);
+static void prefetchNextPartitions(DynamicSeqScanState *node);
 
 /*
  * During attribute re-mapping for heterogeneous partitions, we use
@@ -139,14 +148,16 @@ ExecInitDynamicSeqScan(DynamicSeqScan *node, EState *estate, int eflags)
 	foreach_with_count(lc, node->partOids, i)
 		state->partOids[i] = lfirst_oid(lc);
 	state->whichPart = -1;
+	state->partRels = palloc0(sizeof(Relation) * state->nOids);
 
 	reloid = exec_rt_fetch(node->seqscan.scanrelid, estate)->relid;
 	Assert(OidIsValid(reloid));
+	Assert(RelationGetRelid(scanRel) == reloid);
 
 	state->firstPartition = true;
 
-	/* lastRelOid is used to remap varattno for heterogeneous partitions */
-	state->lastRelOid = reloid;
+	/* lastTupDesc is used to remap varattno for heterogeneous partitions */
+	state->lastTupDesc = CreateTupleDescCopy(RelationGetDescr(scanRel));
 
 	state->scanrelid = node->seqscan.scanrelid;
 
@@ -165,12 +176,12 @@ ExecInitDynamicSeqScan(DynamicSeqScan *node, EState *estate, int eflags)
 
 /*
  * initNextTableToScan
- *   Find the next table to scan and initiate the scan if the previous table
- * is finished.
+ *   Find the next table to scan and initiate its scan, ending the scan of
+ * the previous table.
  *
- * If scanning on the current table is not finished, or a new table is found,
- * this function returns true.
- * If no more table is found, this function returns false.
+ * If a new table is found, this function returns true.
+ * If no more table is found, this function returns false, and leaves the
+ * scan of the previous table, if any, for the caller to clean up.
  */
 static bool
 initNextTableToScan(DynamicSeqScanState *node)
@@ -178,39 +189,37 @@ initNextTableToScan(DynamicSeqScanState *node)
 	ScanState  *scanState = (ScanState *) node;
 	DynamicSeqScan *plan = (DynamicSeqScan *) scanState->ps.plan;
 	EState	   *estate = scanState->ps.state;
-	Relation	lastScannedRel;
 	TupleDesc	partTupDesc;
-	TupleDesc	lastTupDesc;
 	AttrNumber *attMap;
-	Oid		   *pid;
 	Relation	currentRelation;
 
-	if (++node->whichPart < node->nOids)
-		pid = &node->partOids[node->whichPart];
-	else
+	if (node->whichPart + 1 >= node->nOids)
 		return false;
+	node->whichPart++;
 
-	currentRelation = scanState->ss_currentRelation =
-		table_open(node->partOids[node->whichPart], AccessShareLock);
+	/* Use the relation if prefetchNextPartitions() has opened it already */
+	currentRelation = node->partRels[node->whichPart];
+	node->partRels[node->whichPart] = NULL;
+	if (currentRelation == NULL)
+		currentRelation = table_open(node->partOids[node->whichPart], AccessShareLock);
 
 	if (currentRelation->rd_rel->relkind != RELKIND_RELATION)
 	{
 		/* shouldn't happen */
 		elog(ERROR, "unexpected relkind in Dynamic Scan: %c", currentRelation->rd_rel->relkind);
 	}
-	lastScannedRel = table_open(node->lastRelOid, AccessShareLock);
-	lastTupDesc = RelationGetDescr(lastScannedRel);
-	partTupDesc = RelationGetDescr(scanState->ss_currentRelation);
+	partTupDesc = RelationGetDescr(currentRelation);
 	/*
 	 * FIXME: should we use execute_attr_map_tuple instead? Seems like a
 	 * higher level abstraction that fits the bill
 	 */
-	attMap = convert_tuples_by_name_map_if_req(partTupDesc, lastTupDesc, "unused msg");
-	table_close(lastScannedRel, AccessShareLock);
+	attMap = convert_tuples_by_name_map_if_req(partTupDesc, node->lastTupDesc, "unused msg");
 
 	/* If attribute remapping is not necessary, then do not change the varattno */
 	if (attMap)
 	{
+		MemoryContext oldCxt;
+
 		/*
 		 * FIXME: Ewww, this doesn't really belong in the executor. The optimizer
 		 * really should explicitly pass a qual and a tlist to us, for each
@@ -223,7 +232,10 @@ initNextTableToScan(DynamicSeqScanState *node)
 		 * Now that the varattno mapping has been changed, change the relation that
 		 * the new varnos correspond to
 		 */
-		node->lastRelOid = *pid;
+		oldCxt = MemoryContextSwitchTo(estate->es_query_cxt);
+		FreeTupleDesc(node->lastTupDesc);
+		node->lastTupDesc = CreateTupleDescCopy(partTupDesc);
+		MemoryContextSwitchTo(oldCxt);
 	}
 
 	/*
@@ -244,15 +256,89 @@ initNextTableToScan(DynamicSeqScanState *node)
 		MemoryContextSwitchTo(oldCxt);
 	}
 
+	/*
+	 * If the varattnos did not change and the partition uses the same kind of
+	 * slot, the previous partition's SeqScanState, with its qual, projection
+	 * and slots, can scan this one as well. Otherwise start over with a new
+	 * one.
+	 */
+	if (node->seqScanState && !attMap &&
+		node->seqScanState->ss.ss_ScanTupleSlot->tts_ops ==
+		table_slot_callbacks(currentRelation))
+	{
+		ExecSeqScanSwitchPartition(node->seqScanState, currentRelation);
+		table_close(scanState->ss_currentRelation, NoLock);
+	}
+	else
+	{
+		MemoryContext oldCxt;
+		TupleDesc	scanDesc;
+
+		CleanupOnePartition(node);
+
+		/*
+		 * The state may be switched to later partitions, after this one is
+		 * closed, so its slot gets a descriptor that doesn't live in the
+		 * relcache.
+		 */
+		oldCxt = MemoryContextSwitchTo(estate->es_query_cxt);
+		scanDesc = CreateTupleDescCopy(partTupDesc);
+		MemoryContextSwitchTo(oldCxt);
+
+//		DynamicScan_SetTableOid(&node->ss, *pid);
+		node->seqScanState = ExecInitSeqScanForPartition(&plan->seqscan, estate,
+														 currentRelation,
+														 scanDesc);
+	}
+	scanState->ss_currentRelation = currentRelation;
+
 	if (attMap)
 		pfree(attMap);
 
-//	DynamicScan_SetTableOid(&node->ss, *pid);
-	node->seqScanState = ExecInitSeqScanForPartition(&plan->seqscan, estate,
-													 currentRelation);
+	prefetchNextPartitions(node);
+
 	return true;
 }
 
+/*
+ * prefetchNextPartitions
+ *   Open the next gp_dynamic_scan_prefetch_partitions partitions, and
+ * prefetch the first blocks of the heap ones.
+ *
+ * This takes the locks and relcache entries of the upcoming partitions out of
+ * the way, and lets the kernel read their first blocks while the current
+ * partition is being scanned. Append-optimized partitions are only opened,
+ * their segment files are not read through shared buffers.
+ */
+static void
+prefetchNextPartitions(DynamicSeqScanState *node)
+{
+	int			lastPart;
+
+	lastPart = Min(node->whichPart + gp_dynamic_scan_prefetch_partitions,
+				   node->nOids - 1);
+
+	for (int i = node->whichPart + 1; i <= lastPart; i++)
+	{
+		Relation	rel;
+
+		if (node->partRels[i] != NULL)
+			continue;
+
+		rel = table_open(node->partOids[i], AccessShareLock);
+		node->partRels[i] = rel;
+
+		if (RelationIsHeap(rel))
+		{
+			BlockNumber nblocks = RelationGetNumberOfBlocks(rel);
+
+			nblocks = Min(nblocks, DYNAMIC_SCAN_PREFETCH_BLOCKS);
+			for (BlockNumber blkno = 0; blkno < nblocks; blkno++)
+				PrefetchBuffer(rel, MAIN_FORKNUM, blkno);
+		}
+	}
+}
+
 
 TupleTableSlot *
 ExecDynamicSeqScan(PlanState *pstate)
@@ -278,8 +364,12 @@ ExecDynamicSeqScan(PlanState *pstate)
 		if (!TupIsNull(slot))
 			break;
 
-		/* No more tuples from this partition. Move to next one. */
-		CleanupOnePartition(node);
+		/* No more tuples from this partition. Move to next one, if any. */
+		if (!initNextTableToScan(node))
+		{
+			CleanupOnePartition(node);
+			break;
+		}
 	}
 
 	return slot;
@@ -324,6 +414,16 @@ ExecEndDynamicSeqScan(DynamicSeqScanState *node)
 {
 	DynamicSeqScanEndCurrentScan(node);
 
+	/* Close the partitions that were opened ahead but not scanned */
+	for (int i = 0; i < node->nOids; i++)
+	{
+		if (node->partRels[i] != NULL)
+		{
+			table_close(node->partRels[i], NoLock);
+			node->partRels[i] = NULL;
+		}
+	}
+
 	if (node->ss.ps.ps_ResultTupleSlot)
 		ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
 }
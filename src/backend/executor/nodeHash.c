@@ -51,6 +51,7 @@
 #include "cdb/cdbvars.h"
 
 static void ExecHashIncreaseNumBatches(HashJoinTable hashtable);
+static Size ExecHashFindHeavyHitter(HashJoinTable hashtable, uint32 *hashvalue);
 static void ExecHashIncreaseNumBuckets(HashJoinTable hashtable);
 static void ExecParallelHashIncreaseNumBatches(HashJoinTable hashtable);
 static void ExecParallelHashIncreaseNumBuckets(HashJoinTable hashtable);
@@ -532,6 +533,13 @@ ExecHashTableCreate(HashState *state, HashJoinState *hjstate,
 	hashtable->nbatch_original = nbatch;
 	hashtable->nbatch_outstart = nbatch;
 	hashtable->growEnabled = true;
+	hashtable->stripingEnabled = gp_hashjoin_adaptive_skew &&
+		state->parallel_state == NULL &&
+		!hjstate->reuse_hashtable &&
+		(hjstate->js.jointype == JOIN_INNER ||
+		 hjstate->js.jointype == JOIN_RIGHT);
+	hashtable->curstripe = 0;
+	hashtable->innerStripeFile = NULL;
 	hashtable->totalTuples = 0;
 	hashtable->partialTuples = 0;
 	hashtable->skewTuples = 0;
@@ -1000,6 +1008,11 @@ ExecHashTableDestroy(HashState *hashState, HashJoinTable hashtable)
 			hashtable->outerBatchFile[i] = NULL;
 		}
 	}
+	if (hashtable->innerStripeFile != NULL)
+	{
+		BufFileClose(hashtable->innerStripeFile);
+		hashtable->innerStripeFile = NULL;
+	}
 
 	if (hashtable->work_set != NULL)
 	{
@@ -1011,6 +1024,74 @@ ExecHashTableDestroy(HashState *hashState, HashJoinTable hashtable)
 	MemoryContextDelete(hashtable->hashCxt);
 }
 
+/*
+ * ExecHashFindHeavyHitter
+ *		find the hash value that dominates the in-memory hash table, if any
+ *
+ * Returns the space used by the tuples with that hash value, and the hash
+ * value itself in *hashvalue.  This is a Boyer-Moore majority vote over the
+ * tuples in the dense chunks, followed by a second pass to measure the
+ * winner.  The vote is only guaranteed to find a value held by more than half
+ * of the tuples, but that's all we need: we're asked to grow just after the
+ * table went over budget, and a value holding less than half of it could be
+ * split off by increasing nbatch.  Skew buckets are not considered; those
+ * tuples stay in memory regardless.
+ */
+static Size
+ExecHashFindHeavyHitter(HashJoinTable hashtable, uint32 *hashvalue)
+{
+	HashMemoryChunk chunk;
+	uint32		candidate = 0;
+	long		votes = 0;
+	Size		space = 0;
+
+	for (chunk = hashtable->chunks; chunk != NULL; chunk = chunk->next.unshared)
+	{
+		size_t		idx = 0;
+
+		while (idx < chunk->used)
+		{
+			HashJoinTuple hashTuple = (HashJoinTuple) (HASH_CHUNK_DATA(chunk) + idx);
+			MinimalTuple tuple = HJTUPLE_MINTUPLE(hashTuple);
+
+			if (votes == 0)
+			{
+				candidate = hashTuple->hashvalue;
+				votes = 1;
+			}
+			else if (hashTuple->hashvalue == candidate)
+				votes++;
+			else
+				votes--;
+
+			idx += MAXALIGN(HJTUPLE_OVERHEAD + tuple->t_len);
+		}
+	}
+
+	for (chunk = hashtable->chunks; chunk != NULL; chunk = chunk->next.unshared)
+	{
+		size_t		idx = 0;
+
+		while (idx < chunk->used)
+		{
+			HashJoinTuple hashTuple = (HashJoinTuple) (HASH_CHUNK_DATA(chunk) + idx);
+			MinimalTuple tuple = HJTUPLE_MINTUPLE(hashTuple);
+			int			hashTupleSize = (HJTUPLE_OVERHEAD + tuple->t_len);
+
+			if (hashTuple->hashvalue == candidate)
+				space += hashTupleSize;
+
+			idx += MAXALIGN(hashTupleSize);
+		}
+
+		/* allow this loop to be cancellable */
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	*hashvalue = candidate;
+	return space;
+}
+
 /*
  * ExecHashIncreaseNumBatches
  *		increase the original number of batches in order to reduce
@@ -1038,6 +1119,48 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 	if (oldnbatch > Min(INT_MAX / 2, MaxAllocSize / (sizeof(void *) * 2)))
 		return;
 
+	/*
+	 * GPDB: If a single hash value holds so much of the table that we would
+	 * still be over budget after splitting everything else in two, doubling
+	 * nbatch only writes the other tuples out again, and we'd keep doubling
+	 * until nothing but that value is left.  Instead, keep the heavy hitter
+	 * pinned in memory, shut off growth, and let ExecHashTableInsert send the
+	 * rest of the batch to later stripes.
+	 */
+	if (hashtable->stripingEnabled)
+	{
+		uint32		hotvalue;
+		Size		hotspace;
+		Size		restspace;
+
+		hotspace = ExecHashFindHeavyHitter(hashtable, &hotvalue);
+		restspace = hashtable->spaceUsed - hashtable->spaceUsedSkew - hotspace;
+
+		if (hashtable->spaceUsedSkew + hotspace + restspace / 2 >
+			hashtable->spaceAllowed)
+		{
+			MemoryContext oldcxt;
+
+			/* the first batch needs somewhere to keep its outer tuples */
+			if (hashtable->innerBatchFile == NULL)
+			{
+				oldcxt = MemoryContextSwitchTo(hashtable->hashCxt);
+				hashtable->innerBatchFile = (BufFile **)
+					palloc0(oldnbatch * sizeof(BufFile *));
+				hashtable->outerBatchFile = (BufFile **)
+					palloc0(oldnbatch * sizeof(BufFile *));
+				MemoryContextSwitchTo(oldcxt);
+			}
+
+			hashtable->growEnabled = false;
+#ifdef HJDEBUG
+			printf("Hashjoin %p: hash value %u holds %zu of %zu bytes, disabling further increase of nbatch\n",
+				   hashtable, hotvalue, hotspace, hashtable->spaceUsed);
+#endif
+			return;
+		}
+	}
+
 	/* A reusable hash table can only respill during first pass */
 	AssertImply(hashtable->hjstate->reuse_hashtable, hashtable->first_pass);
 
@@ -1754,8 +1877,8 @@ ExecParallelHashIncreaseNumBuckets(HashJoinTable hashtable)
  * worth the messiness required.
  *
  * Returns true if the tuple belonged to this batch and was inserted to
- * the in-memory hash table, or false if it belonged to a later batch and
- * was pushed to a temp file.
+ * the in-memory hash table, or false if it belonged to a later batch (or a
+ * later stripe of this batch) and was pushed to a temp file.
  */
 bool
 ExecHashTableInsert(HashState *hashState, HashJoinTable hashtable,
@@ -1771,6 +1894,29 @@ ExecHashTableInsert(HashState *hashState, HashJoinTable hashtable,
 	ExecHashGetBucketAndBatch(hashtable, hashvalue,
 							  &bucketno, &batchno);
 
+	/*
+	 * GPDB: If the current batch is being split into stripes, and this tuple
+	 * doesn't fit in the current stripe, leave it for a later one.  Every
+	 * stripe gets at least one tuple, so we always make progress.
+	 */
+	if (batchno == hashtable->curbatch &&
+		(hashtable->innerStripeFile != NULL ||
+		 (hashtable->stripingEnabled && !hashtable->growEnabled &&
+		  hashtable->spaceUsed > 0 &&
+		  hashtable->spaceUsed + HJTUPLE_OVERHEAD + tuple->t_len +
+		  hashtable->nbuckets_optimal * sizeof(HashJoinTuple)
+		  > hashtable->spaceAllowed)))
+	{
+		ExecHashJoinSaveTuple(ps, tuple,
+							  hashvalue,
+							  hashtable,
+							  &hashtable->innerStripeFile,
+							  hashtable->bfCxt);
+		if (shouldFree)
+			heap_free_minimal_tuple(tuple);
+		return false;
+	}
+
 	/*
 	 * decide whether to put the tuple in the hash table or a temp file
 	 */
@@ -2522,6 +2668,12 @@ ExecHashTableExplainEnd(PlanState *planstate, struct StringInfoData *buf)
                              "  Skipped %d empty batches.",
                              hashtable->nbatch - stats->nonemptybatches);
     }
+
+    /* Report the stripes of batches that didn't fit in work_mem. */
+    if (stats->nstripes > 0)
+        appendStringInfo(buf,
+                         "  Joined %d more stripes of oversized batches.",
+                         stats->nstripes);
 }                               /* ExecHashTableExplainEnd */
 
 
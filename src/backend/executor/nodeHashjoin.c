@@ -160,6 +160,7 @@ static void ReleaseHashTable(HashJoinState *node);
 
 static void SpillCurrentBatch(HashJoinState *node);
 static bool ExecHashJoinReloadHashTable(HashJoinState *hjstate);
+static bool ExecHashJoinLoadNextStripe(HashJoinState *hjstate);
 static void ExecEagerFreeHashJoin(HashJoinState *node);
 
 /* ----------------------------------------------------------------
@@ -489,21 +490,48 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 
 					/*
 					 * Need to postpone this outer tuple to a later batch.
-					 * Save it in the corresponding outer-batch file.
+					 * Save it in the corresponding outer-batch file.  If
+					 * we're rereading the outer batch for a later stripe,
+					 * that was already done on the first pass.
 					 */
 					Assert(parallel_state == NULL);
 					Assert(batchno > hashtable->curbatch);
+					if (hashtable->curstripe == 0)
+						ExecHashJoinSaveTuple(&node->js.ps, mintuple,
+											  hashvalue,
+											  hashtable,
+											  &hashtable->outerBatchFile[batchno],
+											  hashtable->bfCxt);
+
+					if (shouldFree)
+						pfree(mintuple);
+
+					/* Loop around, staying in HJ_NEED_NEW_OUTER state */
+					continue;
+				}
+
+				/*
+				 * GPDB: If the first batch didn't fit in memory and is being
+				 * processed in stripes, keep its outer tuples so that they
+				 * can be joined against the later stripes too.  Tuples that
+				 * match a skew bucket are done after this pass, though.
+				 */
+				if (hashtable->curbatch == 0 && hashtable->curstripe == 0 &&
+					hashtable->innerStripeFile != NULL &&
+					node->hj_CurSkewBucketNo == INVALID_SKEW_BUCKET_NO)
+				{
+					bool		shouldFree;
+					MinimalTuple mintuple = ExecFetchSlotMinimalTuple(outerTupleSlot,
+																	  &shouldFree);
+
 					ExecHashJoinSaveTuple(&node->js.ps, mintuple,
 										  hashvalue,
 										  hashtable,
-										  &hashtable->outerBatchFile[batchno],
+										  &hashtable->outerBatchFile[0],
 										  hashtable->bfCxt);
 
 					if (shouldFree)
 						pfree(mintuple);
-
-					/* Loop around, staying in HJ_NEED_NEW_OUTER state */
-					continue;
 				}
 
 				/* OK, let's scan the bucket for matches */
@@ -1019,8 +1047,11 @@ ExecHashJoinOuterGetTuple(PlanState *outerNode,
 	ExprContext *econtext;
 	HashState  *hashState = (HashState *) innerPlanState(hjstate);
 
-	/* Read tuples from outer relation only if it's the first batch */
-	if (curbatch == 0)
+	/*
+	 * Read tuples from outer relation only if it's the first batch, and we
+	 * haven't moved on to a later stripe of it.
+	 */
+	if (curbatch == 0 && hashtable->curstripe == 0)
 	{
 		/*
 		 * Check to see if first outer tuple was already fetched by
@@ -1198,6 +1229,22 @@ ExecHashJoinNewBatch(HashJoinState *hjstate)
 	if (curbatch >= nbatch)
 		return false;
 
+	/*
+	 * GPDB: If the current batch was split into stripes, join the next
+	 * stripe against the same outer batch before moving on.  An inner join
+	 * can skip that if there are no outer tuples.
+	 */
+	if (hashtable->innerStripeFile != NULL)
+	{
+		if (hashtable->outerBatchFile[curbatch] != NULL ||
+			HJ_FILL_INNER(hjstate))
+			return ExecHashJoinLoadNextStripe(hjstate);
+
+		BufFileClose(hashtable->innerStripeFile);
+		hashtable->innerStripeFile = NULL;
+	}
+	hashtable->curstripe = 0;
+
 	if (curbatch >= 0 && hashtable->stats)
 		ExecHashTableExplainBatchEnd(hashState, hashtable);
 
@@ -1224,6 +1271,13 @@ ExecHashJoinNewBatch(HashJoinState *hjstate)
 		hashtable->skewBucketNums = NULL;
 		hashtable->nSkewBuckets = 0;
 		hashtable->spaceUsedSkew = 0;
+
+		/* The first batch only has an outer file if it was striped */
+		if (hashtable->outerBatchFile && hashtable->outerBatchFile[0])
+		{
+			BufFileClose(hashtable->outerBatchFile[0]);
+			hashtable->outerBatchFile[0] = NULL;
+		}
 	}
 
 	/*
@@ -1887,6 +1941,90 @@ ExecHashJoinReloadHashTable(HashJoinState *hjstate)
 	return true;
 }
 
+/*
+ * ExecHashJoinLoadNextStripe
+ *		load the next stripe of the current batch into the hash table
+ *
+ * The inner tuples that didn't fit in the previous stripe are loaded, and any
+ * that still don't fit are sent on to yet another stripe.  The outer batch is
+ * rewound, so that all of it gets joined against the new stripe.
+ *
+ * Returns true if successful, false if the query is finishing.
+ */
+static bool
+ExecHashJoinLoadNextStripe(HashJoinState *hjstate)
+{
+	HashState  *hashState = (HashState *) innerPlanState(hjstate);
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	BufFile    *file = hashtable->innerStripeFile;
+	int			curbatch = hashtable->curbatch;
+	TupleTableSlot *slot;
+	uint32		hashvalue;
+
+	Assert(hashtable->stripingEnabled);
+
+	if (curbatch == 0)
+	{
+		/*
+		 * All the skew tuples were joined with the first stripe.  Their
+		 * memory goes away with the reset below.
+		 */
+		hashtable->skewEnabled = false;
+		hashtable->skewBucket = NULL;
+		hashtable->skewBucketNums = NULL;
+		hashtable->nSkewBuckets = 0;
+		hashtable->spaceUsedSkew = 0;
+	}
+
+	hashtable->innerStripeFile = NULL;
+	hashtable->curstripe++;
+	if (hashtable->stats)
+		hashtable->stats->nstripes++;
+
+	ExecHashTableReset(hashState, hashtable);
+
+	if (BufFileSeek(file, 0, 0, SEEK_SET) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not rewind hash-join temporary file: %m")));
+
+	for (;;)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		if (QueryFinishPending)
+		{
+			BufFileClose(file);
+			return false;
+		}
+
+		slot = ExecHashJoinGetSavedTuple(hjstate,
+										 file,
+										 &hashvalue,
+										 hjstate->hj_HashTupleSlot);
+		if (!slot)
+			break;
+
+		(void) ExecHashTableInsert(hashState, hashtable, slot, hashvalue);
+	}
+
+	BufFileClose(file);
+
+#ifdef HJDEBUG
+	elog(gp_workfile_caching_loglevel, "HashJoin loaded stripe %d of batch %d", hashtable->curstripe, curbatch);
+#endif
+
+	if (hashtable->outerBatchFile[curbatch] != NULL)
+	{
+		if (BufFileSeek(hashtable->outerBatchFile[curbatch], 0, 0, SEEK_SET) != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not rewind hash-join temporary file: %m")));
+	}
+
+	return true;
+}
+
 void
 ExecShutdownHashJoin(HashJoinState *node)
 {
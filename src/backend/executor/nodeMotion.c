@@ -24,8 +24,8 @@
 #include "executor/executor.h"
 #include "executor/execdebug.h"
 #include "executor/execUtils.h"
+#include "executor/instrument.h"
 #include "executor/nodeMotion.h"
-#include "lib/binaryheap.h"
 #include "utils/tuplesort.h"
 #include "miscadmin.h"
 #include "utils/memutils.h"
@@ -52,7 +52,11 @@ static TupleTableSlot *execMotionSender(MotionState *node);
 static TupleTableSlot *execMotionUnsortedReceiver(MotionState *node);
 static TupleTableSlot *execMotionSortedReceiver(MotionState *node);
 
-static int	CdbMergeComparator(Datum lhs, Datum rhs, void *context);
+static int	CdbMergeComparator(MotionState *node, int lSegIdx, int rSegIdx);
+static bool mergeBefore(MotionState *node, int lSegIdx, int rSegIdx);
+static void mergeStoreTuple(MotionState *node, int segIdx, MinimalTuple tuple);
+static void mergeBuildTree(MotionState *node);
+static void mergeReplay(MotionState *node, int segIdx);
 static uint32 evalHashKey(ExprContext *econtext, List *hashkeys, CdbHash *h);
 
 static void doSendEndOfStream(Motion *motion, MotionState *node);
@@ -379,9 +383,9 @@ execMotionUnsortedReceiver(MotionState *node)
  * --------------------
  *
  * The 1st time we execute, we need to pull a tuple from each of our source
- * and store them in our tupleheap.  Once that is done, we can pick the lowest
- * (or whatever the criterion is) value from amongst all the sources.  This
- * works since each stream is sorted itself.
+ * and build a tournament tree over them.  Once that is done, we can pick the
+ * lowest (or whatever the criterion is) value from amongst all the sources.
+ * This works since each stream is sorted itself.
  *
  * We keep track of which one was selected, this will be slot we will need
  * to fill during the next call.
@@ -389,21 +393,29 @@ execMotionUnsortedReceiver(MotionState *node)
  * Subsequent calls to this function (after the 1st time) will start by
  * trying to receive a tuple for the slot that was emptied the previous call.
  * Then we again select the lowest value and return that tuple.
+ *
+ * The tournament is a loser tree: each internal node remembers the sender
+ * that lost the match played there, and the overall winner is kept apart.
+ * Replacing the winner's tuple only replays the matches on the path from its
+ * leaf to the root, one comparison per level, where a binary heap needs two
+ * per level to sift the new tuple down.  Senders at end-of-stream lose every
+ * match.  If the leading sort key supports abbreviation, each received tuple
+ * gets its abbreviated key computed once, and the matches compare those
+ * before falling back to the full comparator, as tuplesort does.
  */
 
-/* Sorted receiver using binary heap */
+/* Sorted receiver using a loser tree */
 static TupleTableSlot *
 execMotionSortedReceiver(MotionState *node)
 {
 	TupleTableSlot *slot;
-	binaryheap *hp = node->tupleheap;
 	MinimalTuple inputTuple;
 	Motion	   *motion = (Motion *) node->ps.plan;
 	EState	   *estate = node->ps.state;
 
 	AssertState(motion->motionType == MOTIONTYPE_GATHER &&
 				motion->sendSorted &&
-				hp != NULL);
+				node->mergeTree != NULL);
 
 	/* Notify senders and return EOS if caller doesn't want any more data. */
 	if (node->stopRequested)
@@ -416,12 +428,11 @@ execMotionSortedReceiver(MotionState *node)
 	}
 
 	/*
-	 * On first call, fill the priority queue with each sender's first tuple.
+	 * On first call, fill the tree with each sender's first tuple.
 	 */
-	if (!node->tupleheapReady)
+	if (!node->mergeReady)
 	{
 		MinimalTuple inputTuple;
-		binaryheap *hp = node->tupleheap;
 		Motion	   *motion = (Motion *) node->ps.plan;
 		int			iSegIdx;
 		ListCell   *lcProcess;
@@ -454,17 +465,7 @@ execMotionSortedReceiver(MotionState *node)
 													  &TTSOpsMinimalTuple);
 			MemoryContextSwitchTo(oldcxt);
 
-			/*
-			 * Store the tuple in the slot, and add it to the heap.
-			 *
-			 * Use slot_getsomeattrs() to materialize the columns we need for
-			 * the comparisons in the tts_values/isnull arrays. The comparator
-			 * can then peek directly into the arrays, which is cheaper than
-			 * calling slot_getattr() all the time.
-			 */
-			ExecStoreMinimalTuple(inputTuple, node->slots[iSegIdx], true);
-			slot_getsomeattrs(node->slots[iSegIdx], node->lastSortColIdx);
-			binaryheap_add_unordered(hp, iSegIdx);
+			mergeStoreTuple(node, iSegIdx, inputTuple);
 
 			node->numTuplesFromAMS++;
 
@@ -487,27 +488,26 @@ execMotionSortedReceiver(MotionState *node)
 		Assert(iSegIdx == node->numInputSegs);
 
 		/*
-		 * Done adding the elements, now arrange the heap to satisfy the heap
-		 * property. This is quicker than inserting the initial elements one by
-		 * one.
+		 * Play all the matches at once. This is quicker than replaying each
+		 * sender's path as it is added.
 		 */
-		binaryheap_build(hp);
+		mergeBuildTree(node);
 
-		node->tupleheapReady = true;
+		node->mergeReady = true;
 	}
 
 	/*
-	 * Delete from the priority queue the element that we fetched last time.
-	 * Receive and insert the next tuple from that same sender.
+	 * Replace the tuple that we returned last time with the next tuple from
+	 * that same sender, and replay its matches.
 	 */
 	else
 	{
 		/* sanity check */
-		if (binaryheap_empty(hp))
+		if (!mergeBefore(node, node->mergeTree[0], -1))
 			elog(ERROR, "sorted Gather Motion called again after already receiving all data");
 
-		/* Old element is still at the head of the pq. */
-		Assert(DatumGetInt32(binaryheap_first(hp)) == node->routeIdNext);
+		/* Old element is still the winner. */
+		Assert(node->mergeTree[0] == node->routeIdNext);
 
 		/* Receive the successor of the tuple that we returned last time. */
 		inputTuple = RecvTupleFrom(node->ps.state->motionlayer_context,
@@ -515,12 +515,9 @@ execMotionSortedReceiver(MotionState *node)
 								   motion->motionID,
 								   node->routeIdNext);
 
-		/* Substitute it in the pq for its predecessor. */
 		if (inputTuple)
 		{
-			ExecStoreMinimalTuple(inputTuple, node->slots[node->routeIdNext], true);
-			slot_getsomeattrs(node->slots[node->routeIdNext], node->lastSortColIdx);
-			binaryheap_replace_first(hp, Int32GetDatum(node->routeIdNext));
+			mergeStoreTuple(node, node->routeIdNext, inputTuple);
 
 			node->numTuplesFromAMS++;
 
@@ -542,13 +539,15 @@ execMotionSortedReceiver(MotionState *node)
 		}
 		else
 		{
-			/* At EOS, drop this sender from the priority queue. */
-			binaryheap_remove_first(hp);
+			/* At EOS, this sender loses all its matches from now on. */
+			ExecClearTuple(node->slots[node->routeIdNext]);
 		}
+
+		mergeReplay(node, node->routeIdNext);
 	}
 
 	/* Finished if all senders have returned EOS. */
-	if (binaryheap_empty(hp))
+	if (!mergeBefore(node, node->mergeTree[0], -1))
 	{
 		Assert(node->numTuplesFromAMS == node->numTuplesToParent);
 		Assert(node->numTuplesFromChild == 0);
@@ -557,15 +556,13 @@ execMotionSortedReceiver(MotionState *node)
 	}
 
 	/*
-	 * Our next result tuple, with lowest key among all senders, is now at the
-	 * head of the priority queue.  Get it from there.
+	 * Our next result tuple, with lowest key among all senders, is now the
+	 * winner of the tree.  Get it from there.
 	 *
-	 * We transfer ownership of the tuple from the pq element to our caller,
-	 * but the pq element itself will remain in place until the next time we
-	 * are called, to avoid an unnecessary rearrangement of the priority
-	 * queue.
+	 * We transfer ownership of the tuple from the sender's slot to our
+	 * caller, but the slot will keep it until the next time we are called.
 	 */
-	node->routeIdNext = binaryheap_first(hp);
+	node->routeIdNext = node->mergeTree[0];
 	slot = node->slots[node->routeIdNext];
 
 	/* Update counters. */
@@ -695,7 +692,7 @@ ExecInitMotion(Motion *node, EState *estate, int eflags)
 		/* TODO: If neither sending nor receiving, don't bother to initialize. */
 	}
 
-	motionstate->tupleheapReady = false;
+	motionstate->mergeReady = false;
 	motionstate->sentEndOfStream = false;
 
 	motionstate->otherTime.tv_sec = 0;
@@ -791,6 +788,8 @@ ExecInitMotion(Motion *node, EState *estate, int eflags)
 			sortKey->ssup_collation = node->collations[i];
 			sortKey->ssup_nulls_first = node->nullsFirst[i];
 			sortKey->ssup_attno = node->sortColIdx[i];
+			/* Convey if abbreviation optimization is applicable in principle */
+			sortKey->abbreviate = (i == 0);
 
 			PrepareSortSupportFromOrderingOp(node->sortOperators[i], sortKey);
 
@@ -799,10 +798,18 @@ ExecInitMotion(Motion *node, EState *estate, int eflags)
 				lastSortColIdx = node->sortColIdx[i];
 		}
 		motionstate->lastSortColIdx = lastSortColIdx;
-		motionstate->tupleheap =
-			binaryheap_allocate(motionstate->numInputSegs,
-								CdbMergeComparator,
-								motionstate);
+		motionstate->mergeTree = palloc(numInputSegs * sizeof(int));
+
+		/*
+		 * If the leading key can be abbreviated, keep the abbreviated key of
+		 * each sender's current tuple.
+		 */
+		if (node->numSortCols > 0 &&
+			motionstate->sortKeys[0].abbrev_converter != NULL)
+		{
+			motionstate->abbrevKeys = palloc0(numInputSegs * sizeof(Datum));
+			motionstate->abbrevNext = 10;
+		}
 	}
 
 	/*
@@ -905,11 +912,16 @@ ExecEndMotion(MotionState *node)
 	}
 #endif							/* MEASURE_MOTION_TIME */
 
-	/* Merge Receive: Free the priority queue and associated structures. */
-	if (node->tupleheap != NULL)
+	/* Merge Receive: Free the loser tree and associated structures. */
+	if (node->mergeTree != NULL)
 	{
-		binaryheap_free(node->tupleheap);
-		node->tupleheap = NULL;
+		pfree(node->mergeTree);
+		node->mergeTree = NULL;
+	}
+	if (node->abbrevKeys != NULL)
+	{
+		pfree(node->abbrevKeys);
+		node->abbrevKeys = NULL;
 	}
 
 	/* Free the slices and routes */
@@ -944,12 +956,8 @@ ExecEndMotion(MotionState *node)
  * Used to compare tuples for a sorted motion node.
  */
 static int
-CdbMergeComparator(Datum lhs, Datum rhs, void *context)
+CdbMergeComparator(MotionState *node, int lSegIdx, int rSegIdx)
 {
-	MotionState *node = (MotionState *) context;
-	int			lSegIdx = DatumGetInt32(lhs);
-	int			rSegIdx = DatumGetInt32(rhs);
-
 	TupleTableSlot *lslot = node->slots[lSegIdx];
 	TupleTableSlot *rslot = node->slots[rSegIdx];
 	SortSupport	sortKeys = node->sortKeys;
@@ -977,18 +985,170 @@ CdbMergeComparator(Datum lhs, Datum rhs, void *context)
 		datum2 = rslot->tts_values[attno - 1];
 		isnull2 = rslot->tts_isnull[attno - 1];
 
-		compare = ApplySortComparator(datum1, isnull1,
-									  datum2, isnull2,
-									  ssup);
-		if (compare != 0)
+		if (nkey == 0 && node->abbrevKeys != NULL)
 		{
-			INVERT_COMPARE_RESULT(compare);
-			return compare;
+			compare = ApplySortComparator(node->abbrevKeys[lSegIdx], isnull1,
+										  node->abbrevKeys[rSegIdx], isnull2,
+										  ssup);
+			if (compare == 0)
+				compare = ApplySortAbbrevFullComparator(datum1, isnull1,
+														datum2, isnull2,
+														ssup);
 		}
+		else
+			compare = ApplySortComparator(datum1, isnull1,
+										  datum2, isnull2,
+										  ssup);
+		if (compare != 0)
+			return compare;
 	}
 	return 0;
 }								/* CdbMergeComparator */
 
+/*
+ * mergeBefore:
+ * Does the current tuple of sender lSegIdx win the match against that of
+ * rSegIdx? Senders without a tuple lose every match, including against
+ * rSegIdx -1, and ties go to the lower sender index.
+ */
+static bool
+mergeBefore(MotionState *node, int lSegIdx, int rSegIdx)
+{
+	int			compare;
+
+	if (TupIsNull(node->slots[lSegIdx]))
+		return false;
+	if (rSegIdx < 0 || TupIsNull(node->slots[rSegIdx]))
+		return true;
+
+	compare = CdbMergeComparator(node, lSegIdx, rSegIdx);
+
+	return compare < 0 || (compare == 0 && lSegIdx < rSegIdx);
+}
+
+/*
+ * mergeStoreTuple:
+ * Store the next tuple received from a sender in its slot.
+ *
+ * Use slot_getsomeattrs() to materialize the columns we need for the
+ * comparisons in the tts_values/isnull arrays. The comparator can then peek
+ * directly into the arrays, which is cheaper than calling slot_getattr() all
+ * the time.
+ */
+static void
+mergeStoreTuple(MotionState *node, int segIdx, MinimalTuple tuple)
+{
+	TupleTableSlot *slot = node->slots[segIdx];
+
+	ExecStoreMinimalTuple(tuple, slot, true);
+	slot_getsomeattrs(slot, node->lastSortColIdx);
+
+	if (node->abbrevKeys != NULL)
+	{
+		SortSupport ssup = &node->sortKeys[0];
+		AttrNumber	attno = ssup->ssup_attno;
+		int64		ntuples = node->numTuplesFromAMS + 1;
+
+		if (slot->tts_isnull[attno - 1])
+			node->abbrevKeys[segIdx] = (Datum) 0;
+		else
+			node->abbrevKeys[segIdx] = ssup->abbrev_converter(slot->tts_values[attno - 1],
+															  ssup);
+
+		/*
+		 * Like tuplesort, check at exponentially spaced intervals whether
+		 * the abbreviated keys are distinguishing enough to be worth it.
+		 * Abbreviated keys order the same as the full ones, so the tree
+		 * stays valid when we switch to full comparisons.
+		 */
+		if (ntuples >= node->abbrevNext)
+		{
+			node->abbrevNext *= 2;
+			if (ssup->abbrev_abort(ntuples, ssup))
+			{
+				ssup->comparator = ssup->abbrev_full_comparator;
+				ssup->abbrev_converter = NULL;
+				ssup->abbrev_abort = NULL;
+				ssup->abbrev_full_comparator = NULL;
+
+				pfree(node->abbrevKeys);
+				node->abbrevKeys = NULL;
+			}
+		}
+	}
+}
+
+/*
+ * mergeBuildTree:
+ * Play all the matches of the loser tree of a sorted motion node.
+ *
+ * The tree has numInputSegs leaves, leaf i being node numInputSegs + i, and
+ * the parent of node n is node n / 2. mergeTree[n] holds the loser of the
+ * match at internal node n, and mergeTree[0] the overall winner.
+ */
+static void
+mergeBuildTree(MotionState *node)
+{
+	int			nsegs = node->numInputSegs;
+	int		   *tree = node->mergeTree;
+	int		   *winners;
+	int			n;
+
+	if (nsegs == 1)
+	{
+		tree[0] = 0;
+		return;
+	}
+
+	winners = palloc(nsegs * sizeof(int));
+	for (n = nsegs - 1; n >= 1; n--)
+	{
+		int			left = 2 * n;
+		int			right = 2 * n + 1;
+		int			lwinner = (left >= nsegs) ? left - nsegs : winners[left];
+		int			rwinner = (right >= nsegs) ? right - nsegs : winners[right];
+
+		if (mergeBefore(node, rwinner, lwinner))
+		{
+			winners[n] = rwinner;
+			tree[n] = lwinner;
+		}
+		else
+		{
+			winners[n] = lwinner;
+			tree[n] = rwinner;
+		}
+	}
+	tree[0] = winners[1];
+	pfree(winners);
+}
+
+/*
+ * mergeReplay:
+ * Replay the matches of the previous winner after its tuple was replaced.
+ */
+static void
+mergeReplay(MotionState *node, int segIdx)
+{
+	int		   *tree = node->mergeTree;
+	int			winner = segIdx;
+	int			n;
+
+	Assert(tree[0] == segIdx);
+
+	for (n = (node->numInputSegs + segIdx) / 2; n >= 1; n /= 2)
+	{
+		if (mergeBefore(node, tree[n], winner))
+		{
+			int			loser = winner;
+
+			winner = tree[n];
+			tree[n] = loser;
+		}
+	}
+	tree[0] = winner;
+}
+
 /*
  * Experimental code that will be replaced later with new hashing mechanism
  */
@@ -1169,7 +1329,34 @@ doSendTuple(Motion *motion, MotionState *node, TupleTableSlot *outerTupleSlot)
 
 	Assert(sendRC == SEND_COMPLETE || sendRC == STOP_SENDING);
 	if (sendRC == SEND_COMPLETE)
+	{
 		node->numTuplesToAMS++;
+
+		/*
+		 * GPDB: with query metrics on, publish the tuples sent, so that
+		 * gp_toolkit.gp_live_exec_stats_summary can tell how many the
+		 * receivers have not consumed yet.  A broadcast tuple is sent to
+		 * every receiver.
+		 */
+		if (node->ps.instrument)
+		{
+			InstrumentationSlot *instrSlot = GpInstrGetSlot(node->ps.instrument);
+
+			if (instrSlot)
+			{
+				if (targetRoute == BROADCAST_SEGIDX)
+				{
+					SliceTable *sliceTable = node->ps.state->es_sliceTable;
+					ExecSlice  *sendSlice = &sliceTable->slices[motion->motionID];
+
+					instrSlot->tuplessent +=
+						list_length(sliceTable->slices[sendSlice->parentIndex].segments);
+				}
+				else
+					instrSlot->tuplessent++;
+			}
+		}
+	}
 	else
 		node->stopRequested = true;
 
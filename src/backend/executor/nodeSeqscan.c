@@ -136,12 +136,18 @@ ExecInitSeqScan(SeqScan *node, EState *estate, int eflags)
 	 */
 	currentRelation = ExecOpenScanRelation(estate, node->scanrelid, eflags);
 
-	return ExecInitSeqScanForPartition(node, estate, currentRelation);
+	return ExecInitSeqScanForPartition(node, estate, currentRelation,
+									   RelationGetDescr(currentRelation));
 }
 
+/*
+ * GPDB: 'scanDesc' is the rowtype of the scan slot. A dynamic scan that
+ * switches the state over to other partitions passes a copy it owns, as
+ * the relcache entry of the first partition is closed by then.
+ */
 SeqScanState *
 ExecInitSeqScanForPartition(SeqScan *node, EState *estate,
-							Relation currentRelation)
+							Relation currentRelation, TupleDesc scanDesc)
 {
 	SeqScanState *scanstate;
 
@@ -173,8 +179,7 @@ ExecInitSeqScanForPartition(SeqScan *node, EState *estate,
 	scanstate->ss.ss_currentRelation = currentRelation;
 
 	/* and create slot with the appropriate rowtype */
-	ExecInitScanTupleSlot(estate, &scanstate->ss,
-						  RelationGetDescr(scanstate->ss.ss_currentRelation),
+	ExecInitScanTupleSlot(estate, &scanstate->ss, scanDesc,
 						  table_slot_callbacks(scanstate->ss.ss_currentRelation));
 
 	/*
@@ -192,6 +197,34 @@ ExecInitSeqScanForPartition(SeqScan *node, EState *estate,
 	return scanstate;
 }
 
+/* ----------------------------------------------------------------
+ *		ExecSeqScanSwitchPartition
+ *
+ *		GPDB: make a seqscan started by ExecInitSeqScanForPartition()
+ *		scan another partition instead. The partition must have the
+ *		same attribute layout and slot type as the current one, so
+ *		that the slots, qual and projection can be kept. The caller
+ *		is responsible for closing the previous relation.
+ * ----------------------------------------------------------------
+ */
+void
+ExecSeqScanSwitchPartition(SeqScanState *node, Relation currentRelation)
+{
+	Assert(node->ss.ss_ScanTupleSlot->tts_ops ==
+		   table_slot_callbacks(currentRelation));
+
+	ExecClearTuple(node->ss.ss_ScanTupleSlot);
+	if (node->ss.ss_currentScanDesc != NULL)
+	{
+		table_endscan(node->ss.ss_currentScanDesc);
+		node->ss.ss_currentScanDesc = NULL;
+	}
+
+	node->ss.ss_currentRelation = currentRelation;
+
+	ExecScanReScan((ScanState *) node);
+}
+
 /* ----------------------------------------------------------------
  *		ExecEndSeqScan
  *
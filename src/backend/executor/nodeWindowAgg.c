@@ -37,6 +37,7 @@
 #include "catalog/objectaccess.h"
 #include "catalog/pg_aggregate.h"
 #include "catalog/pg_proc.h"
+#include "catalog/pg_type.h"
 #include "executor/executor.h"
 #include "executor/nodeWindowAgg.h"
 #include "miscadmin.h"
@@ -48,6 +49,7 @@
 #include "utils/acl.h"
 #include "utils/builtins.h"
 #include "utils/datum.h"
+#include "utils/guc.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/regproc.h"
@@ -58,6 +60,13 @@
 #include "optimizer/optimizer.h" // for exprType
 #include "parser/parse_expr.h" // for exprType
 
+/*
+ * Sliding evaluation of aggregates without an inverse transition function is
+ * only used for ROWS frames at least this wide.  For narrower frames,
+ * restarting the aggregation is cheap enough.
+ */
+#define WINDOW_SLIDING_MIN_ROWS		8
+
 /*
  * All the window function APIs are called with this object, which is passed
  * to window functions as fcinfo->context.
@@ -103,6 +112,15 @@ typedef struct WindowStatePerFuncData
 	WindowObject winobj;		/* object used in window function API */
 }			WindowStatePerFuncData;
 
+/*
+ * Partial transition state of a sliding window aggregate, see below.
+ */
+typedef struct WindowSlidingEntry
+{
+	Datum		value;
+	bool		isnull;
+} WindowSlidingEntry;
+
 /*
  * For plain aggregate window functions, we also have one of these.
  */
@@ -179,6 +197,31 @@ typedef struct WindowStatePerAggData
 
 	/* Data local to eval_windowaggregates() */
 	bool		restart;		/* need to restart this agg in this cycle? */
+
+	/*
+	 * GPDB: Support for evaluating an aggregate without an inverse transition
+	 * function over a sliding frame.  Rather than restarting the aggregation
+	 * every time the frame head moves, we keep one partial transition state
+	 * per frame row, and combine them with the aggregate's combine function.
+	 * See advance_windowaggregate_sliding().
+	 */
+	bool		slidingCapable; /* could this agg use sliding evaluation? */
+	bool		sliding;		/* is it used for the current scan? */
+	FmgrInfo	combinefn;
+
+	/*
+	 * Entries [slideHead, slideSplit) hold the combined states of their own
+	 * row and all the later rows up to slideSplit; entries [slideSplit,
+	 * slideTail) hold the states of single rows, which are combined into
+	 * slideBackValue.  slideHead is the entry of the frame head row.
+	 */
+	WindowSlidingEntry *slideEntries;
+	int			slideSize;		/* allocated length of slideEntries */
+	int			slideHead;
+	int			slideSplit;
+	int			slideTail;
+	Datum		slideBackValue;
+	bool		slideBackIsNull;
 } WindowStatePerAggData;
 
 static void initialize_windowaggregate(WindowAggState *winstate,
@@ -190,6 +233,22 @@ static void advance_windowaggregate(WindowAggState *winstate,
 static bool advance_windowaggregate_base(WindowAggState *winstate,
 										 WindowStatePerFunc perfuncstate,
 										 WindowStatePerAgg peraggstate);
+static void advance_windowaggregate_sliding(WindowAggState *winstate,
+											WindowStatePerFunc perfuncstate,
+											WindowStatePerAgg peraggstate);
+static void advance_windowaggregate_sliding_base(WindowAggState *winstate,
+												 WindowStatePerFunc perfuncstate,
+												 WindowStatePerAgg peraggstate,
+												 int64 nrows);
+static void compute_windowaggregate_sliding(WindowAggState *winstate,
+											WindowStatePerFunc perfuncstate,
+											WindowStatePerAgg peraggstate);
+static Datum combine_windowaggregate(WindowAggState *winstate,
+									 WindowStatePerFunc perfuncstate,
+									 WindowStatePerAgg peraggstate,
+									 Datum value1, bool isnull1,
+									 Datum value2, bool isnull2,
+									 bool *isnull);
 static void call_transfunc(WindowAggState *winstate,
 						   WindowStatePerFunc perfuncstate,
 						   WindowStatePerAgg peraggstate,
@@ -204,6 +263,7 @@ static void eval_windowfunction(WindowAggState *winstate,
 								WindowStatePerFunc perfuncstate,
 								Datum *result, bool *isnull);
 
+static void prepare_tuplestore(WindowAggState *winstate);
 static void begin_partition(WindowAggState *winstate);
 static void spool_tuples(WindowAggState *winstate, int64 pos);
 static void release_partition(WindowAggState *winstate);
@@ -225,6 +285,7 @@ static bool window_gettupleslot(WindowObject winobj, int64 pos,
 								TupleTableSlot *slot);
 
 static void compute_start_end_offsets(WindowAggState *winstate);
+static void choose_sliding_aggregates(WindowAggState *winstate);
 
 
 /*
@@ -261,6 +322,18 @@ initialize_windowaggregate(WindowAggState *winstate,
 	peraggstate->resultValue = (Datum) 0;
 	peraggstate->resultValueIsNull = true;
 
+	if (peraggstate->sliding)
+	{
+		/* any entries went away with the private aggcontext */
+		peraggstate->slideEntries = NULL;
+		peraggstate->slideSize = 0;
+		peraggstate->slideHead = 0;
+		peraggstate->slideSplit = 0;
+		peraggstate->slideTail = 0;
+		peraggstate->slideBackValue = (Datum) 0;
+		peraggstate->slideBackIsNull = true;
+	}
+
 	if (peraggstate->isDistinct)
 	{
 		peraggstate->distinctSortState =
@@ -665,6 +738,221 @@ advance_windowaggregate_base(WindowAggState *winstate,
 	return true;
 }
 
+/*
+ * combine_windowaggregate
+ * Combine two partial transition states of a sliding aggregate, value1
+ * covering the earlier rows.
+ *
+ * Like in nodeAgg.c, a strict combine function is not called with a NULL
+ * input; a NULL state then means that no rows have been aggregated.
+ */
+static Datum
+combine_windowaggregate(WindowAggState *winstate,
+						WindowStatePerFunc perfuncstate,
+						WindowStatePerAgg peraggstate,
+						Datum value1, bool isnull1,
+						Datum value2, bool isnull2,
+						bool *isnull)
+{
+	LOCAL_FCINFO(fcinfo, 2);
+	MemoryContext oldContext;
+	Datum		result;
+
+	if (peraggstate->combinefn.fn_strict)
+	{
+		if (isnull2)
+		{
+			*isnull = isnull1;
+			return value1;
+		}
+		if (isnull1)
+		{
+			*isnull = false;
+			return value2;
+		}
+	}
+
+	oldContext = MemoryContextSwitchTo(winstate->tmpcontext->ecxt_per_tuple_memory);
+
+	InitFunctionCallInfoData(*fcinfo, &(peraggstate->combinefn), 2,
+							 perfuncstate->winCollation,
+							 (void *) winstate, NULL);
+	fcinfo->args[0].value = value1;
+	fcinfo->args[0].isnull = isnull1;
+	fcinfo->args[1].value = value2;
+	fcinfo->args[1].isnull = isnull2;
+	winstate->curaggcontext = peraggstate->aggcontext;
+	result = FunctionCallInvoke(fcinfo);
+	winstate->curaggcontext = NULL;
+	*isnull = fcinfo->isnull;
+
+	MemoryContextSwitchTo(oldContext);
+
+	return result;
+}
+
+/*
+ * advance_windowaggregate_sliding
+ * Add the current input row to a sliding aggregate.
+ *
+ * This is the "two stacks" scheme for sliding-window aggregation.  The row's
+ * own transition state is computed with the transition function and appended
+ * to the entries, and combined into the running state of the rows appended
+ * since the last flip.  Removing rows from the frame head is done by
+ * advance_windowaggregate_sliding_base().  Each row is thus passed to the
+ * transition function once, and takes part in a constant number of combine
+ * function calls, however large the frame is.
+ *
+ * Sliding aggregates have a pass-by-value transition type, so the states
+ * need no copying.
+ */
+static void
+advance_windowaggregate_sliding(WindowAggState *winstate,
+								WindowStatePerFunc perfuncstate,
+								WindowStatePerAgg peraggstate)
+{
+	WindowSlidingEntry *entry;
+
+	/* Compute the row's own transition state */
+	peraggstate->transValue = peraggstate->initValue;
+	peraggstate->transValueIsNull = peraggstate->initValueIsNull;
+	peraggstate->transValueCount = 0;
+	advance_windowaggregate(winstate, perfuncstate, peraggstate);
+
+	/* Make room for it, reusing the space of rows that left the frame */
+	if (peraggstate->slideTail == peraggstate->slideSize)
+	{
+		int			nlive = peraggstate->slideTail - peraggstate->slideHead;
+
+		if (peraggstate->slideEntries == NULL)
+		{
+			peraggstate->slideSize = 64;
+			peraggstate->slideEntries = (WindowSlidingEntry *)
+				MemoryContextAlloc(peraggstate->aggcontext,
+								   peraggstate->slideSize * sizeof(WindowSlidingEntry));
+		}
+		else if (nlive > peraggstate->slideSize / 2)
+		{
+			peraggstate->slideSize *= 2;
+			peraggstate->slideEntries = (WindowSlidingEntry *)
+				repalloc(peraggstate->slideEntries,
+						 peraggstate->slideSize * sizeof(WindowSlidingEntry));
+		}
+
+		if (peraggstate->slideHead > 0)
+		{
+			memmove(peraggstate->slideEntries,
+					peraggstate->slideEntries + peraggstate->slideHead,
+					nlive * sizeof(WindowSlidingEntry));
+			peraggstate->slideSplit -= peraggstate->slideHead;
+			peraggstate->slideTail -= peraggstate->slideHead;
+			peraggstate->slideHead = 0;
+		}
+	}
+
+	entry = &peraggstate->slideEntries[peraggstate->slideTail];
+	entry->value = peraggstate->transValue;
+	entry->isnull = peraggstate->transValueIsNull;
+
+	if (peraggstate->slideTail == peraggstate->slideSplit)
+	{
+		peraggstate->slideBackValue = entry->value;
+		peraggstate->slideBackIsNull = entry->isnull;
+	}
+	else
+		peraggstate->slideBackValue =
+			combine_windowaggregate(winstate, perfuncstate, peraggstate,
+									peraggstate->slideBackValue,
+									peraggstate->slideBackIsNull,
+									entry->value, entry->isnull,
+									&peraggstate->slideBackIsNull);
+	peraggstate->slideTail++;
+}
+
+/*
+ * advance_windowaggregate_sliding_base
+ * Remove the oldest nrows rows from a sliding aggregate.
+ *
+ * When the oldest row is one of the single-row states, all of those are
+ * turned into suffix states, from the newest one back, so that the state of
+ * every later frame head is available.
+ */
+static void
+advance_windowaggregate_sliding_base(WindowAggState *winstate,
+									 WindowStatePerFunc perfuncstate,
+									 WindowStatePerAgg peraggstate,
+									 int64 nrows)
+{
+	WindowSlidingEntry *entries = peraggstate->slideEntries;
+
+	if (nrows >= peraggstate->slideTail - peraggstate->slideHead)
+	{
+		peraggstate->slideHead = 0;
+		peraggstate->slideSplit = 0;
+		peraggstate->slideTail = 0;
+		return;
+	}
+
+	while (nrows-- > 0)
+	{
+		if (peraggstate->slideHead == peraggstate->slideSplit)
+		{
+			int			i;
+
+			for (i = peraggstate->slideTail - 2; i >= peraggstate->slideSplit; i--)
+				entries[i].value =
+					combine_windowaggregate(winstate, perfuncstate, peraggstate,
+											entries[i].value, entries[i].isnull,
+											entries[i + 1].value, entries[i + 1].isnull,
+											&entries[i].isnull);
+			peraggstate->slideSplit = peraggstate->slideTail;
+		}
+		peraggstate->slideHead++;
+	}
+}
+
+/*
+ * compute_windowaggregate_sliding
+ * Set transValue of a sliding aggregate to the state of the whole frame,
+ * ready for finalize_windowaggregate().
+ */
+static void
+compute_windowaggregate_sliding(WindowAggState *winstate,
+								WindowStatePerFunc perfuncstate,
+								WindowStatePerAgg peraggstate)
+{
+	WindowSlidingEntry *head;
+
+	if (peraggstate->slideHead == peraggstate->slideTail)
+	{
+		/* empty frame */
+		peraggstate->transValue = peraggstate->initValue;
+		peraggstate->transValueIsNull = peraggstate->initValueIsNull;
+		return;
+	}
+
+	if (peraggstate->slideHead == peraggstate->slideSplit)
+	{
+		peraggstate->transValue = peraggstate->slideBackValue;
+		peraggstate->transValueIsNull = peraggstate->slideBackIsNull;
+		return;
+	}
+
+	head = &peraggstate->slideEntries[peraggstate->slideHead];
+	if (peraggstate->slideSplit == peraggstate->slideTail)
+	{
+		peraggstate->transValue = head->value;
+		peraggstate->transValueIsNull = head->isnull;
+	}
+	else
+		peraggstate->transValue =
+			combine_windowaggregate(winstate, perfuncstate, peraggstate,
+									head->value, head->isnull,
+									peraggstate->slideBackValue,
+									peraggstate->slideBackIsNull,
+									&peraggstate->transValueIsNull);
+}
+
 /*
  * Call transition function for a DISTINCT-qualified aggregate.
  *
@@ -839,6 +1127,7 @@ eval_windowaggregates(WindowAggState *winstate)
 	int			wfuncno,
 				numaggs,
 				numaggs_restart,
+				numaggs_sliding,
 				i;
 	int64		aggregatedupto_nonrestarted;
 	MemoryContext oldContext;
@@ -885,6 +1174,12 @@ eval_windowaggregates(WindowAggState *winstate)
 	 * must perform the aggregation all over again for all tuples within the
 	 * new frame boundaries.
 	 *
+	 * GPDB: Aggregates without an inverse transition function, but with a
+	 * combine function, may instead be evaluated as sliding aggregates over
+	 * wide ROWS frames (see choose_sliding_aggregates()).  Those keep a
+	 * partial transition state for each row in the frame, so rows that fell
+	 * off the frame head can be dropped without a restart.
+	 *
 	 * If there's any exclusion clause, then we may have to aggregate over a
 	 * non-contiguous set of rows, so we punt and recalculate for every row.
 	 * (For some frame end choices, it might be that the frame is always
@@ -997,7 +1292,7 @@ eval_windowaggregates(WindowAggState *winstate)
 	 * We restart the aggregation:
 	 *	 - if we're processing the first row in the partition, or
 	 *	 - if the frame's head moved and we cannot use an inverse
-	 *	   transition function, or
+	 *	   transition function or sliding evaluation, or
 	 *	 - we have an EXCLUSION clause, or
 	 *	 - if the new frame doesn't overlap the old one
 	 *
@@ -1007,12 +1302,14 @@ eval_windowaggregates(WindowAggState *winstate)
 	 *----------
 	 */
 	numaggs_restart = 0;
+	numaggs_sliding = 0;
 	for (i = 0; i < numaggs; i++)
 	{
 		peraggstate = &winstate->peragg[i];
 		if (winstate->currentpos == 0 ||
 			(winstate->aggregatedbase != winstate->frameheadpos &&
-			 !OidIsValid(peraggstate->invtransfn_oid)) ||
+			 !OidIsValid(peraggstate->invtransfn_oid) &&
+			 !peraggstate->sliding) ||
 			(winstate->frameOptions & FRAMEOPTION_EXCLUSION) ||
 			winstate->aggregatedupto <= winstate->frameheadpos ||
 			frame_head_moved_backwards ||
@@ -1022,7 +1319,20 @@ eval_windowaggregates(WindowAggState *winstate)
 			numaggs_restart++;
 		}
 		else
+		{
 			peraggstate->restart = false;
+
+			/* Sliding aggregates just drop the rows before the frame head */
+			if (peraggstate->sliding)
+			{
+				wfuncno = peraggstate->wfuncno;
+				advance_windowaggregate_sliding_base(winstate,
+													 &winstate->perfunc[wfuncno],
+													 peraggstate,
+													 winstate->frameheadpos - winstate->aggregatedbase);
+				numaggs_sliding++;
+			}
+		}
 	}
 
 	/*
@@ -1032,7 +1342,7 @@ eval_windowaggregates(WindowAggState *winstate)
 	 * i.e. advance_windowaggregate_base() can return false, in which case
 	 * we'll restart that aggregate below.
 	 */
-	while (numaggs_restart < numaggs &&
+	while (numaggs_restart + numaggs_sliding < numaggs &&
 		   winstate->aggregatedbase < winstate->frameheadpos)
 	{
 		/*
@@ -1055,7 +1365,7 @@ eval_windowaggregates(WindowAggState *winstate)
 			bool		ok;
 
 			peraggstate = &winstate->peragg[i];
-			if (peraggstate->restart)
+			if (peraggstate->restart || peraggstate->sliding)
 				continue;
 
 			wfuncno = peraggstate->wfuncno;
@@ -1190,9 +1500,14 @@ eval_windowaggregates(WindowAggState *winstate)
 				continue;
 
 			wfuncno = peraggstate->wfuncno;
-			advance_windowaggregate(winstate,
-									&winstate->perfunc[wfuncno],
-									peraggstate);
+			if (peraggstate->sliding)
+				advance_windowaggregate_sliding(winstate,
+												&winstate->perfunc[wfuncno],
+												peraggstate);
+			else
+				advance_windowaggregate(winstate,
+										&winstate->perfunc[wfuncno],
+										peraggstate);
 		}
 
 next_tuple:
@@ -1225,6 +1540,10 @@ next_tuple:
 		wfuncno = peraggstate->wfuncno;
 		result = &econtext->ecxt_aggvalues[wfuncno];
 		isnull = &econtext->ecxt_aggnulls[wfuncno];
+		if (peraggstate->sliding)
+			compute_windowaggregate_sliding(winstate,
+											&winstate->perfunc[wfuncno],
+											peraggstate);
 		finalize_windowaggregate(winstate,
 								 &winstate->perfunc[wfuncno],
 								 peraggstate,
@@ -1313,57 +1632,18 @@ eval_windowfunction(WindowAggState *winstate, WindowStatePerFunc perfuncstate,
 }
 
 /*
- * begin_partition
- * Start buffering rows of the next partition.
+ * prepare_tuplestore
+ * Create the tuplestore that buffers the rows of the current partition, and
+ * its read pointers.
  */
 static void
-begin_partition(WindowAggState *winstate)
+prepare_tuplestore(WindowAggState *winstate)
 {
 	WindowAgg  *node = (WindowAgg *) winstate->ss.ps.plan;
-	PlanState  *outerPlan = outerPlanState(winstate);
 	int			frameOptions = winstate->frameOptions;
 	int			numfuncs = winstate->numfuncs;
 	int			i;
 
-	winstate->partition_spooled = false;
-	winstate->framehead_valid = false;
-	winstate->frametail_valid = false;
-	winstate->grouptail_valid = false;
-	winstate->spooled_rows = 0;
-	winstate->currentpos = 0;
-	winstate->frameheadpos = 0;
-	winstate->frametailpos = 0;
-	winstate->currentgroup = 0;
-	winstate->frameheadgroup = 0;
-	winstate->frametailgroup = 0;
-	winstate->groupheadpos = 0;
-	winstate->grouptailpos = -1;	/* see update_grouptailpos */
-	ExecClearTuple(winstate->agg_row_slot);
-	if (winstate->framehead_slot)
-		ExecClearTuple(winstate->framehead_slot);
-	if (winstate->frametail_slot)
-		ExecClearTuple(winstate->frametail_slot);
-
-	/*
-	 * If this is the very first partition, we need to fetch the first input
-	 * row to store in first_part_slot.
-	 */
-	if (TupIsNull(winstate->first_part_slot))
-	{
-		TupleTableSlot *outerslot = ExecProcNode(outerPlan);
-
-		if (!TupIsNull(outerslot))
-			ExecCopySlot(winstate->first_part_slot, outerslot);
-		else
-		{
-			/* outer plan is empty, so we have nothing to do */
-			winstate->partition_spooled = true;
-			winstate->more_partitions = false;
-			return;
-		}
-	}
-
-	/* Create new tuplestore for this partition */
 	winstate->buffer = tuplestore_begin_heap(false, false, work_mem);
 
 	/*
@@ -1398,12 +1678,6 @@ begin_partition(WindowAggState *winstate)
 
 		agg_winobj->readptr = tuplestore_alloc_read_pointer(winstate->buffer,
 															readptr_flags);
-		agg_winobj->markpos = -1;
-		agg_winobj->seekpos = -1;
-
-		/* Also reset the row counters for aggregates */
-		winstate->aggregatedbase = 0;
-		winstate->aggregatedupto = 0;
 	}
 
 	/* create mark and read pointers for each real window function */
@@ -1419,8 +1693,6 @@ begin_partition(WindowAggState *winstate)
 															0);
 			winobj->readptr = tuplestore_alloc_read_pointer(winstate->buffer,
 															EXEC_FLAG_BACKWARD);
-			winobj->markpos = -1;
-			winobj->seekpos = -1;
 		}
 	}
 
@@ -1466,6 +1738,89 @@ begin_partition(WindowAggState *winstate)
 		winstate->grouptail_ptr =
 			tuplestore_alloc_read_pointer(winstate->buffer, 0);
 	}
+}
+
+/*
+ * begin_partition
+ * Start buffering rows of the next partition.
+ */
+static void
+begin_partition(WindowAggState *winstate)
+{
+	PlanState  *outerPlan = outerPlanState(winstate);
+	int			numfuncs = winstate->numfuncs;
+	int			i;
+
+	winstate->partition_spooled = false;
+	winstate->framehead_valid = false;
+	winstate->frametail_valid = false;
+	winstate->grouptail_valid = false;
+	winstate->spooled_rows = 0;
+	winstate->currentpos = 0;
+	winstate->frameheadpos = 0;
+	winstate->frametailpos = 0;
+	winstate->currentgroup = 0;
+	winstate->frameheadgroup = 0;
+	winstate->frametailgroup = 0;
+	winstate->groupheadpos = 0;
+	winstate->grouptailpos = -1;	/* see update_grouptailpos */
+	ExecClearTuple(winstate->agg_row_slot);
+	if (winstate->framehead_slot)
+		ExecClearTuple(winstate->framehead_slot);
+	if (winstate->frametail_slot)
+		ExecClearTuple(winstate->frametail_slot);
+
+	/*
+	 * If this is the very first partition, we need to fetch the first input
+	 * row to store in first_part_slot.
+	 */
+	if (TupIsNull(winstate->first_part_slot))
+	{
+		TupleTableSlot *outerslot = ExecProcNode(outerPlan);
+
+		if (!TupIsNull(outerslot))
+			ExecCopySlot(winstate->first_part_slot, outerslot);
+		else
+		{
+			/* outer plan is empty, so we have nothing to do */
+			winstate->partition_spooled = true;
+			winstate->more_partitions = false;
+			return;
+		}
+	}
+
+	/*
+	 * Create the tuplestore on the first partition.  Later partitions reuse
+	 * it, and its read pointers; release_partition() just empties it.
+	 */
+	if (winstate->buffer == NULL)
+		prepare_tuplestore(winstate);
+
+	/* reset the read pointer positions */
+	if (winstate->numaggs > 0)
+	{
+		WindowObject agg_winobj = winstate->agg_winobj;
+
+		agg_winobj->markpos = -1;
+		agg_winobj->seekpos = -1;
+
+		/* Also reset the row counters for aggregates */
+		winstate->aggregatedbase = 0;
+		winstate->aggregatedupto = 0;
+	}
+
+	for (i = 0; i < numfuncs; i++)
+	{
+		WindowStatePerFunc perfuncstate = &(winstate->perfunc[i]);
+
+		if (!perfuncstate->plain_agg)
+		{
+			WindowObject winobj = perfuncstate->winobj;
+
+			winobj->markpos = -1;
+			winobj->seekpos = -1;
+		}
+	}
 
 	/*
 	 * Store the first tuple into the tuplestore (it's always available now;
@@ -1551,6 +1906,11 @@ spool_tuples(WindowAggState *winstate, int64 pos)
  * release_partition
  * clear information kept within a partition, including
  * tuplestore and aggregate results.
+ *
+ * The tuplestore is only emptied, to be reused by the next partition; with
+ * many small partitions, creating and destroying one per partition would
+ * take a good part of the time.  Callers that are done with the partitions
+ * must end it themselves.
  */
 static void
 release_partition(WindowAggState *winstate)
@@ -1581,8 +1941,7 @@ release_partition(WindowAggState *winstate)
 	}
 
 	if (winstate->buffer)
-		tuplestore_end(winstate->buffer);
-	winstate->buffer = NULL;
+		tuplestore_clear(winstate->buffer);
 	winstate->partition_spooled = false;
 }
 
@@ -2364,6 +2723,65 @@ compute_start_end_offsets(WindowAggState *winstate)
 	}
 }
 
+/*
+ * choose_sliding_aggregates
+ * Decide whether the aggregates capable of it are evaluated as sliding
+ * aggregates, once the frame offsets are known.
+ *
+ * Sliding evaluation costs a few combine function calls per row, while
+ * restarting the aggregation costs a transition function call for every
+ * row in the frame, so it pays off unless the frame is very narrow.  The
+ * partial states of the frame rows are kept in memory, so it's not used
+ * for frames too wide to fit in work_mem, either.
+ *
+ * Only called with constant offsets; with variable ones, the frame head may
+ * move backwards, and the aggregates are always restarted.
+ */
+static void
+choose_sliding_aggregates(WindowAggState *winstate)
+{
+	int			frameOptions = winstate->frameOptions;
+	int64		maxrows;
+	int64		startoff = 0;
+	int64		endoff = 0;
+	bool		sliding;
+	int			i;
+
+	/* leave room for the entries of rows that already left the frame */
+	maxrows = (int64) work_mem * 1024L / (2 * sizeof(WindowSlidingEntry));
+
+	/* only ROWS offsets count rows; initialize_peragg() checked the rest */
+	if (frameOptions & FRAMEOPTION_ROWS)
+	{
+		if (frameOptions & FRAMEOPTION_START_OFFSET)
+		{
+			startoff = DatumGetInt64(winstate->startOffsetValue);
+			if (frameOptions & FRAMEOPTION_START_OFFSET_PRECEDING)
+				startoff = -startoff;
+		}
+		if (frameOptions & FRAMEOPTION_END_OFFSET)
+		{
+			endoff = DatumGetInt64(winstate->endOffsetValue);
+			if (frameOptions & FRAMEOPTION_END_OFFSET_PRECEDING)
+				endoff = -endoff;
+		}
+	}
+
+	if (!(frameOptions & FRAMEOPTION_ROWS) ||
+		Abs(startoff) > maxrows || Abs(endoff) > maxrows)
+		sliding = false;
+	else
+		sliding = (endoff - startoff + 1 >= WINDOW_SLIDING_MIN_ROWS &&
+				   endoff - startoff + 1 <= maxrows);
+
+	for (i = 0; i < winstate->numaggs; i++)
+	{
+		WindowStatePerAgg peraggstate = &winstate->peragg[i];
+
+		peraggstate->sliding = peraggstate->slidingCapable && sliding;
+	}
+}
+
 /* -----------------
  * ExecWindowAgg
  *
@@ -2399,6 +2817,7 @@ ExecWindowAgg(PlanState *pstate)
 		winstate->end_offset_var_free)
 	{
 		compute_start_end_offsets(winstate);
+		choose_sliding_aggregates(winstate);
 
 		winstate->all_first = false;
 	}
@@ -2582,6 +3001,12 @@ ExecInitWindowAgg(WindowAgg *node, EState *estate, int eflags)
 	winstate->ss.ps.state = estate;
 	winstate->ss.ps.ExecProcNode = ExecWindowAgg;
 
+	/*
+	 * copy frame options to state node for easy access; initialize_peragg()
+	 * looks at them
+	 */
+	winstate->frameOptions = frameOptions;
+
 	/*
 	 * Create expression contexts.  We need two, one for per-input-tuple
 	 * processing and one for per-output-tuple processing.  We cheat a little
@@ -2809,9 +3234,6 @@ ExecInitWindowAgg(WindowAgg *node, EState *estate, int eflags)
 		winstate->agg_winobj = agg_winobj;
 	}
 
-	/* copy frame options to state node for easy access */
-	winstate->frameOptions = frameOptions;
-
 	/* initialize frame bound offset expressions */
 	winstate->startOffset = ExecInitExpr((Expr *) node->startOffset,
 										 (PlanState *) winstate);
@@ -2852,6 +3274,9 @@ ExecEndWindowAgg(WindowAggState *node)
 	int			i;
 
 	release_partition(node);
+	if (node->buffer)
+		tuplestore_end(node->buffer);
+	node->buffer = NULL;
 
 	ExecClearTuple(node->ss.ss_ScanTupleSlot);
 	ExecClearTuple(node->first_part_slot);
@@ -2900,6 +3325,9 @@ ExecReScanWindowAgg(WindowAggState *node)
 
 	/* release tuplestore et al */
 	release_partition(node);
+	if (node->buffer)
+		tuplestore_end(node->buffer);
+	node->buffer = NULL;
 
 	/* release all temp tuples, but especially first_part_slot */
 	ExecClearTuple(node->ss.ss_ScanTupleSlot);
@@ -2950,12 +3378,14 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 	bool		use_ma_code;
 	Oid			transfn_oid,
 				invtransfn_oid,
-				finalfn_oid;
+				finalfn_oid,
+				combinefn_oid;
 	bool		finalextra;
 	char		finalmodify;
 	Expr	   *transfnexpr,
 			   *invtransfnexpr,
-			   *finalfnexpr;
+			   *finalfnexpr,
+			   *combinefnexpr;
 	Datum		textInitVal;
 	int			i;
 	ListCell   *lc;
@@ -3018,6 +3448,27 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 		initvalAttNo = Anum_pg_aggregate_agginitval;
 	}
 
+	/*
+	 * GPDB: Without an inverse transition function, see if the aggregate
+	 * could instead be evaluated as a sliding aggregate, combining partial
+	 * states of the rows in the frame.  That takes a combine function, a
+	 * ROWS frame whose head and tail both move, and no exclusion clause,
+	 * which would make the frame non-contiguous.  Whether it's actually used
+	 * depends on the width of the frame, see choose_sliding_aggregates().
+	 * The transition type is checked below.
+	 */
+	combinefn_oid = InvalidOid;
+	if (!use_ma_code &&
+		gp_enable_window_sliding_agg &&
+		OidIsValid(aggform->aggcombinefn) &&
+		(winstate->frameOptions & FRAMEOPTION_ROWS) &&
+		!(winstate->frameOptions & (FRAMEOPTION_START_UNBOUNDED_PRECEDING |
+									FRAMEOPTION_END_UNBOUNDED_FOLLOWING |
+									FRAMEOPTION_EXCLUSION)) &&
+		!wfunc->windistinct &&
+		!contain_volatile_functions((Node *) wfunc))
+		combinefn_oid = aggform->aggcombinefn;
+
 	/*
 	 * ExecInitWindowAgg already checked permission to call aggregate function
 	 * ... but we still need to check the component functions
@@ -3062,6 +3513,17 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 							   get_func_name(finalfn_oid));
 			InvokeFunctionExecuteHook(finalfn_oid);
 		}
+
+		/* sliding evaluation is optional, so just don't use it if denied */
+		if (OidIsValid(combinefn_oid))
+		{
+			aclresult = pg_proc_aclcheck(combinefn_oid, aggOwner,
+										 ACL_EXECUTE);
+			if (aclresult != ACLCHECK_OK)
+				combinefn_oid = InvalidOid;
+			else
+				InvokeFunctionExecuteHook(combinefn_oid);
+		}
 	}
 
 	/*
@@ -3130,6 +3592,28 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 					&peraggstate->transtypeLen,
 					&peraggstate->transtypeByVal);
 
+	/*
+	 * Sliding aggregates keep many transition states around, so only do that
+	 * for pass-by-value states that don't point to anything.  Floating-point
+	 * states are left out too: combining partial sums adds the rows up in a
+	 * different order than the transition function does, so the result could
+	 * differ in the last digits from the one of a restarted aggregate.
+	 */
+	if (OidIsValid(combinefn_oid) &&
+		peraggstate->transtypeByVal &&
+		aggtranstype != INTERNALOID &&
+		aggtranstype != FLOAT4OID &&
+		aggtranstype != FLOAT8OID)
+	{
+		build_aggregate_combinefn_expr(aggtranstype,
+									   wfunc->inputcollid,
+									   combinefn_oid,
+									   &combinefnexpr);
+		fmgr_info(combinefn_oid, &peraggstate->combinefn);
+		fmgr_info_set_expr((Node *) combinefnexpr, &peraggstate->combinefn);
+		peraggstate->slidingCapable = true;
+	}
+
 	/*
 	 * initval is potentially null, so don't try to access it as a struct
 	 * field. Must do it the hard way with SysCacheGetAttr.
@@ -3220,8 +3704,11 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 	 * make the memory allocation rules for moving aggregates different than
 	 * they have historically been for plain aggregates, but that seems grotty
 	 * and likely to lead to memory leaks.
+	 *
+	 * GPDB: Sliding aggregates keep their partial states in their own
+	 * aggcontext, too, as they don't restart when the frame head moves.
 	 */
-	if (OidIsValid(invtransfn_oid))
+	if (OidIsValid(invtransfn_oid) || peraggstate->slidingCapable)
 		peraggstate->aggcontext =
 			AllocSetContextCreate(CurrentMemoryContext,
 								  "WindowAgg Per Aggregate",
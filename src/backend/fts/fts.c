@@ -395,10 +395,12 @@ void FtsLoop()
 		if (probe_requested)
 			timeout = 0;
 
-		rc = WaitLatch(&MyProc->procLatch,
-					   WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
-					   timeout * 1000L,
-					   WAIT_EVENT_FTS_PROBE_MAIN);
+		/*
+		 * Besides the latch, this also wakes up when a probe connection kept
+		 * open from the last cycle is closed by its segment, so that we start
+		 * probing right away instead of waiting for the interval.
+		 */
+		rc = FtsWaitForNextProbe(timeout * 1000L);
 
 		SIMPLE_FAULT_INJECTOR("ftsLoop_after_latch");
 
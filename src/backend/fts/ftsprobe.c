@@ -29,11 +29,142 @@
 #include "postmaster/fts.h"
 #include "postmaster/ftsprobe.h"
 #include "postmaster/postmaster.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "storage/latch.h"
+#include "utils/memutils.h"
 #include "utils/snapmgr.h"
 
 
 static struct pollfd *PollFds;
 
+/*
+ * Connections to primaries kept open between messages, and between probe
+ * cycles, when gp_fts_persistent_probe_connections is on.  Reusing them
+ * saves launching and authenticating a new FTS handler on the segment for
+ * every message, and lets FtsWaitForNextProbe() notice a segment going away
+ * as soon as its connection is closed.
+ */
+typedef struct fts_cached_conn
+{
+	int16		dbid;
+	PGconn	   *conn;
+} fts_cached_conn;
+
+static fts_cached_conn *CachedConns = NULL;
+static int	NumCachedConns = 0;
+static int	MaxCachedConns = 0;
+
+static void
+ftsDropCachedConnection(int index)
+{
+	Assert(index >= 0 && index < NumCachedConns);
+
+	PQfinish(CachedConns[index].conn);
+	CachedConns[index] = CachedConns[--NumCachedConns];
+}
+
+static void
+ftsCloseCachedConnections(void)
+{
+	while (NumCachedConns > 0)
+		ftsDropCachedConnection(NumCachedConns - 1);
+}
+
+/*
+ * Keep a connection whose message has been answered, for the next message to
+ * the same segment.  The response has been read, but ReadyForQuery might not
+ * have arrived yet; rather than wait for it, give up on the connection.
+ */
+static void
+ftsCacheConnection(int16 dbid, PGconn *conn)
+{
+	if (PQstatus(conn) != CONNECTION_OK || PQisBusy(conn) ||
+		conn->asyncStatus != PGASYNC_IDLE)
+	{
+		PQfinish(conn);
+		return;
+	}
+
+	if (NumCachedConns == MaxCachedConns)
+	{
+		MaxCachedConns = Max(MaxCachedConns * 2, 16);
+		if (CachedConns == NULL)
+			CachedConns = (fts_cached_conn *)
+				MemoryContextAlloc(TopMemoryContext,
+								   MaxCachedConns * sizeof(fts_cached_conn));
+		else
+			CachedConns = (fts_cached_conn *)
+				repalloc(CachedConns, MaxCachedConns * sizeof(fts_cached_conn));
+	}
+
+	CachedConns[NumCachedConns].dbid = dbid;
+	CachedConns[NumCachedConns].conn = conn;
+	NumCachedConns++;
+}
+
+/*
+ * Take the cached connection to a segment out of the cache, if there is one
+ * that's still usable.
+ */
+static PGconn *
+ftsTakeCachedConnection(int16 dbid)
+{
+	int			i;
+
+	for (i = 0; i < NumCachedConns; i++)
+	{
+		PGconn	   *conn = CachedConns[i].conn;
+
+		if (CachedConns[i].dbid != dbid)
+			continue;
+
+		if (PQstatus(conn) != CONNECTION_OK ||
+			conn->asyncStatus != PGASYNC_IDLE)
+		{
+			ftsDropCachedConnection(i);
+			return NULL;
+		}
+
+		CachedConns[i] = CachedConns[--NumCachedConns];
+		return conn;
+	}
+
+	return NULL;
+}
+
+/*
+ * Close cached connections to segments that are no longer acting primaries
+ * according to the configuration of the last probe cycle.
+ */
+static void
+ftsPruneCachedConnections(CdbComponentDatabases *cdbs)
+{
+	int			i = 0;
+
+	while (i < NumCachedConns)
+	{
+		bool		found = false;
+		int			j;
+
+		for (j = 0; j < cdbs->total_segment_dbs; j++)
+		{
+			CdbComponentDatabaseInfo *segInfo = &cdbs->segment_db_info[j];
+
+			if (segInfo->config->dbid == CachedConns[i].dbid)
+			{
+				found = SEGMENT_IS_ACTIVE_PRIMARY(segInfo);
+				break;
+			}
+		}
+
+		if (found)
+			i++;
+		else
+			ftsDropCachedConnection(i);
+	}
+}
+
 static CdbComponentDatabaseInfo *
 FtsGetPeerSegment(CdbComponentDatabases *cdbs,
 				  int content, int dbid)
@@ -167,6 +298,15 @@ ftsConnectStart(fts_segment_info *ftsInfo)
 	snprintf(conninfo, 1024, "host=%s port=%d gpconntype=%s",
 			 hostip ? hostip : "", ftsInfo->primary_cdbinfo->config->port,
 			 GPCONN_TYPE_FTS);
+
+	/*
+	 * A connection that is kept open must notice the segment host going
+	 * away without a probe in flight, so use aggressive TCP keepalives.
+	 */
+	if (gp_fts_persistent_probe_connections)
+		snprintf(conninfo + strlen(conninfo), 1024 - strlen(conninfo),
+				 " keepalives=1 keepalives_idle=1 keepalives_interval=1"
+				 " keepalives_count=%d", Max(gp_fts_probe_retries, 1));
 	ftsInfo->conn = PQconnectStart(conninfo);
 
 	if (ftsInfo->conn == NULL)
@@ -304,7 +444,18 @@ ftsConnect(fts_context *context)
 				{
 					AssertImply(ftsInfo->retry_count > 0,
 								ftsInfo->retry_count <= gp_fts_probe_retries);
-					if (!ftsConnectStart(ftsInfo))
+					if (gp_fts_persistent_probe_connections &&
+						(ftsInfo->conn = ftsTakeCachedConnection(
+							ftsInfo->primary_cdbinfo->config->dbid)) != NULL)
+					{
+						/*
+						 * Already connected and authenticated, wait for the
+						 * socket to become writable and send the message.
+						 */
+						ftsInfo->poll_events = POLLOUT;
+						ftsInfo->startTime = (pg_time_t) time(NULL);
+					}
+					else if (!ftsConnectStart(ftsInfo))
 						ftsInfo->state = nextFailedState(ftsInfo->state);
 				}
 				else if (ftsInfo->poll_revents & (POLLOUT | POLLIN))
@@ -979,6 +1130,11 @@ processResponse(fts_context *context)
 
 		CdbComponentDatabaseInfo *mirror = ftsInfo->mirror_cdbinfo;
 
+		/* Only a connection that delivered a response is worth keeping. */
+		bool keep_conn = gp_fts_persistent_probe_connections &&
+			IsFtsMessageStateSuccess(ftsInfo->state);
+		int16 conn_dbid = primary->config->dbid;
+
 		bool IsPrimaryAlive = ftsInfo->result.isPrimaryAlive;
 		/* Trust a response from primary only if it's alive. */
 		bool IsMirrorAlive =  IsPrimaryAlive ?
@@ -1162,9 +1318,15 @@ processResponse(fts_context *context)
 					 primary->config->segindex, primary->config->dbid, mirror->config->dbid);
 				break;
 		}
-		/* Close connection and reset result for next message, if any. */
+		/*
+		 * Close connection, or keep it for the next message, and reset result
+		 * for next message, if any.
+		 */
 		memset(&ftsInfo->result, 0, sizeof(fts_result));
-		PQfinish(ftsInfo->conn);
+		if (keep_conn)
+			ftsCacheConnection(conn_dbid, ftsInfo->conn);
+		else
+			PQfinish(ftsInfo->conn);
 		ftsInfo->conn = NULL;
 		ftsInfo->poll_events = ftsInfo->poll_revents = 0;
 		ftsInfo->retry_count = 0;
@@ -1258,6 +1420,9 @@ FtsWalRepMessageSegments(CdbComponentDatabases *cdbs)
 	bool is_updated = false;
 	fts_context context;
 
+	if (!gp_fts_persistent_probe_connections)
+		ftsCloseCachedConnections();
+
 	FtsWalRepInitProbeContext(cdbs, &context);
 	InitPollFds(cdbs->total_segments);
 
@@ -1281,7 +1446,10 @@ FtsWalRepMessageSegments(CdbComponentDatabases *cdbs)
 				context.perSegInfos[i].conn = NULL;
 			}
 		}
+		ftsCloseCachedConnections();
 	}
+	else
+		ftsPruneCachedConnections(cdbs);
 #ifdef USE_ASSERT_CHECKING
 	/*
 	 * At the end of probe cycle, there shouldn't be any active libpq
@@ -1305,4 +1473,60 @@ FtsWalRepMessageSegments(CdbComponentDatabases *cdbs)
 	return is_updated;
 }
 
+/*
+ * Wait until the next probe cycle is due, like WaitLatch() on our latch with
+ * the given timeout.  In addition, watch the connections kept open between
+ * probe cycles.  An idle FTS connection has nothing to say unless the segment
+ * is going away, so if one of them becomes readable, close it and return
+ * WL_SOCKET_READABLE to start probing right away rather than at the next
+ * interval.
+ */
+int
+FtsWaitForNextProbe(long timeout)
+{
+	WaitEventSet *set;
+	WaitEvent	event;
+	int			rc;
+	int			i;
+
+	if (NumCachedConns == 0)
+		return WaitLatch(MyLatch,
+						 WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+						 timeout,
+						 WAIT_EVENT_FTS_PROBE_MAIN);
+
+	/*
+	 * Positions 0 and 1 are the latch and postmaster death, the connections
+	 * follow in the order of CachedConns.
+	 */
+	set = CreateWaitEventSet(CurrentMemoryContext, NumCachedConns + 2);
+	AddWaitEventToSet(set, WL_LATCH_SET, PGINVALID_SOCKET, MyLatch, NULL);
+	AddWaitEventToSet(set, WL_POSTMASTER_DEATH, PGINVALID_SOCKET, NULL, NULL);
+	for (i = 0; i < NumCachedConns; i++)
+		AddWaitEventToSet(set, WL_SOCKET_READABLE,
+						  PQsocket(CachedConns[i].conn), NULL, NULL);
+
+	if (WaitEventSetWait(set, timeout, &event, 1,
+						 WAIT_EVENT_FTS_PROBE_MAIN) == 0)
+		rc = WL_TIMEOUT;
+	else if (event.events & WL_SOCKET_READABLE)
+	{
+		int			index = event.pos - 2;
+		PGconn	   *conn = CachedConns[index].conn;
+
+		(void) PQconsumeInput(conn);
+		elog(LOG, "FTS: connection to segment (dbid=%d) became readable "
+			 "while idle, probing now: %s",
+			 CachedConns[index].dbid, PQerrorMessage(conn));
+		ftsDropCachedConnection(index);
+		rc = WL_SOCKET_READABLE;
+	}
+	else
+		rc = event.events;
+
+	FreeWaitEventSet(set);
+
+	return rc;
+}
+
 /* EOF */
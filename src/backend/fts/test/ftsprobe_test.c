@@ -680,6 +680,57 @@ test_PrimayUpMirrorUpNotInSync_to_PrimayUpMirrorUpNotInSync(void **state)
 	assert_false(is_updated);
 }
 
+/*
+ * With persistent probe connections, a connection that delivered a response
+ * is kept open, and reused for the next message to the same segment.
+ */
+static void
+test_processResponse_keeps_persistent_connection(void **state)
+{
+	CdbComponentDatabases *cdbs = InitTestCdb(
+		1, true, GP_SEGMENT_CONFIGURATION_MODE_NOTINSYNC);
+	fts_context context;
+	FtsWalRepInitProbeContext(cdbs, &context);
+	init_fts_context(&context, FTS_PROBE_SUCCESS);
+	fts_segment_info *ftsInfo = &context.perSegInfos[0];
+	PGconn *conn = ftsInfo->conn;
+
+	gp_fts_persistent_probe_connections = true;
+	will_return(FtsIsActive, true);
+
+	ftsInfo->result.isPrimaryAlive = true;
+	ftsInfo->result.isMirrorAlive = true;
+	ftsInfo->result.isSyncRepEnabled = true;
+
+	/* The connection is idle after the response, so it's kept. */
+	expect_value(PQstatus, conn, conn);
+	will_return(PQstatus, CONNECTION_OK);
+	expect_value(PQisBusy, conn, conn);
+	will_return(PQisBusy, false);
+
+	bool is_updated = processResponse(&context);
+
+	assert_false(is_updated);
+	assert_true(ftsInfo->state == FTS_RESPONSE_PROCESSED);
+	assert_true(ftsInfo->conn == NULL);
+	assert_int_equal(NumCachedConns, 1);
+
+	/* The next message doesn't start a new connection. */
+	ftsInfo->state = FTS_PROBE_SEGMENT;
+	ftsInfo->startTime = 0;
+	expect_value(PQstatus, conn, conn);
+	will_return(PQstatus, CONNECTION_OK);
+
+	ftsConnect(&context);
+
+	assert_true(ftsInfo->conn == conn);
+	assert_true(ftsInfo->poll_events & POLLOUT);
+	assert_true(ftsInfo->startTime > 0);
+	assert_int_equal(NumCachedConns, 0);
+
+	gp_fts_persistent_probe_connections = false;
+}
+
 /*
  * 2 segments, is_updated is false, because its double fault scenario
  * primary and mirror are not in sync hence cannot promote mirror, hence
@@ -1390,6 +1441,7 @@ main(int argc, char* argv[])
 		unit_test(test_PrimayUpMirrorUpNotInSync_to_PrimayUpMirrorUpNotInSync),
 		unit_test(test_PrimayUpMirrorUpNotInSync_to_PrimaryUpMirrorDownNotInSync),
 		unit_test(test_PrimayUpMirrorUpNotInSync_to_PrimaryDown),
+		unit_test(test_processResponse_keeps_persistent_connection),
 
 		unit_test(test_PrimaryUpMirrorDownNotInSync_to_PrimayUpMirrorUpSync),
 		unit_test(test_PrimaryUpMirrorDownNotInSync_to_PrimayUpMirrorUpNotInSync),
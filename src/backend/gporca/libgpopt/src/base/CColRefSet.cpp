@@ -169,11 +169,7 @@ CColRefSet::Include(const CColRefArray *colref_array)
 void
 CColRefSet::Include(const CColRefSet *pcrs)
 {
-	CColRefSetIter crsi(*pcrs);
-	while (crsi.Advance())
-	{
-		Include(crsi.Pcr());
-	}
+	CBitSet::Union(pcrs);
 }
 
 
@@ -203,11 +199,7 @@ CColRefSet::Exclude(const CColRef *colref)
 void
 CColRefSet::Exclude(const CColRefSet *pcrs)
 {
-	CColRefSetIter crsi(*pcrs);
-	while (crsi.Advance())
-	{
-		Exclude(crsi.Pcr());
-	}
+	CBitSet::Difference(pcrs);
 }
 
 
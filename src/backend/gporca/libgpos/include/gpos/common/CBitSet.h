@@ -6,15 +6,15 @@
 //		CBitSet.h
 //
 //	@doc:
-//		Implementation of bitset as linked list of bitvectors
+//		Implementation of bitset as a sorted array of blocks of words
 //---------------------------------------------------------------------------
 #ifndef GPOS_CBitSet_H
 #define GPOS_CBitSet_H
 
 #include "gpos/base.h"
-#include "gpos/common/CBitVector.h"
 #include "gpos/common/CDynamicPtrArray.h"
 #include "gpos/common/CList.h"
+#include "gpos/common/CRefCount.h"
 
 
 namespace gpos
@@ -24,7 +24,11 @@ namespace gpos
 //		CBitSet
 //
 //	@doc:
-//		Linked list of CBitSetLink's
+//		Array of blocks of 64-bit words, sorted by block index. Only blocks
+//		that have bits set are kept, so a set of ids that are far apart
+//		stays small. Small sets keep their blocks inside the object, bigger
+//		ones in an array allocated from the memory pool. Set operations
+//		merge the blocks of both sets and work a word at a time.
 //
 //---------------------------------------------------------------------------
 class CBitSet : public CRefCount
@@ -33,79 +37,65 @@ class CBitSet : public CRefCount
 	friend class CBitSetIter;
 
 protected:
-	//---------------------------------------------------------------------------
-	//	@class:
-	//		CBitSetLink
-	//
-	//	@doc:
-	//		bit vector + offset + link
-	//
-	//---------------------------------------------------------------------------
-	class CBitSetLink
-	{
-	private:
-		// offset
-		ULONG m_offset;
-
-		// bitvector
-		CBitVector *m_vec;
-
-	public:
-		CBitSetLink(const CBitSetLink &) = delete;
-
-		// ctor
-		explicit CBitSetLink(CMemoryPool *, ULONG offset, ULONG vector_size);
-
-		explicit CBitSetLink(CMemoryPool *, const CBitSetLink &);
+	// number of words in a block
+	static const ULONG m_block_words = 4;
 
-		// dtor
-		~CBitSetLink();
+	// number of bits in a block
+	static const ULONG m_block_bits = m_block_words * 64;
 
-		// accessor
-		ULONG
-		GetOffset() const
-		{
-			return m_offset;
-		}
+	// number of blocks stored in the object itself
+	static const ULONG m_inline_blocks = 4;
 
-		// accessor
-		CBitVector *
-		GetVec() const
-		{
-			return m_vec;
-		}
+	// block of words holding the bits [m_index * m_block_bits,
+	// (m_index + 1) * m_block_bits); at least one of them is set
+	struct SBlock
+	{
+		ULONG m_index;
+		ULLONG m_words[m_block_words];
+	};
 
-		// list link
-		SLink m_link;
+	// pool to allocate block arrays from
+	CMemoryPool *m_mp;
 
-	};	// class CBitSetLink
+	// words per slice of the set that is hashed separately, derived from
+	// the vector size the set is created with, see HashValue()
+	ULONG m_chunk_words;
 
-	// list of bit set links
-	CList<CBitSetLink> m_bsllist;
+	// blocks, either m_inline or an array from m_mp
+	SBlock *m_blocks;
 
-	// pool to allocate links from
-	CMemoryPool *m_mp;
+	// number of blocks in use
+	ULONG m_num_blocks;
 
-	// size of individual bitvectors
-	ULONG m_vector_size;
+	// number of blocks allocated
+	ULONG m_capacity;
 
 	// number of elements
 	ULONG m_size;
 
+	// inline storage
+	SBlock m_inline[m_inline_blocks];
+
 	// private copy ctor
 	CBitSet(const CBitSet &);
 
-	// find link with offset less or equal to given value
-	CBitSetLink *FindLinkByOffset(ULONG, CBitSetLink * = NULL) const;
+	// position of the first block with an index not below the given one
+	ULONG FindBlock(ULONG index) const;
 
-	// reset set
-	void Clear();
+	// block with given index, NULL if it has no bits set
+	const SBlock *GetBlock(ULONG index) const;
+
+	// word with given index, zero if its block has no bits set
+	ULLONG GetWord(ULONG word) const;
+
+	// make room for at least the given number of blocks
+	void Reserve(ULONG num_blocks);
 
-	// compute target offset
-	ULONG ComputeOffset(ULONG) const;
+	// drop the blocks without bits set and re-compute size of set
+	void Compact();
 
-	// re-compute size of set
-	void RecomputeSize();
+	// reset set
+	void Clear();
 
 public:
 	// ctor
@@ -116,7 +106,11 @@ public:
 	~CBitSet() override;
 
 	// determine if bit is set
-	BOOL Get(ULONG pos) const;
+	BOOL
+	Get(ULONG pos) const
+	{
+		return 0 != (GetWord(pos / 64) & ((ULLONG) 1 << (pos % 64)));
+	}
 
 	// set given bit; return previous value
 	BOOL ExchangeSet(ULONG pos);
@@ -22,7 +22,7 @@ namespace gpos
 //
 //	@doc:
 //		Iterator for bitset's; defined as friend, ie can access bitset's
-//		internal links
+//		internal blocks
 //
 //---------------------------------------------------------------------------
 class CBitSetIter
@@ -31,11 +31,11 @@ private:
 	// bitset
 	const CBitSet &m_bs;
 
-	// current cursor position (in current link)
+	// current cursor position
 	ULONG m_cursor;
 
-	// current cursor link
-	CBitSet::CBitSetLink *m_bsl;
+	// position of the block the cursor is in
+	ULONG m_block;
 
 	// is iterator active or exhausted
 	BOOL m_active;
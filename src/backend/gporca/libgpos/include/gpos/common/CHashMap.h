@@ -11,11 +11,18 @@
 //		* equality == on key uses template function argument
 //		* does not allow insertion of duplicates (no equality on value class req'd)
 //		* destroys objects based on client-side provided destroy functions
+//
+//		Entries are kept in a dense array in insertion order, which is also
+//		the iteration order.  Lookups go through an open-addressing index of
+//		(hash, entry) slots with linear probing, so that a probe touches a
+//		contiguous run of slots and only calls the equality function on
+//		hash matches.
 //---------------------------------------------------------------------------
 #ifndef GPOS_CHashMap_H
 #define GPOS_CHashMap_H
 
 #include "gpos/base.h"
+#include "gpos/common/CAutoRg.h"
 #include "gpos/common/CDynamicPtrArray.h"
 #include "gpos/common/CRefCount.h"
 
@@ -44,190 +51,239 @@ class CHashMap : public CRefCount
 	friend class CHashMapIter<K, T, HashFn, EqFn, DestroyKFn, DestroyTFn>;
 
 private:
-	//---------------------------------------------------------------------------
-	//	@class:
-	//		CHashMapElem
-	//
-	//	@doc:
-	//		Anchor for key/value pair
-	//
-	//---------------------------------------------------------------------------
-	class CHashMapElem
+	// key/value pair, key is NULL once the entry has been deleted
+	struct SEntry
 	{
-	private:
-		// key/value pair
 		K *m_key;
 		T *m_value;
+		ULONG m_hash;
+	};
 
-		// own objects
-		BOOL m_owns_objects;
+	// index slot, entry is the position of the entry plus one, or zero
+	// if the slot is empty
+	struct SSlot
+	{
+		ULONG m_hash;
+		ULONG m_entry;
+	};
 
-	public:
-		CHashMapElem(const CHashMapElem &) = delete;
+	// number of entries allocated on first insertion
+	static const ULONG m_min_entries = 8;
 
-		// ctor
-		CHashMapElem(K *key, T *value, BOOL fOwn)
-			: m_key(key), m_value(value), m_owns_objects(fOwn)
+	// memory pool
+	CMemoryPool *const m_mp;
+
+	// number of entries
+	ULONG m_size;
+
+	// entries in insertion order, including deleted ones
+	SEntry *m_entries;
+	ULONG m_num_entries;
+	ULONG m_entries_capacity;
+
+	// index slots, twice as many as entry capacity; the home slot of a hash
+	// is taken from its top bits
+	SSlot *m_slots;
+	ULONG m_slot_mask;
+	ULONG m_slot_shift;
+
+	// spread the client hash over all bits, hash functions of pointers and
+	// small integers leave the top bits empty
+	static ULONG
+	MixHash(ULONG hash)
+	{
+		return hash * 0x9E3779B1U;
+	}
+
+	// find the slot of the given key, ulong_max if not found
+	ULONG
+	FindSlot(const K *key, ULONG hash) const
+	{
+		if (NULL == m_slots)
 		{
-			GPOS_ASSERT(NULL != key);
+			return gpos::ulong_max;
 		}
 
-		// dtor
-		~CHashMapElem()
+		for (ULONG pos = hash >> m_slot_shift;; pos = (pos + 1) & m_slot_mask)
 		{
-			// in case of a temporary hashmap element for lookup we do NOT own the
-			// objects, otherwise call destroy functions
-			if (m_owns_objects)
+			const SSlot &slot = m_slots[pos];
+			if (0 == slot.m_entry)
 			{
-				DestroyKFn(m_key);
-				DestroyTFn(m_value);
+				return gpos::ulong_max;
 			}
-		}
 
-		// key accessor
-		K *
-		Key() const
-		{
-			return m_key;
+			if (slot.m_hash == hash &&
+				EqFn(m_entries[slot.m_entry - 1].m_key, key))
+			{
+				return pos;
+			}
 		}
+	}
 
-		// value accessor
-		T *
-		Value() const
+	// add a slot for the given entry, the key must not be present
+	void
+	AddSlot(ULONG hash, ULONG entry)
+	{
+		ULONG pos = hash >> m_slot_shift;
+		while (0 != m_slots[pos].m_entry)
 		{
-			return m_value;
+			pos = (pos + 1) & m_slot_mask;
 		}
+		m_slots[pos].m_hash = hash;
+		m_slots[pos].m_entry = entry + 1;
+	}
 
-		// replace value
-		void
-		ReplaceValue(T *new_value)
+	// empty the given slot, shifting back the slots of its probe run
+	void
+	RemoveSlot(ULONG pos)
+	{
+		ULONG next = pos;
+		while (true)
 		{
-			if (m_owns_objects)
+			next = (next + 1) & m_slot_mask;
+			if (0 == m_slots[next].m_entry)
 			{
-				DestroyTFn(m_value);
+				break;
+			}
+
+			// keep the slot where it is if its home lies cyclically in
+			// (pos, next]
+			ULONG home = m_slots[next].m_hash >> m_slot_shift;
+			BOOL stays = (pos <= next) ? (pos < home && home <= next)
+									   : (pos < home || home <= next);
+			if (!stays)
+			{
+				m_slots[pos] = m_slots[next];
+				pos = next;
 			}
-			m_value = new_value;
 		}
+		m_slots[pos].m_entry = 0;
+	}
 
-		// equality operator -- map elements are equal if their keys match
-		BOOL
-		operator==(const CHashMapElem &elem) const
+	// make room for one more entry, dropping deleted entries and growing
+	// the arrays as needed
+	void
+	Grow()
+	{
+		ULONG capacity = m_entries_capacity;
+		if (m_size == m_num_entries || m_size >= m_entries_capacity / 2)
 		{
-			return EqFn(m_key, elem.m_key);
+			capacity = (0 == m_entries_capacity) ? m_min_entries
+												 : 2 * m_entries_capacity;
 		}
-	};
-
-	// memory pool
-	CMemoryPool *const m_mp;
-
-	// size
-	ULONG m_num_chains;
 
-	// number of entries
-	ULONG m_size;
+		ULONG num_slots = 2 * capacity;
+		ULONG shift = 32;
+		for (ULONG n = num_slots; n > 1; n >>= 1)
+		{
+			shift--;
+		}
 
-	// each hash chain is an array of hashmap elements
-	typedef CDynamicPtrArray<CHashMapElem, CleanupDelete> CHashSetElemArray;
-	CHashSetElemArray **const m_chains;
+		CAutoRg<SEntry> entries;
+		entries = GPOS_NEW_ARRAY(m_mp, SEntry, capacity);
+		SSlot *slots = GPOS_NEW_ARRAY(m_mp, SSlot, num_slots);
 
-	// array for keys
-	// We use CleanupNULL because the keys are owned by the hash table
-	typedef CDynamicPtrArray<K, CleanupNULL> Keys;
-	Keys *const m_keys;
+		ULONG num_entries = 0;
+		for (ULONG ul = 0; ul < m_num_entries; ul++)
+		{
+			if (NULL != m_entries[ul].m_key)
+			{
+				entries[num_entries++] = m_entries[ul];
+			}
+		}
+		GPOS_ASSERT(num_entries == m_size);
 
-	IntPtrArray *const m_filled_chains;
+		GPOS_DELETE_ARRAY(m_entries);
+		GPOS_DELETE_ARRAY(m_slots);
 
-	// lookup appropriate hash chain in static table, may be NULL if
-	// no elements have been inserted yet
-	CHashSetElemArray **
-	GetChain(const K *key) const
-	{
-		GPOS_ASSERT(NULL != m_chains);
-		return &m_chains[HashFn(key) % m_num_chains];
-	}
+		m_entries = entries.RgtReset();
+		m_num_entries = num_entries;
+		m_entries_capacity = capacity;
+		m_slots = slots;
+		m_slot_mask = num_slots - 1;
+		m_slot_shift = shift;
 
-	// clear elements
-	void
-	Clear()
-	{
-		for (ULONG i = 0; i < m_filled_chains->Size(); i++)
+		(void) clib::Memset(m_slots, 0, num_slots * sizeof(SSlot));
+		for (ULONG ul = 0; ul < m_num_entries; ul++)
 		{
-			// release each hash chain
-			m_chains[*(*m_filled_chains)[i]]->Release();
+			AddSlot(m_entries[ul].m_hash, ul);
 		}
-		m_size = 0;
-		m_filled_chains->Clear();
 	}
 
-	// lookup an element by its key
-	CHashMapElem *
+	// lookup an entry by its key
+	SEntry *
 	Lookup(const K *key) const
 	{
-		CHashMapElem hme(const_cast<K *>(key), NULL /*T*/, false /*fOwn*/);
-		CHashMapElem *found_hme = NULL;
-		CHashSetElemArray **chain = GetChain(key);
-		if (NULL != *chain)
+		ULONG pos = FindSlot(key, MixHash(HashFn(key)));
+		if (gpos::ulong_max == pos)
 		{
-			found_hme = (*chain)->Find(&hme);
-			GPOS_ASSERT_IMP(NULL != found_hme, *found_hme == hme);
+			return NULL;
 		}
 
-		return found_hme;
+		return &m_entries[m_slots[pos].m_entry - 1];
 	}
 
 public:
 	CHashMap(const CHashMap<K, T, HashFn, EqFn, DestroyKFn, DestroyTFn> &) =
 		delete;
 
-	// ctor
-	CHashMap<K, T, HashFn, EqFn, DestroyKFn, DestroyTFn>(CMemoryPool *mp,
-														 ULONG num_chains = 127)
+	// ctor; the number of chains is only kept for source compatibility,
+	// the map sizes itself as entries are inserted
+	CHashMap<K, T, HashFn, EqFn, DestroyKFn, DestroyTFn>(
+		CMemoryPool *mp, ULONG num_chains GPOS_ASSERTS_ONLY = 127)
 		: m_mp(mp),
-		  m_num_chains(num_chains),
 		  m_size(0),
-		  m_chains(GPOS_NEW_ARRAY(m_mp, CHashSetElemArray *, m_num_chains)),
-		  m_keys(GPOS_NEW(m_mp) Keys(m_mp)),
-		  m_filled_chains(GPOS_NEW(mp) IntPtrArray(mp))
+		  m_entries(NULL),
+		  m_num_entries(0),
+		  m_entries_capacity(0),
+		  m_slots(NULL),
+		  m_slot_mask(0),
+		  m_slot_shift(0)
 	{
-		GPOS_ASSERT(m_num_chains > 0);
-		(void) clib::Memset(m_chains, 0,
-							m_num_chains * sizeof(CHashSetElemArray *));
+		GPOS_ASSERT(num_chains > 0);
 	}
 
 	// dtor
 	~CHashMap<K, T, HashFn, EqFn, DestroyKFn, DestroyTFn>() override
 	{
-		// release all hash chains
-		Clear();
+		for (ULONG ul = 0; ul < m_num_entries; ul++)
+		{
+			if (NULL != m_entries[ul].m_key)
+			{
+				DestroyKFn(m_entries[ul].m_key);
+				DestroyTFn(m_entries[ul].m_value);
+			}
+		}
 
-		GPOS_DELETE_ARRAY(m_chains);
-		m_keys->Release();
-		m_filled_chains->Release();
+		GPOS_DELETE_ARRAY(m_entries);
+		GPOS_DELETE_ARRAY(m_slots);
 	}
 
 	// insert an element if key is not yet present
 	BOOL
 	Insert(K *key, T *value)
 	{
-		if (NULL != Find(key))
+		GPOS_ASSERT(NULL != key);
+
+		ULONG hash = MixHash(HashFn(key));
+		if (gpos::ulong_max != FindSlot(key, hash))
 		{
 			return false;
 		}
 
-		CHashSetElemArray **chain = GetChain(key);
-		if (NULL == *chain)
+		if (m_num_entries == m_entries_capacity)
 		{
-			*chain = GPOS_NEW(m_mp) CHashSetElemArray(m_mp);
-			INT chain_idx = HashFn(key) % m_num_chains;
-			m_filled_chains->Append(GPOS_NEW(m_mp) INT(chain_idx));
+			Grow();
 		}
 
-		CHashMapElem *elem =
-			GPOS_NEW(m_mp) CHashMapElem(key, value, true /*fOwn*/);
-		(*chain)->Append(elem);
+		SEntry &entry = m_entries[m_num_entries];
+		entry.m_key = key;
+		entry.m_value = value;
+		entry.m_hash = hash;
+		AddSlot(hash, m_num_entries);
 
+		m_num_entries++;
 		m_size++;
-		m_keys->Append(key);
 
 		return true;
 	}
@@ -236,10 +292,10 @@ public:
 	T *
 	Find(const K *key) const
 	{
-		CHashMapElem *elem = Lookup(key);
-		if (NULL != elem)
+		SEntry *entry = Lookup(key);
+		if (NULL != entry)
 		{
-			return elem->Value();
+			return entry->m_value;
 		}
 
 		return NULL;
@@ -251,38 +307,41 @@ public:
 	{
 		GPOS_ASSERT(NULL != key);
 
-		BOOL fSuccess = false;
-		CHashMapElem *elem = Lookup(key);
-		if (NULL != elem)
+		SEntry *entry = Lookup(key);
+		if (NULL == entry)
 		{
-			elem->ReplaceValue(ptNew);
-			fSuccess = true;
+			return false;
 		}
 
-		return fSuccess;
+		DestroyTFn(entry->m_value);
+		entry->m_value = ptNew;
+
+		return true;
 	}
 
+	// remove the entry of a key, destroying its key and value
 	BOOL
 	Delete(const K *key)
 	{
-		CHashSetElemArray **chain = GetChain(key);
-
-		if (NULL != *chain)
+		ULONG pos = FindSlot(key, MixHash(HashFn(key)));
+		if (gpos::ulong_max == pos)
 		{
-			for (ULONG ul = 0; ul < (*chain)->Size(); ul++)
-			{
-				if (EqFn((**chain)[ul]->Key(), key))
-				{
-					// found the entry, now remove it by putting it last,
-					// then removing the last element
-					(*chain)->Swap(ul, (*chain)->Size() - 1);
-					CHashMapElem *to_delete = (*chain)->RemoveLast();
-					CleanupDelete(to_delete);
-					return true;
-				}
-			}
+			return false;
 		}
-		return false;
+
+		SEntry &entry = m_entries[m_slots[pos].m_entry - 1];
+		RemoveSlot(pos);
+		m_size--;
+
+		K *deleted_key = entry.m_key;
+		T *deleted_value = entry.m_value;
+		entry.m_key = NULL;
+		entry.m_value = NULL;
+
+		DestroyKFn(deleted_key);
+		DestroyTFn(deleted_value);
+
+		return true;
 	}
 
 	// return number of map entries
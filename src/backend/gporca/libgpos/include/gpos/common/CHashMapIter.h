@@ -12,7 +12,6 @@
 #define GPOS_CHashMapIter_H
 
 #include "gpos/base.h"
-#include "gpos/common/CDynamicPtrArray.h"
 #include "gpos/common/CHashMap.h"
 #include "gpos/common/CStackObject.h"
 
@@ -38,24 +37,15 @@ private:
 	// map to iterate
 	const TMap *m_map;
 
-	// current hashchain
-	ULONG m_chain_idx;
+	// position of the current entry plus one
+	ULONG m_entry_idx;
 
-	// current key
-	ULONG m_key_idx;
-
-	// is initialized?
-	BOOL m_is_initialized;
-
-	// method to return the current element
-	const typename TMap::CHashMapElem *
+	// current entry
+	const typename TMap::SEntry *
 	Get() const
 	{
-		typename TMap::CHashMapElem *elem = NULL;
-		K *k = (*(m_map->m_keys))[m_key_idx - 1];
-		elem = m_map->Lookup(k);
-
-		return elem;
+		GPOS_ASSERT(0 < m_entry_idx);
+		return &m_map->m_entries[m_entry_idx - 1];
 	}
 
 public:
@@ -64,7 +54,7 @@ public:
 
 	// ctor
 	CHashMapIter<K, T, HashFn, EqFn, DestroyKFn, DestroyTFn>(TMap *ptm)
-		: m_map(ptm), m_chain_idx(0), m_key_idx(0)
+		: m_map(ptm), m_entry_idx(0)
 	{
 		GPOS_ASSERT(NULL != ptm);
 	}
@@ -73,14 +63,17 @@ public:
 	virtual ~CHashMapIter<K, T, HashFn, EqFn, DestroyKFn, DestroyTFn>() =
 		default;
 
-	// advance iterator to next element
+	// advance iterator to next element, skipping deleted entries
 	BOOL
 	Advance()
 	{
-		if (m_key_idx < m_map->m_keys->Size())
+		while (m_entry_idx < m_map->m_num_entries)
 		{
-			m_key_idx++;
-			return true;
+			m_entry_idx++;
+			if (NULL != Get()->m_key)
+			{
+				return true;
+			}
 		}
 
 		return false;
@@ -90,24 +83,14 @@ public:
 	const K *
 	Key() const
 	{
-		const typename TMap::CHashMapElem *elem = Get();
-		if (NULL != elem)
-		{
-			return elem->Key();
-		}
-		return NULL;
+		return Get()->m_key;
 	}
 
 	// current value
 	const T *
 	Value() const
 	{
-		const typename TMap::CHashMapElem *elem = Get();
-		if (NULL != elem)
-		{
-			return elem->Value();
-		}
-		return NULL;
+		return Get()->m_value;
 	}
 
 };	// class CHashMapIter
@@ -12,6 +12,9 @@
 //		* does not allow insertion of duplicates
 //		* destroys objects based on client-side provided destroy functions
 //
+//		Laid out like CHashMap: elements in a dense array in insertion order,
+//		indexed by an open-addressing table of (hash, element) slots.
+//
 //	@owner:
 //		solimm1
 //
@@ -23,6 +26,7 @@
 #define GPOS_CHashSet_H
 
 #include "gpos/base.h"
+#include "gpos/common/CAutoRg.h"
 #include "gpos/common/CDynamicPtrArray.h"
 #include "gpos/common/CRefCount.h"
 
@@ -49,166 +53,174 @@ class CHashSet : public CRefCount
 	friend class CHashSetIter<T, HashFn, EqFn, CleanupFn>;
 
 private:
-	//---------------------------------------------------------------------------
-	//	@class:
-	//		CHashSetElem
-	//
-	//	@doc:
-	//		Anchor for set element
-	//
-	//---------------------------------------------------------------------------
-	class CHashSetElem
+	// set element
+	struct SEntry
 	{
-	private:
-		// pointer to object
 		T *m_value;
+		ULONG m_hash;
+	};
 
-		// does hash set element own object?
-		BOOL m_owns_object;
-
-	public:
-		CHashSetElem(const CHashSetElem &) = delete;
-
-		// ctor
-		CHashSetElem(T *value, BOOL fOwn) : m_value(value), m_owns_object(fOwn)
-		{
-			GPOS_ASSERT(NULL != value);
-		}
-
-		// dtor
-		~CHashSetElem()
-		{
-			// in case of a temporary HashSet element for lookup we do NOT own the
-			// objects, otherwise call destroy functions
-			if (m_owns_object)
-			{
-				CleanupFn(m_value);
-			}
-		}
-
-		// object accessor
-		T *
-		Value() const
-		{
-			return m_value;
-		}
+	// index slot, entry is the position of the element plus one, or zero
+	// if the slot is empty
+	struct SSlot
+	{
+		ULONG m_hash;
+		ULONG m_entry;
+	};
 
-		// equality operator
-		BOOL
-		operator==(const CHashSetElem &hse) const
-		{
-			return EqFn(m_value, hse.m_value);
-		}
-	};	// class CHashSetElem
+	// number of elements allocated on first insertion
+	static const ULONG m_min_entries = 8;
 
 	// memory pool
 	CMemoryPool *m_mp;
 
-	// number of hash chains
-	ULONG m_num_chains;
-
 	// total number of entries
 	ULONG m_size;
 
-	// each hash chain is an array of hashset elements
-	typedef CDynamicPtrArray<CHashSetElem, CleanupDelete> HashSetElemArray;
-	HashSetElemArray **m_chains;
+	// elements in insertion order
+	SEntry *m_entries;
+	ULONG m_entries_capacity;
 
-	// array for elements
-	// We use CleanupNULL because the elements are owned by the hash table
-	typedef CDynamicPtrArray<T, CleanupNULL> Elements;
-	Elements *const m_elements;
+	// index slots, twice as many as element capacity; the home slot of a
+	// hash is taken from its top bits
+	SSlot *m_slots;
+	ULONG m_slot_mask;
+	ULONG m_slot_shift;
 
-	IntPtrArray *const m_filled_chains;
+	// spread the client hash over all bits, see CHashMap
+	static ULONG
+	MixHash(ULONG hash)
+	{
+		return hash * 0x9E3779B1U;
+	}
 
-	// lookup appropriate hash chain in static table, may be NULL if
-	// no elements have been inserted yet
-	HashSetElemArray **
-	GetChain(const T *value) const
+	// find the slot of the given element, ulong_max if not found
+	ULONG
+	FindSlot(const T *value, ULONG hash) const
 	{
-		GPOS_ASSERT(NULL != m_chains);
-		return &m_chains[HashFn(value) % m_num_chains];
+		if (NULL == m_slots)
+		{
+			return gpos::ulong_max;
+		}
+
+		for (ULONG pos = hash >> m_slot_shift;; pos = (pos + 1) & m_slot_mask)
+		{
+			const SSlot &slot = m_slots[pos];
+			if (0 == slot.m_entry)
+			{
+				return gpos::ulong_max;
+			}
+
+			if (slot.m_hash == hash &&
+				EqFn(m_entries[slot.m_entry - 1].m_value, value))
+			{
+				return pos;
+			}
+		}
 	}
 
-	// clear elements
+	// add a slot for the given element, which must not be present
 	void
-	Clear()
+	AddSlot(ULONG hash, ULONG entry)
 	{
-		for (ULONG i = 0; i < m_filled_chains->Size(); i++)
+		ULONG pos = hash >> m_slot_shift;
+		while (0 != m_slots[pos].m_entry)
 		{
-			// release each hash chain
-			m_chains[*(*m_filled_chains)[i]]->Release();
+			pos = (pos + 1) & m_slot_mask;
 		}
-		m_size = 0;
-		m_filled_chains->Clear();
+		m_slots[pos].m_hash = hash;
+		m_slots[pos].m_entry = entry + 1;
 	}
 
-	// lookup an element by its key
-	CHashSetElem *
-	Lookup(const T *value) const
+	// double the capacity of the arrays
+	void
+	Grow()
 	{
-		CHashSetElem hse(const_cast<T *>(value), false /*fOwn*/);
-		CHashSetElem *found_hse = NULL;
-		HashSetElemArray **chain = GetChain(value);
-		if (NULL != *chain)
+		ULONG capacity = (0 == m_entries_capacity) ? m_min_entries
+												   : 2 * m_entries_capacity;
+		ULONG num_slots = 2 * capacity;
+		ULONG shift = 32;
+		for (ULONG n = num_slots; n > 1; n >>= 1)
+		{
+			shift--;
+		}
+
+		CAutoRg<SEntry> entries;
+		entries = GPOS_NEW_ARRAY(m_mp, SEntry, capacity);
+		SSlot *slots = GPOS_NEW_ARRAY(m_mp, SSlot, num_slots);
+
+		for (ULONG ul = 0; ul < m_size; ul++)
 		{
-			found_hse = (*chain)->Find(&hse);
-			GPOS_ASSERT_IMP(NULL != found_hse, *found_hse == hse);
+			entries[ul] = m_entries[ul];
 		}
 
-		return found_hse;
+		GPOS_DELETE_ARRAY(m_entries);
+		GPOS_DELETE_ARRAY(m_slots);
+
+		m_entries = entries.RgtReset();
+		m_entries_capacity = capacity;
+		m_slots = slots;
+		m_slot_mask = num_slots - 1;
+		m_slot_shift = shift;
+
+		(void) clib::Memset(m_slots, 0, num_slots * sizeof(SSlot));
+		for (ULONG ul = 0; ul < m_size; ul++)
+		{
+			AddSlot(m_entries[ul].m_hash, ul);
+		}
 	}
 
 public:
 	CHashSet(const CHashSet<T, HashFn, EqFn, CleanupFn> &) = delete;
 
-	// ctor
-	CHashSet<T, HashFn, EqFn, CleanupFn>(CMemoryPool *mp, ULONG size = 127)
+	// ctor; the size argument is only kept for source compatibility, the
+	// set sizes itself as elements are inserted
+	CHashSet<T, HashFn, EqFn, CleanupFn>(CMemoryPool *mp,
+										 ULONG size GPOS_ASSERTS_ONLY = 127)
 		: m_mp(mp),
-		  m_num_chains(size),
 		  m_size(0),
-		  m_chains(GPOS_NEW_ARRAY(m_mp, HashSetElemArray *, m_num_chains)),
-		  m_elements(GPOS_NEW(m_mp) Elements(m_mp)),
-		  m_filled_chains(GPOS_NEW(mp) IntPtrArray(mp))
+		  m_entries(NULL),
+		  m_entries_capacity(0),
+		  m_slots(NULL),
+		  m_slot_mask(0),
+		  m_slot_shift(0)
 	{
 		GPOS_ASSERT(size > 0);
-		(void) clib::Memset(m_chains, 0,
-							m_num_chains * sizeof(HashSetElemArray *));
 	}
 
 	// dtor
 	~CHashSet<T, HashFn, EqFn, CleanupFn>() override
 	{
-		// release all hash chains
-		Clear();
+		for (ULONG ul = 0; ul < m_size; ul++)
+		{
+			CleanupFn(m_entries[ul].m_value);
+		}
 
-		GPOS_DELETE_ARRAY(m_chains);
-		m_elements->Release();
-		m_filled_chains->Release();
+		GPOS_DELETE_ARRAY(m_entries);
+		GPOS_DELETE_ARRAY(m_slots);
 	}
 
 	// insert an element if not present
 	BOOL
 	Insert(T *value)
 	{
-		if (Contains(value))
+		GPOS_ASSERT(NULL != value);
+
+		ULONG hash = MixHash(HashFn(value));
+		if (gpos::ulong_max != FindSlot(value, hash))
 		{
 			return false;
 		}
 
-		HashSetElemArray **chain = GetChain(value);
-		if (NULL == *chain)
+		if (m_size == m_entries_capacity)
 		{
-			*chain = GPOS_NEW(m_mp) HashSetElemArray(m_mp);
-			INT chain_idx = HashFn(value) % m_num_chains;
-			m_filled_chains->Append(GPOS_NEW(m_mp) INT(chain_idx));
+			Grow();
 		}
 
-		CHashSetElem *elem = GPOS_NEW(m_mp) CHashSetElem(value, true /*fOwn*/);
-		(*chain)->Append(elem);
-
+		m_entries[m_size].m_value = value;
+		m_entries[m_size].m_hash = hash;
+		AddSlot(hash, m_size);
 		m_size++;
-		m_elements->Append(value);
 
 		return true;
 	}
@@ -217,16 +229,7 @@ public:
 	BOOL
 	Contains(const T *value) const
 	{
-		CHashSetElem hse(const_cast<T *>(value), false /*fOwn*/);
-		HashSetElemArray **chain = GetChain(value);
-		if (NULL != *chain)
-		{
-			CHashSetElem *found_hse = (*chain)->Find(&hse);
-
-			return (NULL != found_hse);
-		}
-
-		return false;
+		return gpos::ulong_max != FindSlot(value, MixHash(HashFn(value)));
 	}
 
 	// return number of map entries
@@ -7,7 +7,6 @@
 #define GPOS_CHashSetIter_H
 
 #include "gpos/base.h"
-#include "gpos/common/CDynamicPtrArray.h"
 #include "gpos/common/CHashSet.h"
 #include "gpos/common/CStackObject.h"
 
@@ -25,21 +24,15 @@ private:
 	// set to iterate
 	const TSet *m_set;
 
-	// current hashchain
-	ULONG m_chain_idx;
-
-	// current element
+	// position of the current element plus one
 	ULONG m_elem_idx;
 
-	// is initialized?
-	BOOL m_is_initialized;
-
 public:
 	CHashSetIter(const CHashSetIter<T, HashFn, EqFn, CleanupFn> &) = delete;
 
 	// ctor
 	CHashSetIter<T, HashFn, EqFn, CleanupFn>(TSet *set)
-		: m_set(set), m_chain_idx(0), m_elem_idx(0)
+		: m_set(set), m_elem_idx(0)
 	{
 		GPOS_ASSERT(NULL != set);
 	}
@@ -51,7 +44,7 @@ public:
 	BOOL
 	Advance()
 	{
-		if (m_elem_idx < m_set->m_elements->Size())
+		if (m_elem_idx < m_set->m_size)
 		{
 			m_elem_idx++;
 			return true;
@@ -64,14 +57,8 @@ public:
 	const T *
 	Get() const
 	{
-		const typename TSet::CHashSetElem *elem = NULL;
-		T *t = (*(m_set->m_elements))[m_elem_idx - 1];
-		elem = m_set->Lookup(t);
-		if (NULL != elem)
-		{
-			return elem->Value();
-		}
-		return NULL;
+		GPOS_ASSERT(0 < m_elem_idx);
+		return m_set->m_entries[m_elem_idx - 1].m_value;
 	}
 
 };	// class CHashSetIter
@@ -31,7 +31,9 @@ public:
 	static GPOS_RESULT EresUnittest_Basics();
 	static GPOS_RESULT EresUnittest_Removal();
 	static GPOS_RESULT EresUnittest_SetOps();
+	static GPOS_RESULT EresUnittest_Sparse();
 	static GPOS_RESULT EresUnittest_Performance();
+	static GPOS_RESULT EresUnittest_SetOpsPerformance();
 
 };	// class CBitSetTest
 }  // namespace gpos
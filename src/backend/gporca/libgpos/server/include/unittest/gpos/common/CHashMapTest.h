@@ -30,6 +30,8 @@ public:
 	static GPOS_RESULT EresUnittest();
 	static GPOS_RESULT EresUnittest_Basic();
 	static GPOS_RESULT EresUnittest_Ownership();
+	static GPOS_RESULT EresUnittest_Delete();
+	static GPOS_RESULT EresUnittest_Performance();
 
 };	// class CHashMapTest
 }  // namespace gpos
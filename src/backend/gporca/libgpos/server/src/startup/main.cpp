@@ -10,6 +10,7 @@
 //---------------------------------------------------------------------------
 
 #include "gpos/_api.h"
+#include "gpos/common/CBitVector.h"
 #include "gpos/common/CMainArgs.h"
 #include "gpos/test/CUnittest.h"
 #include "gpos/types.h"
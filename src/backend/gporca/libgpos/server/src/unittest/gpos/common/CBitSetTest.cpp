@@ -13,6 +13,7 @@
 
 #include "gpos/base.h"
 #include "gpos/common/CBitSet.h"
+#include "gpos/common/CBitSetIter.h"
 #include "gpos/io/COstreamString.h"
 #include "gpos/memory/CAutoMemoryPool.h"
 #include "gpos/string/CWStringDynamic.h"
@@ -35,7 +36,9 @@ CBitSetTest::EresUnittest()
 		GPOS_UNITTEST_FUNC(CBitSetTest::EresUnittest_Basics),
 		GPOS_UNITTEST_FUNC(CBitSetTest::EresUnittest_Removal),
 		GPOS_UNITTEST_FUNC(CBitSetTest::EresUnittest_SetOps),
-		GPOS_UNITTEST_FUNC(CBitSetTest::EresUnittest_Performance)};
+		GPOS_UNITTEST_FUNC(CBitSetTest::EresUnittest_Sparse),
+		GPOS_UNITTEST_FUNC(CBitSetTest::EresUnittest_Performance),
+		GPOS_UNITTEST_FUNC(CBitSetTest::EresUnittest_SetOpsPerformance)};
 
 	return CUnittest::EresExecute(rgut, GPOS_ARRAY_SIZE(rgut));
 }
@@ -208,6 +211,93 @@ CBitSetTest::EresUnittest_SetOps()
 }
 
 
+//---------------------------------------------------------------------------
+//	@function:
+//		CBitSetTest::EresUnittest_Sparse
+//
+//	@doc:
+//		Test for sets of ids that are far apart; only the blocks holding
+//		them take up memory
+//
+//---------------------------------------------------------------------------
+GPOS_RESULT
+CBitSetTest::EresUnittest_Sparse()
+{
+	// create memory pool
+	CAutoMemoryPool amp;
+	CMemoryPool *mp = amp.Pmp();
+
+	const ULONG rgulIds[] = {1, 50000, 50001, 1000000};
+	CBitSet *pbs = GPOS_NEW(mp) CBitSet(mp);
+
+	// a few blocks are kept inside the set
+	ULLONG ullAllocated = mp->TotalAllocatedSize();
+	for (ULONG i = GPOS_ARRAY_SIZE(rgulIds); i > 0; i--)
+	{
+		(void) pbs->ExchangeSet(rgulIds[i - 1]);
+	}
+	GPOS_ASSERT(ullAllocated == mp->TotalAllocatedSize());
+	GPOS_ASSERT(GPOS_ARRAY_SIZE(rgulIds) == pbs->Size());
+	GPOS_ASSERT(pbs->Get(50000) && !pbs->Get(49999) && !pbs->Get(0));
+
+	// members come out in order
+	CBitSetIter bsiter(*pbs);
+	for (ULONG i = 0; i < GPOS_ARRAY_SIZE(rgulIds); i++)
+	{
+		GPOS_ASSERT(bsiter.Advance() && rgulIds[i] == bsiter.Bit());
+	}
+	GPOS_ASSERT(!bsiter.Advance());
+
+	// more blocks come from the pool, but not the range between them
+	CBitSet *pbsWide = GPOS_NEW(mp) CBitSet(mp, *pbs);
+	ullAllocated = mp->TotalAllocatedSize();
+	for (ULONG i = 1; i <= 8; i++)
+	{
+		(void) pbsWide->ExchangeSet(i * 100000);
+	}
+	GPOS_ASSERT(mp->TotalAllocatedSize() - ullAllocated < 1024);
+	GPOS_ASSERT(pbsWide->ContainsAll(pbs) && !pbs->ContainsAll(pbsWide));
+
+	CBitSet *pbsOther = GPOS_NEW(mp) CBitSet(mp);
+	(void) pbsOther->ExchangeSet(50000);
+	(void) pbsOther->ExchangeSet(2000000);
+	GPOS_ASSERT(!pbs->IsDisjoint(pbsOther));
+
+	CBitSet *pbsCommon = GPOS_NEW(mp) CBitSet(mp);
+	(void) pbsCommon->ExchangeSet(50000);
+
+	// blocks left empty don't count for equality and hashing
+	CBitSet *pbsResult = GPOS_NEW(mp) CBitSet(mp, *pbs);
+	pbsResult->Intersection(pbsOther);
+	GPOS_ASSERT(pbsResult->Equals(pbsCommon));
+	GPOS_ASSERT(pbsCommon->Equals(pbsResult));
+	GPOS_ASSERT(pbsResult->HashValue() == pbsCommon->HashValue());
+
+	pbsResult->Union(pbsOther);
+	pbsResult->Difference(pbsOther);
+	GPOS_ASSERT(0 == pbsResult->Size());
+	GPOS_ASSERT(0 == pbsResult->HashValue());
+
+	pbs->Difference(pbsCommon);
+	GPOS_ASSERT(pbs->IsDisjoint(pbsOther));
+	GPOS_ASSERT(GPOS_ARRAY_SIZE(rgulIds) - 1 == pbs->Size());
+
+	for (ULONG i = 0; i < GPOS_ARRAY_SIZE(rgulIds); i++)
+	{
+		(void) pbs->ExchangeClear(rgulIds[i]);
+	}
+	GPOS_ASSERT(pbs->Equals(pbsResult));
+
+	pbsResult->Release();
+	pbsCommon->Release();
+	pbsOther->Release();
+	pbsWide->Release();
+	pbs->Release();
+
+	return GPOS_OK;
+}
+
+
 //---------------------------------------------------------------------------
 //	@function:
 //		CBitSetTest::EresUnittest_Performance
@@ -249,4 +339,76 @@ CBitSetTest::EresUnittest_Performance()
 	return GPOS_OK;
 }
 
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CBitSetTest::EresUnittest_SetOpsPerformance
+//
+//	@doc:
+//		Microbenchmark of set operations -- simulates column sets in property
+//		derivation: small sets of ids spread over a wide range, copied,
+//		unioned and checked for containment and overlap
+//
+//---------------------------------------------------------------------------
+GPOS_RESULT
+CBitSetTest::EresUnittest_SetOpsPerformance()
+{
+	// create memory pool
+	CAutoMemoryPool amp;
+	CMemoryPool *mp = amp.Pmp();
+
+	const ULONG vector_size = 1024;
+	const ULONG ulSets = 64;
+	const ULONG ulBitsPerSet = 12;
+	const ULONG ulRange = 8192;
+
+	CBitSet *rgpbs[ulSets];
+	for (ULONG i = 0; i < ulSets; i++)
+	{
+		rgpbs[i] = GPOS_NEW(mp) CBitSet(mp, vector_size);
+
+		// the columns of an operator tend to have nearby ids
+		ULONG ulBase = (i * 131) % ulRange;
+		for (ULONG j = 0; j < ulBitsPerSet; j++)
+		{
+			(void) rgpbs[i]->ExchangeSet((ulBase + j * 7) % ulRange);
+		}
+	}
+
+	ULONG ulHits = 0;
+	for (ULONG ulIter = 0; ulIter < 5000; ulIter++)
+	{
+		CBitSet *pbs = GPOS_NEW(mp) CBitSet(mp, *rgpbs[ulIter % ulSets]);
+		for (ULONG i = 0; i < ulSets; i++)
+		{
+			if (!pbs->IsDisjoint(rgpbs[i]))
+			{
+				ulHits++;
+			}
+			if (pbs->ContainsAll(rgpbs[i]))
+			{
+				ulHits++;
+			}
+			if (0 == i % 8)
+			{
+				pbs->Union(rgpbs[i]);
+			}
+		}
+
+		GPOS_ASSERT(pbs->ContainsAll(rgpbs[ulIter % ulSets]));
+		pbs->Intersection(rgpbs[(ulIter + 1) % ulSets]);
+		pbs->Release();
+	}
+
+	GPOS_ASSERT(0 < ulHits);
+	(void) ulHits;
+
+	for (ULONG i = 0; i < ulSets; i++)
+	{
+		rgpbs[i]->Release();
+	}
+
+	return GPOS_OK;
+}
+
 // EOF
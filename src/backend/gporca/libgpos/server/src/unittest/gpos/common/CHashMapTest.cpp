@@ -12,7 +12,7 @@
 #include "unittest/gpos/common/CHashMapTest.h"
 
 #include "gpos/base.h"
-#include "gpos/common/CHashMap.h"
+#include "gpos/common/CHashMapIter.h"
 #include "gpos/memory/CAutoMemoryPool.h"
 #include "gpos/test/CUnittest.h"
 
@@ -32,6 +32,8 @@ CHashMapTest::EresUnittest()
 	CUnittest rgut[] = {
 		GPOS_UNITTEST_FUNC(CHashMapTest::EresUnittest_Basic),
 		GPOS_UNITTEST_FUNC(CHashMapTest::EresUnittest_Ownership),
+		GPOS_UNITTEST_FUNC(CHashMapTest::EresUnittest_Delete),
+		GPOS_UNITTEST_FUNC(CHashMapTest::EresUnittest_Performance),
 	};
 
 	return CUnittest::EresExecute(rgut, GPOS_ARRAY_SIZE(rgut));
@@ -181,4 +183,144 @@ CHashMapTest::EresUnittest_Ownership()
 	return GPOS_OK;
 }
 
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CHashMapTest::EresUnittest_Delete
+//
+//	@doc:
+//		Deleting and re-inserting keys; iteration follows insertion order
+//		and skips deleted entries
+//
+//---------------------------------------------------------------------------
+GPOS_RESULT
+CHashMapTest::EresUnittest_Delete()
+{
+	// create memory pool
+	CAutoMemoryPool amp;
+	CMemoryPool *mp = amp.Pmp();
+
+	const ULONG ulCnt = 1000;
+
+	typedef CHashMap<ULONG, ULONG, HashValue<ULONG>, gpos::Equals<ULONG>,
+					 CleanupDelete<ULONG>, CleanupDelete<ULONG> >
+		UlongToUlongMap;
+	typedef CHashMapIter<ULONG, ULONG, HashValue<ULONG>, gpos::Equals<ULONG>,
+						 CleanupDelete<ULONG>, CleanupDelete<ULONG> >
+		UlongToUlongMapIter;
+
+	UlongToUlongMap *phm = GPOS_NEW(mp) UlongToUlongMap(mp);
+	for (ULONG ul = 0; ul < ulCnt; ul++)
+	{
+		(void) phm->Insert(GPOS_NEW(mp) ULONG(ul), GPOS_NEW(mp) ULONG(ul));
+	}
+
+	// delete every other key, twice
+	for (ULONG ul = 0; ul < ulCnt; ul += 2)
+	{
+		BOOL fSuccess GPOS_ASSERTS_ONLY = phm->Delete(&ul);
+		GPOS_ASSERT(fSuccess);
+		fSuccess = phm->Delete(&ul);
+		GPOS_ASSERT(!fSuccess);
+	}
+	GPOS_ASSERT(ulCnt / 2 == phm->Size());
+
+	for (ULONG ul = 0; ul < ulCnt; ul++)
+	{
+		ULONG *pul GPOS_ASSERTS_ONLY = phm->Find(&ul);
+		GPOS_ASSERT_IMP(0 == ul % 2, NULL == pul);
+		GPOS_ASSERT_IMP(1 == ul % 2, NULL != pul && ul == *pul);
+	}
+
+	// deleted keys go to the end of the iteration order when re-inserted
+	for (ULONG ul = 0; ul < ulCnt; ul += 4)
+	{
+		(void) phm->Insert(GPOS_NEW(mp) ULONG(ul), GPOS_NEW(mp) ULONG(ul));
+	}
+	GPOS_ASSERT(ulCnt / 2 + ulCnt / 4 == phm->Size());
+
+	// odd keys in insertion order, then the re-inserted multiples of four
+	ULONG ulSeen = 0;
+	UlongToUlongMapIter hmi(phm);
+	while (hmi.Advance())
+	{
+		ULONG ulExpected GPOS_ASSERTS_ONLY = (ulSeen < ulCnt / 2)
+												 ? 2 * ulSeen + 1
+												 : 4 * (ulSeen - ulCnt / 2);
+		GPOS_ASSERT(ulExpected == *hmi.Key());
+		GPOS_ASSERT(ulExpected == *hmi.Value());
+		ulSeen++;
+	}
+	GPOS_ASSERT(phm->Size() == ulSeen);
+
+	phm->Release();
+
+	return GPOS_OK;
+}
+
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CHashMapTest::EresUnittest_Performance
+//
+//	@doc:
+//		Simple perf test -- simulates column reference maps: pointer keys,
+//		many lookups per insertion, about half of them misses
+//
+//---------------------------------------------------------------------------
+GPOS_RESULT
+CHashMapTest::EresUnittest_Performance()
+{
+	// create memory pool
+	CAutoMemoryPool amp;
+	CMemoryPool *mp = amp.Pmp();
+
+	const ULONG ulKeys = 4096;
+	const ULONG ulMaps = 64;
+
+	typedef CHashMap<ULONG_PTR, ULONG_PTR, HashPtr<ULONG_PTR>,
+					 gpos::Equals<ULONG_PTR>, CleanupNULL<ULONG_PTR>,
+					 CleanupNULL<ULONG_PTR> >
+		UlongPtrToUlongPtrMap;
+
+	ULONG_PTR *rgulp = GPOS_NEW_ARRAY(mp, ULONG_PTR, ulKeys);
+	for (ULONG ul = 0; ul < ulKeys; ul++)
+	{
+		rgulp[ul] = ul;
+	}
+
+	ULONG ulHits = 0;
+	for (ULONG ulMap = 0; ulMap < ulMaps; ulMap++)
+	{
+		UlongPtrToUlongPtrMap *phm = GPOS_NEW(mp) UlongPtrToUlongPtrMap(mp);
+
+		// each map holds a different slice of half of the keys
+		for (ULONG ul = 0; ul < ulKeys / 2; ul++)
+		{
+			ULONG_PTR *pulp = &rgulp[(ulMap * 61 + ul) % ulKeys];
+			(void) phm->Insert(pulp, pulp);
+		}
+
+		for (ULONG ulRound = 0; ulRound < 8; ulRound++)
+		{
+			for (ULONG ul = 0; ul < ulKeys; ul++)
+			{
+				if (NULL != phm->Find(&rgulp[ul]))
+				{
+					ulHits++;
+				}
+			}
+		}
+
+		phm->Release();
+	}
+
+	GPOS_ASSERT(ulMaps * 8 * ulKeys / 2 == ulHits);
+	(void) ulHits;
+
+	GPOS_DELETE_ARRAY(rgulp);
+
+	return GPOS_OK;
+}
+
 // EOF
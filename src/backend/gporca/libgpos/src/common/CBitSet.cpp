@@ -8,15 +8,16 @@
 //	@doc:
 //		Implementation of bit sets
 //
-//		Underlying assumption: a set contains only a few links of bitvectors
-//		hence, keeping them in a linked list is efficient;
+//		Underlying assumption: the elements of a set come in clusters of
+//		nearby ids, hence, keeping only the blocks of words that have bits
+//		set, sorted by their position, is efficient;
 //---------------------------------------------------------------------------
 
 #include "gpos/common/CBitSet.h"
 
 #include "gpos/base.h"
-#include "gpos/common/CAutoRef.h"
 #include "gpos/common/CBitSetIter.h"
+#include "gpos/common/clibwrapper.h"
 
 #ifdef GPOS_DEBUG
 #include "gpos/error/CAutoTrace.h"
@@ -24,118 +25,153 @@
 
 using namespace gpos;
 
+#define BITS_PER_WORD 64
+
+// number of bits set in a word
+static inline ULONG
+CountBits(ULLONG word)
+{
+	return (ULONG) __builtin_popcountll(word);
+}
+
 
 //---------------------------------------------------------------------------
 //	@function:
-//		CBitSetLink
+//		CBitSet::FindBlock
 //
 //	@doc:
-//		ctor
+//		Binary search for the position of the first block with an index not
+//		below the given one; m_num_blocks if there is none
 //
 //---------------------------------------------------------------------------
-CBitSet::CBitSetLink::CBitSetLink(CMemoryPool *mp, ULONG offset,
-								  ULONG vector_size)
-	: m_offset(offset)
+ULONG
+CBitSet::FindBlock(ULONG index) const
 {
-	m_vec = GPOS_NEW(mp) CBitVector(mp, vector_size);
+	ULONG low = 0;
+	ULONG high = m_num_blocks;
+
+	while (low < high)
+	{
+		ULONG mid = low + (high - low) / 2;
+		if (m_blocks[mid].m_index < index)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+
+	return low;
 }
 
 
 //---------------------------------------------------------------------------
 //	@function:
-//		CBitSetLink
+//		CBitSet::GetBlock
 //
 //	@doc:
-//		copy ctor
+//		Block with given index, NULL if it has no bits set
 //
 //---------------------------------------------------------------------------
-CBitSet::CBitSetLink::CBitSetLink(CMemoryPool *mp, const CBitSetLink &bsl)
-	: m_offset(bsl.m_offset)
+const CBitSet::SBlock *
+CBitSet::GetBlock(ULONG index) const
 {
-	m_vec = GPOS_NEW(mp) CBitVector(mp, *bsl.GetVec());
+	ULONG pos = FindBlock(index);
+	if (pos < m_num_blocks && m_blocks[pos].m_index == index)
+	{
+		return &m_blocks[pos];
+	}
+
+	return NULL;
 }
 
 
 //---------------------------------------------------------------------------
 //	@function:
-//		~CBitSetLink
+//		CBitSet::GetWord
 //
 //	@doc:
-//		ctor
+//		Word with given index, zero if its block has no bits set
 //
 //---------------------------------------------------------------------------
-CBitSet::CBitSetLink::~CBitSetLink()
+ULLONG
+CBitSet::GetWord(ULONG word) const
 {
-	GPOS_DELETE(m_vec);
+	const SBlock *block = GetBlock(word / m_block_words);
+	if (NULL == block)
+	{
+		return 0;
+	}
+
+	return block->m_words[word % m_block_words];
 }
 
 
 //---------------------------------------------------------------------------
 //	@function:
-//		CBitSet::FindLinkByOffset
+//		CBitSet::Reserve
 //
 //	@doc:
-//		Find bit set link for a given offset; if non-existent return previous
-//		link (may be NULL);
-//		By providing a starting link we can implement a number of operations
-//		in one sweep, ie O(N)
+//		Make room for at least the given number of blocks, moving the blocks
+//		to a bigger array if necessary
 //
 //---------------------------------------------------------------------------
-CBitSet::CBitSetLink *
-CBitSet::FindLinkByOffset(ULONG offset, CBitSetLink *bsl) const
+void
+CBitSet::Reserve(ULONG num_blocks)
 {
-	CBitSetLink *found = NULL;
-	CBitSetLink *cursor = bsl;
-
-	if (NULL == bsl)
+	if (num_blocks <= m_capacity)
 	{
-		// if no cursor provided start with first element
-		cursor = m_bsllist.First();
+		return;
 	}
-	else
+
+	m_capacity = std::max(num_blocks, 2 * m_capacity);
+	SBlock *blocks = GPOS_NEW_ARRAY(m_mp, SBlock, m_capacity);
+	for (ULONG i = 0; i < m_num_blocks; i++)
 	{
-		GPOS_ASSERT(bsl->GetOffset() <= offset && "invalid start cursor");
-		found = bsl;
+		blocks[i] = m_blocks[i];
 	}
 
-	GPOS_ASSERT_IMP(NULL != cursor,
-					GPOS_OK == m_bsllist.Find(cursor) && "cursor not in list");
-
-	while (1)
+	if (m_blocks != m_inline)
 	{
-		// no more links or we've overshot the target
-		if (NULL == cursor || cursor->GetOffset() > offset)
-		{
-			break;
-		}
-
-		found = cursor;
-		cursor = m_bsllist.Next(cursor);
+		GPOS_DELETE_ARRAY(m_blocks);
 	}
-
-	GPOS_ASSERT_IMP(found, found->GetOffset() <= offset);
-	return found;
+	m_blocks = blocks;
 }
 
 
 //---------------------------------------------------------------------------
 //	@function:
-//		CBitSet::RecomputeSize
+//		CBitSet::Compact
 //
 //	@doc:
-//		Compute size of set by adding up sizes of links
+//		Drop the blocks that have no bits set anymore and compute size of
+//		set by counting the bits of the remaining ones
 //
 //---------------------------------------------------------------------------
 void
-CBitSet::RecomputeSize()
+CBitSet::Compact()
 {
+	ULONG num_blocks = 0;
 	m_size = 0;
-	CBitSetLink *bsl = NULL;
 
-	for (bsl = m_bsllist.First(); bsl != NULL; bsl = m_bsllist.Next(bsl))
+	for (ULONG i = 0; i < m_num_blocks; i++)
 	{
-		m_size += bsl->GetVec()->CountSetBits();
+		ULONG bits = 0;
+		for (ULONG w = 0; w < m_block_words; w++)
+		{
+			bits += CountBits(m_blocks[i].m_words[w]);
+		}
+
+		if (0 < bits)
+		{
+			m_blocks[num_blocks++] = m_blocks[i];
+			m_size += bits;
+		}
 	}
+
+	m_num_blocks = num_blocks;
 }
 
 
@@ -144,43 +180,24 @@ CBitSet::RecomputeSize()
 //		CBitSet::Clear
 //
 //	@doc:
-//		release all links
+//		release all blocks
 //
 //---------------------------------------------------------------------------
 void
 CBitSet::Clear()
 {
-	CBitSetLink *bsl = NULL;
-
-	while (NULL != (bsl = m_bsllist.First()))
+	if (m_blocks != m_inline)
 	{
-		CBitSetLink *bsl_to_remove = bsl;
-		bsl = m_bsllist.Next(bsl);
-
-		m_bsllist.Remove(bsl_to_remove);
-		GPOS_DELETE(bsl_to_remove);
+		GPOS_DELETE_ARRAY(m_blocks);
 	}
 
-	RecomputeSize();
-}
-
-
-//---------------------------------------------------------------------------
-//	@function:
-//		CBitSet::GetOffset
-//
-//	@doc:
-//		Compute offset
-//
-//---------------------------------------------------------------------------
-ULONG
-CBitSet::ComputeOffset(ULONG ul) const
-{
-	return (ul / m_vector_size) * m_vector_size;
+	m_blocks = m_inline;
+	m_capacity = m_inline_blocks;
+	m_num_blocks = 0;
+	m_size = 0;
 }
 
 
-
 //---------------------------------------------------------------------------
 //	@function:
 //		CBitSet::CBitSet
@@ -190,9 +207,17 @@ CBitSet::ComputeOffset(ULONG ul) const
 //
 //---------------------------------------------------------------------------
 CBitSet::CBitSet(CMemoryPool *mp, ULONG vector_size)
-	: m_mp(mp), m_vector_size(vector_size), m_size(0)
+	: m_mp(mp),
+	  m_chunk_words(1),
+	  m_blocks(m_inline),
+	  m_num_blocks(0),
+	  m_capacity(m_inline_blocks),
+	  m_size(0)
 {
-	m_bsllist.Init(GPOS_OFFSET(CBitSetLink, m_link));
+	if (0 < vector_size && 0 == vector_size % BITS_PER_WORD)
+	{
+		m_chunk_words = vector_size / BITS_PER_WORD;
+	}
 }
 
 
@@ -205,9 +230,13 @@ CBitSet::CBitSet(CMemoryPool *mp, ULONG vector_size)
 //
 //---------------------------------------------------------------------------
 CBitSet::CBitSet(CMemoryPool *mp, const CBitSet &bs)
-	: m_mp(mp), m_vector_size(bs.m_vector_size), m_size(0)
+	: m_mp(mp),
+	  m_chunk_words(bs.m_chunk_words),
+	  m_blocks(m_inline),
+	  m_num_blocks(0),
+	  m_capacity(m_inline_blocks),
+	  m_size(0)
 {
-	m_bsllist.Init(GPOS_OFFSET(CBitSetLink, m_link));
 	Union(&bs);
 }
 
@@ -226,69 +255,46 @@ CBitSet::~CBitSet()
 }
 
 
-//---------------------------------------------------------------------------
-//	@function:
-//		CBitSet::Get
-//
-//	@doc:
-//		Check if given bit is set
-//
-//---------------------------------------------------------------------------
-BOOL
-CBitSet::Get(ULONG pos) const
-{
-	ULONG offset = ComputeOffset(pos);
-
-	CBitSetLink *bsl = FindLinkByOffset(offset);
-	if (NULL != bsl && bsl->GetOffset() == offset)
-	{
-		return bsl->GetVec()->Get(pos - offset);
-	}
-
-	return false;
-}
-
-
 //---------------------------------------------------------------------------
 //	@function:
 //		CBitSet::ExchangeSet
 //
 //	@doc:
-//		Set given bit; return previous value; allocate new link if necessary
+//		Set given bit; return previous value; insert its block if necessary
 //
 //---------------------------------------------------------------------------
 BOOL
 CBitSet::ExchangeSet(ULONG pos)
 {
-	ULONG offset = ComputeOffset(pos);
+	ULONG index = pos / m_block_bits;
+	ULLONG mask = (ULLONG) 1 << (pos % BITS_PER_WORD);
+	ULONG block = FindBlock(index);
 
-	CBitSetLink *bsl = FindLinkByOffset(offset);
-	if (NULL == bsl || bsl->GetOffset() != offset)
+	if (block == m_num_blocks || m_blocks[block].m_index != index)
 	{
-		CBitSetLink *pbsl_new =
-			GPOS_NEW(m_mp) CBitSetLink(m_mp, offset, m_vector_size);
-		if (NULL == bsl)
+		Reserve(m_num_blocks + 1);
+		for (ULONG i = m_num_blocks; i > block; i--)
 		{
-			m_bsllist.Prepend(pbsl_new);
-		}
-		else
-		{
-			// insert after found link
-			m_bsllist.Append(pbsl_new, bsl);
+			m_blocks[i] = m_blocks[i - 1];
 		}
+		m_num_blocks++;
 
-		bsl = pbsl_new;
+		m_blocks[block].m_index = index;
+		clib::Memset(m_blocks[block].m_words, 0,
+					 sizeof(m_blocks[block].m_words));
 	}
 
-	GPOS_ASSERT(bsl->GetOffset() == offset);
-
-	BOOL bit = bsl->GetVec()->ExchangeSet(pos - offset);
-	if (!bit)
+	ULLONG *pword = &m_blocks[block].m_words[(pos % m_block_bits) /
+											 BITS_PER_WORD];
+	if (0 != (*pword & mask))
 	{
-		m_size++;
+		return true;
 	}
 
-	return bit;
+	*pword |= mask;
+	m_size++;
+
+	return false;
 }
 
 
@@ -297,35 +303,48 @@ CBitSet::ExchangeSet(ULONG pos)
 //		CBitSet::ExchangeClear
 //
 //	@doc:
-//		Clear given bit; return previous value
+//		Clear given bit; return previous value; remove its block if it has
+//		no bits set anymore
 //
 //---------------------------------------------------------------------------
 BOOL
 CBitSet::ExchangeClear(ULONG pos)
 {
-	ULONG offset = ComputeOffset(pos);
+	ULONG index = pos / m_block_bits;
+	ULLONG mask = (ULLONG) 1 << (pos % BITS_PER_WORD);
+	ULONG block = FindBlock(index);
 
-	CBitSetLink *bsl = FindLinkByOffset(offset);
-	if (NULL != bsl && bsl->GetOffset() == offset)
+	if (block == m_num_blocks || m_blocks[block].m_index != index)
 	{
-		BOOL bit = bsl->GetVec()->ExchangeClear(pos - offset);
+		return false;
+	}
 
-		// remove empty link
-		if (bsl->GetVec()->IsEmpty())
-		{
-			m_bsllist.Remove(bsl);
-			GPOS_DELETE(bsl);
-		}
+	ULLONG *words = m_blocks[block].m_words;
+	ULLONG *pword = &words[(pos % m_block_bits) / BITS_PER_WORD];
+	if (0 == (*pword & mask))
+	{
+		return false;
+	}
 
-		if (bit)
+	*pword &= ~mask;
+	m_size--;
+
+	BOOL is_empty = true;
+	for (ULONG w = 0; w < m_block_words; w++)
+	{
+		is_empty = is_empty && 0 == words[w];
+	}
+
+	if (is_empty)
+	{
+		m_num_blocks--;
+		for (ULONG i = block; i < m_num_blocks; i++)
 		{
-			m_size--;
+			m_blocks[i] = m_blocks[i + 1];
 		}
-
-		return bit;
 	}
 
-	return false;
+	return true;
 }
 
 
@@ -334,77 +353,75 @@ CBitSet::ExchangeClear(ULONG pos)
 //		CBitSet::Union
 //
 //	@doc:
-//		Union with given other set;
-//		(1) determine which links need to be allocated before(!) modifying
-//			the set allocate and copy missing links aside
-//		(2) insert the new links into the list
-//		(3) union all links, old and new, on a per-bitvector basis
-//
-//		For clarity step (2) and (3) are separated;
+//		Union with given other set; merge the other set's blocks in from the
+//		back, so that no block is moved more than once
 //
 //---------------------------------------------------------------------------
 void
 CBitSet::Union(const CBitSet *pbsOther)
 {
-	CBitSetLink *bsl = NULL;
-	CBitSetLink *bsl_other = NULL;
-
-	// dynamic array of CBitSetLink
-	typedef CDynamicPtrArray<CBitSetLink, CleanupNULL> CBitSetLinkArray;
-
-	CAutoRef<CBitSetLinkArray> a_drgpbsl;
-	a_drgpbsl = GPOS_NEW(m_mp) CBitSetLinkArray(m_mp);
+	if (0 == pbsOther->m_size || this == pbsOther)
+	{
+		return;
+	}
 
-	// iterate through other's links and copy missing links to array
-	for (bsl_other = pbsOther->m_bsllist.First(); bsl_other != NULL;
-		 bsl_other = pbsOther->m_bsllist.Next(bsl_other))
+	// count the other set's blocks missing here
+	ULONG num_missing = 0;
+	for (ULONG i = 0, j = 0; j < pbsOther->m_num_blocks; j++)
 	{
-		bsl = FindLinkByOffset(bsl_other->GetOffset(), bsl);
-		if (NULL == bsl || bsl->GetOffset() != bsl_other->GetOffset())
+		ULONG index = pbsOther->m_blocks[j].m_index;
+		while (i < m_num_blocks && m_blocks[i].m_index < index)
 		{
-			// need to copy this link
-			CAutoP<CBitSetLink> a_pbsl;
-			a_pbsl = GPOS_NEW(m_mp) CBitSetLink(m_mp, *bsl_other);
-			a_drgpbsl->Append(a_pbsl.Value());
+			i++;
+		}
 
-			a_pbsl.Reset();
+		if (i == m_num_blocks || m_blocks[i].m_index != index)
+		{
+			num_missing++;
 		}
 	}
 
-	// insert all new links
-	bsl = NULL;
-	for (ULONG i = 0; i < a_drgpbsl->Size(); i++)
+	Reserve(m_num_blocks + num_missing);
+
+	ULONG i = m_num_blocks;
+	ULONG j = pbsOther->m_num_blocks;
+	ULONG k = m_num_blocks + num_missing;
+	ULONG size = m_size;
+
+	while (0 < j)
 	{
-		CBitSetLink *pbslInsert = (*a_drgpbsl)[i];
-		bsl = FindLinkByOffset(pbslInsert->GetOffset(), bsl);
+		const SBlock &other = pbsOther->m_blocks[j - 1];
 
-		GPOS_ASSERT_IMP(NULL != bsl,
-						bsl->GetOffset() < pbslInsert->GetOffset());
-		if (NULL == bsl)
+		if (0 < i && m_blocks[i - 1].m_index > other.m_index)
 		{
-			m_bsllist.Prepend(pbslInsert);
+			m_blocks[--k] = m_blocks[--i];
 		}
-		else
+		else if (0 < i && m_blocks[i - 1].m_index == other.m_index)
 		{
-			m_bsllist.Append(pbslInsert, bsl);
+			SBlock &block = m_blocks[--i];
+			for (ULONG w = 0; w < m_block_words; w++)
+			{
+				size += CountBits(other.m_words[w] & ~block.m_words[w]);
+				block.m_words[w] |= other.m_words[w];
+			}
+			m_blocks[--k] = block;
+			j--;
 		}
-	}
-
-	// iterate through all links and union them up
-	bsl_other = NULL;
-	bsl = m_bsllist.First();
-	while (NULL != bsl)
-	{
-		bsl_other = pbsOther->FindLinkByOffset(bsl->GetOffset(), bsl_other);
-		if (NULL != bsl_other && bsl_other->GetOffset() == bsl->GetOffset())
+		else
 		{
-			bsl->GetVec()->Or(bsl_other->GetVec());
+			for (ULONG w = 0; w < m_block_words; w++)
+			{
+				size += CountBits(other.m_words[w]);
+			}
+			m_blocks[--k] = other;
+			j--;
 		}
-
-		bsl = m_bsllist.Next(bsl);
 	}
 
-	RecomputeSize();
+	GPOS_ASSERT(k == i);
+
+	m_num_blocks += num_missing;
+	m_size = size;
 }
 
 
@@ -413,7 +430,7 @@ CBitSet::Union(const CBitSet *pbsOther)
 //		CBitSet::Intersection
 //
 //	@doc:
-//		Iterate through all links and intersect them; release unused links
+//		AND all blocks with the other set's; drop the ones left empty
 //
 //---------------------------------------------------------------------------
 void
@@ -424,30 +441,31 @@ CBitSet::Intersection(const CBitSet *pbsOther)
 		return;
 	}
 
-	CBitSetLink *bsl_other = NULL;
-	CBitSetLink *bsl = m_bsllist.First();
-
-	while (NULL != bsl)
+	ULONG j = 0;
+	for (ULONG i = 0; i < m_num_blocks; i++)
 	{
-		CBitSetLink *bsl_to_remove = NULL;
+		SBlock &block = m_blocks[i];
+		while (j < pbsOther->m_num_blocks &&
+			   pbsOther->m_blocks[j].m_index < block.m_index)
+		{
+			j++;
+		}
 
-		bsl_other = pbsOther->FindLinkByOffset(bsl->GetOffset(), bsl_other);
-		if (NULL != bsl_other && bsl_other->GetOffset() == bsl->GetOffset())
+		if (j < pbsOther->m_num_blocks &&
+			pbsOther->m_blocks[j].m_index == block.m_index)
 		{
-			bsl->GetVec()->And(bsl_other->GetVec());
-			bsl = m_bsllist.Next(bsl);
+			for (ULONG w = 0; w < m_block_words; w++)
+			{
+				block.m_words[w] &= pbsOther->m_blocks[j].m_words[w];
+			}
 		}
 		else
 		{
-			bsl_to_remove = bsl;
-			bsl = m_bsllist.Next(bsl);
-
-			m_bsllist.Remove(bsl_to_remove);
-			GPOS_DELETE(bsl_to_remove);
+			clib::Memset(block.m_words, 0, sizeof(block.m_words));
 		}
 	}
 
-	RecomputeSize();
+	Compact();
 }
 
 
@@ -456,8 +474,8 @@ CBitSet::Intersection(const CBitSet *pbsOther)
 //		CBitSet::Difference
 //
 //	@doc:
-//		Substract other set from this by iterating through other set and
-//		explicit removal of elements;
+//		Substract other set from this by clearing the other set's bits in
+//		the blocks both have; drop the ones left empty
 //
 //---------------------------------------------------------------------------
 void
@@ -468,11 +486,25 @@ CBitSet::Difference(const CBitSet *pbs)
 		return;
 	}
 
-	CBitSetIter bsiter(*pbs);
-	while (bsiter.Advance())
+	ULONG j = 0;
+	for (ULONG i = 0; i < m_num_blocks; i++)
 	{
-		(void) ExchangeClear(bsiter.Bit());
+		SBlock &block = m_blocks[i];
+		while (j < pbs->m_num_blocks && pbs->m_blocks[j].m_index < block.m_index)
+		{
+			j++;
+		}
+
+		if (j < pbs->m_num_blocks && pbs->m_blocks[j].m_index == block.m_index)
+		{
+			for (ULONG w = 0; w < m_block_words; w++)
+			{
+				block.m_words[w] &= ~pbs->m_blocks[j].m_words[w];
+			}
+		}
 	}
+
+	Compact();
 }
 
 
@@ -493,20 +525,28 @@ CBitSet::ContainsAll(const CBitSet *bs) const
 		return false;
 	}
 
-	CBitSetLink *bsl = NULL;
-	CBitSetLink *bsl_other = NULL;
-
-	// iterate through other's links and check for subsets
-	for (bsl_other = bs->m_bsllist.First(); bsl_other != NULL;
-		 bsl_other = bs->m_bsllist.Next(bsl_other))
+	ULONG i = 0;
+	for (ULONG j = 0; j < bs->m_num_blocks; j++)
 	{
-		bsl = FindLinkByOffset(bsl_other->GetOffset(), bsl);
+		const SBlock &other = bs->m_blocks[j];
+		while (i < m_num_blocks && m_blocks[i].m_index < other.m_index)
+		{
+			i++;
+		}
 
-		if (NULL == bsl || bsl->GetOffset() != bsl_other->GetOffset() ||
-			!bsl->GetVec()->ContainsAll(bsl_other->GetVec()))
+		// all blocks of the other set have bits set
+		if (i == m_num_blocks || m_blocks[i].m_index != other.m_index)
 		{
 			return false;
 		}
+
+		for (ULONG w = 0; w < m_block_words; w++)
+		{
+			if (0 != (other.m_words[w] & ~m_blocks[i].m_words[w]))
+			{
+				return false;
+			}
+		}
 	}
 
 	return true;
@@ -536,23 +576,9 @@ CBitSet::Equals(const CBitSet *bs) const
 		return false;
 	}
 
-	CBitSetLink *bsl = m_bsllist.First();
-	CBitSetLink *bsl_other = bs->m_bsllist.First();
-
-	while (NULL != bsl)
-	{
-		if (NULL == bsl_other || bsl->GetOffset() != bsl_other->GetOffset() ||
-			!bsl->GetVec()->Equals(bsl_other->GetVec()))
-		{
-			return false;
-		}
-
-		bsl = m_bsllist.Next(bsl);
-		bsl_other = bs->m_bsllist.Next(bsl_other);
-	}
-
-	// same length implies bsl_other must have reached end as well
-	return bsl_other == NULL;
+	// same size, so if all of the other set's bits are set here there are
+	// no other ones
+	return ContainsAll(bs);
 }
 
 
@@ -568,19 +594,34 @@ CBitSet::Equals(const CBitSet *bs) const
 BOOL
 CBitSet::IsDisjoint(const CBitSet *bs) const
 {
-	CBitSetLink *bsl = NULL;
-	CBitSetLink *bsl_other = NULL;
+	// only the blocks both sets have can overlap
+	ULONG i = 0;
+	ULONG j = 0;
 
-	// iterate through other's links an check if disjoint
-	for (bsl_other = bs->m_bsllist.First(); bsl_other != NULL;
-		 bsl_other = bs->m_bsllist.Next(bsl_other))
+	while (i < m_num_blocks && j < bs->m_num_blocks)
 	{
-		bsl = FindLinkByOffset(bsl_other->GetOffset(), bsl);
+		const SBlock &block = m_blocks[i];
+		const SBlock &other = bs->m_blocks[j];
 
-		if (NULL != bsl && bsl->GetOffset() == bsl_other->GetOffset() &&
-			!bsl->GetVec()->IsDisjoint(bsl_other->GetVec()))
+		if (block.m_index < other.m_index)
 		{
-			return false;
+			i++;
+		}
+		else if (block.m_index > other.m_index)
+		{
+			j++;
+		}
+		else
+		{
+			for (ULONG w = 0; w < m_block_words; w++)
+			{
+				if (0 != (block.m_words[w] & other.m_words[w]))
+				{
+					return false;
+				}
+			}
+			i++;
+			j++;
 		}
 	}
 
@@ -593,7 +634,8 @@ CBitSet::IsDisjoint(const CBitSet *bs) const
 //		CBitSet::HashValue
 //
 //	@doc:
-//		Compute hash value for set
+//		Compute hash value for set; combine the hash values of the non-empty
+//		slices of vector_size bits
 //
 //---------------------------------------------------------------------------
 ULONG
@@ -601,11 +643,56 @@ CBitSet::HashValue() const
 {
 	ULONG ulHash = 0;
 
-	CBitSetLink *bsl = m_bsllist.First();
-	while (NULL != bsl)
+	if (0 == m_num_blocks)
+	{
+		return ulHash;
+	}
+
+	// words of one bitvector, including the ones of blocks without bits set
+	ULLONG chunk_inline[4 * m_block_words];
+	ULLONG *chunk = chunk_inline;
+	if (m_chunk_words > GPOS_ARRAY_SIZE(chunk_inline))
+	{
+		chunk = GPOS_NEW_ARRAY(m_mp, ULLONG, m_chunk_words);
+	}
+
+	// the non-empty words come in order, so each slice is hashed once, when
+	// its first non-empty word comes up
+	BOOL is_first = true;
+	ULONG ulLastChunk = 0;
+
+	for (ULONG i = 0; i < m_num_blocks; i++)
+	{
+		for (ULONG w = 0; w < m_block_words; w++)
+		{
+			if (0 == m_blocks[i].m_words[w])
+			{
+				continue;
+			}
+
+			ULONG ulChunk =
+				(m_blocks[i].m_index * m_block_words + w) / m_chunk_words;
+			if (!is_first && ulChunk == ulLastChunk)
+			{
+				continue;
+			}
+
+			for (ULONG ul = 0; ul < m_chunk_words; ul++)
+			{
+				chunk[ul] = GetWord(ulChunk * m_chunk_words + ul);
+			}
+
+			ulHash = gpos::CombineHashes(
+				ulHash, gpos::HashByteArray((BYTE *) chunk,
+											m_chunk_words * sizeof(ULLONG)));
+			is_first = false;
+			ulLastChunk = ulChunk;
+		}
+	}
+
+	if (chunk != chunk_inline)
 	{
-		ulHash = gpos::CombineHashes(ulHash, bsl->GetVec()->HashValue());
-		bsl = m_bsllist.Next(bsl);
+		GPOS_DELETE_ARRAY(chunk);
 	}
 
 	return ulHash;
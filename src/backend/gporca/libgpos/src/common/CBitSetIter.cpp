@@ -12,7 +12,6 @@
 #include "gpos/common/CBitSetIter.h"
 
 #include "gpos/base.h"
-#include "gpos/common/CAutoRef.h"
 
 using namespace gpos;
 
@@ -26,7 +25,7 @@ using namespace gpos;
 //
 //---------------------------------------------------------------------------
 CBitSetIter::CBitSetIter(const CBitSet &bs)
-	: m_bs(bs), m_cursor((ULONG) -1), m_bsl(NULL), m_active(true)
+	: m_bs(bs), m_cursor((ULONG) -1), m_block(0), m_active(true)
 {
 }
 
@@ -44,25 +43,42 @@ CBitSetIter::Advance()
 {
 	GPOS_ASSERT(m_active && "called advance on exhausted iterator");
 
-	if (NULL == m_bsl)
-	{
-		m_bsl = m_bs.m_bsllist.First();
-	}
+	// look for the first bit set after the cursor, starting in the block
+	// the cursor is in
+	ULONG pos = m_cursor + 1;
 
-	while (NULL != m_bsl)
+	for (; m_block < m_bs.m_num_blocks; m_block++)
 	{
-		if (m_cursor + 1 <= m_bs.m_vector_size &&
-			m_bsl->GetVec()->GetNextSetBit(m_cursor + 1, m_cursor))
+		const CBitSet::SBlock &block = m_bs.m_blocks[m_block];
+		ULONG w = 0;
+		ULLONG mask = ~(ULLONG) 0;
+
+		if (pos / CBitSet::m_block_bits > block.m_index)
 		{
-			break;
+			// the cursor was on the last bit of the block
+			continue;
 		}
 
-		m_bsl = m_bs.m_bsllist.Next(m_bsl);
-		m_cursor = (ULONG) -1;
+		if (pos / CBitSet::m_block_bits == block.m_index)
+		{
+			w = (pos % CBitSet::m_block_bits) / 64;
+			mask <<= pos % 64;
+		}
+
+		for (; w < CBitSet::m_block_words; w++, mask = ~(ULLONG) 0)
+		{
+			ULLONG word = block.m_words[w] & mask;
+			if (0 != word)
+			{
+				m_cursor = block.m_index * CBitSet::m_block_bits + w * 64 +
+						   __builtin_ctzll(word);
+				return true;
+			}
+		}
 	}
 
-	m_active = (NULL != m_bsl);
-	return m_active;
+	m_active = false;
+	return false;
 }
 
 
@@ -77,10 +93,11 @@ CBitSetIter::Advance()
 ULONG
 CBitSetIter::Bit() const
 {
-	GPOS_ASSERT(m_active && NULL != m_bsl && "iterator uninitialized");
-	GPOS_ASSERT(m_bsl->GetVec()->Get(m_cursor));
+	GPOS_ASSERT(m_active && "iterator uninitialized");
+	GPOS_ASSERT(m_bs.Get(m_cursor));
 
-	return m_bsl->GetOffset() + m_cursor;
+	return m_cursor;
 }
 
+
 // EOF
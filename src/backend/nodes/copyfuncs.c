@@ -630,6 +630,7 @@ _copyExternalScanInfo(const ExternalScanInfo *from)
 	ExternalScanInfo *newnode = makeNode(ExternalScanInfo);
 
 	COPY_NODE_FIELD(uriList);
+	COPY_NODE_FIELD(splitList);
 	COPY_SCALAR_FIELD(fmtType);
 	COPY_SCALAR_FIELD(isMasterOnly);
 	COPY_SCALAR_FIELD(rejLimit);
@@ -732,6 +732,7 @@ _outExternalScanInfo(StringInfo str, const ExternalScanInfo *node)
 	WRITE_NODE_TYPE("EXTERNALSCANINFO");
 
 	WRITE_NODE_FIELD(uriList);
+	WRITE_NODE_FIELD(splitList);
 	WRITE_CHAR_FIELD(fmtType);
 	WRITE_BOOL_FIELD(isMasterOnly);
 	WRITE_INT_FIELD(rejLimit);
@@ -3408,6 +3409,7 @@ _outAlterTableCmd(StringInfo str, const AlterTableCmd *node)
 	WRITE_BOOL_FIELD(missing_ok);
 
 	WRITE_INT_FIELD(backendId);
+	WRITE_BOOL_FIELD(expandInPlace);
 	WRITE_NODE_FIELD(policy);
 }
 
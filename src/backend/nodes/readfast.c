@@ -964,6 +964,7 @@ _readExternalScanInfo(void)
 	READ_LOCALS(ExternalScanInfo);
 
 	READ_NODE_FIELD(uriList);
+	READ_NODE_FIELD(splitList);
 	READ_CHAR_FIELD(fmtType);
 	READ_BOOL_FIELD(isMasterOnly);
 	READ_INT_FIELD(rejLimit);
@@ -919,6 +919,7 @@ _readAlterTableCmd(void)
 	READ_BOOL_FIELD(missing_ok);
 
 	READ_INT_FIELD(backendId);
+	READ_BOOL_FIELD(expandInPlace);
 	READ_NODE_FIELD(policy);
 
 	READ_DONE();
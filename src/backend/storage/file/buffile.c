@@ -52,6 +52,7 @@
 #include "storage/fd.h"
 #include "storage/buffile.h"
 #include "storage/buf_internals.h"
+#include "storage/bufmgr.h"
 #include "utils/resowner.h"
 
 #include "storage/gp_compress.h"
@@ -66,6 +67,16 @@
 #define MAX_PHYSICAL_FILESIZE	0x40000000 
 #define BUFFILE_SEG_SIZE		(MAX_PHYSICAL_FILESIZE / BLCKSZ)
 
+/*
+ * GPDB: written data is handed to the kernel writeback, and dropped from the
+ * OS page cache, in windows of this size when gp_workfile_bypass_page_cache
+ * is on.  The spill bandwidth is reported to the workfile set at the same
+ * granularity.
+ */
+#define BUFFILE_WRITEBACK_WINDOW	(1024 * 1024)
+
+bool		gp_workfile_bypass_page_cache = false;	/* GUC */
+
 /* To align upstream's structure, minimize the code differences */
 typedef union FakeAlignedBlock
 {
@@ -122,6 +133,27 @@ struct BufFile
 	int64		nbytes;			/* total # of valid bytes in buffer */
 	FakeAlignedBlock buffer;	/* GPDB: PG upstream uses PGAlignedBlock */
 
+	/*
+	 * GPDB: written ranges not dropped from the OS page cache yet, see
+	 * BufFileAdviseWritten().  'wb' is the range still growing, 'drop' the
+	 * previous window, whose writeback has been started.  The file index is
+	 * -1 if there's no such range.
+	 */
+	int			wbFile;
+	off_t		wbStart;
+	off_t		wbEnd;
+	int			dropFile;
+	off_t		dropStart;
+	off_t		dropEnd;
+
+	/*
+	 * GPDB: bytes written and time spent, not yet reported to work_set.  The
+	 * time is only measured with track_io_timing.
+	 */
+	int64		writeBytes;
+	int64		writeUsecs;
+	bool		writeReported;	/* reported anything yet? */
+
 	/*
 	 * Current stage, if this is a sequential BufFile. A sequential BufFile
 	 * can be written to once, and read once after that. Without compression,
@@ -158,6 +190,9 @@ static BufFile *makeBufFile(File firstfile, const char *operation_name);
 static void extendBufFile(BufFile *file);
 static void BufFileLoadBuffer(BufFile *file);
 static void BufFileDumpBuffer(BufFile *file);
+static void BufFileAdviseWritten(BufFile *file, int fileno, off_t offset, int nbytes);
+static void BufFileDropWritten(BufFile *file);
+static void BufFileReportWriteStats(BufFile *file);
 static int	BufFileFlush(BufFile *file);
 static File MakeNewSharedSegment(BufFile *file, int segment);
 
@@ -183,6 +218,8 @@ makeBufFileCommon(int nfiles)
 	file->pos = 0;
 	file->nbytes = 0;
 	file->buffer.data = palloc(BLCKSZ);
+	file->wbFile = -1;
+	file->dropFile = -1;
 
 	return file;
 }
@@ -502,6 +539,8 @@ BufFileClose(BufFile *file)
 
 	/* flush any unwritten data */
 	BufFileFlush(file);
+	/* the workfile set might go away with the last file */
+	BufFileReportWriteStats(file);
 	/* close and delete the underlying file(s) */
 	for (i = 0; i < file->numFiles; i++)
 		FileClose(file->files[i]);
@@ -543,6 +582,10 @@ BufFileLoadBuffer(BufFile *file)
 		file->curOffset = 0L;
 	}
 
+	/* we are reading now, forget the written data */
+	if (file->wbFile >= 0 || file->dropFile >= 0)
+		BufFileDropWritten(file);
+
 	/*
 	 * Read whatever we can get, up to a full bufferload.
 	 */
@@ -557,7 +600,14 @@ BufFileLoadBuffer(BufFile *file)
 	/* we choose not to advance curOffset here */
 
 	if (file->nbytes > 0)
+	{
 		pgBufferUsage.temp_blks_read++;
+
+		/* the data is in our buffer now, don't keep it in the page cache */
+		if (gp_workfile_bypass_page_cache)
+			FileDropCache(thisfile, file->curOffset, file->nbytes,
+						  WAIT_EVENT_BUFFILE_READ);
+	}
 }
 
 /*
@@ -573,6 +623,8 @@ BufFileDumpBuffer(BufFile *file)
 	int			wpos = 0;
 	int			bytestowrite;
 	File		thisfile;
+	instr_time	start;
+	instr_time	duration;
 
 	/*
 	 * Unlike BufFileLoadBuffer, we must dump the whole buffer even if it
@@ -603,6 +655,8 @@ BufFileDumpBuffer(BufFile *file)
 			bytestowrite = (int) availbytes;
 
 		thisfile = file->files[file->curFile];
+		if (track_io_timing)
+			INSTR_TIME_SET_CURRENT(start);
 		bytestowrite = FileWrite(thisfile,
 								 file->buffer.data + wpos,
 								 bytestowrite,
@@ -610,6 +664,16 @@ BufFileDumpBuffer(BufFile *file)
 								 WAIT_EVENT_BUFFILE_WRITE);
 		if (bytestowrite <= 0)
 			return;				/* failed to write */
+		if (track_io_timing)
+		{
+			INSTR_TIME_SET_CURRENT(duration);
+			INSTR_TIME_SUBTRACT(duration, start);
+			file->writeUsecs += INSTR_TIME_GET_MICROSEC(duration);
+		}
+
+		file->writeBytes += bytestowrite;
+		BufFileAdviseWritten(file, file->curFile, file->curOffset, bytestowrite);
+
 		file->curOffset += bytestowrite;
 		wpos += bytestowrite;
 
@@ -617,6 +681,13 @@ BufFileDumpBuffer(BufFile *file)
 	}
 	file->dirty = false;
 
+	/*
+	 * Report the first write of each file right away, so that the workfile
+	 * set shows what it has written before its files fill a window.
+	 */
+	if (file->writeBytes >= BUFFILE_WRITEBACK_WINDOW || !file->writeReported)
+		BufFileReportWriteStats(file);
+
 	/*
 	 * At this point, curOffset has been advanced to the end of the buffer,
 	 * ie, its original value + nbytes.  We need to make it point to the
@@ -638,6 +709,90 @@ BufFileDumpBuffer(BufFile *file)
 	file->nbytes = 0;
 }
 
+/*
+ * BufFileAdviseWritten
+ *
+ * GPDB: keep the written data of a workfile out of the OS page cache, which
+ * is better used for the table data.
+ *
+ * Contiguous writes are collected into windows of BUFFILE_WRITEBACK_WINDOW
+ * bytes.  When a window is full its writeback is started, which doesn't
+ * wait for the I/O, so the operator can keep producing, and the previous
+ * window, which should have been written back by then, is dropped from the
+ * page cache.
+ */
+static void
+BufFileAdviseWritten(BufFile *file, int fileno, off_t offset, int nbytes)
+{
+	if (!gp_workfile_bypass_page_cache)
+		return;
+
+	/* not contiguous with the pending range, start a new one */
+	if (fileno != file->wbFile || offset != file->wbEnd)
+	{
+		BufFileDropWritten(file);
+		file->wbFile = fileno;
+		file->wbStart = offset;
+	}
+	file->wbEnd = offset + nbytes;
+
+	if (file->wbEnd - file->wbStart < BUFFILE_WRITEBACK_WINDOW)
+		return;
+
+	if (file->dropFile >= 0)
+		FileDropCache(file->files[file->dropFile], file->dropStart,
+					  file->dropEnd - file->dropStart, WAIT_EVENT_BUFFILE_WRITE);
+
+	FileStartWriteback(file->files[file->wbFile], file->wbStart,
+					   file->wbEnd - file->wbStart, WAIT_EVENT_BUFFILE_WRITE);
+
+	file->dropFile = file->wbFile;
+	file->dropStart = file->wbStart;
+	file->dropEnd = file->wbEnd;
+	file->wbStart = file->wbEnd;
+}
+
+/*
+ * BufFileDropWritten
+ *
+ * Drop all the written ranges tracked by BufFileAdviseWritten() from the
+ * page cache.  Pages still dirty are only scheduled for writeback.
+ */
+static void
+BufFileDropWritten(BufFile *file)
+{
+	if (file->dropFile >= 0)
+		FileDropCache(file->files[file->dropFile], file->dropStart,
+					  file->dropEnd - file->dropStart, WAIT_EVENT_BUFFILE_WRITE);
+
+	if (file->wbFile >= 0)
+		FileDropCache(file->files[file->wbFile], file->wbStart,
+					  file->wbEnd - file->wbStart, WAIT_EVENT_BUFFILE_WRITE);
+
+	file->dropFile = -1;
+	file->wbFile = -1;
+}
+
+/*
+ * BufFileReportWriteStats
+ *
+ * GPDB: add the bytes written and the time spent on writing them to the
+ * workfile set, for the spill bandwidth in gp_toolkit.gp_workfile_entries.
+ */
+static void
+BufFileReportWriteStats(BufFile *file)
+{
+	if (file->writeBytes == 0)
+		return;
+
+	if (file->work_set != NULL)
+		WorkFileAddWriteStats(file->work_set, file->writeBytes, file->writeUsecs);
+
+	file->writeBytes = 0;
+	file->writeUsecs = 0;
+	file->writeReported = true;
+}
+
 /*
  * BufFileRead
  *
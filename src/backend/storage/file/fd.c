@@ -2049,6 +2049,78 @@ FileWriteback(File file, off_t offset, off_t nbytes, uint32 wait_event_info)
 	pgstat_report_wait_end();
 }
 
+/*
+ * FileStartWriteback --- start writeback of dirty data without waiting
+ *
+ * Unlike FileWriteback() this is done even if fsync is disabled, as the
+ * purpose is not to spread out the cost of a later fsync but to get the
+ * pages clean, so that FileDropCache() can evict them.  Only temporary
+ * files use this, see buffile.c.
+ */
+void
+FileStartWriteback(File file, off_t offset, off_t nbytes, uint32 wait_event_info)
+{
+#if defined(HAVE_SYNC_FILE_RANGE)
+	int			returnCode;
+
+	Assert(FileIsValid(file));
+
+	DO_DB(elog(LOG, "FileStartWriteback: %d (%s) " INT64_FORMAT " " INT64_FORMAT,
+			   file, VfdCache[file].fileName,
+			   (int64) offset, (int64) nbytes));
+
+	if (nbytes <= 0)
+		return;
+
+	returnCode = FileAccess(file);
+	if (returnCode < 0)
+		return;
+
+	/* this is just a hint, errors are ignored */
+	pgstat_report_wait_start(wait_event_info);
+	(void) sync_file_range(VfdCache[file].fd, offset, nbytes,
+						   SYNC_FILE_RANGE_WRITE);
+	pgstat_report_wait_end();
+#else
+	Assert(FileIsValid(file));
+#endif
+}
+
+/*
+ * FileDropCache --- advise the kernel the data is not needed in the cache
+ *
+ * Clean pages in the range are evicted from the OS page cache, dirty ones
+ * are scheduled for writeback.
+ */
+void
+FileDropCache(File file, off_t offset, off_t nbytes, uint32 wait_event_info)
+{
+#if defined(USE_POSIX_FADVISE) && defined(POSIX_FADV_DONTNEED)
+	int			returnCode;
+
+	Assert(FileIsValid(file));
+
+	DO_DB(elog(LOG, "FileDropCache: %d (%s) " INT64_FORMAT " " INT64_FORMAT,
+			   file, VfdCache[file].fileName,
+			   (int64) offset, (int64) nbytes));
+
+	if (nbytes <= 0)
+		return;
+
+	returnCode = FileAccess(file);
+	if (returnCode < 0)
+		return;
+
+	/* this is just a hint, errors are ignored */
+	pgstat_report_wait_start(wait_event_info);
+	(void) posix_fadvise(VfdCache[file].fd, offset, nbytes,
+						 POSIX_FADV_DONTNEED);
+	pgstat_report_wait_end();
+#else
+	Assert(FileIsValid(file));
+#endif
+}
+
 int
 FileRead(File file, char *buffer, int amount, off_t offset,
 		 uint32 wait_event_info)
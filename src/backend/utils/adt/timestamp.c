@@ -2464,6 +2464,7 @@ timestamp_cmp(PG_FUNCTION_ARGS)
 }
 
 /* note: this is used for timestamptz also */
+#ifndef USE_FLOAT8_BYVAL
 static int
 timestamp_fastcmp(Datum x, Datum y, SortSupport ssup)
 {
@@ -2472,13 +2473,19 @@ timestamp_fastcmp(Datum x, Datum y, SortSupport ssup)
 
 	return timestamp_cmp_internal(a, b);
 }
+#endif
 
 Datum
 timestamp_sortsupport(PG_FUNCTION_ARGS)
 {
 	SortSupport ssup = (SortSupport) PG_GETARG_POINTER(0);
 
+#ifdef USE_FLOAT8_BYVAL
+	/* timestamp_cmp_internal() is a plain int64 comparison */
+	ssup->comparator = ssup_datum_signed_cmp;
+#else
 	ssup->comparator = timestamp_fastcmp;
+#endif
 	PG_RETURN_VOID();
 }
 
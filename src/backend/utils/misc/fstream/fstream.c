@@ -25,7 +25,6 @@
 #endif
 
 #define FILE_ERROR_SZ 200
-char* format_error(char* c1, char* c2);
 
 typedef struct
 {
@@ -46,9 +45,47 @@ struct fstream_t
 	char* 			buffer;			 /* buffer to store data read from file */
 	int 			buffer_cur_size; /* number of bytes in buffer currently */
 	const char*		ferror; 		 /* error string */
+	char			ferror_buf[FILE_ERROR_SZ]; /* storage for formatted ferror */
 	struct fstream_options options;
+
+	/*
+	 * Byte range of the current file when reading only a share of it, see
+	 * split_current_file(). split_end is -1 if the file is read whole.
+	 * Lines are then numbered from the start of the range, split_start.
+	 */
+	int64_t 		split_start;
+	int64_t 		split_pos;		 /* file offset of the next byte to read */
+	int64_t 		split_end;
+	char			split_eol;
+	int 			split_seek_line; /* still looking for the first line start */
+	int 			split_done;		 /* read the last line of the range */
 };
 
+static const char *format_error(fstream_t *fs, const char *c1, const char *c2);
+static int nextFile(fstream_t *fs);
+static int split_current_file(fstream_t *fs);
+
+/*
+ * Returns a pointer to the last occurrence of byte 'c' in [start, start+len),
+ * or NULL. gpfdist calls this on every block it sends, so use the C library's
+ * vectorized memrchr() where there is one.
+ */
+static char *find_last_byte(const char *start, size_t len, char c)
+{
+#ifdef __GLIBC__
+	return memrchr(start, c, len);
+#else
+	const char *p;
+
+	for (p = start + len; start <= --p;)
+	{
+		if (*p == c)
+			return (char*)p;
+	}
+	return NULL;
+#endif
+}
+
 /*
  * Returns a pointer to the end of the last delimiter occurrence,
  * or the start pointer if delimiter doesn't appear.
@@ -59,16 +96,18 @@ static char *find_last_eol_delim (const char *start, const int size,
 								  const char *delimiter, const int delimiter_length)
 {
 	char* p;
+	size_t	len;
 
 	if (size <= delimiter_length)
 		return (char*)start - 1;
 
-	for (p = (char*)start + size - delimiter_length; start <= p; p--)
+	/* only look closer at the positions where the first byte matches */
+	len = size - delimiter_length + 1;
+	while ((p = find_last_byte(start, len, delimiter[0])) != NULL)
 	{
 		if (memcmp(p, delimiter, delimiter_length) == 0)
-		{
 			return (char*)p + delimiter_length - 1;
-		}
+		len = p - start;
 	}
 	return (char*)start - 1;
 }
@@ -612,9 +651,148 @@ fstream_open(const char *path, const struct fstream_options *options,
 	fs->line_number = 1;
 	fs->skip_header_line = options->header;
 
+	/* a reader with a share of the files may have to skip the first one */
+	i = split_current_file(fs);
+	if (i > 0)
+		i = nextFile(fs) ? -1 : 0;
+	if (i < 0)
+	{
+		*response_string = "unable to read file";
+		gfile_printf_then_putc_newline("fstream unable to read files");
+		fstream_close(fs);
+		return 0;
+	}
+
 	return fs;
 }
 
+/*
+ * split_current_file
+ *
+ * Prepare the file just opened for a reader that reads only its share,
+ * split_index out of split_count, of the data. A plain file is cut into
+ * split_count byte ranges of the same size, and the reader gets the lines
+ * that start in its range, numbered from the first of them. Counting the
+ * lines before the range would mean reading the whole file in every reader,
+ * so errors report the offset of the range along with the line number in
+ * it. Files that can't be repositioned are read whole, each by one of the
+ * readers.
+ *
+ * return 1 if this reader has nothing to read in the file.
+ * return -1 if the file could not be positioned.
+ * return 0 otherwise.
+ */
+static int split_current_file(fstream_t *fs)
+{
+	int		index = fs->options.split_index;
+	int		count = fs->options.split_count;
+	int64_t	size;
+	int64_t	start;
+
+	fs->split_start = 0;
+	fs->split_end = -1;
+
+	if (count <= 1)
+		return 0;
+
+	if (!gfile_is_seekable(&fs->fd))
+		return fs->fidx % count != index;
+
+	size = gfile_get_compressed_size(&fs->fd);
+	start = size * index / count;
+
+	fs->split_pos = 0;
+	fs->split_end = size * (index + 1) / count;
+	fs->split_eol = fs->options.eol_type == EOL_CR ? '\r' : '\n';
+	fs->split_seek_line = 0;
+	fs->split_done = (start == fs->split_end);
+
+	if (start > 0)
+	{
+		/*
+		 * Start at the byte before the range, so that a line starting right
+		 * at 'start' is found as the one after an end of line. The header,
+		 * if any, is in the first range.
+		 */
+		if (gfile_seek(&fs->fd, start - 1))
+			return -1;
+
+		fs->split_start = start;
+		fs->split_pos = start - 1;
+		fs->split_seek_line = 1;
+		fs->skip_header_line = 0;
+	}
+
+	return 0;
+}
+
+/*
+ * read_current_file
+ *
+ * Read from the current file like gfile_read(). If only a byte range of the
+ * file is ours, the partial line before the range is dropped, and reading
+ * stops after the end of line that terminates the last line starting in the
+ * range.
+ */
+static ssize_t read_current_file(fstream_t *fs, char *dest, size_t len)
+{
+	if (fs->split_end < 0)
+		return gfile_read(&fs->fd, dest, len);
+
+	while (!fs->split_done)
+	{
+		int64_t	pos = fs->split_pos;
+		int64_t	first = 0;
+		int64_t	last;
+		int64_t	from;
+		char   *p;
+		ssize_t	n = gfile_read(&fs->fd, dest, len);
+
+		if (n <= 0)
+			return n;
+
+		fs->split_pos += n;
+		last = n;
+
+		if (fs->split_seek_line)
+		{
+			p = memchr(dest, fs->split_eol, n);
+			if (!p)
+				continue;
+
+			first = p + 1 - dest;
+			fs->split_seek_line = 0;
+
+			if (pos + first >= fs->split_end)
+			{
+				fs->split_done = 1;
+				break;
+			}
+		}
+
+		/* an end of line at or past split_end - 1 ends our last line */
+		from = Max(first, fs->split_end - 1 - pos);
+		if (from < n)
+		{
+			p = memchr(dest + from, fs->split_eol, n - from);
+			if (p)
+			{
+				last = p + 1 - dest;
+				fs->split_done = 1;
+			}
+		}
+
+		if (last > first)
+		{
+			if (first > 0)
+				memmove(dest, dest + first, last - first);
+			return last - first;
+		}
+	}
+
+	return 0;
+}
+
 /*
  * Updates the currently used filename and line number and offset. Since we
  * may be reading from more than 1 file, we need to be up to date all the time.
@@ -626,6 +804,7 @@ static void updateCurFileState(fstream_t* fs,
 	{
 		fo->foff = fs->foff;
 		fo->line_number = fs->line_number;
+		fo->split_start = fs->split_start;
 		strncpy(fo->fname, fs->glob.gl_pathv[fs->fidx], sizeof fo->fname);
 		fo->fname[sizeof fo->fname - 1] = 0;
 	}
@@ -663,6 +842,19 @@ static int nextFile(fstream_t*fs)
 			fs->ferror = "unable to open file";
 			return 1;
 		}
+
+		switch (split_current_file(fs))
+		{
+			case 0:
+				break;
+			case 1:
+				return nextFile(fs);
+			default:
+				gfile_printf_then_putc_newline("fstream unable to seek file %s",
+												fs->glob.gl_pathv[fs->fidx]);
+				fs->ferror = "unable to seek file";
+				return 1;
+		}
 	}
 
 	return 0;
@@ -672,18 +864,19 @@ static int nextFile(fstream_t*fs)
  * format_error
  * enables addition of string parameters to the const char* error message in fstream_t
  * while enabling the calling functions not to worry about freeing memory - which is 
- * the present behaviour
+ * the present behaviour. The message is kept in the fstream itself, so streams that
+ * are read from different threads (gpfdist --readahead) don't clobber each other.
  */
-char* format_error(char* c1, char* c2)
+static const char *format_error(fstream_t *fs, const char *c1, const char *c2)
 {
 	int len1, len2;
 	
-	static char err_msg[FILE_ERROR_SZ];
+	char* err_msg = fs->ferror_buf;
 	memset(err_msg, 0, FILE_ERROR_SZ);
 	
 	len1 = strlen(c1);
 	len2 = strlen(c2);
-	if ( (len1 + len2) > FILE_ERROR_SZ )
+	if ( (len1 + len2) >= FILE_ERROR_SZ )
 	{
 		gfile_printf_then_putc_newline("cannot read file");
 		return "cannot read file";
@@ -716,7 +909,7 @@ int fstream_read(fstream_t *fs,
 				 const int line_delim_length)
 {
 	int buffer_capacity = fs->options.bufsize;
-	static char err_buf[FILE_ERROR_SZ] = {0};
+	char *err_buf = fs->ferror_buf;
 	
 	if (fs->ferror)
 		return -1;
@@ -745,11 +938,11 @@ int fstream_read(fstream_t *fs,
 			 * read data from the source file and fill up the file stream buffer
 			 */
 			len = buffer_capacity - fs->buffer_cur_size;
-			bytesread = gfile_read(&fs->fd, q, len);
+			bytesread = read_current_file(fs, q, len);
 
 			if (bytesread < 0)
 			{
-				fs->ferror = format_error("cannot read file - ", fs->glob.gl_pathv[fs->fidx]);
+				fs->ferror = format_error(fs, "cannot read file - ", fs->glob.gl_pathv[fs->fidx]);
 				return -1;
 			}
 
@@ -831,11 +1024,11 @@ int fstream_read(fstream_t *fs,
 			}
 
 			/* read more data from source file into destination buffer */
-			bytesread2 = gfile_read(&fs->fd, (char*) dest + total_bytes, size - total_bytes);
+			bytesread2 = read_current_file(fs, (char*) dest + total_bytes, size - total_bytes);
 
 			if (bytesread2 < 0)
 			{
-				fs->ferror = format_error("cannot read file - ", fs->glob.gl_pathv[fs->fidx]);
+				fs->ferror = format_error(fs, "cannot read file - ", fs->glob.gl_pathv[fs->fidx]);
 				return -1;
 			}
 
@@ -890,11 +1083,10 @@ int fstream_read(fstream_t *fs,
 				}
 				else
 				{
-					for (p = (char*)dest + size; (char*)dest <= --p && *p != '\n';)
-						;
+					p = find_last_byte((char*)dest, size, '\n');
 				}
 
-				p = (char*)dest <= p ? p + 1 : 0;
+				p = p && (char*)dest <= p ? p + 1 : 0;
 				fs->line_number = 0;
 			}
 
@@ -904,10 +1096,10 @@ int fstream_read(fstream_t *fs,
 			if (!p || (char*)dest + size >= p + buffer_capacity)
 			{
 #ifdef WIN32
-				snprintf(err_buf, sizeof(err_buf)-1, "line too long in file %s near (%ld bytes)",
+				snprintf(err_buf, FILE_ERROR_SZ, "line too long in file %s near (%ld bytes)",
 						 fs->glob.gl_pathv[fs->fidx], (long) fs->foff);
 #else
-				snprintf(err_buf, sizeof(err_buf)-1, "line too long in file %s near (%lld bytes)",
+				snprintf(err_buf, FILE_ERROR_SZ, "line too long in file %s near (%lld bytes)",
 						 fs->glob.gl_pathv[fs->fidx], (long long) fs->foff);
 #endif
 				fs->ferror = err_buf;
@@ -949,11 +1141,11 @@ int fstream_read(fstream_t *fs,
 			return total_bytes;
 		}
 
-		bytesread = gfile_read(&fs->fd, dest, size);
+		bytesread = read_current_file(fs, dest, size);
 
 		if (bytesread < 0)
 		{
-			fs->ferror = format_error("cannot read file - ", fs->glob.gl_pathv[fs->fidx]);
+			fs->ferror = format_error(fs, "cannot read file - ", fs->glob.gl_pathv[fs->fidx]);
 			
 			return -1;
 		}
@@ -24,6 +24,9 @@
 #include <stdio.h>
 
 #include <fstream/gfile.h>
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
 #ifdef GPFXDIST
 #include <gpfxdist.h>
 #endif
@@ -146,6 +149,7 @@ struct bzlib_stuff
 {
 	bz_stream s;
 	int in_size, out_size, eof;
+	int new_stream;		/* decompressor was restarted, no input seen yet */
 	char in[COMPRESSION_BUFFER_SIZE];
 	char out[COMPRESSION_BUFFER_SIZE];
 };
@@ -186,14 +190,43 @@ bz_file_read(gfile_t *fd, void *ptr, size_t len)
 		
 		z->s.avail_in = s = z->in + z->in_size - z->s.next_in;
 		z->s.avail_out = sizeof z->out;
+
+		if (z->new_stream && s == 0)
+		{
+			/* the previous stream was the last one */
+			z->eof = 1;
+			continue;
+		}
+		z->new_stream = 0;
+
 		e = BZ2_bzDecompress(&z->s);
 		
-		if (e == BZ_STREAM_END)
+		if (e == BZ_STREAM_END && z->s.avail_in == 0 && z->in_size < sizeof z->in)
 			z->eof = 1;
+		else if (e == BZ_STREAM_END)
+		{
+			/*
+			 * End of one stream, but there may be more input: parallel
+			 * compressors such as pbzip2 write concatenated streams. Start
+			 * over with a fresh decompressor, keeping the unconsumed input.
+			 */
+			char   *next_in = z->s.next_in;
+			unsigned int avail_in = z->s.avail_in;
+			char   *next_out = z->s.next_out;
+			unsigned int avail_out = z->s.avail_out;
+
+			if (BZ2_bzDecompressEnd(&z->s) != BZ_OK ||
+				BZ2_bzDecompressInit(&z->s, 0, 0) != BZ_OK)
+				return -1;
+			z->s.next_in = next_in;
+			z->s.avail_in = avail_in;
+			z->s.next_out = next_out;
+			z->s.avail_out = avail_out;
+			z->new_stream = 1;
+		}
 		else if (e)
 			return -1;
-		
-		if (z->s.avail_out == sizeof z->out && z->s.avail_in == s)
+		else if (z->s.avail_out == sizeof z->out && z->s.avail_in == s)
 			return -1;
 		
 		if (z->s.next_in == z->in + z->in_size)
@@ -501,6 +534,118 @@ gz_file_open(gfile_t *fd)
 }
 #endif
 
+#ifdef USE_ZSTD
+/* ZSTD */
+struct zstd_stuff
+{
+	ZSTD_DCtx  *dctx;
+	ZSTD_inBuffer in;
+	ZSTD_outBuffer out;
+	size_t		out_size;	/* bytes of 'out' already returned */
+	size_t		last_ret;	/* last ZSTD_decompressStream() result, 0 at end of frame */
+	int			eof;
+	char		inbuf[COMPRESSION_BUFFER_SIZE];
+	char		outbuf[COMPRESSION_BUFFER_SIZE];
+};
+
+static ssize_t
+zstd_file_read(gfile_t *fd, void *ptr, size_t len)
+{
+	struct zstd_stuff *z = fd->u.zstd;
+
+	for (;;)
+	{
+		size_t		s = z->out.pos - z->out_size;
+		size_t		ret;
+
+		if (s > 0 || z->eof)
+		{
+			if (s > len)
+				s = len;
+			memcpy(ptr, z->outbuf + z->out_size, s);
+			z->out_size += s;
+			return s;
+		}
+
+		/*
+		 * Only fetch more input once the decoder had room to spare last
+		 * time, otherwise it may still be holding output for us.
+		 */
+		if (z->in.pos == z->in.size && z->out.pos < z->out.size)
+		{
+			ssize_t		n = read_and_retry(fd, z->inbuf, sizeof z->inbuf);
+
+			if (n < 0)
+				return -1;
+			if (n == 0)
+			{
+				/*
+				 * A .zst file may hold any number of frames (zstd -T, pzstd
+				 * and the seekable format all write several), but it must
+				 * not end in the middle of one.
+				 */
+				if (z->last_ret != 0)
+				{
+					gfile_printf_then_putc_newline("zstd: unexpected end of file");
+					return -1;
+				}
+				z->eof = 1;
+				continue;
+			}
+			z->in.size = n;
+			z->in.pos = 0;
+		}
+
+		z->out.pos = 0;
+		z->out_size = 0;
+
+		ret = ZSTD_decompressStream(z->dctx, &z->out, &z->in);
+		if (ZSTD_isError(ret))
+		{
+			gfile_printf_then_putc_newline("zstd decompression failed: %s",
+										   ZSTD_getErrorName(ret));
+			return -1;
+		}
+		z->last_ret = ret;
+	}
+}
+
+static int
+zstd_file_close(gfile_t *fd)
+{
+	ZSTD_freeDCtx(fd->u.zstd->dctx);
+	gfile_free(fd->u.zstd);
+
+	return 0;
+}
+
+static int
+zstd_file_open(gfile_t *fd)
+{
+	if (!(fd->u.zstd = gfile_malloc(sizeof *fd->u.zstd)))
+	{
+		gfile_printf_then_putc_newline("Out of memory");
+		return 1;
+	}
+
+	memset(fd->u.zstd, 0, sizeof *fd->u.zstd);
+	if (!(fd->u.zstd->dctx = ZSTD_createDCtx()))
+	{
+		gfile_printf_then_putc_newline("ZSTD_createDCtx failed");
+		gfile_free(fd->u.zstd);
+		return 1;
+	}
+
+	fd->u.zstd->in.src = fd->u.zstd->inbuf;
+	fd->u.zstd->out.dst = fd->u.zstd->outbuf;
+	fd->u.zstd->out.size = sizeof fd->u.zstd->outbuf;
+	fd->read = zstd_file_read;
+	fd->close = zstd_file_close;
+
+	return 0;
+}
+#endif
+
 #ifdef GPFXDIST
 /*
  * subprocess support
@@ -982,6 +1127,18 @@ int gfile_open(gfile_t* fd, const char* fpath, int flags, int* response_code, co
 		return bz_file_open(fd);
 #endif
 	}
+#ifdef USE_ZSTD
+	else if (s && strcasecmp(s,".zst")==0 && flags == GFILE_OPEN_FOR_READ)
+	{
+		/*
+		 * Writable tables don't compress .zst targets, they are written as
+		 * plain files, which is also how any .zst file is handled by builds
+		 * without zstd.
+		 */
+		fd->compression = ZSTD_COMPRESSION;
+		return zstd_file_open(fd);
+	}
+#endif
 	else if (s && strcasecmp(s,".z") == 0)
 		gfile_printf_then_putc_newline("gfile compression .z file is not supported");
 	else if (s && strcasecmp(s,".zip") == 0)
@@ -1015,7 +1172,7 @@ gfile_close(gfile_t*fd)
 		 * for the compressed data implementation we need to call the "close" callback. Other implementations
 		 * didn't use to call this callback here and it will remain so.
 		 */
-		if (  fd->compression == GZ_COMPRESSION ) 
+		if (  fd->compression == GZ_COMPRESSION || fd->compression == ZSTD_COMPRESSION ) 
 		{
 			fd->close(fd);
 		}
@@ -1106,3 +1263,27 @@ off_t gfile_get_compressed_position(gfile_t *fd)
 {
 	return fd->compressed_position;
 }
+
+/*
+ * Can the read position of the file be moved with gfile_seek()? Only plain
+ * uncompressed files can, not pipes or transformed or compressed sources.
+ */
+bool_t gfile_is_seekable(gfile_t *fd)
+{
+	return fd->read == read_and_retry &&
+		fd->compression == NO_COMPRESSION &&
+		lseek(fd->fd.filefd, 0, SEEK_CUR) >= 0;
+}
+
+/*
+ * Move the read position of a seekable file to 'offset'. Returns 0 on
+ * success, -1 on failure.
+ */
+int gfile_seek(gfile_t *fd, off_t offset)
+{
+	if (lseek(fd->fd.filefd, offset, SEEK_SET) < 0)
+		return -1;
+
+	fd->compressed_position = offset;
+	return 0;
+}
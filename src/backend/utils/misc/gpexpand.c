@@ -13,6 +13,7 @@
 
 #include "postgres.h"
 
+#include "access/relation.h"
 #include "catalog/gp_configuration_history.h"
 #include "catalog/pg_auth_time_constraint.h"
 #include "catalog/pg_description.h"
@@ -21,11 +22,13 @@
 #include "catalog/pg_stat_last_operation.h"
 #include "catalog/pg_stat_last_shoperation.h"
 #include "catalog/pg_statistic.h"
+#include "cdb/cdbhash.h"
 #include "cdb/cdbutil.h"
 #include "cdb/cdbvars.h"
 #include "postmaster/fts.h"
 #include "storage/lock.h"
 #include "utils/builtins.h"
+#include "utils/lsyscache.h"
 #include "utils/rel.h"
 #include "utils/relcache.h"
 #include "utils/gpexpand.h"
@@ -84,6 +87,80 @@ gp_expand_bump_version(PG_FUNCTION_ARGS)
 	PG_RETURN_VOID();
 }
 
+/*
+ * gp_expand_target_segment(rel regclass, numsegments int4, VARIADIC "any")
+ *
+ * Return the segment a row of hash distributed table 'rel' with the given
+ * distribution key values belongs to, when the table is distributed across
+ * 'numsegments' segments.  The in-place EXPAND TABLE uses it to find the rows
+ * that have to move.
+ */
+Datum
+gp_expand_target_segment(PG_FUNCTION_ARGS)
+{
+	CdbHash    *h = (CdbHash *) fcinfo->flinfo->fn_extra;
+	int			i;
+
+	if (PG_ARGISNULL(0) || PG_ARGISNULL(1))
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+				 errmsg("relation and number of segments must not be null")));
+
+	if (h == NULL)
+	{
+		Oid			relid = PG_GETARG_OID(0);
+		int			numsegments = PG_GETARG_INT32(1);
+		int			nkeys = PG_NARGS() - 2;
+		Relation	rel;
+		GpPolicy   *policy;
+		Oid		   *hashfuncs;
+		MemoryContext oldcontext;
+
+		if (numsegments <= 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("number of segments must be greater than zero")));
+
+		rel = relation_open(relid, AccessShareLock);
+		policy = rel->rd_cdbpolicy;
+
+		if (!GpPolicyIsHashPartitioned(policy))
+			ereport(ERROR,
+					(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+					 errmsg("\"%s\" is not a hash distributed table",
+							RelationGetRelationName(rel))));
+		if (nkeys != policy->nattrs)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("\"%s\" has %d distribution key columns, got %d values",
+							RelationGetRelationName(rel), policy->nattrs, nkeys)));
+
+		oldcontext = MemoryContextSwitchTo(fcinfo->flinfo->fn_mcxt);
+
+		hashfuncs = palloc(nkeys * sizeof(Oid));
+		for (i = 0; i < nkeys; i++)
+		{
+			Oid			typeoid = get_fn_expr_argtype(fcinfo->flinfo, i + 2);
+			Oid			opfamily = get_opclass_family(policy->opclasses[i]);
+
+			hashfuncs[i] = cdb_hashproc_in_opfamily(opfamily, typeoid);
+		}
+		h = makeCdbHash(numsegments, nkeys, hashfuncs);
+
+		MemoryContextSwitchTo(oldcontext);
+
+		relation_close(rel, AccessShareLock);
+
+		fcinfo->flinfo->fn_extra = h;
+	}
+
+	cdbhashinit(h);
+	for (i = 0; i < h->natts; i++)
+		cdbhash(h, i + 1, PG_GETARG_DATUM(i + 2), PG_ARGISNULL(i + 2));
+
+	PG_RETURN_INT32(cdbhashreduce(h));
+}
+
 /*
  * Lock the catalog lock in exclusive mode.
  *
@@ -255,8 +255,11 @@ bool		gp_enable_agg_distinct = true;
 bool		gp_enable_dqa_pruning = true;
 bool		gp_dynamic_partition_pruning = true;
 bool		gp_log_dynamic_partition_pruning = false;
+int			gp_dynamic_scan_prefetch_partitions = 0;
 bool		gp_cte_sharing = false;
 bool		gp_enable_relsize_collection = false;
+bool		gp_enable_radix_sort = true;
+bool		gp_enable_window_sliding_agg = true;
 bool		gp_recursive_cte = true;
 
 /* Optimizer related gucs */
@@ -395,22 +398,29 @@ static char *gp_server_version_string;
 
 /* Query Metrics */
 bool		gp_enable_query_metrics = false;
+bool		gp_enable_query_metrics_timing = false;
 int			gp_instrument_shmem_size = 5120;
 
 /* Security */
 bool		gp_reject_internal_tcp_conn = true;
 
+/* gpexpand */
+bool		gp_expand_in_place = false;
+
 /* copy */
 bool		gp_enable_segment_copy_checking = true;
+int			gp_copy_dispatch_chunk_size = 0;
 /*
  * Default storage options GUC.  Value is comma-separated name=value
  * pairs.  E.g. "appendonly=true,orientation=column"
  */
 char	   *gp_default_storage_options = NULL;
 
-int			writable_external_table_bufsize = 64;
+int			writable_external_table_bufsize = 1024;
+int			writable_external_table_compression = WRITABLE_EXTERNAL_TABLE_COMPRESSION_NONE;
 
 bool		gp_external_enable_filter_pushdown = true;
+bool		gp_external_enable_file_split = false;
 
 /* Enable GDD */
 bool		gp_enable_global_deadlock_detector = false;
@@ -505,6 +515,15 @@ static const struct config_enum_entry gp_interconnect_types[] = {
 	{NULL, 0}
 };
 
+static const struct config_enum_entry writable_external_table_compression_options[] = {
+	{"none", WRITABLE_EXTERNAL_TABLE_COMPRESSION_NONE},
+	{"zlib", WRITABLE_EXTERNAL_TABLE_COMPRESSION_ZLIB},
+#ifdef USE_ZSTD
+	{"zstd", WRITABLE_EXTERNAL_TABLE_COMPRESSION_ZSTD},
+#endif
+	{NULL, 0}
+};
+
 static const struct config_enum_entry gp_log_verbosity[] = {
 	{"terse", GPVARS_VERBOSITY_TERSE},
 	{"off", GPVARS_VERBOSITY_OFF},
@@ -761,6 +780,29 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_fts_persistent_probe_connections", PGC_SIGHUP, GP_ARRAY_TUNING,
+			gettext_noop("Keep FTS probe connections to primary segments open between probes."),
+			gettext_noop("FTS then probes right away when a segment closes its connection, "
+						 "instead of waiting for gp_fts_probe_interval."),
+		},
+		&gp_fts_persistent_probe_connections,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_hashjoin_adaptive_skew", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Handle hash join batches that can't be split to fit in memory."),
+			gettext_noop("When a single hash value dominates a batch, stop increasing the number "
+						 "of batches and join the batch in several passes over its outer side instead."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_hashjoin_adaptive_skew,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_selectivity_damping_for_scans", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Damping of selectivities for clauses over the same base relation."),
@@ -946,6 +988,17 @@ struct config_bool ConfigureNamesBool_gp[] =
 		check_gp_workfile_compression, NULL, NULL
 	},
 
+	{
+		{"gp_workfile_bypass_page_cache", PGC_USERSET, RESOURCES_DISK,
+			gettext_noop("Keeps temporary files out of the OS page cache."),
+			gettext_noop("The writeback of spilled data is started in the background "
+						 "and the data is dropped from the page cache once written or read.")
+		},
+		&gp_workfile_bypass_page_cache,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_reraise_signal", PGC_SUSET, DEVELOPER_OPTIONS,
 			gettext_noop("Do we attempt to dump core when a serious problem occurs."),
@@ -1454,6 +1507,19 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_enable_query_metrics_timing", PGC_USERSET, UNGROUPED,
+			gettext_noop("Collect per-node timing in the query metrics shared memory."),
+			gettext_noop("Only effective when gp_enable_query_metrics is on. "
+						 "Timing is shown by gp_toolkit.gp_live_exec_stats while "
+						 "the query runs, at the cost of reading the clock on "
+						 "every node call.")
+		},
+		&gp_enable_query_metrics_timing,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"coredump_on_memerror", PGC_SUSET, DEVELOPER_OPTIONS,
 			gettext_noop("Generate core dump on memory error."),
@@ -1691,6 +1757,28 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_enable_radix_sort", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables radix sort of in-memory sorts on integer-like leading keys."),
+			gettext_noop("Applies to int4, int8, date and timestamp keys, "
+						 "and to text and uuid keys sorted on abbreviated keys.")
+		},
+		&gp_enable_radix_sort,
+		true,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_enable_window_sliding_agg", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables sliding evaluation of window aggregates that have no inverse transition function."),
+			gettext_noop("Applies to wide ROWS frames whose head moves, for aggregates "
+						 "such as min and max that have a combine function.")
+		},
+		&gp_enable_window_sliding_agg,
+		true,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_log_dynamic_partition_pruning", PGC_USERSET, LOGGING_WHAT,
 			gettext_noop("This guc enables debug messages related to dynamic partition pruning."),
@@ -2656,6 +2744,18 @@ struct config_bool ConfigureNamesBool_gp[] =
 		check_pljava_classpath_insecure, assign_pljava_classpath_insecure, NULL
 	},
 
+	{
+		{"gp_expand_in_place", PGC_USERSET, CUSTOM_OPTIONS,
+			gettext_noop("Expand hash distributed tables by moving only the rows whose segment changes."),
+			gettext_noop("ALTER TABLE EXPAND TABLE then inserts the moved rows on their new "
+						 "segments and deletes them from the old ones, instead of rewriting the table."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_expand_in_place,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_enable_segment_copy_checking", PGC_USERSET, CUSTOM_OPTIONS,
 			gettext_noop("Enable check the distribution key restriction on segment for command \"COPY FROM ON SEGMENT\"."),
@@ -2716,6 +2816,15 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, NULL, NULL
 	},
 
+	{
+		{"gp_external_enable_file_split", PGC_USERSET, EXTERNAL_TABLES,
+			gettext_noop("Let all primaries on a host read byte ranges of the file:// external table files on that host."),
+			gettext_noop("Only applies to TEXT format files that are not compressed.")
+		},
+		&gp_external_enable_file_split,
+		false, NULL, NULL
+	},
+
 	{
 		{"gp_resource_group_bypass", PGC_USERSET, RESOURCES,
 			gettext_noop("If the value is true, the query in this session will not be limited by resource group."),
@@ -2726,6 +2835,19 @@ struct config_bool ConfigureNamesBool_gp[] =
 		check_gp_resource_group_bypass, NULL, NULL
 	},
 
+	{
+		{"gp_resource_group_adaptive_concurrency", PGC_SIGHUP, RESOURCES_MGM,
+			gettext_noop("Adjust the effective concurrency of resource groups by their throughput and cpu usage."),
+			gettext_noop("The effective concurrency stays between gp_resource_group_adaptive_min_concurrency "
+						 "and the configured concurrency of each group. Only the cpu usage of the group "
+						 "on the coordinator host is measured, the load of the segment hosts is not seen."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_resource_group_adaptive_concurrency,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"stats_queue_level", PGC_SUSET, STATS_COLLECTOR,
 			gettext_noop("Collects resource queue-level statistics on database activity."),
@@ -2815,6 +2937,20 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_copy_dispatch_chunk_size", PGC_USERSET, CUSTOM_OPTIONS,
+			gettext_noop("Size of the chunks in which COPY FROM sends data from the master to each segment."),
+			gettext_noop("0 sends every row to its segment as it is read. Any other value "
+						 "also lets the master skip parsing rows of randomly "
+						 "distributed tables, spraying whole chunks of lines to the "
+						 "segments in turn."),
+			GUC_UNIT_KB | GUC_NOT_IN_SAMPLE
+		},
+		&gp_copy_dispatch_chunk_size,
+		0, 0, 4096,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"writable_external_table_bufsize", PGC_USERSET, EXTERNAL_TABLES,
 			gettext_noop("Buffer size in kilobytes for writable external table before writing data to gpfdist."),
@@ -2822,7 +2958,7 @@ struct config_int ConfigureNamesInt_gp[] =
 			GUC_UNIT_KB | GUC_NOT_IN_SAMPLE
 		},
 		&writable_external_table_bufsize,
-		64, 32, 131072,
+		1024, 32, 131072,
 		NULL, NULL, NULL
 	},
 
@@ -3562,6 +3698,16 @@ struct config_int ConfigureNamesInt_gp[] =
 		check_gp_hashagg_default_nbatches, NULL, NULL
 	},
 
+	{
+		{"gp_dynamic_scan_prefetch_partitions", PGC_USERSET, RESOURCES_ASYNCHRONOUS,
+			gettext_noop("Number of upcoming partitions a dynamic scan opens and prefetches ahead of the current one."),
+			gettext_noop("A value of 0 opens each partition only when its scan starts.")
+		},
+		&gp_dynamic_scan_prefetch_partitions,
+		0, 0, 64,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_motion_slice_noop", PGC_USERSET, GP_ARRAY_TUNING,
 			gettext_noop("Make motion nodes in certain slices noop"),
@@ -3683,6 +3829,37 @@ struct config_int ConfigureNamesInt_gp[] =
 		0, 0, INT_MAX,
 		NULL, NULL, NULL
 	},
+	{
+		{"gp_resource_group_memory_batch_chunks", PGC_SIGHUP, RESOURCES_MGM,
+			gettext_noop("Number of extra memory chunks a process accounts in its resource group slot at once."),
+			gettext_noop("Small memory reservations are served from these chunks without updating "
+						 "the shared group counters. 0 accounts every reservation exactly."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_resource_group_memory_batch_chunks,
+		0, 0, 1024,
+		NULL, NULL, NULL
+	},
+	{
+		{"gp_resource_group_adaptive_min_concurrency", PGC_SIGHUP, RESOURCES_MGM,
+			gettext_noop("Sets the lower bound of the effective concurrency in the adaptive concurrency mode."),
+			NULL,
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_resource_group_adaptive_min_concurrency,
+		1, 1, INT_MAX,
+		NULL, NULL, NULL
+	},
+	{
+		{"gp_resource_group_adaptive_cpu_threshold", PGC_SIGHUP, RESOURCES_MGM,
+			gettext_noop("Sets the cpu usage percentage of a group above which its effective concurrency is not increased."),
+			gettext_noop("The cpu usage is measured on the coordinator host only."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_resource_group_adaptive_cpu_threshold,
+		90, 1, 100,
+		NULL, NULL, NULL
+	},
 	{
 		{"gp_blockdirectory_entry_min_range", PGC_USERSET, GP_ARRAY_TUNING,
 			gettext_noop("Minimal range in bytes one block directory entry covers."),
@@ -4440,6 +4617,18 @@ struct config_enum ConfigureNamesEnum_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"writable_external_table_compression", PGC_USERSET, EXTERNAL_TABLES,
+			gettext_noop("Compresses the data writable external tables send to gpfdist."),
+			gettext_noop("Valid values are \"none\", \"zlib\" and \"zstd\". The data is "
+						 "sent uncompressed if gpfdist does not support the method."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&writable_external_table_compression,
+		WRITABLE_EXTERNAL_TABLE_COMPRESSION_NONE, writable_external_table_compression_options,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_log_fts", PGC_SIGHUP, LOGGING_WHAT,
 			gettext_noop("Sets the verbosity of logged messages pertaining to fault probing."),
@@ -84,6 +84,12 @@
 #define RESGROUP_BYPASS_MODE_MEMORY_LIMIT_ON_QD	30
 #define RESGROUP_BYPASS_MODE_MEMORY_LIMIT_ON_QE	10
 
+/*
+ * How often the effective concurrency of a group is adjusted in the
+ * adaptive concurrency mode, in milliseconds.
+ */
+#define RESGROUP_ADAPTIVE_CONCURRENCY_INTERVAL	1000
+
 /*
  * GUC variables.
  */
@@ -94,6 +100,10 @@ bool						gp_resgroup_print_operator_memory_limits = false;
 bool						gp_resgroup_debug_wait_queue = true;
 int							memory_spill_ratio = 20;
 int							gp_resource_group_queuing_timeout = 0;
+int							gp_resource_group_memory_batch_chunks = 0;
+bool						gp_resource_group_adaptive_concurrency = false;
+int							gp_resource_group_adaptive_min_concurrency = 1;
+int							gp_resource_group_adaptive_cpu_threshold = 90;
 
 /*
  * Data structures
@@ -135,6 +145,14 @@ struct ResGroupProcData
 	Oid		groupId;
 
 	int32	memUsage;			/* memory usage of current proc */
+
+	/*
+	 * Chunks already accounted in the slot and group memory usage but not
+	 * yet used by current proc.  Small reservations are served from here
+	 * without touching the shared counters, see ResGroupReserveMemory().
+	 * It is always 0 when the proc is not attached to a slot.
+	 */
+	int32	memReserved;
 	/* 
 	 * Record current bypass memory limit for each bypass queries.
 	 * For bypass mode, memUsage of current process could accumulate in a session.
@@ -218,10 +236,22 @@ struct ResGroupData
 	volatile int			nRunning;		/* number of running trans */
 	volatile int	nRunningBypassed;		/* number of running trans in bypass mode */
 	int			totalExecuted;	/* total number of executed trans */
+	int			totalCompleted;	/* total number of finished trans */
 	int			totalQueued;	/* total number of queued trans	*/
 	int64	totalQueuedTimeMs;	/* total queue time, in milliseconds */
 	PROC_QUEUE	waitProcs;		/* list of PGPROC objects waiting on this group */
 
+	/*
+	 * Runtime status of the adaptive concurrency mode, only maintained on
+	 * QD.  adaptConcurrency is the effective concurrency limit, 0 means it
+	 * has not been adjusted yet and the configured concurrency is used.
+	 */
+	int			adaptConcurrency;
+	TimestampTz	adaptLastTime;		/* when the last adjustment was made */
+	int			adaptLastCompleted;	/* totalCompleted at adaptLastTime */
+	int64		adaptLastCpuUsage;	/* cgroup cpu usage at adaptLastTime */
+	double		adaptLastThroughput;	/* finished trans per second */
+
 	/*
 	 * operation functions for resource group
 	 */
@@ -322,6 +352,14 @@ static void AtProcExit_ResGroup(int code, Datum arg);
 static void groupWaitCancel(bool isMoveQuery);
 static int32 groupReserveMemQuota(ResGroupData *group);
 static void groupReleaseMemQuota(ResGroupData *group, ResGroupSlotData *slot);
+static int groupGetConcurrency(const ResGroupData *group);
+static bool groupAdaptConcurrencyIsDue(const ResGroupData *group, TimestampTz now);
+static bool groupAdaptConcurrency(ResGroupData *group, TimestampTz now, int64 cpuUsage);
+static float groupGetCpuShare(const ResGroupCaps *caps);
+static int	adaptConcurrencyStep(int concurrency, int minConcurrency,
+								 int maxConcurrency, float cpuPercent,
+								 double throughput, double lastThroughput,
+								 bool hasWaiters);
 static int32 groupIncMemUsage(ResGroupData *group,
 							  ResGroupSlotData *slot,
 							  int32 chunks);
@@ -1155,6 +1193,8 @@ bool
 ResGroupReserveMemory(int32 memoryChunks, int32 overuseChunks, bool *waiverUsed)
 {
 	int32				overuseMem;
+	int32				accountChunks;
+	int32				batchChunks = 0;
 	ResGroupSlotData	*slot = self->slot;
 	ResGroupData		*group = self->group;
 
@@ -1200,8 +1240,41 @@ ResGroupReserveMemory(int32 memoryChunks, int32 overuseChunks, bool *waiverUsed)
 	Assert(group->memUsage >= 0);
 	Assert(self->memUsage >= 0);
 
-	/* add memoryChunks into group & slot memory usage */
-	overuseMem = groupIncMemUsage(group, slot, memoryChunks);
+	/*
+	 * Serve the request from the chunks this proc has already accounted in
+	 * the slot and group, no shared counter needs to be touched.
+	 */
+	if (self->memReserved >= memoryChunks)
+	{
+		self->memReserved -= memoryChunks;
+		return true;
+	}
+
+	/* the locally reserved chunks cover part of the request */
+	accountChunks = memoryChunks - self->memReserved;
+
+	/*
+	 * Account a batch of extra chunks together with the request so the
+	 * following small reservations can be served locally.  Bypassed queries
+	 * have a per proc limit, they always account the exact amount.
+	 */
+	if (!bypassedGroup)
+		batchChunks = gp_resource_group_memory_batch_chunks;
+
+	/* add the chunks into group & slot memory usage */
+	overuseMem = groupIncMemUsage(group, slot, accountChunks + batchChunks);
+
+	/*
+	 * Never let the extra batch push us over the limit, give it back and
+	 * only keep the requested chunks.
+	 */
+	if (overuseMem > 0 && batchChunks > 0)
+	{
+		int32		released = groupDecMemUsage(group, slot, batchChunks);
+
+		overuseMem = Max(0, overuseMem - released);
+		batchChunks = 0;
+	}
 
 	/* then check whether there is over usage */
 	if (CritSectionCount == 0)
@@ -1209,7 +1282,7 @@ ResGroupReserveMemory(int32 memoryChunks, int32 overuseChunks, bool *waiverUsed)
 		if (overuseMem > overuseChunks)
 		{
 			/* if the over usage is larger than allowed then revert the change */
-			groupDecMemUsage(group, slot, memoryChunks);
+			groupDecMemUsage(group, slot, accountChunks);
 
 			/* also revert in proc */
 			self->memUsage -= memoryChunks;
@@ -1227,6 +1300,8 @@ ResGroupReserveMemory(int32 memoryChunks, int32 overuseChunks, bool *waiverUsed)
 		}
 	}
 
+	self->memReserved = batchChunks;
+
 	return true;
 }
 
@@ -1260,6 +1335,22 @@ ResGroupReleaseMemory(int32 memoryChunks)
 
 	Assert(bypassedGroup || slotIsInUse(slot));
 
+	/*
+	 * Keep up to gp_resource_group_memory_batch_chunks chunks accounted for
+	 * the following reservations, only the excess is given back to the slot
+	 * and group.  Release the batch completely once it grows over twice the
+	 * batch size, so a proc that is shrinking does not hold on to it.
+	 */
+	if (!bypassedGroup && gp_resource_group_memory_batch_chunks > 0)
+	{
+		self->memReserved += memoryChunks;
+		if (self->memReserved <= 2 * gp_resource_group_memory_batch_chunks)
+			return;
+
+		memoryChunks = self->memReserved - gp_resource_group_memory_batch_chunks;
+		self->memReserved = gp_resource_group_memory_batch_chunks;
+	}
+
 	groupDecMemUsage(group, slot, memoryChunks);
 }
 
@@ -1344,7 +1435,13 @@ createGroup(Oid groupId, const ResGroupCaps *caps)
 	group->nRunningBypassed = 0;
 	ProcQueueInit(&group->waitProcs);
 	group->totalExecuted = 0;
+	group->totalCompleted = 0;
 	group->totalQueued = 0;
+	group->adaptConcurrency = 0;
+	group->adaptLastTime = 0;
+	group->adaptLastCompleted = 0;
+	group->adaptLastCpuUsage = 0;
+	group->adaptLastThroughput = 0.0;
 	group->memGap = 0;
 	group->memUsage = 0;
 	group->memSharedUsage = 0;
@@ -1569,7 +1666,9 @@ selfAttachResGroup(ResGroupData *group, ResGroupSlotData *slot)
 static void
 selfDetachResGroup(ResGroupData *group, ResGroupSlotData *slot)
 {
-	groupDecMemUsage(group, slot, self->memUsage);
+	/* the locally reserved chunks are accounted in the slot too */
+	groupDecMemUsage(group, slot, self->memUsage + self->memReserved);
+	self->memReserved = 0;
 	pg_atomic_sub_fetch_u32((pg_atomic_uint32*) &slot->nProcs, 1);
 	selfUnsetSlot();
 	selfUnsetGroup();
@@ -1694,7 +1793,7 @@ groupGetSlot(ResGroupData *group)
 	caps = &group->caps;
 
 	/* First check if the concurrency limit is reached */
-	if (group->nRunning >= caps->concurrency)
+	if (group->nRunning >= groupGetConcurrency(group))
 		return NULL;
 
 	slotMemQuota = groupReserveMemQuota(group);
@@ -1733,6 +1832,7 @@ groupPutSlot(ResGroupData *group, ResGroupSlotData *slot)
 	/* Return the slot back to free list */
 	slotpoolFreeSlot(slot);
 	group->nRunning--;
+	group->totalCompleted++;
 
 	/* And finally release the overused memory quota */
 	released = mempoolAutoRelease(group);
@@ -1884,6 +1984,171 @@ groupDecBypassedRef(ResGroupData *group)
 	pg_atomic_sub_fetch_u32((pg_atomic_uint32 *) &group->nRunningBypassed, 1);
 }
 
+/*
+ * Get the concurrency limit of a group on QD.
+ *
+ * In the adaptive concurrency mode it's the effective limit decided by
+ * groupAdaptConcurrency(), which never exceeds the configured concurrency,
+ * so the memory quota of each slot is unchanged.
+ */
+static int
+groupGetConcurrency(const ResGroupData *group)
+{
+	if (!gp_resource_group_adaptive_concurrency || group->adaptConcurrency <= 0)
+		return group->caps.concurrency;
+
+	return Min(group->adaptConcurrency, group->caps.concurrency);
+}
+
+/*
+ * Whether it's time to adjust the effective concurrency of a group.
+ */
+static bool
+groupAdaptConcurrencyIsDue(const ResGroupData *group, TimestampTz now)
+{
+	return TimestampDifferenceExceeds(group->adaptLastTime, now,
+									  RESGROUP_ADAPTIVE_CONCURRENCY_INTERVAL);
+}
+
+/*
+ * Get the percentage of the system cpu a group can use.
+ *
+ * ResGroupOps_ConvertCpuUsageToPercent() returns a share of all the cores,
+ * but a group only gets cpu_rate_limit percent of what the resource groups
+ * can use, or the cores of its cpuset, so its usage has to be compared with
+ * this share.
+ */
+static float
+groupGetCpuShare(const ResGroupCaps *caps)
+{
+	float		share = 100.0;
+
+	if (caps->cpuRateLimit != CPU_RATE_LIMIT_DISABLED)
+		share = caps->cpuRateLimit * gp_resource_group_cpu_limit;
+	else if (!CpusetIsEmpty(caps->cpuset))
+	{
+		Bitmapset  *bms = CpusetToBitset(caps->cpuset, MaxCpuSetLength);
+		int			ncores = ResGroupOps_GetCpuCores();
+
+		if (ncores > 0)
+			share = 100.0 * bms_num_members(bms) / ncores;
+		bms_free(bms);
+	}
+
+	return share > 0.0 ? Min(share, 100.0) : 100.0;
+}
+
+/*
+ * Decide the next effective concurrency of a group.
+ *
+ * This is a simple hill climbing on the number of finished transactions
+ * per second:
+ *
+ * - when the group's cpu usage reaches gp_resource_group_adaptive_cpu_threshold
+ *   and the throughput did not increase, running more transactions only
+ *   increases their latency, so the limit is decreased by one, but never
+ *   below 'minConcurrency';
+ * - when the cpu is not saturated and there are queuing transactions the
+ *   limit is increased by one, up to 'maxConcurrency';
+ * - otherwise the limit is kept.
+ *
+ * 'cpuPercent' is the usage of the group relative to its own cpu share.
+ * Admission is decided on the coordinator, so this is the usage on the
+ * coordinator host: a group whose queries are heavy on the segments but
+ * light on the coordinator is only limited by its throughput.
+ */
+static int
+adaptConcurrencyStep(int concurrency, int minConcurrency, int maxConcurrency,
+					 float cpuPercent, double throughput, double lastThroughput,
+					 bool hasWaiters)
+{
+	if (cpuPercent >= gp_resource_group_adaptive_cpu_threshold &&
+		throughput <= lastThroughput)
+		concurrency = Max(concurrency - 1, minConcurrency);
+	else if (cpuPercent < gp_resource_group_adaptive_cpu_threshold &&
+			 hasWaiters)
+		concurrency = Min(concurrency + 1, maxConcurrency);
+
+	return concurrency;
+}
+
+/*
+ * Adjust the effective concurrency of a group according to its throughput
+ * and cpu usage in the last interval, see adaptConcurrencyStep().
+ *
+ * 'cpuUsage' is the cumulated cgroup cpu usage of the group on the
+ * coordinator host, it's 0 when cpu accounting is not available, in such a
+ * case only the throughput is considered.
+ *
+ * Return true if the limit is increased.
+ */
+static bool
+groupAdaptConcurrency(ResGroupData *group, TimestampTz now, int64 cpuUsage)
+{
+	long		secs;
+	int			usecs;
+	int64		duration;
+	double		throughput;
+	float		cpuPercent = 0.0;
+	int			concurrency;
+	int			minConcurrency;
+
+	Assert(LWLockHeldByMeInMode(ResGroupLock, LW_EXCLUSIVE));
+	Assert(Gp_role == GP_ROLE_DISPATCH);
+
+	if (!groupAdaptConcurrencyIsDue(group, now))
+		return false;
+
+	/* the first sample, just record the start point */
+	if (group->adaptLastTime == 0)
+	{
+		group->adaptLastTime = now;
+		group->adaptLastCompleted = group->totalCompleted;
+		group->adaptLastCpuUsage = cpuUsage;
+		return false;
+	}
+
+	TimestampDifference(group->adaptLastTime, now, &secs, &usecs);
+	duration = secs * USECS_PER_SEC + usecs;
+	Assert(duration > 0);
+
+	throughput = (group->totalCompleted - group->adaptLastCompleted) *
+		(double) USECS_PER_SEC / duration;
+
+	if (cpuUsage > group->adaptLastCpuUsage)
+		cpuPercent = ResGroupOps_ConvertCpuUsageToPercent(cpuUsage - group->adaptLastCpuUsage,
+														  duration) *
+			100.0 / groupGetCpuShare(&group->caps);
+
+	minConcurrency = Min(gp_resource_group_adaptive_min_concurrency,
+						 group->caps.concurrency);
+	concurrency = adaptConcurrencyStep(groupGetConcurrency(group),
+									   minConcurrency,
+									   group->caps.concurrency,
+									   cpuPercent, throughput,
+									   group->adaptLastThroughput,
+									   !groupWaitQueueIsEmpty(group));
+
+	LOG_RESGROUP_DEBUG(LOG, "resource group %u: throughput %.2f/s, cpu usage %.2f%%, "
+					   "concurrency %d -> %d",
+					   group->groupId, throughput, cpuPercent,
+					   groupGetConcurrency(group), concurrency);
+
+	group->adaptLastTime = now;
+	group->adaptLastCompleted = group->totalCompleted;
+	group->adaptLastCpuUsage = cpuUsage;
+	group->adaptLastThroughput = throughput;
+
+	if (concurrency > groupGetConcurrency(group))
+	{
+		group->adaptConcurrency = concurrency;
+		return true;
+	}
+
+	group->adaptConcurrency = concurrency;
+	return false;
+}
+
 /*
  * Acquire a resource group slot
  *
@@ -1896,10 +2161,24 @@ groupAcquireSlot(ResGroupInfo *pGroupInfo, bool isMoveQuery)
 {
 	ResGroupSlotData *slot;
 	ResGroupData	 *group;
+	TimestampTz		 now = 0;
+	int64			 cpuUsage = 0;
 
 	Assert(!selfIsAssigned() || isMoveQuery);
 	group = pGroupInfo->group;
 
+	/*
+	 * Sample the cpu usage of the group for the adaptive concurrency mode.
+	 * It is read from the cgroup file system of this host, so do it before
+	 * taking the lock, the due check is redone under the lock.
+	 */
+	if (gp_resource_group_adaptive_concurrency)
+	{
+		now = GetCurrentTimestamp();
+		if (groupAdaptConcurrencyIsDue(group, now))
+			cpuUsage = ResGroupOps_GetCpuUsage(pGroupInfo->groupId);
+	}
+
 	LWLockAcquire(ResGroupLock, LW_EXCLUSIVE);
 
 	/* Has the group been dropped? */
@@ -1912,6 +2191,14 @@ groupAcquireSlot(ResGroupInfo *pGroupInfo, bool isMoveQuery)
 	/* acquire a slot */
 	if (!group->lockedForDrop)
 	{
+		/*
+		 * Adjust the effective concurrency, if it grows the queuing procs
+		 * are served first.
+		 */
+		if (gp_resource_group_adaptive_concurrency &&
+			groupAdaptConcurrency(group, now, cpuUsage))
+			wakeupSlots(group, true);
+
 		/* try to get a slot directly */
 		slot = groupGetSlot(group);
 
@@ -3797,6 +4084,7 @@ resgroupDumpGroup(StringInfo str, ResGroupData *group)
 	appendStringInfo(str, "{");
 	appendStringInfo(str, "\"group_id\":%u,", group->groupId);
 	appendStringInfo(str, "\"nRunning\":%d,", group->nRunning);
+	appendStringInfo(str, "\"concurrency\":%d,", groupGetConcurrency(group));
 	appendStringInfo(str, "\"nRunningBypassed\":%d,", group->nRunningBypassed);
 	appendStringInfo(str, "\"locked_for_drop\":%d,", group->lockedForDrop);
 	appendStringInfo(str, "\"memExpected\":%d,", group->memExpected);
@@ -5,6 +5,12 @@
 #include <setjmp.h>
 #include "cmockery.h"
 
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "portability/instr_time.h"
+
 #define test_with_setup_and_teardown(test_func) \
 	unit_test_setup_teardown(test_func, setup, teardown)
 
@@ -344,6 +350,377 @@ test__shouldBypassQuery__message_context_is_null(void **state)
 	assert_false(shouldBypassQuery("select 1"));
 }
 
+/*
+ * Helpers to set up a group with a number of in use slots, each of them
+ * attached by one fake proc.
+ */
+static ResGroupControl	fakeControl;
+static ResGroupData		fakeGroup;
+
+static void
+setupFakeGroup(ResGroupSlotData *slots, ResGroupProcData *procs, int nslots,
+			   int32 slotQuota, int32 freeChunks)
+{
+	int			i;
+
+	ResourceScheduler = true;
+	Gp_resource_manager_policy = RESOURCE_MANAGER_POLICY_GROUP;
+
+	MemSet(&fakeControl, 0, sizeof(fakeControl));
+	pg_atomic_init_u32(&fakeControl.freeChunks, freeChunks);
+	pResGroupControl = &fakeControl;
+
+	MemSet(&fakeGroup, 0, sizeof(fakeGroup));
+	fakeGroup.groupId = 1;
+
+	for (i = 0; i < nslots; i++)
+	{
+		MemSet(&slots[i], 0, sizeof(slots[i]));
+		slots[i].groupId = fakeGroup.groupId;
+		slots[i].group = &fakeGroup;
+		slots[i].memQuota = slotQuota;
+		slots[i].nProcs = 1;
+
+		MemSet(&procs[i], 0, sizeof(procs[i]));
+		procs[i].groupId = fakeGroup.groupId;
+		procs[i].group = &fakeGroup;
+		procs[i].slot = &slots[i];
+	}
+}
+
+static void
+detachFakeProc(ResGroupProcData *proc)
+{
+	self = proc;
+	groupDecMemUsage(proc->group, proc->slot, proc->memUsage + proc->memReserved);
+	proc->memReserved = 0;
+	self = &__self;
+}
+
+static void
+test__ResGroupReserveMemory_batched_accounting(void **state)
+{
+	ResGroupSlotData	slot;
+	ResGroupProcData	proc;
+	bool				waiverUsed = false;
+
+	setupFakeGroup(&slot, &proc, 1, 100, 100);
+	gp_resource_group_memory_batch_chunks = 4;
+	self = &proc;
+
+	/* the first reservation accounts the batch in the slot and group */
+	assert_true(ResGroupReserveMemory(1, 0, &waiverUsed));
+	assert_int_equal(proc.memUsage, 1);
+	assert_int_equal(proc.memReserved, 4);
+	assert_int_equal(slot.memUsage, 5);
+	assert_int_equal(fakeGroup.memUsage, 5);
+
+	/* the second one is served locally */
+	assert_true(ResGroupReserveMemory(1, 0, &waiverUsed));
+	assert_int_equal(proc.memReserved, 3);
+	assert_int_equal(fakeGroup.memUsage, 5);
+
+	/* releases are kept locally up to twice the batch */
+	ResGroupReleaseMemory(2);
+	assert_int_equal(proc.memUsage, 0);
+	assert_int_equal(proc.memReserved, 5);
+	assert_int_equal(fakeGroup.memUsage, 5);
+
+	/* the excess over the batch is given back */
+	assert_true(ResGroupReserveMemory(10, 0, &waiverUsed));
+	assert_int_equal(proc.memReserved, 4);
+	assert_int_equal(fakeGroup.memUsage, 14);
+	ResGroupReleaseMemory(10);
+	assert_int_equal(proc.memReserved, 4);
+	assert_int_equal(fakeGroup.memUsage, 4);
+
+	assert_false(waiverUsed);
+
+	self = &__self;
+	detachFakeProc(&proc);
+	assert_int_equal(slot.memUsage, 0);
+	assert_int_equal(fakeGroup.memUsage, 0);
+	gp_resource_group_memory_batch_chunks = 0;
+}
+
+static void
+test__ResGroupReserveMemory_batch_does_not_overuse(void **state)
+{
+	ResGroupSlotData	slot;
+	ResGroupProcData	proc;
+	bool				waiverUsed = false;
+
+	/* only 2 chunks in the slot quota and 2 chunks in the global share */
+	setupFakeGroup(&slot, &proc, 1, 2, 2);
+	gp_resource_group_memory_batch_chunks = 4;
+	self = &proc;
+
+	/* the batch would overuse the global share, so it is not kept */
+	assert_true(ResGroupReserveMemory(2, 0, &waiverUsed));
+	assert_false(waiverUsed);
+	assert_int_equal(proc.memReserved, 0);
+	assert_int_equal(slot.memUsage, 2);
+	assert_int_equal(pg_atomic_read_u32(&fakeControl.freeChunks), 2);
+
+	/* the locally reserved chunks never count for a failed reservation */
+	assert_true(ResGroupReserveMemory(2, 0, &waiverUsed));
+	assert_false(ResGroupReserveMemory(1, 0, &waiverUsed));
+	assert_int_equal(proc.memUsage, 4);
+	assert_int_equal(slot.memUsage, 4);
+	assert_int_equal(pg_atomic_read_u32(&fakeControl.freeChunks), 0);
+
+	ResGroupReleaseMemory(4);
+	self = &__self;
+	detachFakeProc(&proc);
+	assert_int_equal(fakeGroup.memUsage, 0);
+	assert_int_equal(fakeGroup.memSharedUsage, 0);
+	assert_int_equal(pg_atomic_read_u32(&fakeControl.freeChunks), 2);
+	gp_resource_group_memory_batch_chunks = 0;
+}
+
+static void
+test__groupGetCpuShare(void **state)
+{
+	ResGroupCaps caps;
+
+	ClearResGroupCaps(&caps);
+	gp_resource_group_cpu_limit = 0.9;
+
+	/* a cpu_rate_limit is a share of what the resource groups can use */
+	caps.cpuRateLimit = 20;
+	assert_true(fabs(groupGetCpuShare(&caps) - 18.0) < 0.01);
+
+	/* a cpuset is a share of the cores */
+	caps.cpuRateLimit = CPU_RATE_LIMIT_DISABLED;
+	strcpy(caps.cpuset, "0-1");
+	will_return(ResGroupOps_GetCpuCores, 8);
+	assert_true(fabs(groupGetCpuShare(&caps) - 25.0) < 0.01);
+}
+
+static void
+test__adaptConcurrencyStep_increase(void **state)
+{
+	gp_resource_group_adaptive_cpu_threshold = 90;
+
+	/* the cpu is not saturated and transactions are queuing */
+	assert_int_equal(adaptConcurrencyStep(4, 1, 10, 50.0, 10.0, 10.0, true), 5);
+
+	/* nothing to gain without queuing transactions */
+	assert_int_equal(adaptConcurrencyStep(4, 1, 10, 50.0, 10.0, 10.0, false), 4);
+}
+
+static void
+test__adaptConcurrencyStep_decrease(void **state)
+{
+	ResGroupCaps caps;
+	float		cpuPercent;
+
+	gp_resource_group_adaptive_cpu_threshold = 90;
+
+	/* the cpu is saturated and the throughput did not improve */
+	assert_int_equal(adaptConcurrencyStep(4, 1, 10, 95.0, 10.0, 10.0, true), 3);
+
+	/* the throughput still improves, keep the limit */
+	assert_int_equal(adaptConcurrencyStep(4, 1, 10, 95.0, 12.0, 10.0, true), 4);
+
+	/*
+	 * A group capped to 18% of the system that uses 17% of it is saturated,
+	 * although the system wide usage is far from the threshold.
+	 */
+	ClearResGroupCaps(&caps);
+	caps.cpuRateLimit = 20;
+	gp_resource_group_cpu_limit = 0.9;
+	cpuPercent = 17.0 * 100.0 / groupGetCpuShare(&caps);
+	assert_int_equal(adaptConcurrencyStep(4, 1, 10, cpuPercent, 10.0, 10.0, true), 3);
+}
+
+static void
+test__adaptConcurrencyStep_clamp(void **state)
+{
+	gp_resource_group_adaptive_cpu_threshold = 90;
+
+	/* never below the minimum */
+	assert_int_equal(adaptConcurrencyStep(2, 2, 10, 95.0, 10.0, 10.0, true), 2);
+
+	/* never above the configured concurrency */
+	assert_int_equal(adaptConcurrencyStep(10, 1, 10, 50.0, 10.0, 10.0, true), 10);
+}
+
+/*
+ * Several procs in turn reserve and release small amounts of memory, the way
+ * queries allocating and freeing chunks do; with batched accounting all the
+ * memory must still be given back once they are detached.
+ */
+static void
+test__ResGroupReserveMemory_batched_multi_slots(void **state)
+{
+#define NSLOTS 8
+	ResGroupSlotData	slots[NSLOTS];
+	ResGroupProcData	procs[NSLOTS];
+	bool				waiverUsed = false;
+	int					i;
+	int					round;
+
+	setupFakeGroup(slots, procs, NSLOTS, 4, 16 * NSLOTS);
+	gp_resource_group_memory_batch_chunks = 8;
+
+	for (round = 0; round < 10; round++)
+	{
+		for (i = 0; i < NSLOTS; i++)
+		{
+			self = &procs[i];
+			assert_true(ResGroupReserveMemory(1, 0, &waiverUsed));
+			assert_true(ResGroupReserveMemory(2, 0, &waiverUsed));
+			ResGroupReleaseMemory(1);
+			ResGroupReleaseMemory(2);
+		}
+	}
+	self = &__self;
+	assert_false(waiverUsed);
+
+	/* no memory is in use, but each proc may keep up to twice the batch */
+	for (i = 0; i < NSLOTS; i++)
+	{
+		assert_int_equal(procs[i].memUsage, 0);
+		assert_true(procs[i].memReserved <= 2 * 8);
+		assert_int_equal(slots[i].memUsage, procs[i].memReserved);
+	}
+
+	for (i = 0; i < NSLOTS; i++)
+	{
+		detachFakeProc(&procs[i]);
+		assert_int_equal(slots[i].memUsage, 0);
+	}
+
+	/* all the accounting must be given back */
+	assert_int_equal(fakeGroup.memUsage, 0);
+	assert_int_equal(fakeGroup.memSharedUsage, 0);
+	assert_int_equal(pg_atomic_read_u32(&fakeControl.freeChunks), 16 * NSLOTS);
+
+	gp_resource_group_memory_batch_chunks = 0;
+#undef NSLOTS
+}
+
+/*
+ * Microbenchmark of the vmem tracker accounting path, not run by default:
+ * set RESGROUP_BENCHMARK in the environment, or use "make benchmark".
+ *
+ * Like backends, each fake proc is a process of its own, and they all
+ * reserve and release small amounts of memory at the same time in one
+ * group, so the slot, group and global counters in shared memory are
+ * updated concurrently. The throughput is reported with and without
+ * batched accounting.
+ */
+#define BENCH_ROUNDS 10000
+
+typedef struct BenchShared
+{
+	ResGroupControl		control;
+	ResGroupData		group;
+	ResGroupSlotData	slots[FLEXIBLE_ARRAY_MEMBER];
+} BenchShared;
+
+static double
+benchReserveRelease(int nslots, int batchChunks)
+{
+	Size				size = offsetof(BenchShared, slots) +
+							   sizeof(ResGroupSlotData) * nslots;
+	BenchShared		   *shared;
+	ResGroupProcData   *procs = palloc(sizeof(ResGroupProcData) * nslots);
+	int					startPipe[2];
+	instr_time			start;
+	instr_time			duration;
+	int					i;
+
+	shared = mmap(NULL, size, PROT_READ | PROT_WRITE,
+				  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	assert_true(shared != MAP_FAILED);
+
+	/* set up the group as usual, then move it to the shared memory */
+	setupFakeGroup(shared->slots, procs, nslots, 4, 16 * nslots);
+	shared->control = fakeControl;
+	shared->group = fakeGroup;
+	pResGroupControl = &shared->control;
+	for (i = 0; i < nslots; i++)
+	{
+		shared->slots[i].group = &shared->group;
+		procs[i].group = &shared->group;
+	}
+	gp_resource_group_memory_batch_chunks = batchChunks;
+
+	/* the procs wait for the end of file on the pipe to start together */
+	assert_int_equal(pipe(startPipe), 0);
+	for (i = 0; i < nslots; i++)
+	{
+		pid_t		pid = fork();
+
+		assert_true(pid >= 0);
+		if (pid == 0)
+		{
+			bool		waiverUsed = false;
+			char		c;
+			int			round;
+
+			close(startPipe[1]);
+			if (read(startPipe[0], &c, 1) != 0)
+				_exit(1);
+
+			self = &procs[i];
+			for (round = 0; round < BENCH_ROUNDS; round++)
+			{
+				if (!ResGroupReserveMemory(1, 0, &waiverUsed) ||
+					!ResGroupReserveMemory(2, 0, &waiverUsed))
+					_exit(1);
+				ResGroupReleaseMemory(1);
+				ResGroupReleaseMemory(2);
+			}
+			detachFakeProc(&procs[i]);
+			_exit(waiverUsed ? 1 : 0);
+		}
+	}
+
+	close(startPipe[0]);
+	INSTR_TIME_SET_CURRENT(start);
+	close(startPipe[1]);
+	for (i = 0; i < nslots; i++)
+	{
+		int			status;
+
+		assert_true(wait(&status) > 0);
+		assert_true(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	}
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, start);
+
+	/* all the accounting must be given back */
+	assert_int_equal(shared->group.memUsage, 0);
+	assert_int_equal(shared->group.memSharedUsage, 0);
+	assert_int_equal(pg_atomic_read_u32(&shared->control.freeChunks), 16 * nslots);
+
+	gp_resource_group_memory_batch_chunks = 0;
+	pResGroupControl = &fakeControl;
+	munmap(shared, size);
+	pfree(procs);
+
+	return 4.0 * BENCH_ROUNDS * nslots / Max(INSTR_TIME_GET_DOUBLE(duration), 1e-9);
+}
+
+static void
+test__ResGroupReserveMemory_benchmark(void **state)
+{
+	const int	nslotsList[] = {64, 128, 256};
+	int			i;
+
+	for (i = 0; i < lengthof(nslotsList); i++)
+	{
+		double		exact = benchReserveRelease(nslotsList[i], 0);
+		double		batched = benchReserveRelease(nslotsList[i], 8);
+
+		printf("%d slots: %.0f ops/s exact, %.0f ops/s batched\n",
+			   nslotsList[i], exact, batched);
+	}
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -367,6 +744,17 @@ main(int argc, char *argv[])
 			test_with_setup_and_teardown(test__shouldBypassQuery__cmd_mixed),
 			test_with_setup_and_teardown(test__shouldBypassQuery__forced_bypass_mode),
 			test_with_setup_and_teardown(test__shouldBypassQuery__message_context_is_null),
+			unit_test(test__ResGroupReserveMemory_batched_accounting),
+			unit_test(test__ResGroupReserveMemory_batch_does_not_overuse),
+			unit_test(test__ResGroupReserveMemory_batched_multi_slots),
+			unit_test(test__groupGetCpuShare),
+			unit_test(test__adaptConcurrencyStep_increase),
+			unit_test(test__adaptConcurrencyStep_decrease),
+			unit_test(test__adaptConcurrencyStep_clamp),
+	};
+
+	const UnitTest benchmarks[] = {
+			unit_test(test__ResGroupReserveMemory_benchmark),
 	};
 
 	MemoryContextInit();
@@ -375,5 +763,9 @@ main(int argc, char *argv[])
 											   ALLOCSET_DEFAULT_MINSIZE,
 											   ALLOCSET_DEFAULT_INITSIZE,
 											   ALLOCSET_DEFAULT_MAXSIZE);
-	run_tests(tests);
+
+	if (getenv("RESGROUP_BENCHMARK") != NULL)
+		run_tests(benchmarks);
+	else
+		run_tests(tests);
 }
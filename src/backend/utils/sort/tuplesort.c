@@ -105,7 +105,9 @@
 #include "executor/executor.h"
 #include "miscadmin.h"
 #include "pg_trace.h"
+#include "port/pg_bitutils.h"
 #include "utils/datum.h"
+#include "utils/guc.h"
 #include "utils/logtape.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
@@ -659,6 +661,258 @@ static void free_sort_tuple(Tuplesortstate *state, SortTuple *stup);
  */
 #include "qsort_tuple.c"
 
+/*
+ * Radix sort of SortTuples.
+ *
+ * When the comparator of the leading key is one of the ssup_datum_*_cmp()
+ * functions, the order of the leading keys is the order of an unsigned
+ * integer computed from datum1.  Instead of comparing tuples, we then
+ * distribute them on the bytes of that integer, most significant byte
+ * first ("American flag sort").  Buckets that get small are finished with
+ * quicksort, and so are runs of equal leading keys when further keys or an
+ * abbreviated leading key call for the full comparetup routine.
+ */
+#define RADIX_SORT_MIN_TUPLES	1024	/* use quicksort for smaller sorts */
+#define RADIX_SORT_MIN_BUCKET	64	/* use quicksort for smaller buckets */
+
+typedef enum
+{
+	RADIX_KEY_UNSIGNED,			/* ssup_datum_unsigned_cmp */
+	RADIX_KEY_SIGNED,			/* ssup_datum_signed_cmp */
+	RADIX_KEY_INT32				/* ssup_datum_int32_cmp */
+} RadixKeyKind;
+
+typedef struct RadixSortState
+{
+	Tuplesortstate *state;
+	RadixKeyKind kind;
+	bool		reverse;		/* descending leading key? */
+	bool		tiebreak;		/* must equal leading keys be compared? */
+} RadixSortState;
+
+/*
+ * Map a non-NULL leading key to an unsigned integer in sort order.
+ */
+static inline uint64
+radix_key(const RadixSortState *rs, Datum datum)
+{
+	uint64		key;
+
+	switch (rs->kind)
+	{
+		case RADIX_KEY_INT32:
+			key = (uint32) DatumGetInt32(datum) ^ ((uint32) 1 << 31);
+			break;
+#ifdef USE_FLOAT8_BYVAL
+		case RADIX_KEY_SIGNED:
+			key = (uint64) DatumGetInt64(datum) ^ ((uint64) 1 << 63);
+			break;
+#endif
+		default:
+			key = (uint64) datum;
+			break;
+	}
+
+	return rs->reverse ? ~key : key;
+}
+
+/*
+ * Sort SortTuples with the regular comparison sort.
+ */
+static void
+radix_sort_fallback(const RadixSortState *rs, SortTuple *tuples, int n)
+{
+	Tuplesortstate *state = rs->state;
+
+	if (state->onlyKey != NULL)
+		qsort_ssup(tuples, n, state->onlyKey);
+	else
+		qsort_tuple(tuples, n, state->comparetup, state);
+}
+
+/*
+ * Sort non-NULL SortTuples whose keys agree on all bytes above "byte".
+ */
+static void
+radix_sort_tuple(const RadixSortState *rs, SortTuple *tuples, int n, int byte)
+{
+	int			counts[256];
+	int			next[256];
+	int			ends[256];
+	int			shift;
+	int			pos;
+	int			c;
+	int			i;
+
+	for (;;)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		shift = byte * BITS_PER_BYTE;
+		memset(counts, 0, sizeof(counts));
+		for (i = 0; i < n; i++)
+			counts[(radix_key(rs, tuples[i].datum1) >> shift) & 0xFF]++;
+
+		/* Skip a byte that all the keys share */
+		c = (radix_key(rs, tuples[0].datum1) >> shift) & 0xFF;
+		if (counts[c] < n)
+			break;
+
+		if (byte == 0)
+		{
+			if (rs->tiebreak)
+				radix_sort_fallback(rs, tuples, n);
+			return;
+		}
+		byte--;
+	}
+
+	pos = 0;
+	for (c = 0; c < 256; c++)
+	{
+		next[c] = pos;
+		pos += counts[c];
+		ends[c] = pos;
+	}
+
+	/*
+	 * Move each tuple to its bucket, following cycles of displaced tuples
+	 * until one of them belongs where the cycle started.
+	 */
+	for (c = 0; c < 256; c++)
+	{
+		while (next[c] < ends[c])
+		{
+			SortTuple	tuple = tuples[next[c]];
+			int			d = (radix_key(rs, tuple.datum1) >> shift) & 0xFF;
+
+			while (d != c)
+			{
+				SortTuple	displaced = tuples[next[d]];
+
+				tuples[next[d]++] = tuple;
+				tuple = displaced;
+				d = (radix_key(rs, tuple.datum1) >> shift) & 0xFF;
+			}
+			tuples[next[c]++] = tuple;
+		}
+	}
+
+	for (c = 0; c < 256; c++)
+	{
+		SortTuple  *bucket = tuples + ends[c] - counts[c];
+
+		if (counts[c] < 2)
+			continue;
+
+		if (byte == 0)
+		{
+			if (rs->tiebreak)
+				radix_sort_fallback(rs, bucket, counts[c]);
+		}
+		else if (counts[c] < RADIX_SORT_MIN_BUCKET)
+			radix_sort_fallback(rs, bucket, counts[c]);
+		else
+			radix_sort_tuple(rs, bucket, counts[c], byte - 1);
+	}
+}
+
+/*
+ * Sort all memtuples with a radix sort on their leading key, if that key
+ * allows it.  Returns false if the caller should use quicksort instead.
+ */
+static bool
+radix_sort_memtuples(Tuplesortstate *state)
+{
+	SortSupport ssup = state->sortKeys;
+	SortTuple  *tuples = state->memtuples;
+	int			n = state->memtupcount;
+	RadixSortState rs;
+	uint64		minkey = PG_UINT64_MAX;
+	uint64		maxkey = 0;
+	uint64		prevkey = 0;
+	bool		presorted = true;
+	int			nnulls = 0;
+	int			i;
+	int			j;
+
+	if (ssup == NULL)
+		return false;
+
+	if (ssup->comparator == ssup_datum_unsigned_cmp)
+		rs.kind = RADIX_KEY_UNSIGNED;
+#ifdef USE_FLOAT8_BYVAL
+	else if (ssup->comparator == ssup_datum_signed_cmp)
+		rs.kind = RADIX_KEY_SIGNED;
+#endif
+	else if (ssup->comparator == ssup_datum_int32_cmp)
+		rs.kind = RADIX_KEY_INT32;
+	else
+		return false;
+
+	rs.state = state;
+	rs.reverse = ssup->ssup_reverse;
+	/* onlyKey is set for single-key sorts without abbreviation */
+	rs.tiebreak = (state->onlyKey == NULL);
+
+	for (i = 0; i < n; i++)
+	{
+		uint64		key;
+
+		if (tuples[i].isnull1)
+		{
+			nnulls++;
+			presorted = false;
+			continue;
+		}
+
+		key = radix_key(&rs, tuples[i].datum1);
+		if (key < prevkey)
+			presorted = false;
+		prevkey = key;
+		minkey = Min(minkey, key);
+		maxkey = Max(maxkey, key);
+	}
+
+	/*
+	 * Quicksort recognizes presorted input in a single pass, and there is
+	 * nothing to distribute if all the leading keys are equal.
+	 */
+	if (presorted || minkey >= maxkey)
+		return false;
+
+	/* Move the NULLs to the end they sort to, and sort them on their own */
+	if (nnulls > 0)
+	{
+		j = 0;
+		for (i = 0; i < n; i++)
+		{
+			if (tuples[i].isnull1 == ssup->ssup_nulls_first)
+			{
+				SortTuple	tmp = tuples[i];
+
+				tuples[i] = tuples[j];
+				tuples[j++] = tmp;
+			}
+		}
+
+		if (ssup->ssup_nulls_first)
+		{
+			if (rs.tiebreak && nnulls > 1)
+				radix_sort_fallback(&rs, tuples, nnulls);
+			tuples += nnulls;
+		}
+		else if (rs.tiebreak && nnulls > 1)
+			radix_sort_fallback(&rs, tuples + n - nnulls, nnulls);
+		n -= nnulls;
+	}
+
+	radix_sort_tuple(&rs, tuples, n,
+					 pg_leftmost_one_pos64(minkey ^ maxkey) / BITS_PER_BYTE);
+
+	return true;
+}
+
 
 /*
  *		tuplesort_begin_xxx
@@ -1436,9 +1690,36 @@ noalloc:
 void
 tuplesort_puttupleslot(Tuplesortstate *state, TupleTableSlot *slot)
 {
-	MemoryContext oldcontext = MemoryContextSwitchTo(state->sortcontext);
+	MemoryContext oldcontext;
 	SortTuple	stup;
 
+	/*
+	 * GPDB: Once a bounded sort keeps only its top tuples in a heap, the top
+	 * of the heap is the threshold a new tuple must beat.  A tuple whose
+	 * leading key alone already loses against it cannot make the result, so
+	 * discard it before paying for a copy.  Ties on the leading key take the
+	 * regular path, which compares the remaining keys.  The sort direction is
+	 * reversed while the heap is built, hence the check for < 0.  Bounded
+	 * sorts don't use abbreviated keys, so datum1 holds the real key.
+	 */
+	if (state->status == TSS_BOUNDED && state->copytup == copytup_heap)
+	{
+		Datum		datum1;
+		bool		isnull1;
+
+		datum1 = slot_getattr(slot, state->sortKeys[0].ssup_attno, &isnull1);
+		if (ApplySortComparator(datum1, isnull1,
+								state->memtuples[0].datum1,
+								state->memtuples[0].isnull1,
+								state->sortKeys) < 0)
+		{
+			CHECK_FOR_INTERRUPTS();
+			return;
+		}
+	}
+
+	oldcontext = MemoryContextSwitchTo(state->sortcontext);
+
 	/*
 	 * Copy the given tuple into memory we control, and decrease availMem.
 	 * Then call the common code.
@@ -3342,6 +3623,12 @@ tuplesort_sort_memtuples(Tuplesortstate *state)
 
 	if (state->memtupcount > 1)
 	{
+		/* GPDB: can we distribute the tuples on their leading key? */
+		if (gp_enable_radix_sort &&
+			state->memtupcount >= RADIX_SORT_MIN_TUPLES &&
+			radix_sort_memtuples(state))
+			return;
+
 		/* Can we use the single-key sort function? */
 		if (state->onlyKey != NULL)
 			qsort_ssup(state->memtuples, state->memtupcount,
@@ -4618,3 +4905,49 @@ free_sort_tuple(Tuplesortstate *state, SortTuple *stup)
 	FREEMEM(state, GetMemoryChunkSpace(stup->tuple));
 	pfree(stup->tuple);
 }
+
+/*
+ * Comparators for Datums that hold integers, see sortsupport.h.  Having
+ * datatypes share these lets tuplesort_sort_memtuples() recognize leading
+ * keys that it can radix sort.
+ */
+int
+ssup_datum_unsigned_cmp(Datum x, Datum y, SortSupport ssup)
+{
+	if (x < y)
+		return -1;
+	else if (x > y)
+		return 1;
+	else
+		return 0;
+}
+
+#ifdef USE_FLOAT8_BYVAL
+int
+ssup_datum_signed_cmp(Datum x, Datum y, SortSupport ssup)
+{
+	int64		xx = DatumGetInt64(x);
+	int64		yy = DatumGetInt64(y);
+
+	if (xx < yy)
+		return -1;
+	else if (xx > yy)
+		return 1;
+	else
+		return 0;
+}
+#endif
+
+int
+ssup_datum_int32_cmp(Datum x, Datum y, SortSupport ssup)
+{
+	int32		xx = DatumGetInt32(x);
+	int32		yy = DatumGetInt32(y);
+
+	if (xx < yy)
+		return -1;
+	else if (xx > yy)
+		return 1;
+	else
+		return 0;
+}
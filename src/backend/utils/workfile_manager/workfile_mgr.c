@@ -425,6 +425,27 @@ UpdateWorkFileSize(File file, uint64 newsize)
 	LWLockRelease(WorkFileManagerLock);
 }
 
+/*
+ * Account the bytes written to the files of a workfile set and the time
+ * spent on writing them.
+ *
+ * buffile.c calls this in batches, so that the spill bandwidth of running
+ * queries can be seen in the gp_toolkit views.
+ */
+void
+WorkFileAddWriteStats(workfile_set *work_set, int64 nbytes, int64 usecs)
+{
+	LWLockAcquire(WorkFileManagerLock, LW_EXCLUSIVE);
+
+	if (work_set->active)
+	{
+		work_set->write_bytes += nbytes;
+		work_set->write_usecs += usecs;
+	}
+
+	LWLockRelease(WorkFileManagerLock);
+}
+
 /*
  * WorkFileDeleted - Delete the file from it's workfile_set, update
  * the stats for the workfile_set.
@@ -628,6 +649,8 @@ workfile_mgr_create_set_internal(const char *operator_name, const char *prefix)
 	work_set->perquery = perquery;
 	work_set->num_files = 0;
 	work_set->total_bytes = 0;
+	work_set->write_bytes = 0;
+	work_set->write_usecs = 0;
 	work_set->active = true;
 	work_set->pinned = false;
 
@@ -860,7 +883,7 @@ gp_workfile_mgr_cache_entries_internal(PG_FUNCTION_ARGS)
 		 * The number and type of attributes have to match the definition of the
 		 * view gp_workfile_mgr_cache_entries
 		 */
-#define NUM_CACHE_ENTRIES_ELEM 8
+#define NUM_CACHE_ENTRIES_ELEM 10
 		TupleDesc tupdesc = CreateTemplateTupleDesc(NUM_CACHE_ENTRIES_ELEM);
 
 		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "segid", INT4OID, -1, 0);
@@ -871,6 +894,8 @@ gp_workfile_mgr_cache_entries_internal(PG_FUNCTION_ARGS)
 		TupleDescInitEntry(tupdesc, (AttrNumber) 6, "sessionid", INT4OID, -1, 0);
 		TupleDescInitEntry(tupdesc, (AttrNumber) 7, "commandid", INT4OID, -1, 0);
 		TupleDescInitEntry(tupdesc, (AttrNumber) 8, "numfiles", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 9, "written", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 10, "write_usecs", INT8OID, -1, 0);
 
 		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
 
@@ -906,6 +931,8 @@ gp_workfile_mgr_cache_entries_internal(PG_FUNCTION_ARGS)
 		values[5] = UInt32GetDatum(work_set->session_id);
 		values[6] = UInt32GetDatum(work_set->command_count);
 		values[7] = UInt32GetDatum(work_set->num_files);
+		values[8] = Int64GetDatum(work_set->write_bytes);
+		values[9] = Int64GetDatum(work_set->write_usecs);
 
 		cxt->index++;
 
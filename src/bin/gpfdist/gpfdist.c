@@ -56,6 +56,12 @@
 #include <pg_config.h>
 #include <pg_config_manual.h>
 #include "gpfdist_helper.h"
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
 #ifdef USE_SSL
 #include <openssl/ssl.h>
 #include <openssl/rand.h>
@@ -125,6 +131,13 @@ static void flush_ssl_buffer(int fd, short event, void* arg);
  not property terminated, then gpfdist encountered some error, and caller
  should check the gpfdist error log.
 
+ X-GP-COMPRESSION - compression of the data a writable external table
+              POSTs, "zlib" or "zstd". gpfdist echoes the header in the
+              response to the first request of a segment if it supports
+              the method, and the body of every later request carrying
+              the header is then one complete zlib stream or a sequence
+              of zstd frames. "none" or no header means plain data.
+
  **************/
 
 typedef struct gnet_request_t gnet_request_t;
@@ -174,7 +187,8 @@ static struct
 	struct transform* trlist; /* transforms from config file */
 	const char* ssl; /* path to certificates in case we use gpfdist with ssl */
 	int			w; /* The time used for session timeout in seconds */
-} opt = { 8080, 8080, 0, 0, 0, ".", 0, 0, -1, 5, 0, 32768, 0, 256, 0, 0, 0, 0 };
+	int			r; /* blocks each GET session reads ahead in a worker thread */
+} opt = { 8080, 8080, 0, 0, 0, ".", 0, 0, -1, 5, 0, 32768, 0, 256, 0, 0, 0, 0, 0 };
 
 
 typedef union address
@@ -210,6 +224,48 @@ static struct
 	int 			wdtimer; /* Kill gpfdist after k seconds of inactivity. 0 to disable. */
 } gcb;
 
+#ifndef WIN32
+/*
+ * Read-ahead state of a GET session (--readahead).
+ *
+ * A worker thread owns the fstream while the session is running, reading,
+ * decompressing (or running the transform) and splitting rows into a ring
+ * of 'nslot' blocks. The event loop only copies finished blocks out of the
+ * ring and sends them, so file I/O and decompression of one session overlap
+ * with the network I/O of every session instead of serializing behind it.
+ *
+ * Slots [head, head + count) are owned by the consumer, the rest by the
+ * worker. Both counters are protected by 'lock'. The event loop never waits
+ * for the worker: a request that finds the ring empty stops watching its
+ * socket until the worker signals a finished block through 'notify'.
+ */
+typedef struct readahead_slot_t
+{
+	char*		data;
+	int			size;		/* result of fstream_read(): >0 data, 0 EOF, <0 error */
+	apr_int64_t	read_bytes;	/* compressed bytes consumed to produce this block */
+	struct fstream_filename_and_offset fos;
+} readahead_slot_t;
+
+typedef struct readahead_t
+{
+	pthread_t		thread;
+	pthread_mutex_t	lock;
+	pthread_cond_t	cond;
+	int				nslot;
+	int				head;
+	int				count;
+	int				stop;		/* set by the event loop to shut the worker down */
+	int				notify[2];	/* pipe the worker signals finished blocks through */
+	struct event	notify_ev;	/* event loop side of 'notify' */
+	char			error[256];	/* copy of the fstream error, set under 'lock' */
+	fstream_t*		fstream;
+	const char*		line_delim_str;
+	int				line_delim_length;
+	readahead_slot_t* slot;
+} readahead_t;
+#endif
+
 /*  A session */
 typedef struct session_t session_t;
 struct session_t
@@ -233,6 +289,11 @@ struct session_t
 	struct timeval 	tm;             /* timeout for struct event */
 	struct event   	ev;             /* event we are watching for this session*/
 	apr_hash_t		*requests;
+	apr_time_t		start_time;		/* time the session was created */
+	apr_int64_t		bytes;			/* bytes sent to or received from all requests */
+#ifndef WIN32
+	readahead_t*	readahead;		/* read-ahead worker, NULL if not started */
+#endif
 };
 
 /*  An http request */
@@ -270,6 +331,7 @@ struct request_t
 	int 			gp_proto; 	/* the protocol to use, sent from client */
 	int				is_get;     /* true for GET, false for POST */
 	int				is_final;	/* the final POST request. a signal from client to end session */
+	int				compression; /* POST_COMPRESSION_* of the POST request body */
 	int				segid;		/* the segment id of the segdb with the request */
 	int				totalsegs;	/* the total number of segdbs */
 
@@ -288,6 +350,9 @@ struct request_t
 	block_t	outblock;	/* next block to send out */
 	char*           line_delim_str;
 	int             line_delim_length;
+#ifndef WIN32
+	int				readahead_wait;	/* waiting for a block of the read-ahead worker */
+#endif
 
 #ifdef USE_SSL
 	/* SSL related */
@@ -311,6 +376,12 @@ struct request_t
 #define NO_SEQ    0
 #define OPEN_SEQ  1
 
+/* X-GP-COMPRESSION of a POST request */
+#define POST_COMPRESSION_NONE	0
+#define POST_COMPRESSION_ZLIB	1
+#define POST_COMPRESSION_ZSTD	2
+#define POST_COMPRESSION_UNSUPPORTED	(-1)
+
 static int ggetpid();
 static void log_gpfdist_status();
 static void log_request_header(const request_t *r);
@@ -355,6 +426,7 @@ static void free_session_cb(int fd, short event, void* arg);
 static int request_set_transform(request_t *r);
 #endif
 static void handle_post_request(request_t *r, int header_end);
+static int handle_compressed_post_data(request_t *r, const char *data, int len);
 static void handle_get_request(request_t *r);
 
 static int gpfdist_socket_send(const request_t *r, const void *buf, const size_t buflen);
@@ -503,7 +575,7 @@ static void usage_error(const char* msg, int print_usage)
 		{
 			fprintf(stderr,
 					"gpfdist -- file distribution web server\n\n"
-						"usage: gpfdist [--ssl <certificates_directory>] [-d <directory>] [-p <http(s)_port>] [-l <log_file>] [-t <timeout>] [-v | -V | -s] [-m <maxlen>] [-w <timeout>]"
+						"usage: gpfdist [--ssl <certificates_directory>] [-d <directory>] [-p <http(s)_port>] [-l <log_file>] [-t <timeout>] [-v | -V | -s] [-m <maxlen>] [-w <timeout>] [--readahead <blocks>]"
 #ifdef GPFXDIST
 					    "[-c file]"
 #endif
@@ -529,7 +601,8 @@ static void usage_error(const char* msg, int print_usage)
 					    "        -c file    : configuration file for transformations\n"
 #endif
 						"        --version  : print version information\n"
-						"        -w timeout : timeout in seconds before close target file\n\n");
+						"        -w timeout : timeout in seconds before close target file\n"
+						"        --readahead blocks : number of blocks each session reads ahead in a worker thread, default is 0 (off)\n\n");
 		}
 	}
 
@@ -592,6 +665,7 @@ static void parse_command_line(int argc, const char* const argv[],
 #endif
 	{ "version", 256, 0, "print version number" },
 	{ NULL, 'w', 1, "wait for session timeout in seconds" },
+	{ "readahead", 258, 1, "blocks read ahead per session by a worker thread" },
 	{ 0 } };
 
 	status = apr_getopt_init(&os, pool, argc, argv);
@@ -676,6 +750,15 @@ static void parse_command_line(int argc, const char* const argv[],
 		case 'w':
 			opt.w = atoi(arg);
 			break;
+#ifndef WIN32
+		case 258:
+			opt.r = atoi(arg);
+			break;
+#else
+		case 258:
+			usage_error("--readahead is not supported by this build", 0);
+			break;
+#endif
 		}
 	}
 
@@ -704,6 +787,9 @@ static void parse_command_line(int argc, const char* const argv[],
     if (!is_valid_listen_queue_size(opt.z))
 		usage_error("Error: -z listen queue size must be between 16 and 512 (default is 256)", 0);
 
+	if (!is_valid_readahead(opt.r))
+		usage_error("Error: --readahead must be between 0 and 64 blocks (default is 0, disabled)", 0);
+
     /* get current directory, for ssl directory validation */
     if (0 != apr_filepath_get(&current_directory, APR_FILEPATH_NATIVE, pool))
 		usage_error(apr_psprintf(pool, "Error: cannot access directory '.'\n"
@@ -883,12 +969,20 @@ static apr_status_t http_ok(request_t* r)
 		"Expires: 0\r\n"
 		"X-GPFDIST-VERSION: " GP_VERSION "\r\n"
 		"X-GP-PROTO: %d\r\n"
+		"%s"
 		"Cache-Control: no-cache\r\n"
 		"Connection: close\r\n\r\n";
+	const char* compression = "";
 	char buf[1024];
 	int m, n;
 
-	n = apr_snprintf(buf, sizeof(buf), fmt, r->gp_proto);
+	/* confirm the compression of the data a writable external table sends */
+	if (r->compression == POST_COMPRESSION_ZLIB)
+		compression = "X-GP-COMPRESSION: zlib\r\n";
+	else if (r->compression == POST_COMPRESSION_ZSTD)
+		compression = "X-GP-COMPRESSION: zstd\r\n";
+
+	n = apr_snprintf(buf, sizeof(buf), fmt, r->gp_proto, compression);
 	if (n >= sizeof(buf) - 1)
 		gfatal(r, "internal error - buffer overflow during http_ok");
 
@@ -903,6 +997,21 @@ static apr_status_t http_ok(request_t* r)
 	return 0;
 }
 
+/*
+ * session_rate
+ *
+ * Average throughput of a session since it was created, in bytes/second.
+ */
+static apr_int64_t session_rate(const session_t* s)
+{
+	apr_time_t elapsed = apr_time_now() - s->start_time;
+
+	if (elapsed <= 0)
+		return 0;
+
+	return (apr_int64_t) ((double) s->bytes * APR_USEC_PER_SEC / elapsed);
+}
+
 static void log_gpfdist_status()
 {
 	char buf[1024];
@@ -923,6 +1032,18 @@ static void log_gpfdist_status()
 			continue;
 		}
 		const char *ferror = (s->fstream == NULL ? NULL : fstream_get_error(s->fstream));
+#ifndef WIN32
+		char		ra_error[sizeof(s->readahead->error)];
+
+		/* the worker owns the fstream, only its copy of the error is safe */
+		if (s->readahead)
+		{
+			pthread_mutex_lock(&s->readahead->lock);
+			apr_cpystrn(ra_error, s->readahead->error, sizeof(ra_error));
+			pthread_mutex_unlock(&s->readahead->lock);
+			ferror = (ra_error[0] ? ra_error : NULL);
+		}
+#endif
 		gprint(NULL, "session %d: tid=%s, fs_error=%s, is_error=%d, nrequest=%d is_get=%d, maxsegs=%d\n",
 				i, s->tid, (ferror == NULL ? "N/A" : ferror), s->is_error, s->nrequest, s->is_get, s->maxsegs);
 		session_active_segs_dump(s);
@@ -944,9 +1065,26 @@ static void log_gpfdist_status()
 						"\t\tnrequest: %d\r\n"
 						"\t\tis_get: %d\r\n"
 						"\t\tpath: %s\r\n"
+#ifdef WIN32
+						"\t\tbytes: %ld\r\n"
+						"\t\trate: %ld\r\n"
+#else
+						"\t\tbytes: %"APR_INT64_T_FMT"\r\n"
+						"\t\trate: %"APR_INT64_T_FMT"\r\n"
+						"\t\treadahead: %d\r\n"
+#endif
 						"\t\trequest: [\r\n",
 						s->tid, s->nrequest,
-						s->is_get,s->path);
+						s->is_get,s->path,
+#ifdef WIN32
+						(long) s->bytes,
+						(long) session_rate(s)
+#else
+						s->bytes,
+						session_rate(s),
+						s->readahead ? s->readahead->nslot : 0
+#endif
+						);
 
 		printf("%s\n",buf);
 
@@ -1080,6 +1218,31 @@ static apr_status_t send_gpfdist_status(request_t* r)
 		return APR_EGENERAL;
 	}
 
+	/* one line per session: tid, bytes transferred and throughput (bytes/s) */
+	apr_hash_index_t* hi;
+	for (hi = apr_hash_first(r->pool, gcb.session.tab); hi; hi = apr_hash_next(hi))
+	{
+		void *entry;
+		apr_hash_this(hi, 0, 0, &entry);
+		session_t *s = (session_t*) entry;
+		if (s == NULL)
+			continue;
+
+		n = apr_snprintf(buf, sizeof(buf),
+#ifdef WIN32
+						 "session %s bytes %ld rate %ld\r\n",
+						 s->tid, (long) s->bytes, (long) session_rate(s));
+#else
+						 "session %s bytes %"APR_INT64_T_FMT" rate %"APR_INT64_T_FMT"\r\n",
+						 s->tid, s->bytes, session_rate(s));
+#endif
+		if (local_send(r, buf, n) != n)
+		{
+			gprint(r, "%s - socket error\n", r->peer);
+			return APR_EGENERAL;
+		}
+	}
+
 	return 0;
 }
 
@@ -1291,6 +1454,284 @@ static void gp1_send_errfile(request_t* r, apr_file_t* errfile)
 }
 #endif
 
+#ifndef WIN32
+/*
+ * readahead_thread
+ *
+ * Body of a session's read-ahead worker. Keep filling free slots until EOF,
+ * an error, or the event loop asks us to stop. The worker never touches
+ * the session itself, only the fstream and the ring.
+ */
+static void* readahead_thread(void* arg)
+{
+	readahead_t* ra = (readahead_t*) arg;
+
+	for (;;)
+	{
+		readahead_slot_t*	slot;
+		apr_int64_t			before;
+		int					size;
+
+		pthread_mutex_lock(&ra->lock);
+		while (!ra->stop && ra->count == ra->nslot)
+			pthread_cond_wait(&ra->cond, &ra->lock);
+		if (ra->stop)
+		{
+			pthread_mutex_unlock(&ra->lock);
+			break;
+		}
+		slot = &ra->slot[(ra->head + ra->count) % ra->nslot];
+		pthread_mutex_unlock(&ra->lock);
+
+		before = fstream_get_compressed_position(ra->fstream);
+		size = fstream_read(ra->fstream, slot->data, opt.m, &slot->fos, 1,
+							ra->line_delim_str, ra->line_delim_length);
+		slot->size = size;
+		if (size == 0)
+			slot->read_bytes = fstream_get_compressed_size(ra->fstream) - before;
+		else
+			slot->read_bytes = fstream_get_compressed_position(ra->fstream) - before;
+
+		pthread_mutex_lock(&ra->lock);
+		if (size < 0 && fstream_get_error(ra->fstream))
+			apr_cpystrn(ra->error, fstream_get_error(ra->fstream), sizeof(ra->error));
+		ra->count++;
+		pthread_mutex_unlock(&ra->lock);
+
+		/* wake up the event loop, a full pipe means it is already awake */
+		while (write(ra->notify[1], "", 1) < 0 && errno == EINTR)
+			;
+
+		/* EOF and errors are final, the event loop ends the session */
+		if (size <= 0)
+			break;
+	}
+
+	return NULL;
+}
+
+/*
+ * session_readahead_wake
+ *
+ * Make the requests waiting for the read-ahead worker watch their socket
+ * again, do_write() then picks up the next block.
+ */
+static void session_readahead_wake(session_t* session)
+{
+	apr_hash_index_t*	hi;
+	request_t**			waiting;
+	int					nwaiting = 0;
+	int					i;
+
+	waiting = malloc(sizeof(request_t*) * (apr_hash_count(session->requests) + 1));
+	if (!waiting)
+		gfatal(NULL, "out of memory when waking up read-ahead requests");
+
+	/* request_end() may detach requests, so don't do it while iterating */
+	for (hi = apr_hash_first(NULL, session->requests); hi; hi = apr_hash_next(hi))
+	{
+		void*		entry;
+		request_t*	r;
+
+		apr_hash_this(hi, 0, 0, &entry);
+		r = (request_t*) entry;
+		if (r && r->readahead_wait)
+		{
+			r->readahead_wait = 0;
+			waiting[nwaiting++] = r;
+		}
+	}
+
+	for (i = 0; i < nwaiting; i++)
+	{
+		if (setup_write(waiting[i]))
+			request_end(waiting[i], 1, 0);
+	}
+
+	free(waiting);
+}
+
+/*
+ * readahead_notify
+ *
+ * Callback when the read-ahead worker of a session finished a block.
+ */
+static void readahead_notify(int fd, short event, void* arg)
+{
+	session_t*	session = (session_t*) arg;
+	char		buf[64];
+
+	while (read(fd, buf, sizeof(buf)) > 0)
+		;
+
+	session_readahead_wake(session);
+}
+
+/*
+ * session_start_readahead
+ *
+ * Hand the session's fstream over to a read-ahead worker. On failure the
+ * session simply keeps reading synchronously.
+ */
+static void session_start_readahead(const request_t* r, session_t* session,
+									const char* line_delim_str, int line_delim_length)
+{
+	readahead_t*	ra;
+	int				i;
+
+	ra = pcalloc_safe(NULL, session->pool, sizeof(readahead_t),
+					  "out of memory when allocating read-ahead state");
+	ra->slot = pcalloc_safe(NULL, session->pool, sizeof(readahead_slot_t) * opt.r,
+							"out of memory when allocating read-ahead slots");
+	for (i = 0; i < opt.r; i++)
+		ra->slot[i].data = palloc_safe(NULL, session->pool, opt.m,
+									   "out of memory when allocating buffer: %d bytes", opt.m);
+
+	ra->nslot = opt.r;
+	ra->fstream = session->fstream;
+	ra->line_delim_length = line_delim_length;
+	if (line_delim_length > 0)
+		ra->line_delim_str = apr_pstrmemdup(session->pool, line_delim_str, line_delim_length);
+
+	if (pipe(ra->notify) != 0)
+	{
+		gwarning(r, "could not create read-ahead pipe: %s, reading synchronously", strerror(errno));
+		return;
+	}
+	fcntl(ra->notify[0], F_SETFL, fcntl(ra->notify[0], F_GETFL) | O_NONBLOCK);
+	fcntl(ra->notify[1], F_SETFL, fcntl(ra->notify[1], F_GETFL) | O_NONBLOCK);
+
+	event_set(&ra->notify_ev, ra->notify[0], EV_READ | EV_PERSIST, readahead_notify, session);
+	if (event_add(&ra->notify_ev, 0))
+	{
+		gwarning(r, "could not watch read-ahead pipe, reading synchronously");
+		close(ra->notify[0]);
+		close(ra->notify[1]);
+		return;
+	}
+
+	pthread_mutex_init(&ra->lock, NULL);
+	pthread_cond_init(&ra->cond, NULL);
+
+	if (pthread_create(&ra->thread, NULL, readahead_thread, ra) != 0)
+	{
+		gwarning(r, "could not start read-ahead thread: %s, reading synchronously", strerror(errno));
+		event_del(&ra->notify_ev);
+		close(ra->notify[0]);
+		close(ra->notify[1]);
+		pthread_cond_destroy(&ra->cond);
+		pthread_mutex_destroy(&ra->lock);
+		return;
+	}
+
+	gprintlnif(r, "session %ld reads ahead %d blocks", session->id, ra->nslot);
+	session->readahead = ra;
+}
+
+/*
+ * session_stop_readahead
+ *
+ * Stop and join the read-ahead worker. This must happen before the fstream
+ * it reads from is closed. Blocks that were read but never sent are simply
+ * dropped, just like the unread remainder of the files. Requests still
+ * waiting for a block find the session ended.
+ */
+static void session_stop_readahead(session_t* session)
+{
+	readahead_t* ra = session->readahead;
+
+	if (!ra)
+		return;
+
+	pthread_mutex_lock(&ra->lock);
+	ra->stop = 1;
+	pthread_cond_broadcast(&ra->cond);
+	pthread_mutex_unlock(&ra->lock);
+
+	pthread_join(ra->thread, NULL);
+	pthread_cond_destroy(&ra->cond);
+	pthread_mutex_destroy(&ra->lock);
+
+	event_del(&ra->notify_ev);
+	close(ra->notify[0]);
+	close(ra->notify[1]);
+
+	session->readahead = NULL;
+
+	session_readahead_wake(session);
+}
+
+/*
+ * session_readahead_wait
+ *
+ * Start the read-ahead worker of a GET session if needed. Return true if
+ * the request has to wait for the worker to finish a block, in which case
+ * it stops watching its socket until readahead_notify() wakes it up.
+ */
+static int session_readahead_wait(request_t* r)
+{
+	session_t*	session = r->session;
+	readahead_t* ra;
+	int			ready;
+
+	if (opt.r <= 0 || !session || !session->is_get ||
+		session->is_error || !session->fstream)
+		return 0;
+
+	if (!session->readahead)
+		session_start_readahead(r, session, r->line_delim_str, r->line_delim_length);
+
+	ra = session->readahead;
+	if (!ra)
+		return 0;
+
+	pthread_mutex_lock(&ra->lock);
+	ready = (ra->count > 0);
+	pthread_mutex_unlock(&ra->lock);
+
+	if (ready)
+		return 0;
+
+	event_del(&r->ev);
+	r->readahead_wait = 1;
+	return 1;
+}
+
+/*
+ * session_readahead_get
+ *
+ * Take the next block from the read-ahead ring, session_readahead_wait()
+ * made sure there is one. Returns the fstream_read() result.
+ */
+static int session_readahead_get(session_t* session, char* data,
+								 struct fstream_filename_and_offset* fos)
+{
+	readahead_t*		ra = session->readahead;
+	readahead_slot_t*	slot;
+	int					size;
+
+	pthread_mutex_lock(&ra->lock);
+	if (ra->count == 0)
+		gfatal(NULL, "internal error - read-ahead ring of session %ld is empty", session->id);
+	slot = &ra->slot[ra->head];
+	pthread_mutex_unlock(&ra->lock);
+
+	size = slot->size;
+	if (size > 0)
+		memcpy(data, slot->data, size);
+	*fos = slot->fos;
+	gcb.read_bytes += slot->read_bytes;
+
+	pthread_mutex_lock(&ra->lock);
+	ra->head = (ra->head + 1) % ra->nslot;
+	ra->count--;
+	pthread_cond_broadcast(&ra->cond);
+	pthread_mutex_unlock(&ra->lock);
+
+	return size;
+}
+#endif
+
 /*
  * session_get_block
  *
@@ -1315,22 +1756,40 @@ session_get_block(const request_t* r, block_t* retblock, char* line_delim_str, i
 		return 0;
 	}
 
-	gcb.read_bytes -= fstream_get_compressed_position(session->fstream);
+#ifndef WIN32
+	if (session->readahead)
+	{
+		/* the worker already did the read and the read_bytes accounting */
+		size = session_readahead_get(session, retblock->data, &fos);
+		delay_watchdog_timer();
 
-	/* read data from our filestream as a chunk with whole data rows */
+		if (size == 0)
+		{
+			gprintln(NULL, "session_get_block: end session due to EOF");
+			session_end(session, 0);
+			return 0;
+		}
+	}
+	else
+#endif
+	{
+		gcb.read_bytes -= fstream_get_compressed_position(session->fstream);
 
-	size = fstream_read(session->fstream, retblock->data, opt.m, &fos, whole_rows, line_delim_str, line_delim_length);
-	delay_watchdog_timer();
+		/* read data from our filestream as a chunk with whole data rows */
 
-	if (size == 0)
-	{
-		gprintln(NULL, "session_get_block: end session due to EOF");
-		gcb.read_bytes += fstream_get_compressed_size(session->fstream);
-		session_end(session, 0);
-		return 0;
-	}
+		size = fstream_read(session->fstream, retblock->data, opt.m, &fos, whole_rows, line_delim_str, line_delim_length);
+		delay_watchdog_timer();
 
-	gcb.read_bytes += fstream_get_compressed_position(session->fstream);
+		if (size == 0)
+		{
+			gprintln(NULL, "session_get_block: end session due to EOF");
+			gcb.read_bytes += fstream_get_compressed_size(session->fstream);
+			session_end(session, 0);
+			return 0;
+		}
+
+		gcb.read_bytes += fstream_get_compressed_position(session->fstream);
+	}
 
 	if (size < 0)
 	{
@@ -1356,6 +1815,10 @@ static void session_end(session_t* session, int error)
 	if (error)
 		session->is_error = error;
 
+#ifndef WIN32
+	session_stop_readahead(session);
+#endif
+
 	if (session->fstream)
 	{
 		gprintln(NULL, "close fstream");
@@ -1369,6 +1832,10 @@ static void session_free(session_t* session)
 {
 	gprintln(NULL, "free session %s", session->key);
 
+#ifndef WIN32
+	session_stop_readahead(session);
+#endif
+
 	if (session->fstream)
 	{
 		fstream_close(session->fstream);
@@ -1644,6 +2111,7 @@ static int session_attach(request_t* r)
 		session->active_segids[r->segid] = 1; /* mark this segid as active */
 		session->maxsegs = r->totalsegs;
 		session->requests = apr_hash_make(pool);
+		session->start_time = apr_time_now();
 		event_set(&session->ev, 0, 0, 0, 0);
 
 		if (session->tid == 0 || session->path == 0 || session->key == 0)
@@ -1767,7 +2235,15 @@ static void do_write(int fd, short event, void* arg)
 		/* get a block (or find a remaining block) */
 		if (r->outblock.top == r->outblock.bot)
 		{
-			const char* ferror = session_get_block(r, &r->outblock, r->line_delim_str, r->line_delim_length);
+			const char* ferror;
+
+#ifndef WIN32
+			/* do_write() is called again when the worker has a block */
+			if (session_readahead_wait(r))
+				return;
+#endif
+
+			ferror = session_get_block(r, &r->outblock, r->line_delim_str, r->line_delim_length);
 
 			if (ferror)
 			{
@@ -1842,6 +2318,8 @@ static void do_write(int fd, short event, void* arg)
 			   datablock->bot, datablock->bot + n, datablock->top);
 
 		r->bytes += n;
+		if (r->session)
+			r->session->bytes += n;
 		r->last = apr_time_now();
 		datablock->bot += n;
 
@@ -2935,6 +3413,228 @@ static void handle_get_request(request_t *r)
 	}
 }
 
+/* Decompression state of a compressed POST request body */
+typedef struct post_decoder_t
+{
+	int			compression;
+	int			done;		/* at the end of a zlib stream or zstd frame */
+	apr_int64_t	inbytes;	/* compressed bytes received */
+	apr_int64_t	outbytes;	/* bytes of rows they were decompressed to */
+#ifdef HAVE_LIBZ
+	z_stream	zstream;
+#endif
+#ifdef USE_ZSTD
+	ZSTD_DCtx*	dctx;
+#endif
+} post_decoder_t;
+
+/*
+ * post_write_rows
+ *
+ * Write the complete rows in r->in.dbuf to the session's file, and move the
+ * partial row at the end, if any, to the front of the buffer. Returns an
+ * error message, or NULL.
+ */
+static const char* post_write_rows(request_t* r)
+{
+	session_t*	session = r->session;
+	int			wrote;
+
+	wrote = fstream_write(session->fstream, r->in.dbuf, r->in.dbuftop, 1, r->line_delim_str, r->line_delim_length);
+	gdebug(r, "wrote %d bytes to file", wrote);
+	delay_watchdog_timer();
+
+	if (wrote == -1)
+		return fstream_get_error(session->fstream);
+
+	memmove(r->in.dbuf, r->in.dbuf + wrote, r->in.dbuftop - wrote);
+	r->in.dbuftop -= wrote;
+
+	return NULL;
+}
+
+/*
+ * post_decode
+ *
+ * Decompress 'len' bytes of the request body into r->in.dbuf, writing out
+ * the rows whenever the buffer fills up. Returns an error message, or NULL.
+ */
+static const char* post_decode(request_t* r, post_decoder_t* dec, const char* data, int len)
+{
+	const char* err;
+
+	dec->inbytes += len;
+
+#ifdef HAVE_LIBZ
+	if (dec->compression == POST_COMPRESSION_ZLIB)
+	{
+		z_stream*	zs = &dec->zstream;
+		int			ret;
+
+		zs->next_in = (Bytef*) data;
+		zs->avail_in = len;
+
+		do
+		{
+			if (r->in.dbuftop == r->in.dbufmax && (err = post_write_rows(r)) != NULL)
+				return err;
+
+			zs->next_out = (Bytef*) r->in.dbuf + r->in.dbuftop;
+			zs->avail_out = r->in.dbufmax - r->in.dbuftop;
+
+			ret = inflate(zs, Z_NO_FLUSH);
+			dec->outbytes += (r->in.dbufmax - zs->avail_out) - r->in.dbuftop;
+			r->in.dbuftop = r->in.dbufmax - zs->avail_out;
+
+			if (ret == Z_STREAM_END)
+			{
+				dec->done = 1;
+				if (zs->avail_in > 0)
+					return "unexpected data after the end of the compressed data";
+				break;
+			}
+			if (ret != Z_OK && ret != Z_BUF_ERROR)
+				return zs->msg ? zs->msg : "zlib decompression failed";
+		} while (zs->avail_in > 0 || zs->avail_out == 0);
+
+		return NULL;
+	}
+#endif
+#ifdef USE_ZSTD
+	if (dec->compression == POST_COMPRESSION_ZSTD)
+	{
+		ZSTD_inBuffer	in = { data, len, 0 };
+		ZSTD_outBuffer	out;
+		size_t			ret;
+
+		do
+		{
+			if (r->in.dbuftop == r->in.dbufmax && (err = post_write_rows(r)) != NULL)
+				return err;
+
+			out.dst = r->in.dbuf + r->in.dbuftop;
+			out.size = r->in.dbufmax - r->in.dbuftop;
+			out.pos = 0;
+
+			ret = ZSTD_decompressStream(dec->dctx, &out, &in);
+			if (ZSTD_isError(ret))
+				return ZSTD_getErrorName(ret);
+			r->in.dbuftop += out.pos;
+			dec->outbytes += out.pos;
+			dec->done = (ret == 0);
+		} while (in.pos < in.size || out.pos == out.size);
+
+		return NULL;
+	}
+#endif
+
+	return "unsupported compression";
+}
+
+/*
+ * handle_compressed_post_data
+ *
+ * Receive the compressed body of a POST request from a writable external
+ * table, decompress it and write the rows out. 'data' holds the part of the
+ * body that came in with the request headers. Returns 0 on success; on
+ * failure the error response has already been sent.
+ */
+static int handle_compressed_post_data(request_t *r, const char *data, int len)
+{
+	post_decoder_t	dec;
+	const char*		err = NULL;
+	char*			cbuf;
+
+	memset(&dec, 0, sizeof(dec));
+	dec.compression = r->compression;
+#ifdef HAVE_LIBZ
+	if (dec.compression == POST_COMPRESSION_ZLIB && inflateInit(&dec.zstream) != Z_OK)
+		err = "out of memory when allocating the zlib stream";
+#endif
+#ifdef USE_ZSTD
+	if (dec.compression == POST_COMPRESSION_ZSTD && (dec.dctx = ZSTD_createDCtx()) == NULL)
+		err = "out of memory when allocating the zstd context";
+#endif
+
+	if (!err && len > 0)
+	{
+		r->in.davailable -= len;
+		err = post_decode(r, &dec, data, len);
+	}
+
+	cbuf = palloc_safe(r, r->pool, opt.m, "out of memory when allocating the compressed data buffer: %d bytes", opt.m);
+
+	while (!err && r->in.davailable > 0)
+	{
+		size_t	want = r->in.davailable > opt.m ? opt.m : r->in.davailable;
+		ssize_t	n;
+
+		n = gpfdist_receive(r, cbuf, want);
+
+		if (n < 0)
+		{
+#ifdef WIN32
+			int e = WSAGetLastError();
+			int ok = (e == WSAEINTR || e == WSAEWOULDBLOCK);
+#else
+			int e = errno;
+			int ok = (e == EINTR || e == EAGAIN);
+#endif
+			if (!ok)
+			{
+				gwarning(r, "handle_post_request receive errno: %d, msg: %s", e, strerror(e));
+				err = "internal error";
+			}
+		}
+		else if (n == 0)
+		{
+			/* socket close by peer will return 0 */
+			gwarning(r, "handle_post_request socket closed by peer");
+			err = "socket closed by peer";
+		}
+		else
+		{
+			r->bytes += n;
+			if (r->session)
+				r->session->bytes += n;
+			r->last = apr_time_now();
+			r->in.davailable -= n;
+
+			err = post_decode(r, &dec, cbuf, n);
+		}
+	}
+
+	/* the body must end with complete compressed data and complete rows */
+	if (!err && !dec.done)
+		err = "incomplete compressed data";
+	if (!err && r->in.dbuftop > 0)
+		err = post_write_rows(r);
+	if (!err && r->in.dbuftop > 0)
+		err = "incomplete data row at the end of the request";
+
+#ifdef HAVE_LIBZ
+	if (dec.compression == POST_COMPRESSION_ZLIB)
+		inflateEnd(&dec.zstream);
+#endif
+#ifdef USE_ZSTD
+	if (dec.dctx)
+		ZSTD_freeDCtx(dec.dctx);
+#endif
+
+	if (err)
+	{
+		gwarning(r, "handle_post_request, write error: %s", err);
+		http_error(r, FDIST_INTERNAL_ERROR, err);
+		request_end(r, 1, 0);
+		return -1;
+	}
+
+	gprintlnif(r, "received compressed body: %"APR_INT64_T_FMT" bytes, %"APR_INT64_T_FMT" bytes uncompressed",
+			   dec.inbytes, dec.outbytes);
+
+	return 0;
+}
+
 static void handle_post_request(request_t *r, int header_end)
 {
 	int h_count = r->in.req->hc;
@@ -3028,6 +3728,14 @@ static void handle_post_request(request_t *r, int header_end)
 			}
 	}
 
+	if (r->compression == POST_COMPRESSION_UNSUPPORTED)
+	{
+		http_error(r, FDIST_BAD_REQUEST, "unsupported compression");
+		gwarning(r, "got a request with unsupported compression");
+		request_end(r, 1, 0);
+		return;
+	}
+
 	/* create a buffer to hold the incoming raw data */
 	r->in.dbufmax = opt.m; /* size of max line size */
 	r->in.dbuftop = 0;
@@ -3041,6 +3749,15 @@ static void handle_post_request(request_t *r, int header_end)
 		data_bytes_in_req = (r->in.hbuf + r->in.hbuftop) - data_start;
 	}
 
+	if (r->compression != POST_COMPRESSION_NONE)
+	{
+		if (handle_compressed_post_data(r, data_start, data_bytes_in_req) != 0)
+			return;
+
+		session->seq_segs[r->segid] = r->seq;
+		goto done_processing_request;
+	}
+
 	if(data_bytes_in_req > 0)
 	{
 		/* we have data after the request headers. consume it */
@@ -3111,6 +3828,8 @@ static void handle_post_request(request_t *r, int header_end)
 			/*gprint("received %d bytes from client\n", n);*/
 
 			r->bytes += n;
+			if (r->session)
+				r->session->bytes += n;
 			r->last = apr_time_now();
 			r->in.davailable -= n;
 			r->in.dbuftop += n;
@@ -3318,11 +4037,13 @@ static int request_parse_gp_headers(request_t *r, int opt_g)
 	const char* cid = 0;
 	const char* sn = 0;
 	const char* gp_proto = NULL; /* default to invalid, so that report error if not specified*/
+	const char* compression = NULL;
 	int 		i;
 
 	r->csvopt = "";
 	r->is_final = 0;
 	r->seq = 0;
+	r->compression = POST_COMPRESSION_NONE;
 
 	for (i = 0; i < r->in.req->hc; i++)
 	{
@@ -3338,6 +4059,8 @@ static int request_parse_gp_headers(request_t *r, int opt_g)
 			gp_proto = r->in.req->hvalue[i];
 		else if (0 == strcasecmp("X-GP-DONE", r->in.req->hname[i]))
 			r->is_final = 1;
+		else if (0 == strcasecmp("X-GP-COMPRESSION", r->in.req->hname[i]))
+			compression = r->in.req->hvalue[i];
 		else if (0 == strcasecmp("X-GP-SEGMENT-COUNT", r->in.req->hname[i]))
 			r->totalsegs = atoi(r->in.req->hvalue[i]);
 		else if (0 == strcasecmp("X-GP-SEGMENT-ID", r->in.req->hname[i]))
@@ -3373,6 +4096,21 @@ static int request_parse_gp_headers(request_t *r, int opt_g)
 		}
 	}
 
+	if (compression && 0 != strcmp(compression, "none"))
+	{
+#ifdef HAVE_LIBZ
+		if (0 == strcmp(compression, "zlib"))
+			r->compression = POST_COMPRESSION_ZLIB;
+		else
+#endif
+#ifdef USE_ZSTD
+		if (0 == strcmp(compression, "zstd"))
+			r->compression = POST_COMPRESSION_ZSTD;
+		else
+#endif
+			r->compression = POST_COMPRESSION_UNSUPPORTED;
+	}
+
 	if (r->line_delim_length > 0)
 	{
 		if (NULL == r->line_delim_str || (((int)strlen(r->line_delim_str)) != r->line_delim_length))
@@ -33,3 +33,13 @@ bool is_valid_listen_queue_size(int listen_queue_size)
 	else
 		return true;
 }
+
+bool is_valid_readahead(int readahead)
+{
+	if (readahead < 0)
+		return false;
+	else if (readahead > 64)
+		return false;
+	else
+		return true;
+}
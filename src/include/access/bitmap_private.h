@@ -77,6 +77,7 @@ typedef struct BMBuildLovData
 {
 	BlockNumber 	lov_block;
 	OffsetNumber	lov_off;
+	BMTIDBuffer	   *tidbuf;		/* buffered tids for this value, or NULL */
 } BMBuildLovData;
 
 
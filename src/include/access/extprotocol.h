@@ -23,8 +23,26 @@
 
 /* ------------------------- I/O function API -----------------------------*/
 
-struct ExternalSelectDescData;
-typedef struct ExternalSelectDescData *ExternalSelectDesc;
+struct ProjectionInfo;
+
+/*
+ * ExternalSelectDescData is used for storing state related
+ * to selecting data from an external table. A protocol may use it to
+ * read only the referenced columns, or to skip data that can't satisfy
+ * the filter quals; the quals are still checked on the returned rows.
+ * When several segments read the same file:// URI, each one reads only
+ * its share, split_index out of split_count, of the data.
+ */
+typedef struct ExternalSelectDescData
+{
+	struct ProjectionInfo *projInfo;   /* Information for column projection */
+	List *filter_quals;         /* Information for filter pushdown */
+	int split_index;            /* share of the data to read ... */
+	int split_count;            /* ... out of this many, if > 1 */
+
+} ExternalSelectDescData;
+
+typedef ExternalSelectDescData *ExternalSelectDesc;
 
 /*
  * ExtProtocolData is the node type that is passed as fmgr "context" info
@@ -100,7 +100,7 @@ extern size_t url_curl_fread(void *ptr, size_t size, URL_FILE *file, CopyState p
 extern size_t url_curl_fwrite(void *ptr, size_t size, URL_FILE *file, CopyState pstate);
 extern void url_curl_fflush(URL_FILE *file, CopyState pstate);
 
-extern URL_FILE *url_file_fopen(char *url, bool forwrite, extvar_t *ev, CopyState pstate);
+extern URL_FILE *url_file_fopen(char *url, bool forwrite, extvar_t *ev, CopyState pstate, ExternalSelectDesc desc);
 extern void url_file_fclose(URL_FILE *file, bool failOnError, const char *relname);
 extern bool url_file_feof(URL_FILE *file, int bytesread);
 extern bool url_file_ferror(URL_FILE *file, int bytesread, char *ebuf, int ebuflen);
@@ -37,6 +37,14 @@ typedef struct CdbCopy
 								 * for copy out, once a segment gave away all it's
 								 * data rows, it is taken out of the list */
 	struct CdbDispatcherState *dispatcherState;
+
+	/*
+	 * For COPY FROM with gp_copy_dispatch_chunk_size set, data for each
+	 * segment is collected in send_chunks[segindex] and handed to libpq
+	 * in send_chunk_size pieces, instead of one message per row.
+	 */
+	StringInfoData *send_chunks;
+	int			send_chunk_size;
 } CdbCopy;
 
 
@@ -46,6 +54,8 @@ extern CdbCopy *makeCdbCopy(struct CopyStateData *cstate, bool copy_in);
 extern void cdbCopyStart(CdbCopy *cdbCopy, CopyStmt *stmt, int file_encoding);
 extern void cdbCopySendDataToAll(CdbCopy *c, const char *buffer, int nbytes);
 extern void cdbCopySendData(CdbCopy *c, int target_seg, const char *buffer, int nbytes);
+extern bool cdbCopySendDataChunked(CdbCopy *c, int target_seg, const char *buffer, int nbytes);
+extern void cdbCopyFlushChunks(CdbCopy *c);
 extern bool cdbCopyGetData(CdbCopy *c, bool cancel, uint64 *rows_processed);
 extern void cdbCopyAbort(CdbCopy *c);
 extern void cdbCopyEnd(CdbCopy *c,
@@ -246,6 +246,7 @@ extern int	gp_snapshotadd_timeout; /* GUC var - timeout specifier for snapshot-c
 
 extern int	gp_fts_probe_retries; /* GUC var - specifies probe number of retries for FTS */
 extern int	gp_fts_probe_timeout; /* GUC var - specifies probe timeout for FTS */
+extern bool gp_fts_persistent_probe_connections; /* GUC var - keep FTS probe connections open */
 extern int	gp_fts_probe_interval; /* GUC var - specifies polling interval for FTS */
 extern int gp_fts_mark_mirror_down_grace_period;
 extern int	gp_fts_replication_attempt_count; /* GUC var - specifies replication max attempt count for FTS */
@@ -504,6 +505,12 @@ extern bool gp_adjust_selectivity_for_outerjoins;
 extern int gp_hashjoin_tuples_per_bucket;
 extern int gp_hashagg_groups_per_bucket;
 
+/*
+ * Stop increasing the number of hash join batches when a single hash value
+ * dominates a batch, and join batches that can't fit in memory in stripes.
+ */
+extern bool gp_hashjoin_adaptive_skew;
+
 /*
  * Damping of selectivities of clauses which pertain to the same base
  * relation; compensates for undetected correlation
@@ -597,6 +604,9 @@ extern bool trace_sort;
  */
 extern bool gp_dynamic_partition_pruning;
 
+/* Number of partitions a dynamic scan opens and prefetches ahead */
+extern int	gp_dynamic_scan_prefetch_partitions;
+
 /* Sharing of plan fragments for common table expressions */
 extern bool gp_cte_sharing;
 /* Enable RECURSIVE clauses in common table expressions */
@@ -630,6 +640,7 @@ extern bool gp_disable_tuple_hints;
 
 /* Enable metrics */
 extern bool gp_enable_query_metrics;
+extern bool gp_enable_query_metrics_timing;
 extern int gp_instrument_shmem_size;
 
 extern bool dml_ignore_target_partition_check;
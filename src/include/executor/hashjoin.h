@@ -175,6 +175,7 @@ typedef struct HashJoinTableStats
     int                     nonemptybatches;    /* num of nontrivial batches */
     Size                    workmem_max;        /* work_mem high water mark */
     CdbExplain_Agg          chainlength;        /* hash chain length stats */
+    int                     nstripes;           /* num of stripes after the first */
 } HashJoinTableStats;
 
 
@@ -351,6 +352,18 @@ typedef struct HashJoinTableData
 
 	bool		growEnabled;	/* flag to shut off nbatch increases */
 
+	/*
+	 * GPDB: Once nbatch can't grow any more, a batch that still doesn't fit
+	 * in memory is loaded one stripe at a time, and the whole outer batch is
+	 * joined against each stripe in turn.  Inner tuples that don't fit in the
+	 * current stripe are written to innerStripeFile, which becomes the next
+	 * stripe.  This is only enabled for join types that don't need to track
+	 * outer tuple matches across stripes.
+	 */
+	bool		stripingEnabled;	/* may batches be split into stripes? */
+	int			curstripe;		/* current stripe of curbatch; 0 at first */
+	BufFile    *innerStripeFile;	/* inner tuples left for later stripes */
+
 	uint64		totalTuples;	/* # tuples obtained from inner plan */
 	uint64		partialTuples;	/* # tuples obtained from inner plan by me */
 	uint64		skewTuples;		/* # tuples inserted into skew tuples */
@@ -15,6 +15,7 @@
 #ifndef INSTRUMENT_H
 #define INSTRUMENT_H
 
+#include "datatype/timestamp.h"
 #include "nodes/plannodes.h"
 #include "portability/instr_time.h"
 #include "utils/resowner.h"
@@ -106,7 +107,10 @@ extern void InstrStartParallelQuery(void);
 extern void InstrEndParallelQuery(BufferUsage *result);
 extern void InstrAccumParallelQuery(BufferUsage *result);
 
-#define GP_INSTRUMENT_OPTS (gp_enable_query_metrics ? INSTRUMENT_ROWS : INSTRUMENT_NONE)
+#define GP_INSTRUMENT_OPTS (gp_enable_query_metrics ? \
+							(gp_enable_query_metrics_timing ? \
+							 INSTRUMENT_ROWS | INSTRUMENT_TIMER : INSTRUMENT_ROWS) : \
+							INSTRUMENT_NONE)
 
 /* Greenplum query metrics */
 typedef struct InstrumentationHeader
@@ -125,6 +129,11 @@ typedef struct InstrumentationSlot
 	int32		ccnt;			/* command count */
 	int16		segid;			/* segment id */
 	int16		nid;			/* node id */
+	int16		sliceid;		/* slice id */
+	int16		ntag;			/* node tag of the plan node */
+	int64		tuplessent;		/* sending side of a Motion: tuples sent so
+								 * far, -1 for other nodes */
+	TimestampTz starttime;		/* time the node was initialized */
 } InstrumentationSlot;
 
 /*
@@ -142,7 +151,9 @@ extern InstrumentationHeader *InstrumentGlobal;
 extern Size InstrShmemNumSlots(void);
 extern Size InstrShmemSize(void);
 extern void InstrShmemInit(void);
-extern Instrumentation *GpInstrAlloc(const Plan *node, int instrument_options);
+extern Instrumentation *GpInstrAlloc(const Plan *node, int instrument_options,
+									 int sliceId, bool sending);
+extern InstrumentationSlot *GpInstrGetSlot(Instrumentation *instr);
 
 /*
  * For each free slot in shmem, fill it with specific pattern
@@ -19,7 +19,9 @@
 
 extern SeqScanState *ExecInitSeqScan(SeqScan *node, EState *estate, int eflags);
 extern SeqScanState *ExecInitSeqScanForPartition(SeqScan *node, EState *estate,
-							Relation currentRelation);
+							Relation currentRelation, TupleDesc scanDesc);
+extern void ExecSeqScanSwitchPartition(SeqScanState *node,
+									   Relation currentRelation);
 extern void ExecEndSeqScan(SeqScanState *node);
 extern void ExecReScanSeqScan(SeqScanState *node);
 
@@ -24,12 +24,15 @@ struct fstream_options{
     int forwrite;   /* true for write, false for read */
 	int usesync;    /* true if writes use O_SYNC */
     struct gpfxdist_t* transform;	/* for gpfxdist transformations */
+    int split_index;	/* read only this share of the files ... */
+    int split_count;	/* ... out of this many, if > 1 */
 };
 
 struct fstream_filename_and_offset{
     char 	fname[256];
     int64_t line_number; /* Line number of first line in buffer.  Zero means fstream doesn't know the line number. */
     int64_t foff;
+    int64_t split_start; /* Offset of the byte range read in the file, line_number counts from there. Zero if the file is read whole. */
 };
 
 // If read_whole_lines, then size must be at least the value of -m (blocksize). */
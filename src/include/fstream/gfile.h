@@ -41,7 +41,8 @@ typedef enum Compression_type
 {
 	NO_COMPRESSION = 0,
 	GZ_COMPRESSION,
-	BZ_COMPRESSION
+	BZ_COMPRESSION,
+	ZSTD_COMPRESSION
 } compression_type;
 
 /* The struct gfile_t is private.  Please do not use any of its fields. */
@@ -70,6 +71,9 @@ typedef struct gfile_t
 #endif
 #ifdef HAVE_LIBBZ2
 		struct bzlib_stuff*bz;
+#endif
+#ifdef USE_ZSTD
+		struct zstd_stuff*zstd;
 #endif
 	}u;
 	bool_t is_write;
@@ -90,6 +94,8 @@ int gfile_open(gfile_t* fd, const char* fpath, int flags, int* response_code, co
 int gfile_close(gfile_t*fd);
 off_t gfile_get_compressed_size(gfile_t*fd);
 off_t gfile_get_compressed_position(gfile_t*fd);
+bool_t gfile_is_seekable(gfile_t*fd);
+int gfile_seek(gfile_t*fd, off_t offset);
 ssize_t gfile_read(gfile_t* fd, void* ptr, size_t len); /* gfile_read reads as much as it can--short read indicates error. */
 ssize_t gfile_write(gfile_t* fd, void* ptr, size_t len);
 void gfile_printf_then_putc_newline(const char*format,...) pg_attribute_printf(1, 2);
@@ -2116,12 +2116,13 @@ typedef struct DynamicSeqScanState
 	 */
 	bool		firstPartition;
 	/*
-	 * lastRelOid is the last relation that corresponds to the
-	 * varattno mapping of qual and target list. Each time we open a new partition, we will
-	 * compare the last relation with current relation by using varattnos_map()
-	 * and then convert the varattno to the new varattno
+	 * lastTupDesc is a copy of the descriptor of the last relation that
+	 * corresponds to the varattno mapping of qual and target list. Each time
+	 * we open a new partition, we will compare it with the current relation
+	 * by using convert_tuples_by_name_map_if_req() and then convert the
+	 * varattno to the new varattno
 	 */
-	Oid			lastRelOid;
+	TupleDesc	lastTupDesc;
 
 	/*
 	 * scanrelid is the RTE index for this scan node. It will be used to select
@@ -2138,6 +2139,12 @@ typedef struct DynamicSeqScanState
 	int			nOids;
 	Oid		   *partOids;
 	int			whichPart;
+
+	/*
+	 * Partitions after whichPart that have been opened ahead of time, see
+	 * gp_dynamic_scan_prefetch_partitions. NULL if not opened yet.
+	 */
+	Relation   *partRels;
 } DynamicSeqScanState;
 
 /* ----------------
@@ -2906,14 +2913,16 @@ typedef struct MotionState
 	/* For Motion recv */
 	int			routeIdNext;	/* for a sorted motion node, the routeId to get next (same as
 								 * the routeId last returned ) */
-	bool		tupleheapReady; /* for a sorted motion node, false until we have a tuple from
+	bool		mergeReady;		/* for a sorted motion node, false until we have a tuple from
 								 * each source segindex */
 
 	/* For sorted Motion recv */
 	int			numSortCols;
 	SortSupport sortKeys;
 	TupleTableSlot **slots;
-	struct binaryheap *tupleheap; /* binary heap of slot indices */
+	int		   *mergeTree;		/* loser tree of slot indices; [0] is the winner */
+	Datum	   *abbrevKeys;		/* abbreviated leading key of each slot, or NULL */
+	int64		abbrevNext;		/* tuple count at which to consider aborting abbreviation */
 	int			lastSortColIdx;
 
 	/* The following can be used for debugging, usage stats, etc.  */
@@ -2032,6 +2032,7 @@ typedef struct AlterTableCmd	/* one subcommand of an ALTER TABLE */
 	 * AT_ExpandTable
 	 */
 	int	        backendId;     /* backend ID on QD, if a temporary table was created */
+	bool		expandInPlace;	/* EXPAND TABLE by the in-place method? */
 
 	GpPolicy   *policy;
 
@@ -902,6 +902,8 @@ typedef struct ExternalScanInfo
 {
 	NodeTag		type;
 	List		*uriList;       /* data uri or null for each segment  */
+	List		*splitList;		/* (index, count) share of its uri to read,
+								 * or NIL, for each segment; NIL if none */
 	char		fmtType;        /* data format type                   */
 	bool		isMasterOnly;   /* true for EXECUTE on master seg only */
 	int			rejLimit;       /* reject limit (-1 for no sreh)      */
@@ -93,4 +93,5 @@ typedef struct
 } fts_context;
 
 extern bool FtsWalRepMessageSegments(CdbComponentDatabases *context);
+extern int FtsWaitForNextProbe(long timeout);
 #endif
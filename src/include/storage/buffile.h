@@ -66,6 +66,7 @@ extern void BufFileSuspend(BufFile *buffile);
 extern void BufFileResume(BufFile *buffile);
 
 extern bool gp_workfile_compression;
+extern bool gp_workfile_bypass_page_cache;
 extern void BufFilePledgeSequential(BufFile *buffile);
 extern void BufFileSetIsTempFile(BufFile *file, bool isTempFile);
 
@@ -383,6 +383,8 @@ extern bool vmem_process_interrupt;
 extern bool execute_pruned_plan;
 
 extern bool gp_enable_relsize_collection;
+extern bool gp_enable_radix_sort;
+extern bool gp_enable_window_sliding_agg;
 
 /* Debug DTM Action */
 typedef enum
@@ -593,14 +595,30 @@ extern char  *gp_auth_time_override_str;
 
 extern char  *gp_default_storage_options;
 
+/* gpexpand GUC */
+extern bool gp_expand_in_place;
+
 /* copy GUC */
 extern bool gp_enable_segment_copy_checking;
+extern int gp_copy_dispatch_chunk_size;
 
 extern int writable_external_table_bufsize;
 
+typedef enum
+{
+	WRITABLE_EXTERNAL_TABLE_COMPRESSION_NONE,
+	WRITABLE_EXTERNAL_TABLE_COMPRESSION_ZLIB,
+	WRITABLE_EXTERNAL_TABLE_COMPRESSION_ZSTD
+} WritableExternalTableCompression;
+
+extern int writable_external_table_compression;
+
 /* Enable passing of query constraints to external table providers */
 extern bool gp_external_enable_filter_pushdown;
 
+/* Split file:// external table files among the primaries of their host */
+extern bool gp_external_enable_file_split;
+
 /* Enable the Global Deadlock Detector */
 extern bool gp_enable_global_deadlock_detector;
 
@@ -102,6 +102,10 @@ extern double gp_resource_group_cpu_limit;
 extern double gp_resource_group_memory_limit;
 extern bool gp_resource_group_bypass;
 extern int gp_resource_group_queuing_timeout;
+extern int gp_resource_group_memory_batch_chunks;
+extern bool gp_resource_group_adaptive_concurrency;
+extern int gp_resource_group_adaptive_min_concurrency;
+extern int gp_resource_group_adaptive_cpu_threshold;
 
 /*
  * Non-GUC global variables.
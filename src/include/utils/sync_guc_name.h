@@ -16,10 +16,15 @@
 		"gp_debug_linger",
 		"gp_default_storage_options",
 		"gp_disable_tuple_hints",
+		"gp_dynamic_scan_prefetch_partitions",
+		"gp_enable_query_metrics_timing",
+		"gp_enable_radix_sort",
 		"gp_enable_segment_copy_checking",
+		"gp_enable_window_sliding_agg",
 		"gp_external_enable_filter_pushdown",
 		"gp_hashagg_default_nbatches",
 		"gp_hashagg_groups_per_bucket",
+		"gp_hashjoin_adaptive_skew",
 		"gp_hashjoin_tuples_per_bucket",
 		"gp_ignore_error_table",
 		"gp_indexcheck_insert",
@@ -62,6 +67,7 @@
 		"gp_udpic_fault_inject_percent",
 		"gp_udpic_network_disable_ipv6",
 		"gp_vmem_idle_resource_timeout",
+		"gp_workfile_bypass_page_cache",
 		"gp_workfile_caching_loglevel",
 		"gp_workfile_compression",
 		"gp_workfile_limit_files_per_query",
@@ -123,4 +129,5 @@
 		"vmem_process_interrupt",
 		"wal_debug",
 		"work_mem",
+		"writable_external_table_compression",
 		"gp_resgroup_debug_wait_queue",
@@ -162,6 +162,7 @@
 		"gp_command_count",
 		"gp_connection_send_timeout",
 		"gp_contentid",
+		"gp_copy_dispatch_chunk_size",
 		"gp_cost_hashjoin_chainwalk",
 		"gp_create_table_random_default_distribution",
 		"gp_cte_sharing",
@@ -193,9 +194,12 @@
 		"gp_enable_sort_distinct",
 		"gp_enable_sort_limit",
 		"gp_encoding_check_locale_compatibility",
+		"gp_expand_in_place",
 		"gp_external_enable_exec",
+		"gp_external_enable_file_split",
 		"gp_external_max_segs",
 		"gp_fts_mark_mirror_down_grace_period",
+		"gp_fts_persistent_probe_connections",
 		"gp_fts_probe_interval",
 		"gp_fts_probe_retries",
 		"gp_fts_probe_timeout",
@@ -226,9 +230,13 @@
 		"gp_reject_percent_threshold",
 		"gp_reraise_signal",
 		"gp_resgroup_memory_policy",
+		"gp_resource_group_adaptive_concurrency",
+		"gp_resource_group_adaptive_cpu_threshold",
+		"gp_resource_group_adaptive_min_concurrency",
 		"gp_resource_group_bypass",
 		"gp_resource_group_cpu_limit",
 		"gp_resource_group_cpu_priority",
+		"gp_resource_group_memory_batch_chunks",
 		"gp_resource_group_memory_limit",
 		"gp_resource_group_queuing_timeout",
 		"gp_resource_manager",
@@ -67,6 +67,10 @@ typedef struct workfile_set
 	/* Size in bytes of the files in this workfile set */
 	int64		total_bytes;
 
+	/* Bytes written to the files, and the time spent on it in microseconds */
+	int64		write_bytes;
+	int64		write_usecs;
+
 	/* Prefix of files in the workfile set */
 	char		prefix[WORKFILE_PREFIX_LEN];
 
@@ -98,6 +102,7 @@ extern void AtEOXact_WorkFile(void);
 extern void RegisterFileWithSet(File file, struct workfile_set *work_set);
 extern void UpdateWorkFileSize(File file, uint64 newsize);
 extern void WorkFileDeleted(File file, bool hold_lock);
+extern void WorkFileAddWriteStats(struct workfile_set *work_set, int64 nbytes, int64 usecs);
 
 extern workfile_set *workfile_mgr_create_set(const char *operator_name, const char *prefix, bool hold_pin);
 extern void workfile_mgr_close_set(workfile_set *work_set);
@@ -0,0 +1,4 @@
+SET gp_enable_radix_sort = on;
+SET statement_mem = '2GB';
+CREATE TABLE sort_int4_few_distinct_radix_out AS SELECT * FROM sort_int4_few_distinct ORDER BY k DISTRIBUTED RANDOMLY;
+DROP TABLE sort_int4_few_distinct_radix_out;
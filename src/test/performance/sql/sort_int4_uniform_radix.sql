@@ -0,0 +1,4 @@
+SET gp_enable_radix_sort = on;
+SET statement_mem = '2GB';
+CREATE TABLE sort_int4_uniform_radix_out AS SELECT * FROM sort_int4_uniform ORDER BY k DISTRIBUTED RANDOMLY;
+DROP TABLE sort_int4_uniform_radix_out;
@@ -0,0 +1,4 @@
+SET gp_enable_radix_sort = off;
+SET statement_mem = '2GB';
+CREATE TABLE sort_int8_skewed_qsort_out AS SELECT * FROM sort_int8_skewed ORDER BY k DISTRIBUTED RANDOMLY;
+DROP TABLE sort_int8_skewed_qsort_out;
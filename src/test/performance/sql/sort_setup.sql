@@ -0,0 +1,36 @@
+--
+-- Create the tables for the sort performance tests, 10 million rows each.
+-- The leading sort key of each table follows a different distribution.
+--
+CREATE TABLE sort_int4_uniform (k int4, k2 int4, pad text) DISTRIBUTED RANDOMLY;
+INSERT INTO sort_int4_uniform
+  SELECT (random() * 2147483647)::int4, i, 'padding' FROM generate_series(1, 10000000) i;
+
+CREATE TABLE sort_int4_few_distinct (k int4, k2 int4, pad text) DISTRIBUTED RANDOMLY;
+INSERT INTO sort_int4_few_distinct
+  SELECT i % 10, (random() * 1000000)::int4, 'padding' FROM generate_series(1, 10000000) i;
+
+CREATE TABLE sort_int8_skewed (k int8, k2 int4, pad text) DISTRIBUTED RANDOMLY;
+INSERT INTO sort_int8_skewed
+  SELECT CASE WHEN i % 10 < 9 THEN 42 ELSE (random() * 9e18)::int8 END, i, 'padding'
+  FROM generate_series(1, 10000000) i;
+
+CREATE TABLE sort_int8_presorted (k int8, k2 int4, pad text) DISTRIBUTED RANDOMLY;
+INSERT INTO sort_int8_presorted
+  SELECT i, i, 'padding' FROM generate_series(1, 10000000) i;
+
+CREATE TABLE sort_timestamp_uniform (k timestamp, k2 int4, pad text) DISTRIBUTED RANDOMLY;
+INSERT INTO sort_timestamp_uniform
+  SELECT timestamp '2000-01-01' + random() * interval '20 years', i, 'padding'
+  FROM generate_series(1, 10000000) i;
+
+CREATE TABLE sort_text_uniform (k text, k2 int4, pad text) DISTRIBUTED RANDOMLY;
+INSERT INTO sort_text_uniform
+  SELECT md5(i::text), i, 'padding' FROM generate_series(1, 10000000) i;
+
+ANALYZE sort_int4_uniform;
+ANALYZE sort_int4_few_distinct;
+ANALYZE sort_int8_skewed;
+ANALYZE sort_int8_presorted;
+ANALYZE sort_timestamp_uniform;
+ANALYZE sort_text_uniform;
@@ -0,0 +1,4 @@
+SET gp_enable_radix_sort = on;
+SET statement_mem = '2GB';
+CREATE TABLE sort_timestamp_uniform_radix_out AS SELECT * FROM sort_timestamp_uniform ORDER BY k DISTRIBUTED RANDOMLY;
+DROP TABLE sort_timestamp_uniform_radix_out;
@@ -624,6 +624,27 @@ select count_operator('delete from mpp6247_foo using mpp6247_bar where mpp6247_f
 drop table mpp6247_bar;
 drop table mpp6247_foo;
 
+-- A Dynamic Seq Scan keeps its scan state for partitions of the same layout,
+-- and starts over for a partition whose columns have to be remapped. Check
+-- both, with and without opening partitions ahead of the scan.
+create table dyn_reuse (a int, b int, c text) distributed by (a)
+partition by range (b) (start (0) end (40) every (10));
+create table dyn_reuse_other (a int, junk int, b int, c text) distributed by (a);
+alter table dyn_reuse_other drop column junk;
+alter table dyn_reuse detach partition dyn_reuse_1_prt_3;
+alter table dyn_reuse attach partition dyn_reuse_other for values from (20) to (30);
+drop table dyn_reuse_1_prt_3;
+insert into dyn_reuse select i, i % 40, 'x' || i from generate_series(1, 400) i;
+
+select count(*), sum(a), count(c) from dyn_reuse where a > 10;
+select c from dyn_reuse where a in (15, 25, 35, 399) order by c;
+set gp_dynamic_scan_prefetch_partitions = 2;
+select count(*), sum(a), count(c) from dyn_reuse where a > 10;
+select c from dyn_reuse where a in (15, 25, 35, 399) order by c;
+reset gp_dynamic_scan_prefetch_partitions;
+
+drop table dyn_reuse;
+
 -- CLEANUP
 -- start_ignore
 drop schema if exists bfv_partition_plans cascade;
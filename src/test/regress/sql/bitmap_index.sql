@@ -391,3 +391,32 @@ SET enable_bitmapscan = OFF;
 explain (analyze, verbose) select * from test_bmsparse where type > 500;
 
 DROP TABLE test_bmsparse;
+
+-- Union of bitmap vectors for medium cardinality values. These are made up
+-- of literal words mostly, which are ORed a run at a time.
+CREATE TABLE test_bmunion (id int, v int) DISTRIBUTED BY (id);
+INSERT INTO test_bmunion SELECT g, g % 7 FROM generate_series(1, 100000) g;
+CREATE INDEX ON test_bmunion USING bitmap(v);
+SET enable_seqscan = OFF;
+SET enable_bitmapscan = ON;
+SELECT count(*) FROM test_bmunion WHERE v < 3;
+SELECT count(*) FROM test_bmunion WHERE v IN (1, 4, 6);
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+DROP TABLE test_bmunion;
+
+-- Bitmap index build over many distinct values and NULLs. The tid buffer of
+-- each value is cached in the build hash table.
+CREATE TABLE test_bmbuild (id int, v int, t text) DISTRIBUTED BY (id);
+INSERT INTO test_bmbuild SELECT g, CASE WHEN g % 10 = 0 THEN NULL ELSE g % 20000 END, (g % 3000)::text FROM generate_series(1, 100000) g;
+CREATE INDEX test_bmbuild_v ON test_bmbuild USING bitmap(v);
+CREATE INDEX test_bmbuild_vt ON test_bmbuild USING bitmap(v, t);
+SET enable_seqscan = OFF;
+SET enable_bitmapscan = ON;
+SELECT count(*) FROM test_bmbuild WHERE v = 1234;
+SELECT count(*) FROM test_bmbuild WHERE v IS NULL;
+SELECT count(*) FROM test_bmbuild WHERE v = 1234 AND t = '1234';
+SELECT count(*) FROM test_bmbuild WHERE v BETWEEN 100 AND 199;
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+DROP TABLE test_bmbuild;
@@ -446,6 +446,46 @@ alter table expand_domain_tab expand table;
 select gp_segment_id, count(*) from expand_domain_tab group by gp_segment_id;
 select numsegments from gp_distribution_policy where localoid='expand_domain_tab'::regclass;
 
+--
+-- Test expanding tables in place: only the rows that move to the new segment
+-- are moved, the others stay on their old segments.
+--
+select gp_debug_set_create_table_default_numsegments(2);
+set gp_expand_in_place = on;
+
+create table expand_inplace_heap(a int, b text, c int) distributed by (a, b);
+insert into expand_inplace_heap select i, 'b' || i % 7 from generate_series(1, 1000) i;
+update expand_inplace_heap set c = gp_segment_id;
+
+create table expand_inplace_ao(a int, c int) with (appendonly=true) distributed by (a);
+insert into expand_inplace_ao select i from generate_series(1, 1000) i;
+update expand_inplace_ao set c = gp_segment_id;
+
+alter table expand_inplace_heap expand table;
+alter table expand_inplace_ao expand table;
+
+select count(*) from expand_inplace_heap;
+select count(*) from expand_inplace_heap
+ where gp_segment_id <> gp_expand_target_segment('expand_inplace_heap'::regclass, 3, a, b);
+-- rows never move between the old segments
+select count(*) from expand_inplace_heap where gp_segment_id <> c and gp_segment_id < 2;
+select count(distinct gp_segment_id) from expand_inplace_heap;
+
+select count(*) from expand_inplace_ao;
+select count(*) from expand_inplace_ao
+ where gp_segment_id <> gp_expand_target_segment('expand_inplace_ao'::regclass, 3, a);
+select count(*) from expand_inplace_ao where gp_segment_id <> c and gp_segment_id < 2;
+
+select localoid::regclass, numsegments from gp_distribution_policy
+ where localoid in ('expand_inplace_heap'::regclass, 'expand_inplace_ao'::regclass)
+ order by 1;
+
+-- the function checks its arguments against the distribution key
+select gp_expand_target_segment('expand_inplace_ao'::regclass, 3, 1, 2);
+select gp_expand_target_segment('expand_inplace_ao'::regclass, 0, 1);
+
+reset gp_expand_in_place;
+
 -- start_ignore
 -- We need to do a cluster expansion which will check if there are partial
 -- tables, we need to drop the partial tables to keep the cluster expansion
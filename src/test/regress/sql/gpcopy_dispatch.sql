@@ -174,3 +174,35 @@ COPY partdisttest FROM STDIN LOG ERRORS SEGMENT REJECT LIMIT 2;
 \.
 
 DROP TABLE partdisttest;
+
+-- Chunked dispatch. For a randomly distributed table, the QD doesn't parse
+-- the lines at all, and sends them to the segments in chunks.
+SET gp_copy_dispatch_chunk_size = 1;
+CREATE TABLE chunkdisttest (a smallint, b smallint) DISTRIBUTED RANDOMLY;
+COPY chunkdisttest FROM '/tmp/ten-thousand-and-one-lines.txt';
+SELECT count(*), sum(a), sum(b) FROM chunkdisttest;
+SELECT count(DISTINCT gp_segment_id) > 1 AS spread FROM chunkdisttest;
+
+-- Bad lines are still caught, on the QEs this time.
+COPY chunkdisttest FROM STDIN LOG ERRORS SEGMENT REJECT LIMIT 2;
+1	1
+1	x
+\.
+SELECT count(*) FROM chunkdisttest;
+DROP TABLE chunkdisttest;
+
+-- Hash distributed tables are still routed by the QD, in chunks.
+CREATE TABLE chunkdisttest (a smallint, b smallint) DISTRIBUTED BY (b);
+COPY chunkdisttest FROM '/tmp/ten-thousand-and-one-lines.txt';
+SELECT count(*), count(DISTINCT gp_segment_id) FROM chunkdisttest;
+
+-- Lines rejected by the QD are sent after the rows before them in the chunk.
+COPY chunkdisttest FROM STDIN LOG ERRORS SEGMENT REJECT LIMIT 2;
+2	1
+3	x
+4	1
+\.
+SELECT count(*), sum(a) FROM chunkdisttest;
+SELECT linenum, errmsg FROM gp_read_error_log('chunkdisttest');
+DROP TABLE chunkdisttest;
+RESET gp_copy_dispatch_chunk_size;
@@ -55,4 +55,41 @@ SELECT count(*) FROM pg_stat_activity where backend_type = 'client backend';
 -- If more than one row returned, means previous test has leaked slots.
 SELECT count(*) FROM (SELECT 1 FROM gp_instrument_shmem_detail GROUP BY ssid, ccnt) t;
 
+-- The running query finds its own plan nodes in the live statistics.
+SELECT count(*) > 0 AS has_nodes, bool_and(node_type IS NOT NULL) AS has_types
+FROM gp_toolkit.gp_live_exec_stats
+WHERE sess_id = current_setting('gp_session_id')::int;
+
+-- Every segment publishes a plan node only for the slice it executes, plus
+-- the sending side of the Motions it feeds. The cursor's Gather Motion has
+-- consumed a single row so far. The segments go on to send all of theirs,
+-- which fit in the interconnect buffers, so wait for that; the rest of the
+-- sent rows are then queued. The queries looking at the statistics show up
+-- in them too, so only look at the cursor's, the oldest command running.
+CREATE TABLE live_stats_t (a int) DISTRIBUTED BY (a);
+INSERT INTO live_stats_t SELECT generate_series(1, 1000);
+CREATE TEMP VIEW live_stats_cursor AS
+SELECT * FROM gp_toolkit.gp_live_exec_stats_summary
+WHERE sess_id = current_setting('gp_session_id')::int AND
+      command_cnt = (SELECT min(command_cnt) FROM gp_toolkit.gp_live_exec_stats
+                     WHERE sess_id = current_setting('gp_session_id')::int);
+BEGIN;
+DECLARE live_stats_c CURSOR FOR SELECT * FROM live_stats_t;
+FETCH 1 FROM live_stats_c \g /dev/null
+SELECT count(*) = count(DISTINCT (segid, command_cnt, node_id, sending)) AS executed_only
+FROM gp_toolkit.gp_live_exec_stats
+WHERE sess_id = current_setting('gp_session_id')::int;
+DO $$
+BEGIN
+	FOR i IN 1..600 LOOP
+		EXIT WHEN (SELECT sum(rows) FROM live_stats_cursor WHERE sending) = 1000;
+		PERFORM pg_sleep(0.1);
+	END LOOP;
+END;
+$$;
+SELECT sum(rows) FILTER (WHERE sending) AS sent,
+       bool_or(queue_depth > 0) FILTER (WHERE NOT sending) AS has_backlog
+FROM live_stats_cursor;
+COMMIT;
+
 DROP SCHEMA QUERY_METRICS CASCADE;
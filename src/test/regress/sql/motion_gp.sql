@@ -98,3 +98,64 @@ $$) order by id;
 CREATE TABLE motion_noatts ();
 INSERT INTO motion_noatts SELECT;
 SELECT * FROM motion_noatts;
+
+-- Sorted Gather Motion: the coordinator merges the sorted streams of all the
+-- segments with a loser tree, comparing the abbreviated keys of the leading
+-- sort key first. The 't' keys share a long prefix, so their abbreviated keys
+-- are all equal, every comparison falls back to the full keys, and the
+-- abbreviation is given up after a few hundred tuples. The 'u' keys differ in
+-- their first bytes, so the abbreviated keys mostly decide.
+CREATE TABLE motion_merge (id int, seg int, t text COLLATE "C", u text COLLATE "C") DISTRIBUTED BY (id);
+INSERT INTO motion_merge
+  SELECT i, NULL,
+         repeat('common prefix ', 4) || lpad(((i * 7919) % 1000)::text, 4, '0'),
+         lpad(((i * 7919) % 500)::text, 4, '0') || repeat('x', 20)
+  FROM generate_series(1, 1000) i;
+INSERT INTO motion_merge SELECT i, NULL, NULL, NULL FROM generate_series(1001, 1010) i;
+UPDATE motion_merge SET seg = gp_segment_id;
+
+-- Does the plan merge the streams in the Gather Motion?
+create or replace function motion_merge_plan(sql text) returns bool as $$
+declare
+  line text;
+begin
+  for line in execute 'explain ' || sql
+  loop
+    if line like '%Merge Key%' then
+      return true;
+    end if;
+  end loop;
+  return false;
+end;
+$$ language plpgsql;
+
+-- Runs query 'sql', and checks that its 't' column comes in ascending order,
+-- nulls last. ~<~ compares bytewise, like the "C" collation.
+create or replace function motion_merge_check(sql text, out n bigint, out sorted bool) as $$
+declare
+  rec record;
+  prev text;
+begin
+  n := 0;
+  sorted := true;
+  for rec in execute sql
+  loop
+    if n > 0 and (prev is null and rec.t is not null or rec.t ~<~ prev) then
+      sorted := false;
+    end if;
+    prev := rec.t;
+    n := n + 1;
+  end loop;
+end;
+$$ language plpgsql;
+
+select motion_merge_plan($$ select t from motion_merge order by t $$);
+-- All the senders have tuples, the abbreviated keys collide
+select * from motion_merge_check($$ select t from motion_merge order by t $$);
+-- The abbreviated keys are distinct, but for duplicates
+select * from motion_merge_check($$ select u as t from motion_merge order by u $$);
+-- All the senders but one are empty
+select n = (select count(*) from motion_merge where seg = 0) as all_rows, n > 0 as nonempty, sorted
+from motion_merge_check($$ select t from motion_merge where seg = 0 order by t $$);
+-- All the senders are empty
+select * from motion_merge_check($$ select t from motion_merge where seg < 0 order by t $$);
@@ -1724,4 +1724,72 @@ EXPLAIN WITH cte as (SELECT *, row_number() over (PARTITION BY date,region) FROM
 -- When there is a disjunct in the filter predicates, it is not possible to push down either into the window function.
 EXPLAIN WITH cte as (SELECT *, row_number() over (PARTITION BY date,region) FROM window_part_sales) SELECT * FROM cte WHERE date > '2011-03-01' OR region = 'usa';
 
+-- Aggregates without an inverse transition function are evaluated as sliding
+-- aggregates over wide ROWS frames, instead of being restarted on every row.
+select i, v, min(v) over w, max(v) over w, bit_and(v) over w,
+       max(v) filter (where v % 2 = 0) over w
+from (select i, case when i % 9 = 0 then null else (i * 37) % 101 end
+      from generate_series(1, 30) i) t(i, v)
+window w as (order by i rows between 7 preceding and current row)
+order by i;
+create table window_sliding (p int, i int, v int) distributed by (p);
+insert into window_sliding
+  select i % 5, i, case when i % 13 = 0 then null else (i * 7919) % 10007 end
+  from generate_series(1, 20000) i;
+set gp_enable_window_sliding_agg = on;
+create table window_sliding_on as
+  select p, i,
+         min(v) over (partition by p order by i rows between 1000 preceding and current row) as a,
+         max(v) over (partition by p order by i rows between 50 preceding and 20 following) as b,
+         bit_or(v) over (partition by p order by i rows between 5 following and 30 following) as c,
+         max(v) filter (where v % 3 = 0) over (partition by p order by i rows between 200 preceding and 10 preceding) as d
+  from window_sliding distributed by (p);
+set gp_enable_window_sliding_agg = off;
+create table window_sliding_off as
+  select p, i,
+         min(v) over (partition by p order by i rows between 1000 preceding and current row) as a,
+         max(v) over (partition by p order by i rows between 50 preceding and 20 following) as b,
+         bit_or(v) over (partition by p order by i rows between 5 following and 30 following) as c,
+         max(v) filter (where v % 3 = 0) over (partition by p order by i rows between 200 preceding and 10 preceding) as d
+  from window_sliding distributed by (p);
+reset gp_enable_window_sliding_agg;
+select count(*) from window_sliding_on;
+(select * from window_sliding_on except all select * from window_sliding_off)
+union all
+(select * from window_sliding_off except all select * from window_sliding_on);
+
+-- An aggregate whose combine function doesn't agree with its transition
+-- function shows whether the partial states were actually combined.
+create aggregate window_sliding_probe(int4)
+  (sfunc = int4pl, stype = int4, initcond = '0', combinefunc = int4larger);
+create aggregate window_sliding_probe_float(float8)
+  (sfunc = float8pl, stype = float8, initcond = '0', combinefunc = float8larger);
+select bool_or(s <> least(i, 10)) as sliding
+from (select i, window_sliding_probe(1) over (order by i rows between 9 preceding and current row) as s
+      from generate_series(1, 100) i) t;
+-- floating-point states could differ in rounding, they are never combined
+select bool_or(s <> least(i, 10)) as sliding
+from (select i, window_sliding_probe_float(1) over (order by i rows between 9 preceding and current row) as s
+      from generate_series(1, 100) i) t;
+set gp_enable_window_sliding_agg = off;
+select bool_or(s <> least(i, 10)) as sliding
+from (select i, window_sliding_probe(1) over (order by i rows between 9 preceding and current row) as s
+      from generate_series(1, 100) i) t;
+reset gp_enable_window_sliding_agg;
+
+-- The tuplestore is reused across partitions, also after a partition
+-- spilled to disk, and when the WindowAgg is rescanned.
+set work_mem = '64kB';
+select p, count(*), sum(rn), sum(nxt - i)
+from (select p, i, row_number() over (partition by p order by i) as rn,
+             lead(i) over (partition by p order by i) as nxt
+      from (select case when i <= 10000 then 0 else i % 4 + 1 end, i
+            from generate_series(1, 10020) i) t(p, i)) s
+group by p order by p;
+reset work_mem;
+select x, (select sum(rn)
+           from (select row_number() over (partition by g) as rn
+                 from (values (1), (1), (2)) v(g) where g <= x) s)
+from generate_series(1, 2) x order by x;
+
 -- End of Test
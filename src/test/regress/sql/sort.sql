@@ -130,3 +130,51 @@ with t as (
 select count(*) from t;
 
 reset enable_hashjoin;
+
+--
+-- Radix sort of integer-like leading keys must give the same order as
+-- quicksort, including NULLs, descending keys and ties on the leading key.
+--
+create table radix_sort_t (i int4, b int8, ts timestamp, t text) distributed randomly;
+insert into radix_sort_t
+  select case when g % 97 = 0 then null else (g * 7919) % 5003 - 2500 end,
+         (g::int8 * 1000003) % 1000000007 - 500000000,
+         timestamp '2000-01-01' + ((g * 31) % 10007) * interval '1 hour',
+         md5((g % 3001)::text)
+  from generate_series(1, 20000) g;
+
+create function radix_sort_orders() returns setof text as $$
+  select md5(string_agg(coalesce(i::text, 'N') || ':' || b, ',' order by i, b)) from radix_sort_t
+  union all
+  select md5(string_agg(coalesce(i::text, 'N') || ':' || b, ',' order by i desc nulls last, b)) from radix_sort_t
+  union all
+  select md5(string_agg(b::text, ',' order by b desc)) from radix_sort_t
+  union all
+  select md5(string_agg(ts || ':' || b, ',' order by ts, b)) from radix_sort_t
+  union all
+  select md5(string_agg(t || ':' || b, ',' order by t, b)) from radix_sort_t
+$$ language sql;
+
+set gp_enable_radix_sort = on;
+create temp table radix_sort_on as select row_number() over () as n, h from radix_sort_orders() h distributed by (n);
+set gp_enable_radix_sort = off;
+create temp table radix_sort_off as select row_number() over () as n, h from radix_sort_orders() h distributed by (n);
+select n, radix_sort_on.h = radix_sort_off.h as same from radix_sort_on join radix_sort_off using (n) order by n;
+reset gp_enable_radix_sort;
+
+-- Duplicates are still found when a unique index is built with radix sort
+create table radix_sort_u (i int4) distributed by (i);
+insert into radix_sort_u select g from generate_series(1, 20000) g;
+insert into radix_sort_u values (4242);
+create unique index radix_sort_u_i on radix_sort_u (i);
+
+-- Top-N sorts discard tuples that lose on the leading key before copying
+-- them; ties on the leading key and NULLs still go through all the keys
+select a, b from (select (i * 7) % 13, i from generate_series(1, 1000) i) t(a, b)
+order by a, b desc limit 5;
+select a, b from (select case when i % 100 = 0 then null else (i * 7) % 13 end, i
+                  from generate_series(1, 1000) i) t(a, b)
+order by a nulls first, b limit 3;
+select a, b from (select case when i % 100 = 0 then null else (i * 7) % 13 end, i
+                  from generate_series(1, 1000) i) t(a, b)
+order by a desc nulls last, b limit 3;
@@ -35,6 +35,15 @@ return result
 $$
 language plpython3u;
 
+-- count the hash joins of a query that joined oversized batches in stripes.
+create or replace function hashjoin_spill.num_striped_joins(explain_query text)
+returns int as
+$$
+rv = plpy.execute(explain_query)
+return len([r for r in rv if 'more stripes of oversized batches' in r['QUERY PLAN']])
+$$
+language plpython3u;
+
 CREATE TABLE test_hj_spill (i1 int, i2 int, i3 int, i4 int, i5 int, i6 int, i7 int, i8 int);
 insert into test_hj_spill SELECT i,i,i%1000,i,i,i,i,i from
 	(select generate_series(1, nsegments * 15000) as i from
@@ -59,4 +68,40 @@ select count(1) from generate_series(1, 1000000) t1 left join generate_series(1,
 set gp_workfile_compression = off;
 select count(1) from generate_series(1, 1000000) t1 left join generate_series(1, 50000) t2 on t1 = t2;
 
+-- Keep the spilled data out of the page cache, the result must be the same.
+set gp_workfile_bypass_page_cache = on;
+select avg(i3) from (SELECT t1.* FROM test_hj_spill AS t1 RIGHT JOIN test_hj_spill AS t2 ON t1.i1=t2.i2) foo;
+select count(1) from generate_series(1, 1000000) t1 left join generate_series(1, 50000) t2 on t1 = t2;
+reset gp_workfile_bypass_page_cache;
+
+-- The workfile sets of a running hash join show the bytes written so far. The
+-- write time is only measured with track_io_timing, which is off.
+begin;
+declare c cursor for SELECT t1.* FROM test_hj_spill AS t1 RIGHT JOIN test_hj_spill AS t2 ON t1.i1=t2.i2;
+move 1 in c;
+select sum(written) > 0 as written, sum(write_usecs) = 0 as untimed
+  from gp_toolkit.gp_workfile_entries where sess_id = current_setting('gp_session_id')::int;
+commit;
+
+-- A single hot key on the inner side can't be split into smaller batches.
+-- Instead of doubling the number of batches until it's alone, the batch is
+-- joined in stripes.
+CREATE TABLE test_hj_skew_inner (k int, v int) distributed by (k);
+insert into test_hj_skew_inner select case when i <= 50000 then 1 else i end, i from generate_series(1, 60000) i;
+CREATE TABLE test_hj_skew_outer (k int) distributed by (k);
+insert into test_hj_skew_outer select i % 100000 from generate_series(1, 200000) i;
+analyze test_hj_skew_inner;
+analyze test_hj_skew_outer;
+set gp_hashjoin_adaptive_skew = on;
+select count(*) from test_hj_skew_outer o join test_hj_skew_inner i on o.k = i.k;
+select hashjoin_spill.num_striped_joins('explain analyze select count(*) from test_hj_skew_outer o join test_hj_skew_inner i on o.k = i.k') > 0 as striped;
+-- the unmatched inner tuples of every stripe are returned
+select count(*), count(o.k) from test_hj_skew_outer o right join test_hj_skew_inner i on o.k = i.k and o.k <> 60000;
+select hashjoin_spill.num_striped_joins('explain analyze select count(*), count(o.k) from test_hj_skew_outer o right join test_hj_skew_inner i on o.k = i.k and o.k <> 60000') > 0 as striped;
+-- a full join can't track the matched outer tuples across stripes
+select count(*), count(o.k), count(i.k) from test_hj_skew_outer o full join test_hj_skew_inner i on o.k = i.k;
+reset gp_hashjoin_adaptive_skew;
+select count(*) from test_hj_skew_outer o join test_hj_skew_inner i on o.k = i.k;
+select hashjoin_spill.num_striped_joins('explain analyze select count(*) from test_hj_skew_outer o join test_hj_skew_inner i on o.k = i.k') as striped;
+
 drop schema hashjoin_spill cascade;